@@ -0,0 +1,19 @@
+#include <benchmark/benchmark.h>
+#include <omp.h>
+#include "consensus/posyg_engine.hpp"
+
+// One PoSyg cycle over range(0) participants on range(1) OpenMP threads.
+static void BM_PoSygRunCycle(benchmark::State& state) {
+    const int previous_threads = omp_get_max_threads();
+    omp_set_num_threads(static_cast<int>(state.range(1)));
+    PoSygEngine engine(static_cast<size_t>(state.range(0)), 42);
+    for (auto _ : state) {
+        engine.run_cycle();
+    }
+    omp_set_num_threads(previous_threads);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_PoSygRunCycle)
+    ->ArgsProduct({ benchmark::CreateRange(1 << 10, 1 << 20, 32), { 1, 2, 4, 8 } })
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
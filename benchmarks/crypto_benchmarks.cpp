@@ -0,0 +1,41 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include "cryptography/crypto.hpp"
+#include "cryptography/ecdsa.hpp"
+
+// Key pair shared by the signing benchmarks; generating one is slow and not what is measured.
+static const std::pair<std::string, std::string>& benchmark_keys() {
+    static const std::pair<std::string, std::string> keys = ECDSA::generate_key_pair();
+    return keys;
+}
+
+static void BM_CryptoHash(benchmark::State& state) {
+    const std::string data(static_cast<size_t>(state.range(0)), 'x');
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Crypto::hash(data));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_CryptoHash)->RangeMultiplier(8)->Range(64, 64 << 12);
+
+static void BM_EcdsaSign(benchmark::State& state) {
+    const auto& keys = benchmark_keys();
+    const std::string message = Crypto::hash("benchmark message");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ECDSA::sign_message(message, keys.first));
+    }
+}
+BENCHMARK(BM_EcdsaSign);
+
+static void BM_EcdsaVerify(benchmark::State& state) {
+    const auto& keys = benchmark_keys();
+    const std::string message = Crypto::hash("benchmark message");
+    const std::string signature = ECDSA::sign_message(message, keys.first);
+    for (auto _ : state) {
+        if (!ECDSA::verify_signature(message, signature, keys.second)) {
+            state.SkipWithError("Signature rejected");
+            break;
+        }
+    }
+}
+BENCHMARK(BM_EcdsaVerify);
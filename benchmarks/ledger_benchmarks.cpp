@@ -0,0 +1,115 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "cryptography/crypto.hpp"
+#include "cryptography/ecdsa.hpp"
+#include "ledger/block.hpp"
+#include "ledger/ledger.hpp"
+
+// Signed transactions with distinct amounts, so each has its own hash; built once and reused.
+static const std::vector<Transaction>& signed_transactions(size_t count) {
+    static std::vector<Transaction> transactions;
+    if (transactions.size() < count) {
+        auto keys = ECDSA::generate_key_pair();
+        const std::string signature = Crypto::sign(keys.second, keys.first);
+        for (size_t i = transactions.size(); i < count; ++i) {
+            transactions.emplace_back(keys.second, "receiver", 1.0 + static_cast<double>(i), signature,
+                                      TransactionType::STANDARD_PAYMENT, "benchmark");
+        }
+    }
+    return transactions;
+}
+
+// Block of `count` transactions on top of a dummy parent.
+static Block block_of(size_t count) {
+    Block block(1, Crypto::hash("parent"), 2);
+    const auto& transactions = signed_transactions(count);
+    block.add_transactions(std::vector<Transaction>(transactions.begin(), transactions.begin() + count));
+    return block;
+}
+
+// Ledger holding `height` blocks (genesis included).
+static std::unique_ptr<Ledger> ledger_of(size_t height) {
+    auto ledger = std::make_unique<Ledger>(3);
+    for (size_t number = 1; number < height; ++number) {
+        ledger->add_block(Block(number, ledger->get_latest_block().get_block_hash(), 2));
+    }
+    return ledger;
+}
+
+static void BM_TransactionSerialize(benchmark::State& state) {
+    const Transaction& tx = signed_transactions(1).front();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tx.serialize());
+    }
+}
+BENCHMARK(BM_TransactionSerialize);
+
+static void BM_TransactionDeserialize(benchmark::State& state) {
+    const std::string wire = signed_transactions(1).front().serialize();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Transaction::deserialize(wire));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * wire.size()));
+}
+BENCHMARK(BM_TransactionDeserialize);
+
+static void BM_BlockSerialize(benchmark::State& state) {
+    const Block block = block_of(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(block.serialize());
+    }
+}
+BENCHMARK(BM_BlockSerialize)->RangeMultiplier(10)->Range(1, 1000);
+
+static void BM_BlockDeserialize(benchmark::State& state) {
+    const std::string wire = block_of(static_cast<size_t>(state.range(0))).serialize();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Block::deserialize(wire));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * wire.size()));
+}
+BENCHMARK(BM_BlockDeserialize)->RangeMultiplier(10)->Range(1, 1000);
+
+// Appends one transaction to a block already holding range(0), which verifies its signature and extends the tree.
+static void BM_BlockAddTransaction(benchmark::State& state) {
+    const size_t existing = static_cast<size_t>(state.range(0));
+    const Transaction& extra = signed_transactions(existing + 1)[existing];
+    for (auto _ : state) {
+        state.PauseTiming();
+        Block block = block_of(existing);
+        state.ResumeTiming();
+        block.add_transaction(extra);
+        benchmark::DoNotOptimize(block.get_block_hash());
+    }
+}
+BENCHMARK(BM_BlockAddTransaction)->RangeMultiplier(10)->Range(1, 1000)->Unit(benchmark::kMicrosecond);
+
+// Full validation of a freshly loaded chain of range(0) blocks.
+static void BM_LedgerValidateChain(benchmark::State& state) {
+    const size_t height = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::unique_ptr<Ledger> ledger = ledger_of(height);
+        state.ResumeTiming();
+        if (!ledger->validate_chain()) {
+            state.SkipWithError("Chain rejected");
+            break;
+        }
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_LedgerValidateChain)->RangeMultiplier(4)->Range(16, 4096)->Complexity()->Unit(benchmark::kMicrosecond);
+
+// Parallel audit of the same chain with range(1) threads.
+static void BM_LedgerAuditChain(benchmark::State& state) {
+    std::unique_ptr<Ledger> ledger = ledger_of(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        if (!ledger->audit_chain(static_cast<int>(state.range(1)))) {
+            state.SkipWithError("Chain rejected");
+            break;
+        }
+    }
+}
+BENCHMARK(BM_LedgerAuditChain)->ArgsProduct({ { 1024, 4096 }, { 1, 2, 4 } })->Unit(benchmark::kMicrosecond);
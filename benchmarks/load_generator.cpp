@@ -0,0 +1,184 @@
+/*
+ * Multi-node transaction load generator.
+ *
+ * Starts a full mesh of P2PProtocol nodes on localhost and has every node send signed transactions to its peers
+ * at a fixed aggregate rate. Each transaction carries its send time in `data`, so receivers measure delivery
+ * latency. The run is summarized as one JSON object on standard output (and in --out, when given):
+ *
+ *     synledger_load_generator --nodes 4 --tps 5000 --duration 10 --base-port 19000 --out load.json
+ */
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cryptography/crypto.hpp"
+#include "cryptography/ecdsa.hpp"
+#include "ledger/block.hpp"
+#include "logging/logger.hpp"
+#include "metrics/metrics.hpp"
+#include "network/p2p_protocol.hpp"
+
+const int CONNECT_WAIT_MS = 500;   // Time given to the mesh to connect before sending starts.
+const int DRAIN_WAIT_MS = 2000;    // Time given to in-flight messages after sending stops.
+const int SEND_TICK_MS = 1;        // Pacing interval of each sender.
+
+struct LoadOptions {
+    size_t nodes = 4;        // Nodes in the mesh.
+    double tps = 2000.0;     // Transactions per second over all nodes.
+    double duration = 5.0;   // Seconds of sending.
+    int base_port = 19000;   // Node i listens on base_port + i.
+    bool verify = false;     // Whether receivers verify each signature.
+    std::string out;         // Optional JSON output file.
+};
+
+static LoadOptions parse_options(int argc, char* argv[]) {
+    LoadOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string flag = argv[i];
+        if (flag == "--verify") {
+            options.verify = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Missing value for " + flag);
+        }
+        const std::string value = argv[++i];
+        if (flag == "--nodes") {
+            options.nodes = std::stoul(value);
+        } else if (flag == "--tps") {
+            options.tps = std::stod(value);
+        } else if (flag == "--duration") {
+            options.duration = std::stod(value);
+        } else if (flag == "--base-port") {
+            options.base_port = std::stoi(value);
+        } else if (flag == "--out") {
+            options.out = value;
+        } else {
+            throw std::invalid_argument("Unknown option " + flag);
+        }
+    }
+    if (options.nodes < 2 || options.tps <= 0.0 || options.duration <= 0.0) {
+        throw std::invalid_argument("Need at least 2 nodes and a positive rate and duration");
+    }
+    return options;
+}
+
+int main(int argc, char* argv[]) {
+    LoadOptions options;
+    try {
+        options = parse_options(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\nUsage: " << argv[0]
+                  << " [--nodes N] [--tps T] [--duration S] [--base-port P] [--verify] [--out file.json]" << std::endl;
+        return 1;
+    }
+
+    // Standard output carries only the JSON summary.
+    Logger::instance().set_output(std::cerr);
+
+    Histogram& latency = MetricsRegistry::instance().timer("synledger_load_delivery_seconds",
+                                                           "Send-to-handler latency of generated transactions");
+    std::atomic<uint64_t> received{ 0 };
+    std::atomic<uint64_t> rejected{ 0 };
+
+    std::vector<std::unique_ptr<P2PProtocol>> nodes;
+    for (size_t i = 0; i < options.nodes; ++i) {
+        nodes.push_back(std::make_unique<P2PProtocol>(i + 1, "127.0.0.1"));
+        nodes.back()->set_message_handler([&](const std::string&, const std::string& message) {
+            try {
+                Transaction tx = Transaction::deserialize(message);
+                if (options.verify && !tx.verify_transaction()) {
+                    rejected.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                latency.record(metric_clock_ns() - std::stoull(tx.data));
+                received.fetch_add(1, std::memory_order_relaxed);
+            } catch (const std::exception&) {
+                rejected.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+        nodes.back()->initialize(options.base_port + static_cast<int>(i));
+    }
+    for (size_t i = 0; i < options.nodes; ++i) {
+        for (size_t j = 0; j < options.nodes; ++j) {
+            if (i != j) {
+                nodes[i]->add_peer(j + 1, "127.0.0.1:" + std::to_string(options.base_port + static_cast<int>(j)));
+            }
+        }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(CONNECT_WAIT_MS));
+
+    // Each node signs once; the signature covers the sender, so changing `data` keeps transactions valid.
+    std::atomic<uint64_t> sent{ 0 };
+    std::vector<std::thread> senders;
+    const double per_node_tps = options.tps / static_cast<double>(options.nodes);
+    const auto run_time = std::chrono::duration<double>(options.duration);
+    for (size_t i = 0; i < options.nodes; ++i) {
+        senders.emplace_back([&, i] {
+            auto keys = ECDSA::generate_key_pair();
+            Transaction tx(keys.second, "receiver", 1.0, Crypto::sign(keys.second, keys.first),
+                           TransactionType::STANDARD_PAYMENT);
+            const auto start = std::chrono::steady_clock::now();
+            uint64_t local_sent = 0;
+            size_t next_peer = 0;
+            while (std::chrono::steady_clock::now() - start < run_time) {
+                const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                const uint64_t due = static_cast<uint64_t>(elapsed * per_node_tps);
+                for (; local_sent < due; ++local_sent) {
+                    next_peer = (next_peer + 1) % options.nodes;
+                    if (next_peer == i) {
+                        next_peer = (next_peer + 1) % options.nodes;
+                    }
+                    tx.data = std::to_string(metric_clock_ns());
+                    nodes[i]->send_message(next_peer + 1, tx.serialize());
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(SEND_TICK_MS));
+            }
+            sent.fetch_add(local_sent, std::memory_order_relaxed);
+        });
+    }
+    for (auto& sender : senders) {
+        sender.join();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(DRAIN_WAIT_MS));
+
+    uint64_t dropped = 0;
+    for (size_t i = 0; i < options.nodes; ++i) {
+        for (size_t j = 0; j < options.nodes; ++j) {
+            if (i != j) {
+                dropped += nodes[i]->get_dropped_messages(j + 1);
+            }
+        }
+    }
+    for (auto& node : nodes) {
+        node->shutdown();
+    }
+
+    const HistogramSnapshot delivery = latency.snapshot();
+    const double to_ms = 1e-6;
+    std::ostringstream json;
+    json << "{\"nodes\":" << options.nodes << ",\"target_tps\":" << options.tps
+         << ",\"duration_s\":" << options.duration << ",\"verify\":" << (options.verify ? "true" : "false")
+         << ",\"sent\":" << sent.load() << ",\"received\":" << received.load() << ",\"rejected\":" << rejected.load()
+         << ",\"dropped\":" << dropped << ",\"achieved_tps\":" << static_cast<double>(received.load()) / options.duration
+         << ",\"latency_ms\":{\"p50\":" << delivery.quantile(0.5) * to_ms << ",\"p90\":" << delivery.quantile(0.9) * to_ms
+         << ",\"p99\":" << delivery.quantile(0.99) * to_ms << ",\"p999\":" << delivery.quantile(0.999) * to_ms
+         << "}}";
+
+    std::cout << json.str() << std::endl;
+    if (!options.out.empty()) {
+        std::ofstream file(options.out);
+        file << json.str() << "\n";
+        if (!file) {
+            std::cerr << "Failed to write " << options.out << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
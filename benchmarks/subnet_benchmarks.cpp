@@ -0,0 +1,43 @@
+#include <benchmark/benchmark.h>
+#include "subnet/subnet_manager.hpp"
+
+// Assigns range(0) nodes to 64 subnets.
+static void BM_SubnetAssignment(benchmark::State& state) {
+    const size_t nodes = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        SubnetManager manager(64);
+        for (size_t node_id = 0; node_id < nodes; ++node_id) {
+            manager.assign_node_to_subnet(node_id);
+        }
+        benchmark::DoNotOptimize(manager.get_subnet_load(0));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_SubnetAssignment)->RangeMultiplier(8)->Range(64, 1 << 15)->Unit(benchmark::kMicrosecond);
+
+// Assigns range(0) nodes to 64 subnets in one batch.
+static void BM_SubnetBatchAssignment(benchmark::State& state) {
+    std::vector<size_t> node_ids(static_cast<size_t>(state.range(0)));
+    for (size_t node_id = 0; node_id < node_ids.size(); ++node_id) {
+        node_ids[node_id] = node_id;
+    }
+    for (auto _ : state) {
+        SubnetManager manager(64);
+        manager.assign_nodes_to_subnets(node_ids);
+        benchmark::DoNotOptimize(manager.get_subnet_load(0));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_SubnetBatchAssignment)->RangeMultiplier(8)->Range(64, 1 << 15)->Unit(benchmark::kMicrosecond);
+
+// Plans a rebalance of 64 subnets holding range(0) nodes.
+static void BM_SubnetPlanRebalance(benchmark::State& state) {
+    SubnetManager manager(64);
+    for (size_t node_id = 0; node_id < static_cast<size_t>(state.range(0)); ++node_id) {
+        manager.assign_node_to_subnet(node_id);
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(manager.plan_rebalance());
+    }
+}
+BENCHMARK(BM_SubnetPlanRebalance)->RangeMultiplier(8)->Range(64, 1 << 15)->Unit(benchmark::kMicrosecond);
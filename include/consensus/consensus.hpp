@@ -9,6 +9,12 @@
  * consensus engine, and the ledger. Security-critical functions such as validator slashing and multisig
  * handling are embedded to maintain the integrity and resilience of the network.
  *
+ * Rounds run either one at a time (`initiate_consensus`) or pipelined (`run_pipeline`), in which height N+1 is
+ * proposed while height N collects votes and height N-1 is finalized, the three stages chaining like the phases
+ * of chained HotStuff. Slashing, rewards and parameter adjustment run on a background thread in both modes, and
+ * the latency of every stage is recorded. Rewards and slashes of a round are gathered in a `RewardLedger` and
+ * committed to the PoSyg engine together; slashes are reported to a `SlashingSink` as one batch per round.
+ *
  * Dependencies:
  * - Block class from the ledger module.
  * - P2PProtocol class for peer-to-peer communication.
@@ -20,15 +26,48 @@
 #define CONSENSUS_HPP
 
 #include <vector>        // To manage a collection of validators.
+#include <unordered_set> // Transactions of in-flight blocks.
 #include <cstddef>       // For size_t type, used for indexing.
 #include <chrono>        // For time-related consensus operations.
 #include <atomic>        // Atomic operations for thread-safe synchronization.
 #include <mutex>         // Mutex for locking shared resources.
+#include <array>         // Per-stage latency counters.
+#include <thread>        // Background bookkeeping thread.
 #include "../ledger/block.hpp"     // Block structure for consensus validation.
 #include "../network/p2p_protocol.hpp"  // P2P communication protocol.
+#include "../network/gossip.hpp"        // Inventory-based block propagation.
+#include "../network/event_loop.hpp"    // Task queue of the bookkeeping thread.
 #include "posyg_engine.hpp"        // Proof of Synergy consensus engine.
+#include "signature_collector.hpp" // Quorum collection of validator signatures.
+#include "reward_ledger.hpp"       // Per-round reward and slashing deltas.
 #include "../ledger/ledger.hpp"    // Ledger for block storage and validation.
 
+/**
+ * @enum ConsensusStage
+ * @brief The stages a block passes through, for latency accounting.
+ */
+enum class ConsensusStage {
+    PROPOSE = 0,      ///< Block template creation and validation.
+    VOTE = 1,         ///< Signature collection up to the quorum.
+    FINALIZE = 2,     ///< Applying and announcing the block.
+    BOOKKEEPING = 3,  ///< Slashing, rewards and parameter adjustment (off the critical path).
+};
+
+const size_t CONSENSUS_STAGE_COUNT = 4;  ///< Number of `ConsensusStage` values.
+
+/**
+ * @struct StageLatency
+ * @brief Accumulated wall-clock time of one stage.
+ */
+struct StageLatency {
+    size_t samples = 0;     ///< Measurements taken.
+    double total_ms = 0.0;  ///< Sum of all measurements.
+    double max_ms = 0.0;    ///< Slowest measurement.
+
+    double mean_ms() const { return samples == 0 ? 0.0 : total_ms / samples; }  ///< Average measurement.
+    void record(double ms);                                                      ///< Adds a measurement.
+};
+
 /**
  * @class Consensus
  * @brief Core class responsible for driving the consensus process in SynLedger.
@@ -38,21 +77,35 @@
  * to honest ones. It also ensures that network parameters can adapt dynamically over time.
  */
 class Consensus {
+public:
+    static const int MULTISIG_TIMEOUT_MS = 2000;  ///< How long a round waits for its signature quorum.
+
 protected:
     size_t num_validators;              ///< Total number of validators participating in consensus.
     std::vector<size_t> validators;     ///< List of validator IDs involved in the current round.
+    std::vector<std::string> validator_private_keys; ///< Signing keys of the locally simulated validators.
+    std::vector<std::string> validator_public_keys;  ///< Public keys by validator index.
     Block current_block;                ///< The current block under validation.
     P2PProtocol& p2p_network;           ///< Reference to the P2P communication protocol for validator coordination.
+    Gossip* gossip;                     ///< Block propagation, if attached.
     PoSygEngine& posyg_engine;          ///< Reference to the Proof of Synergy consensus engine.
     Ledger& ledger;                     ///< Reference to the Ledger for block finalization.
+    std::mutex ledger_mutex;            ///< Serializes proposals reading the mempool with finalized blocks committing.
     double slashing_penalty;            ///< Penalty for validators found to be malicious.
     double reward_for_validators;       ///< Reward for honest validators.
+    std::array<StageLatency, CONSENSUS_STAGE_COUNT> stage_latency; ///< Latency by stage; guarded by `stats_mutex`.
+    StageLatency block_latency;         ///< Proposal-to-finalization time of each block; guarded by `stats_mutex`.
+    mutable std::mutex stats_mutex;     ///< Guards the latency counters.
+    EventLoop bookkeeping_loop;         ///< Queue of post-round bookkeeping tasks.
+    std::thread bookkeeping_thread;     ///< Runs `bookkeeping_loop`.
+    RewardLedger reward_ledger;         ///< Deltas of the current bookkeeping round; owned by the bookkeeping thread.
 
     /**
      * @brief Slashes the given validator for malicious behavior.
      * 
      * Applies penalties to dishonest or malicious validators by reducing their Synergy Score 
-     * or potentially removing their validation privileges.
+     * or potentially removing their validation privileges. The slash is recorded in the reward ledger and takes
+     * effect when the round is committed. Safe to call from the threads of an OpenMP team.
      * 
      * @param validator_id The ID of the validator to be slashed.
      */
@@ -62,7 +115,7 @@ protected:
      * @brief Distributes rewards to honest validators.
      * 
      * After successful consensus, validators who participated honestly are rewarded 
-     * based on their contributions to the consensus round.
+     * based on their contributions to the consensus round. Rewards are credited when the round is committed.
      */
     void distribute_rewards();
 
@@ -70,11 +123,34 @@ protected:
      * @brief Handles multisignature verification for a block.
      * 
      * Ensures that the block has received sufficient validation signatures from the network's validators 
-     * before finalization, enhancing security.
+     * before finalization, enhancing security. Validators sign the block hash in parallel and submit to a
+     * `SignatureCollector` without any shared lock; collection stops at `required_signatures` valid signatures,
+     * which are then attached to the block in validator order.
+     * 
+     * @param block The block being validated by the network; receives the quorum signatures.
+     * @return True if the quorum was reached within `MULTISIG_TIMEOUT_MS`.
+     */
+    bool handle_multisig(Block& block);
+
+    /**
+     * @brief Creates a block on top of an arbitrary parent.
      * 
-     * @param block The block being validated by the network.
+     * @param block_number Height of the new block.
+     * @param previous_block_hash Hash of its parent, which need not be finalized yet.
+     * @param excluded Transactions already carried by blocks still in flight.
+     */
+    Block create_block(size_t block_number, const std::string& previous_block_hash,
+                       const std::unordered_set<Hash256, Hash256Hasher>& excluded);
+
+    /**
+     * @brief Queues slashing, reward distribution and parameter adjustment for the finished round.
+     */
+    void schedule_bookkeeping();
+
+    /**
+     * @brief Adds a measurement to a stage's latency counters.
      */
-    void handle_multisig(const Block& block);
+    void record_latency(ConsensusStage stage, double ms);
 
     /**
      * @brief Manages dynamic network adjustments.
@@ -101,7 +177,7 @@ public:
     /**
      * @brief Destructor for the Consensus class.
      * 
-     * Handles any necessary cleanup when the consensus object is destroyed.
+     * Handles any necessary cleanup when the consensus object is destroyed. Queued bookkeeping is completed first.
      */
     ~Consensus();
 
@@ -109,9 +185,40 @@ public:
      * @brief Initiates the consensus process.
      * 
      * Coordinates the validators to begin a new round of consensus, validating the next block in the chain.
+     * Returns once the block is finalized; the round's bookkeeping continues in the background.
      */
     void initiate_consensus();
 
+    /**
+     * @brief Runs consensus rounds as a three-stage pipeline.
+     * 
+     * At every step the next height is proposed, the previous proposal collects its votes and the block voted on
+     * before that is finalized, all concurrently, so a block's time is bounded by the slowest stage rather than
+     * by their sum. Proposals chain on the hash of their unfinalized parent and never repeat its transactions. If
+     * a block misses its quorum, the proposal built on it is discarded and the next one is built on its parent. If
+     * a finalized block cannot be committed because the ledger moved on, everything in flight is discarded and
+     * proposing resumes on the ledger's tip.
+     * 
+     * @param rounds Number of heights to propose.
+     * @return The number of blocks committed to the ledger.
+     */
+    size_t run_pipeline(size_t rounds);
+
+    /**
+     * @brief Blocks until all queued bookkeeping has run.
+     */
+    void flush_bookkeeping();
+
+    /**
+     * @brief Returns the latency counters of a stage.
+     */
+    StageLatency get_stage_latency(ConsensusStage stage) const;
+
+    /**
+     * @brief Returns the proposal-to-finalization latency of blocks.
+     */
+    StageLatency get_block_latency() const;
+
     /**
      * @brief Creates a new block for the blockchain.
      * 
@@ -134,19 +241,37 @@ public:
     /**
      * @brief Finalizes the block after successful consensus.
      * 
-     * Once consensus is achieved, the block is added to the ledger and made immutable.
+     * Once consensus is achieved, the block is added to the ledger, which also removes its transactions from the
+     * mempool, and made immutable. A block that no longer extends the ledger's tip, e.g. because another block
+     * was added meanwhile, is not committed. When a gossip layer is attached, a committed block is announced to
+     * the network by digest.
      * 
      * @param block The block to be finalized.
+     * @return true if the block was committed to the ledger.
      */
-    void finalize_block(const Block& block);
+    bool finalize_block(const Block& block);
+
+    /**
+     * @brief Attaches the gossip layer used to propagate finalized blocks.
+     * 
+     * @param gossip The gossip instance, or nullptr to stop propagating.
+     */
+    void set_gossip(Gossip* gossip);
 
     /**
      * @brief Validates and slashes dishonest validators.
      * 
      * Reviews the behavior of validators during the consensus process. If any malicious activity is detected, 
-     * the responsible validators are penalized through slashing.
+     * the responsible validators are penalized through slashing when the bookkeeping round is committed.
      */
     void validate_and_slash();
+
+    /**
+     * @brief Sets the receiver of each round's slashing events. Takes effect from the next bookkeeping round.
+     * 
+     * @param sink Called on the bookkeeping thread with the round's events, or empty to stop reporting.
+     */
+    void set_slashing_sink(SlashingSink sink);
 };
 
 #endif  // CONSENSUS_HPP
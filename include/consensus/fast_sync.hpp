@@ -0,0 +1,282 @@
+/**
+ * @file fast_sync.hpp
+ * @brief Chunked state snapshots and the fast sync that lets a new node start from one.
+ *
+ * This header defines the snapshot format and both ends of fast sync. A `SnapshotStore` periodically captures the
+ * ledger tip, the account state, the `PoSygEngine` state and the `SubnetManager` assignment, and cuts them into
+ * chunks of bounded size. A `SnapshotManifest` lists the chunks by content hash, so a joining node can fetch them
+ * from several peers at once and verify each one on arrival. `FastSync` accepts a manifest only if its block is a
+ * finalized block the node already trusts and the manifest is pinned by a trusted checkpoint or agreed on by a
+ * quorum of peers, downloads and checks the chunks, and rebuilds a ledger that starts at the snapshot block; only
+ * the blocks after it are then synced.
+ */
+
+#ifndef FAST_SYNC_HPP
+#define FAST_SYNC_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include "posyg_engine.hpp"
+#include "../ledger/ledger.hpp"
+#include "../subnet/subnet_manager.hpp"
+#include "../cryptography/hash256.hpp"
+
+/**
+ * @enum SnapshotSection
+ * @brief The part of the node state a chunk holds.
+ */
+enum class SnapshotSection : uint8_t {
+    ACCOUNTS = 1,      ///< Account balances and nonces, sorted by address.
+    ENGINE = 2,        ///< PoSyg dynamic parameters, seed, cycle and participant count.
+    PARTICIPANTS = 3,  ///< PoSyg participant rows, by id.
+    SUBNETS = 4        ///< Subnet members, by subnet and join order.
+};
+
+/**
+ * @struct SnapshotChunkInfo
+ * @brief Manifest entry of one chunk.
+ */
+struct SnapshotChunkInfo {
+    SnapshotSection section;  ///< State the chunk belongs to.
+    uint64_t first;           ///< Index of the chunk's first record within its section.
+    uint32_t records;         ///< Records in the chunk.
+    uint32_t size;            ///< Payload size in bytes.
+    Hash256 hash;             ///< SHA-256 of the payload; also the id under which peers serve it.
+};
+
+/**
+ * @struct SnapshotManifest
+ * @brief Names the block a snapshot follows and lists its chunks in restore order.
+ */
+struct SnapshotManifest {
+    uint64_t height = 0;                   ///< Height of the snapshot block.
+    Hash256 block_digest;                  ///< Digest of the snapshot block.
+    std::string block;                     ///< The serialized snapshot block, which becomes the joining node's tip.
+    std::vector<SnapshotChunkInfo> chunks; ///< Every chunk, grouped by section.
+
+    std::string serialize() const;
+
+    /**
+     * @throws std::runtime_error if the payload is truncated, has trailing bytes or an unknown format.
+     */
+    static SnapshotManifest deserialize(std::string_view payload);
+
+    /**
+     * @brief SHA-256 of the serialized manifest; peers offering the same snapshot offer the same digest.
+     */
+    Hash256 digest() const;
+};
+
+/**
+ * @struct NodeSnapshot
+ * @brief A manifest together with the payloads of its chunks.
+ */
+struct NodeSnapshot {
+    SnapshotManifest manifest;        ///< Chunk list.
+    std::vector<std::string> chunks;  ///< Payloads, in manifest order.
+};
+
+/**
+ * @brief Fetches a chunk by content hash from one peer.
+ *
+ * @return True if the peer returned a payload; it is verified by the caller.
+ */
+using SnapshotSource = std::function<bool(const Hash256& chunk_hash, std::string& payload)>;
+
+/**
+ * @class SnapshotStore
+ * @brief Takes periodic snapshots and serves their chunks.
+ *
+ * The previous snapshot is retained next to the latest one, so peers that started downloading it just before a
+ * new snapshot was taken can still finish. All methods are thread-safe.
+ */
+class SnapshotStore {
+public:
+    static const uint64_t DEFAULT_INTERVAL = 1000;         ///< Blocks between periodic snapshots.
+    static const size_t DEFAULT_CHUNK_BYTES = 256 * 1024;  ///< Target payload size of a chunk.
+    static const size_t RETAINED_SNAPSHOTS = 2;            ///< Snapshots whose chunks are served.
+
+    /**
+     * @param interval A snapshot is taken each time the tip reaches or passes a new multiple of this.
+     * @param chunk_bytes Target payload size; a chunk is closed once it reaches it.
+     */
+    explicit SnapshotStore(uint64_t interval = DEFAULT_INTERVAL, size_t chunk_bytes = DEFAULT_CHUNK_BYTES);
+
+    /**
+     * @brief Captures the node state after the ledger's tip.
+     *
+     * The caller must keep the ledger, the engine and the subnet manager from changing meanwhile, so that the
+     * three parts describe the same moment.
+     */
+    static NodeSnapshot create_snapshot(const Ledger& ledger, const PoSygEngine& engine, const SubnetManager& subnets,
+                                        size_t chunk_bytes = DEFAULT_CHUNK_BYTES);
+
+    /**
+     * @brief Takes and publishes a snapshot if the tip has reached a multiple of the interval not snapshotted yet.
+     *
+     * The snapshot is taken at the tip, so a multiple that several blocks added between calls skipped over is
+     * snapshotted at the first call past it.
+     *
+     * @return True if a snapshot was taken.
+     */
+    bool maybe_snapshot(const Ledger& ledger, const PoSygEngine& engine, const SubnetManager& subnets);
+
+    /**
+     * @brief Makes a snapshot the latest one, dropping the oldest retained snapshot if needed.
+     */
+    void publish(NodeSnapshot snapshot);
+
+    bool has_snapshot() const;  ///< Whether a snapshot has been published.
+
+    /**
+     * @brief Returns the manifest of the latest snapshot.
+     *
+     * @throws std::logic_error if no snapshot has been published.
+     */
+    SnapshotManifest get_manifest() const;
+
+    /**
+     * @brief Looks up a chunk of any retained snapshot by content hash.
+     *
+     * @return True if the chunk was found.
+     */
+    bool get_chunk(const Hash256& chunk_hash, std::string& payload) const;
+
+    /**
+     * @brief Returns a source that reads from this store, e.g. to serve requests or to sync a local node.
+     */
+    SnapshotSource source() const;
+
+private:
+    uint64_t interval;                                       ///< Blocks between snapshots.
+    size_t chunk_bytes;                                      ///< Target payload size.
+    uint64_t snapshotted_interval;                           ///< `height / interval` of the last periodic snapshot.
+    std::deque<std::shared_ptr<const NodeSnapshot>> retained; ///< Served snapshots, latest last.
+    std::unordered_map<Hash256, const std::string*, Hash256Hasher> chunk_index; ///< Payloads of `retained`.
+    mutable std::mutex store_mutex;                          ///< Guards the snapshots and `snapshotted_interval`.
+};
+
+/**
+ * @struct SnapshotOffer
+ * @brief A manifest as offered by one peer.
+ */
+struct SnapshotOffer {
+    size_t peer;                ///< Offering peer; each peer counts at most once towards the quorum.
+    SnapshotManifest manifest;  ///< The offered manifest.
+};
+
+/**
+ * @struct FastSyncStats
+ * @brief Outcome of the chunk downloads of a fast sync.
+ */
+struct FastSyncStats {
+    size_t chunks_verified;   ///< Chunks whose content hash matched.
+    size_t chunks_rejected;   ///< Payloads discarded because their hash, size or header did not match.
+    size_t chunks_missing;    ///< Chunks no source could provide.
+    uint64_t bytes_received;  ///< Payload bytes of verified chunks.
+};
+
+/**
+ * @class FastSync
+ * @brief Brings a new node to a recent state from a snapshot instead of replaying the whole chain.
+ *
+ * Trust model: block headers do not commit to the state, so finality covers only the snapshot block, not the
+ * accounts, PoSyg rows and subnets. Unless the manifest digest itself is known from a trusted checkpoint (see
+ * `set_trusted_manifest`), the state is trusted on peer agreement: `accept_manifest` requires a quorum of at least
+ * `MIN_QUORUM` distinct peers offering the identical manifest, and a peer offering different manifests is ignored.
+ * A colluding quorum can therefore still choose the joining node's state. From there on every chunk is checked
+ * against its hash in the manifest, so a chunk from a faulty peer is discarded and fetched from another one.
+ */
+class FastSync {
+public:
+    /**
+     * @param finalized_block Digest of a finalized block the node trusts, e.g. confirmed by its validators.
+     */
+    explicit FastSync(const Hash256& finalized_block);
+
+    static const size_t MIN_QUORUM = 2;  ///< Fewest distinct peers that must agree on an untrusted manifest.
+
+    /**
+     * @brief Pins the manifest digest, e.g. from a checkpoint signed by the validators or shipped with the node.
+     *
+     * Afterwards only that manifest is accepted, and a single offer of it suffices.
+     */
+    void set_trusted_manifest(const Hash256& manifest_digest);
+
+    /**
+     * @brief Picks the manifest to sync to from the offers of different peers.
+     *
+     * An offer counts only if its snapshot block is well-formed and is the finalized block. Without a trusted
+     * manifest digest, the first manifest offered identically by at least `quorum` distinct peers is chosen.
+     *
+     * @param quorum Distinct peers that must agree; ignored when a trusted manifest digest is set.
+     * @return True if a manifest was accepted.
+     * @throws std::invalid_argument if `quorum` is below `MIN_QUORUM` and no trusted digest is set.
+     */
+    bool accept_manifest(const std::vector<SnapshotOffer>& offers, size_t quorum);
+
+    /**
+     * @brief Returns the accepted manifest.
+     *
+     * @throws std::logic_error if no manifest has been accepted.
+     */
+    const SnapshotManifest& get_manifest() const;
+
+    /**
+     * @brief Downloads and verifies the chunks still missing, spreading them over the sources.
+     *
+     * Worker `w` asks source `w % sources.size()` first and falls back to the others in turn, so every source
+     * serves a share of the chunks in parallel. May be called again, e.g. with new peers, to fetch the chunks
+     * that could not be obtained.
+     *
+     * @param sources One source per peer.
+     * @param num_threads Concurrent downloads; 0 uses one per source.
+     * @return True if every chunk is verified.
+     * @throws std::logic_error if no manifest has been accepted.
+     */
+    bool download(const std::vector<SnapshotSource>& sources, int num_threads = 0);
+
+    bool is_complete() const;         ///< Whether every chunk is verified.
+    FastSyncStats get_stats() const;  ///< Download counters accumulated over all calls.
+
+    /**
+     * @brief Restores the snapshot into the engine and the subnet manager and builds the ledger.
+     *
+     * The returned ledger starts at the snapshot block; blocks after it are added with `Ledger::add_block`.
+     *
+     * @param initial_difficulty Difficulty of the new ledger.
+     * @throws std::logic_error if the download is not complete.
+     * @throws std::runtime_error if a chunk does not decode or the sections are inconsistent; all checks are made
+     *         before anything is restored, so the engine and the subnet manager are then left unchanged.
+     */
+    std::unique_ptr<Ledger> restore(size_t initial_difficulty, PoSygEngine& engine, SubnetManager& subnets) const;
+
+private:
+    Hash256 finalized_block;          ///< Block the snapshot must follow.
+    bool has_trusted_manifest;        ///< Whether `trusted_manifest` pins the manifest.
+    Hash256 trusted_manifest;         ///< Digest of the only acceptable manifest, if pinned.
+    bool accepted;                    ///< Whether `manifest` holds an accepted manifest.
+    SnapshotManifest manifest;        ///< Accepted manifest.
+    std::vector<std::string> chunks;  ///< Verified payloads, in manifest order.
+    std::vector<uint8_t> verified;    ///< Whether each chunk is verified.
+    FastSyncStats stats;              ///< Download counters.
+};
+
+#endif  // FAST_SYNC_HPP
+
+/**
+ * @file fast_sync.hpp
+ *
+ * A new node that replays the chain from genesis spends time proportional to the whole history before it can take
+ * part, and the one peer it syncs from sets the pace. A snapshot bounds the work by the size of the current state,
+ * content-addressed chunks let any number of peers share the transfer without the node trusting any one of them,
+ * and binding the snapshot to a finalized block keeps the node on the chain it would have reached by replaying.
+ */
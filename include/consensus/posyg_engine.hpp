@@ -13,6 +13,8 @@
 
 #include <vector>        // For storing and managing participants in the consensus.
 #include <cstddef>       // For size_t types used for participant IDs.
+#include <cstdint>       // For the packed slashed bitset.
+#include <memory>        // For shared synergy snapshots.
 
 // Constants defining participant behaviors and economic incentives.
 #define PARTICIPANT_HONEST 1
@@ -26,46 +28,107 @@ const double SLASH_PENALTY = 100.0;          ///< Penalty applied when a partici
 const double INITIAL_RESTORE_SYNERGY = 50.0; ///< Synergy restored after a participant is slashed.
 const int MAX_ECONOMIC_ACTIVITY = 10;        ///< Maximum allowed economic activity for a participant.
 
+/**
+ * @struct ParticipantTable
+ * @brief Structure-of-arrays storage of all participants.
+ *
+ * Every field of a participant lives in its own contiguous column indexed by participant id, so a pass that reads
+ * one or two fields streams only those columns through the cache and vectorizes. The slashed flags are packed 64
+ * to a word; per-cycle kernels process whole words, so that threads never share a word.
+ */
+struct ParticipantTable {
+    std::vector<double> synergy;                ///< Current synergy score of each participant.
+    std::vector<double> reward;                 ///< Accumulated rewards based on honest activity.
+    std::vector<double> penalty;                ///< Penalty incurred for dishonest actions.
+    std::vector<double> economic_contribution;  ///< Contribution to the economic health of the network.
+    std::vector<int> violations_count;          ///< Number of violations.
+    std::vector<int> economic_activity;         ///< Level of economic activity.
+    std::vector<int> governance_activity;       ///< Involvement in governance activities.
+    std::vector<uint8_t> behavior;              ///< PARTICIPANT_HONEST or PARTICIPANT_DISHONEST.
+    std::vector<uint64_t> slashed;              ///< Bit `i % 64` of word `i / 64` is set if participant `i` is slashed.
+
+    /**
+     * @brief Creates `count` honest participants with default scores.
+     */
+    explicit ParticipantTable(size_t count = 0);
+
+    size_t size() const { return synergy.size(); }        ///< Number of participants.
+    size_t word_count() const { return slashed.size(); }  ///< Number of words in the slashed bitset.
+
+    /**
+     * @brief The rule of `Participant::detect_suspicious_behavior`, read from the columns.
+     */
+    bool is_suspicious(size_t index) const { return economic_activity[index] > 4 && governance_activity[index] > 2; }
+
+    /**
+     * @brief Returns whether a participant is slashed. Safe against concurrent `set_slashed` calls.
+     */
+    bool is_slashed(size_t index) const {
+        return (__atomic_load_n(&slashed[index / 64], __ATOMIC_RELAXED) >> (index % 64)) & 1;
+    }
+
+    /**
+     * @brief Sets or clears a participant's slashed flag atomically, so handles of participants that share a
+     *        word may be updated from different threads.
+     */
+    void set_slashed(size_t index, bool value) {
+        const uint64_t mask = uint64_t(1) << (index % 64);
+        if (value) {
+            __atomic_fetch_or(&slashed[index / 64], mask, __ATOMIC_RELAXED);
+        } else {
+            __atomic_fetch_and(&slashed[index / 64], ~mask, __ATOMIC_RELAXED);
+        }
+    }
+};
+
+/**
+ * @class SlashedFlag
+ * @brief Reference-like view of one bit of `ParticipantTable::slashed`.
+ */
+class SlashedFlag {
+public:
+    SlashedFlag(ParticipantTable& table, size_t index) : table(&table), index(index) {}
+
+    operator bool() const { return table->is_slashed(index); }
+    SlashedFlag& operator=(bool value) {
+        table->set_slashed(index, value);
+        return *this;
+    }
+
+private:
+    ParticipantTable* table;  ///< The table holding the bit.
+    size_t index;             ///< Participant whose bit this is.
+};
+
 /**
  * @struct Participant
  * @brief Represents an individual validator or participant in the PoSyg consensus process.
  *
- * The Participant struct stores data related to individual participants, including synergy, rewards, 
- * penalties, behavior, and governance activity. It manages functions like synergy updates, detection of 
- * malicious behavior, and the slashing mechanism that penalizes dishonest participants.
+ * The Participant struct is a handle onto one row of the `ParticipantTable`: its fields are references into the
+ * table's columns, so reading and writing them reads and writes the table. It manages functions like synergy
+ * updates, detection of malicious behavior, and the slashing mechanism that penalizes dishonest participants.
+ * A handle is cheap to copy and stays valid as long as the table is not resized.
  */
 struct Participant {
     size_t id;                        ///< Unique ID for the participant.
-    double synergy;                   ///< Current synergy score of the participant.
-    double reward;                    ///< Accumulated rewards based on honest activity.
-    double penalty;                   ///< Penalty incurred for dishonest actions.
-    int violations_count;             ///< Number of violations by the participant.
-    int behavior;                     ///< Current behavior: PARTICIPANT_HONEST or PARTICIPANT_DISHONEST.
-    int economic_activity;            ///< Participant's level of economic activity.
-    int governance_activity;          ///< Participant's involvement in governance activities.
-    bool slashed;                     ///< Whether the participant has been slashed for misconduct.
-    double economic_contribution;     ///< Participant's contribution to the economic health of the network.
+    double& synergy;                  ///< Current synergy score of the participant.
+    double& reward;                   ///< Accumulated rewards based on honest activity.
+    double& penalty;                  ///< Penalty incurred for dishonest actions.
+    int& violations_count;            ///< Number of violations by the participant.
+    uint8_t& behavior;                ///< Current behavior: PARTICIPANT_HONEST or PARTICIPANT_DISHONEST.
+    int& economic_activity;           ///< Participant's level of economic activity.
+    int& governance_activity;         ///< Participant's involvement in governance activities.
+    SlashedFlag slashed;              ///< Whether the participant has been slashed for misconduct.
+    double& economic_contribution;    ///< Participant's contribution to the economic health of the network.
 
     /**
-     * @brief Constructor for a default participant.
-     * Initializes a participant with default synergy, no penalties or rewards, and an honest behavior.
+     * @brief Binds a handle to row `id` of a table.
      */
-    Participant() 
-        : id(0), synergy(INITIAL_SYNERGY), reward(0.0), penalty(0.0), 
-          violations_count(0), behavior(PARTICIPANT_HONEST), economic_activity(1),
-          governance_activity(1), slashed(false), economic_contribution(0.0) {}
-
-    /**
-     * @brief Constructor for a participant with a specified ID and behavior.
-     * Initializes a participant with the provided ID and behavior status.
-     * 
-     * @param id Participant's unique ID.
-     * @param behavior Participant's initial behavior (honest or dishonest).
-     */
-    Participant(size_t id, int behavior)
-        : id(id), synergy(INITIAL_SYNERGY), reward(0.0), penalty(0.0),
-          violations_count(0), behavior(behavior), economic_activity(1),
-          governance_activity(1), slashed(false), economic_contribution(0.0) {}
+    Participant(ParticipantTable& table, size_t id)
+        : id(id), synergy(table.synergy[id]), reward(table.reward[id]), penalty(table.penalty[id]),
+          violations_count(table.violations_count[id]), behavior(table.behavior[id]),
+          economic_activity(table.economic_activity[id]), governance_activity(table.governance_activity[id]),
+          slashed(table, id), economic_contribution(table.economic_contribution[id]) {}
 
     void update_synergy();                     ///< Updates the participant's synergy score.
     bool detect_suspicious_behavior();         ///< Detects if the participant is engaging in malicious activities.
@@ -74,6 +137,40 @@ struct Participant {
     void update_economic_activity(double contribution); ///< Updates the participant's economic activity score.
 };
 
+/**
+ * @struct SynergySnapshot
+ * @brief Immutable copy of the vote-relevant participant columns as of the end of one cycle.
+ *
+ * Snapshots are published by the engine and shared by reference count; readers never see one change.
+ */
+struct SynergySnapshot {
+    uint64_t epoch = 0;              ///< Number of cycles completed when the snapshot was taken.
+    std::vector<double> synergy;     ///< Synergy of each participant.
+    std::vector<uint64_t> slashed;   ///< Slashed flags, packed as in `ParticipantTable::slashed`.
+
+    size_t size() const { return synergy.size(); }  ///< Number of participants.
+    bool is_slashed(size_t index) const { return (slashed[index / 64] >> (index % 64)) & 1; }  ///< Slashed flag.
+};
+
+/**
+ * @struct PoSygCheckpoint
+ * @brief Complete engine state between cycles, from which another engine continues identically.
+ *
+ * Behaviors are drawn from streams keyed on the seed and indexed by cycle, so restoring the seed and cycle
+ * together with the table and the dynamic parameters reproduces every later cycle.
+ */
+struct PoSygCheckpoint {
+    ParticipantTable participants;     ///< Columns of every participant.
+    double dynamic_synergy_gain;       ///< Synergy gain based on network conditions.
+    double dynamic_penalty_increment;  ///< Increment for penalties based on network health.
+    double dynamic_conversion_rate;    ///< Conversion rate for synergy-to-token conversions.
+    double slash_penalty;              ///< Penalty applied for slashing a participant.
+    double total_economic_activity;    ///< Total economic activity in the network.
+    uint64_t seed;                     ///< Key of the per-participant behavior streams.
+    uint64_t cycle;                    ///< Number of cycles run so far.
+    uint64_t honest_count;             ///< Honest participants at the end of the last cycle.
+};
+
 /**
  * @struct Stats
  * @brief Aggregates statistics about the consensus process.
@@ -101,16 +198,55 @@ struct Stats {
 class PoSygEngine {
 private:
     size_t num_participants;                      ///< Total number of participants in the network.
-    std::vector<Participant> participants;        ///< List of all participants in the network.
+    ParticipantTable participants;                ///< Columns of all participants in the network.
     double dynamic_synergy_gain;                  ///< Synergy gain based on network conditions.
     double dynamic_penalty_increment;             ///< Increment for penalties based on network health.
     double dynamic_conversion_rate;               ///< Conversion rate for synergy-to-token conversions.
     double slash_penalty;                         ///< Penalty applied for slashing a participant.
     double total_economic_activity;               ///< Total economic activity in the network.
+    uint64_t seed;                                ///< Key of the per-participant behavior streams.
+    uint64_t cycle;                               ///< Number of cycles run so far.
+    size_t honest_count;                          ///< Honest participants at the end of the last cycle.
+    std::vector<double> synergy_partials;         ///< Per-word synergy sums of the current cycle.
+    std::shared_ptr<const SynergySnapshot> published; ///< Latest snapshot; accessed with the atomic shared_ptr functions.
+    std::shared_ptr<SynergySnapshot> current_snapshot; ///< Writable alias of `published`.
+    std::shared_ptr<SynergySnapshot> spare_snapshot;   ///< Previous snapshot, reused once no reader holds it.
 
     void adjust_network_parameters();             ///< Adjusts network parameters dynamically based on conditions.
     void process_slashing();                      ///< Processes slashing for all dishonest participants.
-    void distribute_rewards();                    ///< Distributes rewards to honest participants.
+
+    /**
+     * @brief First pass of a cycle: draws behaviors, updates synergy, slashes and counts, all in one sweep.
+     * 
+     * The updated synergy and slashed columns are also written to `snapshot`.
+     * 
+     * @return The synergy of all participants that are not slashed, summed in a fixed order.
+     */
+    double update_participants(SynergySnapshot& snapshot);
+
+    /**
+     * @brief Returns a snapshot buffer to fill: the spare one if no reader holds it any more, otherwise a new one.
+     */
+    SynergySnapshot& acquire_snapshot();
+
+    /**
+     * @brief Publishes the buffer returned by `acquire_snapshot`, filling it from the table first if `copy` is set.
+     */
+    void publish_snapshot(bool copy);
+
+    /**
+     * @brief Second pass of a cycle: distributes `total_economic_activity` in proportion to synergy.
+     */
+    void distribute_rewards(double total_synergy);
+
+    /**
+     * @brief Converts the synergy of every participant that is not slashed through the batch `SynergyModel` kernel.
+     * 
+     * @param conversion_rate Tokens per unit of synergy.
+     * @param balances If not null, each participant's tokens are added to its entry.
+     * @return The tokens converted, summed in a fixed order.
+     */
+    double convert_in_chunks(double conversion_rate, double* balances) const;
 
 public:
     /**
@@ -122,6 +258,17 @@ public:
      */
     PoSygEngine(size_t num_participants);
 
+    /**
+     * @brief Constructs an engine whose cycles are replayable.
+     * 
+     * Two engines with the same participants and seed produce bit-identical states after every cycle, whatever
+     * the number of OpenMP threads each of them uses.
+     * 
+     * @param num_participants Number of participants in the network.
+     * @param seed Key of the behavior random streams.
+     */
+    PoSygEngine(size_t num_participants, uint64_t seed);
+
     /**
      * @brief Destructor for the PoSygEngine.
      */
@@ -131,11 +278,17 @@ public:
      * @brief Runs a single consensus cycle.
      * 
      * Simulates one full round of the consensus process, updating participant states and ensuring security.
+     * The cycle makes two passes over the participants: one fused update of behavior, synergy, slashing and
+     * statistics, then the reward distribution. Each participant's behavior comes from a counter-based Philox
+     * stream keyed on the seed and indexed by cycle and participant id, so no generator state is shared.
      * 
      * @return An integer representing the result of the cycle.
      */
     int run_cycle();
 
+    uint64_t get_seed() const { return seed; }    ///< Key of the behavior streams.
+    uint64_t get_cycle() const { return cycle; }  ///< Number of cycles run so far.
+
     /**
      * @brief Retrieves network statistics.
      * 
@@ -161,9 +314,59 @@ public:
      * Provides access to a participant's data based on their unique ID.
      * 
      * @param participant_id The ID of the participant.
-     * @return Reference to the requested Participant.
+     * @return A handle whose fields refer to the participant's row of the table.
+     * @throws std::out_of_range if there is no such participant.
+     */
+    Participant get_participant(size_t participant_id);
+
+    /**
+     * @brief Returns the synergy snapshot of the most recent cycle.
+     * 
+     * Safe to call from any thread, including while `run_cycle` runs: the cycle fills a separate buffer and
+     * publishes it atomically when it completes. Changes made through participant handles between cycles show
+     * up in the next snapshot, or after `refresh_synergy_snapshot`.
+     */
+    std::shared_ptr<const SynergySnapshot> get_synergy_snapshot() const;
+
+    /**
+     * @brief Publishes a snapshot of the current table, e.g. after slashing participants through handles.
+     * 
+     * Must not run concurrently with `run_cycle` or other writers of the table.
+     */
+    void refresh_synergy_snapshot();
+
+    /**
+     * @brief Retrieves the participant columns, for passes over every participant.
+     */
+    const ParticipantTable& get_participants() const { return participants; }
+
+    /**
+     * @brief Adds reward and penalty deltas to the first `count` participants and slashes the flagged ones.
+     * 
+     * Slashing follows `Participant::apply_slash`. The synergy snapshot is republished afterwards.
+     * 
+     * @param reward Reward delta of each participant.
+     * @param penalty Penalty delta of each participant.
+     * @param slashes Bitset of participants to slash; on return only the bits of participants that were not
+     *        already slashed remain set.
+     * @param count Number of participants covered by the deltas.
+     * @throws std::out_of_range if `count` exceeds the number of participants.
+     */
+    void apply_deltas(const double* reward, const double* penalty, uint64_t* slashes, size_t count);
+
+    /**
+     * @brief Captures the engine state, e.g. for a state snapshot. Must not run concurrently with `run_cycle`.
+     */
+    PoSygCheckpoint get_checkpoint() const;
+
+    /**
+     * @brief Replaces the engine state with a checkpoint, possibly of a different number of participants.
+     * 
+     * The synergy snapshot is republished afterwards. Must not run concurrently with `run_cycle` or other writers.
+     * 
+     * @throws std::invalid_argument if the checkpoint's columns differ in length.
      */
-    Participant& get_participant(size_t participant_id);
+    void restore_checkpoint(const PoSygCheckpoint& checkpoint);
 
     /**
      * @brief Applies the slashing mechanism across the network.
@@ -181,4 +384,6 @@ public:
  * This module is a cornerstone of the PoSyg consensus, balancing incentives and penalties to maintain network integrity. 
  * It dynamically adjusts network conditions based on behavior and contributions, leveraging cryptographic slashing and rewards 
  * to enforce honesty and resilience. The use of adaptive parameters ensures that the network is secure, scalable, and fair under varying conditions.
+ * Participants are stored by column because each per-cycle pass reads only a few fields of every participant; with
+ * millions of them the passes are bound by memory bandwidth, not arithmetic.
  */
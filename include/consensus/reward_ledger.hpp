@@ -0,0 +1,122 @@
+/**
+ * @file reward_ledger.hpp
+ * @brief Per-thread accumulation of validator rewards, penalties and slashes, committed once per round.
+ *
+ * This header defines the `RewardLedger` class, which collects the bookkeeping of a consensus round without
+ * touching the `PoSygEngine` while the round's parallel passes run. Every OpenMP thread records its rewards,
+ * penalties and slashes in its own buffer; `commit()` merges the buffers in thread order, applies the result to
+ * the engine's columns in one vectorized pass and hands the round's slashing events to a sink as a single batch.
+ */
+
+#ifndef REWARD_LEDGER_HPP
+#define REWARD_LEDGER_HPP
+
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+#include "posyg_engine.hpp"
+
+/**
+ * @enum SlashReason
+ * @brief Why a participant was slashed.
+ */
+enum class SlashReason {
+    SUSPICIOUS_BEHAVIOR = 0,  ///< Activity pattern flagged by `Participant::detect_suspicious_behavior`.
+};
+
+/**
+ * @struct SlashingEvent
+ * @brief One participant slashed in one round.
+ */
+struct SlashingEvent {
+    uint64_t round;         ///< Bookkeeping round that committed the slash.
+    size_t participant_id;  ///< The slashed participant.
+    double penalty;         ///< Penalty charged by the slash.
+    SlashReason reason;     ///< What triggered it.
+};
+
+/**
+ * @brief Receives the slashing events of a round, ordered by participant id. Called on the committing thread.
+ */
+using SlashingSink = std::function<void(const std::vector<SlashingEvent>& events)>;
+
+/**
+ * @class RewardLedger
+ * @brief Lock-free reward and slashing deltas for the participants `[0, participant_count)`.
+ *
+ * `credit`, `penalize` and `slash` may be called concurrently from the threads of an OpenMP team, since each thread
+ * writes only its own buffer; they must not run concurrently with `commit`. They never throw, so that they are safe
+ * inside a parallel region: the caller checks the ids with `require_tracked` beforehand and caps the team at
+ * `get_thread_capacity()` threads. A participant slashed by several threads, or already slashed in the engine, is
+ * slashed and reported at most once.
+ */
+class RewardLedger {
+public:
+    /**
+     * @brief Creates empty buffers for the threads of the widest OpenMP team.
+     *
+     * @param participant_count Number of participants whose deltas are tracked, starting at id 0.
+     */
+    explicit RewardLedger(size_t participant_count);
+
+    void credit(size_t participant_id, double amount);    ///< Adds to a participant's reward for this round.
+    void penalize(size_t participant_id, double amount);  ///< Adds to a participant's penalty for this round.
+    void slash(size_t participant_id, SlashReason reason); ///< Marks a participant to be slashed at commit.
+
+    /**
+     * @brief Checks, before a parallel pass, that every id it will record is tracked.
+     *
+     * @throws std::out_of_range naming the first untracked id.
+     */
+    void require_tracked(const std::vector<size_t>& participant_ids) const;
+
+    /**
+     * @brief Returns the widest OpenMP team the buffers cover, to be passed as `num_threads` of a parallel pass.
+     */
+    int get_thread_capacity() const { return static_cast<int>(buffers.size()); }
+
+    /**
+     * @brief Applies the round's deltas to the engine, reports its slashes and clears the buffers.
+     *
+     * @param engine The engine holding the participants.
+     * @return The number of participants newly slashed.
+     */
+    size_t commit(PoSygEngine& engine);
+
+    /**
+     * @brief Sets the receiver of slashing events; without one, events are only counted.
+     */
+    void set_slashing_sink(SlashingSink sink);
+
+    uint64_t get_round() const { return round; }                 ///< Rounds committed so far.
+    size_t get_slashed_count() const { return slashed_count; }   ///< Participants slashed over all rounds.
+
+private:
+    struct ThreadBuffer {
+        std::vector<double> reward;      ///< Reward deltas by participant.
+        std::vector<double> penalty;     ///< Penalty deltas by participant.
+        std::vector<uint64_t> slashes;   ///< Participants to slash, as a bitset.
+        std::vector<SlashReason> reasons; ///< Reason recorded with each slash.
+        bool dirty = false;              ///< Whether anything was recorded since the last commit.
+    };
+
+    size_t participant_count;             ///< Tracked participants.
+    std::vector<ThreadBuffer> buffers;    ///< One buffer per OpenMP thread.
+    SlashingSink sink;                    ///< Receiver of slashing events.
+    uint64_t round;                       ///< Rounds committed so far.
+    size_t slashed_count;                 ///< Participants slashed over all rounds.
+
+    ThreadBuffer& local(size_t participant_id);  ///< The calling thread's buffer; the id and team width are asserted.
+};
+
+#endif  // REWARD_LEDGER_HPP
+
+/**
+ * @file reward_ledger.hpp
+ *
+ * Writing rewards through participant handles from a parallel loop gives every validator's row to whichever thread
+ * gets there first and makes each slash a point of contention on the console. Buffering the deltas per thread keeps
+ * the parallel pass free of shared writes, and committing them in one pass makes the round's effect on the engine
+ * atomic from the point of view of everything that runs between rounds.
+ */
@@ -0,0 +1,184 @@
+/**
+ * @file sharded_execution.hpp
+ * @brief Subnet-sharded transaction execution with a beacon chain over the shard headers.
+ *
+ * This header defines the `ShardedExecutor` class, which partitions the account space across the subnets of a
+ * `SubnetManager`. Each shard verifies, orders and executes the transactions sent by its own accounts against its
+ * own `StateDB`, and all shards of a round run in parallel. A transfer to an account of another shard debits the
+ * sender locally and emits a `CrossShardReceipt`; the receipt is relayed to the target shard once the round is
+ * finalized and credited there in the next round. Finalization happens at the beacon level: the beacon validators
+ * sign a `BeaconBlock` that commits to every shard's header, and a round without a signature quorum is rolled back.
+ */
+
+#ifndef SHARDED_EXECUTION_HPP
+#define SHARDED_EXECUTION_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+#include "../cryptography/hash256.hpp"
+#include "../cryptography/signature_verifier.hpp"
+#include "../ledger/block.hpp"
+#include "../ledger/state_db.hpp"
+#include "../subnet/subnet_manager.hpp"
+
+/**
+ * @struct CrossShardReceipt
+ * @brief Proof that a shard debited a sender for an account that lives in another shard.
+ */
+struct CrossShardReceipt {
+    size_t source_shard;     ///< Shard that executed the transaction.
+    size_t target_shard;     ///< Shard that owns the receiver.
+    uint64_t source_height;  ///< Height of the source shard's header that emitted the receipt.
+    Hash256 tx_id;           ///< Hash of the originating transaction.
+    std::string receiver;    ///< Account credited by the target shard.
+    double amount;           ///< Credited amount.
+
+    /**
+     * @brief Hashes the receipt; the leaves of a header's receipts root.
+     */
+    Hash256 hash() const;
+};
+
+/**
+ * @struct ShardHeader
+ * @brief Summary of one shard's round, finalized by the beacon chain.
+ */
+struct ShardHeader {
+    size_t shard_id;            ///< The shard.
+    uint64_t height;            ///< Round number within the shard, starting at 1.
+    Hash256 previous_digest;    ///< Digest of the shard's previous header (zero at height 1).
+    Hash256 transactions_root;  ///< Merkle root of the executed transactions.
+    Hash256 receipts_root;      ///< Merkle root of the outgoing receipts.
+    size_t transaction_count;   ///< Transactions executed.
+    size_t rejected_count;      ///< Transactions dropped for an invalid signature.
+    size_t outgoing_receipts;   ///< Receipts emitted for other shards.
+    size_t incoming_receipts;   ///< Receipts from other shards credited in this round.
+
+    /**
+     * @brief Hashes every field of the header.
+     */
+    Hash256 digest() const;
+};
+
+/**
+ * @struct BeaconBlock
+ * @brief One finalized round: the headers of all shards and the beacon validators' signatures on them.
+ */
+struct BeaconBlock {
+    uint64_t height;                      ///< Position in the beacon chain, starting at 1.
+    Hash256 previous_digest;              ///< Digest of the previous beacon block (zero at height 1).
+    std::vector<ShardHeader> headers;     ///< One header per shard, in shard order.
+    std::vector<std::string> signatures;  ///< Quorum signatures over `digest()`, in validator order.
+    VerificationBitmap signers;           ///< Validators whose signatures are in `signatures`.
+
+    /**
+     * @brief Hashes the height, the previous digest and the digest of every header (not the signatures).
+     */
+    Hash256 digest() const;
+};
+
+/**
+ * @class ShardedExecutor
+ * @brief Executes transactions in one shard per subnet and finalizes the rounds on a beacon chain.
+ *
+ * Accounts are assigned to shards by a hash of the address, so every node routes a transaction to the same shard
+ * without a lookup. Value in flight between shards is held by relay accounts: the source shard moves the amount
+ * from the sender to `relay:<target>`, and the target shard moves it from `relay:<source>` to the receiver, so the
+ * sum of all balances over all shards never changes. `submit()` may be called from any thread; `run_round()` and
+ * the accessors are called from the thread driving the rounds.
+ */
+class ShardedExecutor {
+public:
+    static const int BEACON_TIMEOUT_MS = 2000;  ///< Time the beacon validators have to reach the quorum.
+
+    /**
+     * @brief Creates one empty shard per subnet and a beacon validator set with fresh keys.
+     *
+     * @param subnets The subnet layout; the executor runs one shard per subnet.
+     * @param beacon_validators Number of beacon validators.
+     * @param required_signatures Signatures needed to finalize a round.
+     * @param num_threads Threads executing shards in parallel; 0 uses the OpenMP default.
+     * @throws std::invalid_argument if the quorum is zero or larger than the validator set.
+     */
+    ShardedExecutor(const SubnetManager& subnets, size_t beacon_validators, size_t required_signatures,
+                    int num_threads = 0);
+
+    /**
+     * @brief Returns the shard that owns an account.
+     */
+    size_t shard_of(const std::string& address) const;
+
+    /**
+     * @brief Queues a transaction on the shard of its sender.
+     */
+    void submit(const Transaction& tx);
+
+    /**
+     * @brief Executes the queued transactions and incoming receipts of every shard and finalizes the round.
+     *
+     * @return True if the beacon block reached its quorum. Otherwise every shard is rolled back and the round's
+     *         transactions and receipts are queued again.
+     */
+    bool run_round();
+
+    /**
+     * @brief Returns the committed state of an account from the shard that owns it.
+     */
+    AccountState get_account(const std::string& address) const;
+
+    /**
+     * @brief Returns the committed state of one shard, including its relay accounts.
+     * @throws std::out_of_range if the shard does not exist.
+     */
+    std::shared_ptr<const StateSnapshot> get_shard_state(size_t shard_id) const;
+
+    const std::vector<BeaconBlock>& get_beacon_chain() const { return beacon_chain; }  ///< Finalized rounds.
+    size_t get_shard_count() const { return shards.size(); }                          ///< Number of shards.
+    size_t get_pending_receipts() const;  ///< Receipts waiting to be credited in the next round.
+
+private:
+    struct Shard {
+        StateDB state;                              ///< Accounts owned by the shard and its relay accounts.
+        std::mutex pending_mutex;                   ///< Guards `pending`.
+        std::vector<Transaction> pending;           ///< Submitted, not yet executed transactions.
+        std::vector<CrossShardReceipt> inbox;       ///< Finalized receipts to credit in the next round.
+        uint64_t height = 0;                        ///< Height of the last finalized header.
+        Hash256 last_digest;                        ///< Digest of the last finalized header.
+
+        Shard() : state(StateDB::DEFAULT_SHARD_COUNT, 1) {}
+    };
+
+    struct RoundOutput {
+        std::vector<Transaction> executed;          ///< Transactions taken from `pending`.
+        std::vector<CrossShardReceipt> credited;    ///< Receipts taken from `inbox`.
+        std::vector<CrossShardReceipt> outbox;      ///< Receipts emitted for other shards.
+        std::shared_ptr<const StateSnapshot> before; ///< State to restore if the round is not finalized.
+        ShardHeader header;                         ///< The shard's header for the round.
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;     ///< One shard per subnet.
+    std::vector<std::string> relay_accounts;        ///< `relay:<shard>` for every shard.
+    std::vector<std::string> validator_private_keys; ///< Beacon validator signing keys.
+    std::vector<std::string> validator_public_keys;  ///< Beacon validator public keys.
+    size_t required_signatures;                     ///< Beacon quorum.
+    int num_threads;                                ///< Shard execution threads.
+    std::vector<BeaconBlock> beacon_chain;          ///< Finalized rounds.
+
+    void execute_shard(size_t shard_id, RoundOutput& output);
+    bool finalize_beacon(BeaconBlock& block);
+};
+
+#endif  // SHARDED_EXECUTION_HPP
+
+/**
+ * @file sharded_execution.hpp
+ *
+ * A single state machine caps throughput at what one execution pipeline can verify and apply, no matter how many
+ * subnets the network has. Giving every subnet its own slice of the accounts lets rounds execute in parallel and
+ * keeps each shard's work proportional to its own traffic; the beacon chain only orders fixed-size headers, and
+ * cross-shard value moves as receipts that cost one extra round of latency instead of a global lock.
+ */
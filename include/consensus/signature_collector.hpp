@@ -0,0 +1,133 @@
+/**
+ * @file signature_collector.hpp
+ * @brief Lock-free accumulator of validator signatures on a block.
+ *
+ * This header defines the `SignatureCollector` class, which gathers validator signatures for one block as they
+ * arrive from the network. Signatures may be submitted concurrently from any number of threads; each one is
+ * verified on the submitting thread (or across an OpenMP team for batches), stored in its validator's slot with
+ * atomic state transitions, and counted towards the quorum. Collection completes the moment the quorum is
+ * reached, and later submissions are rejected without being verified.
+ *
+ * The crypto backend is ECDSA, which has no signature aggregation, so the collector yields the quorum as the list
+ * of individual signatures in validator order together with a signer bitmap.
+ */
+
+#ifndef SIGNATURE_COLLECTOR_HPP
+#define SIGNATURE_COLLECTOR_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include "../cryptography/signature_verifier.hpp"
+
+/**
+ * @struct ValidatorSignature
+ * @brief A signature submitted by one validator.
+ */
+struct ValidatorSignature {
+    size_t validator_index;  ///< Position of the validator in the collector's key list.
+    std::string signature;   ///< Hex-encoded signature over the block hash.
+};
+
+/**
+ * @class SignatureCollector
+ * @brief Per-block vote accumulator that completes at `required_signatures` valid signatures.
+ *
+ * Every validator owns one slot that moves from EMPTY to VERIFYING to FILLED (or back to EMPTY if its signature is
+ * invalid) through compare-and-swap, so concurrent submitters never block one another and each validator is
+ * counted at most once.
+ */
+class SignatureCollector {
+public:
+    /**
+     * @brief Starts collecting signatures on a block.
+     *
+     * @param message The signed message, i.e. the block hash.
+     * @param validator_keys PEM-encoded public keys of the validator set, indexed by validator.
+     * @param required_signatures Quorum size.
+     * @param num_threads Worker threads for `submit_batch`; 0 uses the OpenMP default.
+     * @throws std::invalid_argument if the quorum is zero or larger than the validator set.
+     */
+    SignatureCollector(std::string message, std::vector<std::string> validator_keys, size_t required_signatures,
+                       int num_threads = 0);
+
+    /**
+     * @brief Verifies and records one validator's signature. Safe to call from any thread.
+     *
+     * @return True if the signature was valid and counted; false if it was invalid, the validator had already
+     *         signed, the index is unknown, or the quorum was already complete.
+     */
+    bool submit(size_t validator_index, const std::string& signature);
+
+    /**
+     * @brief Verifies a batch of signatures in parallel and records the valid ones.
+     *
+     * @return The number of signatures counted.
+     */
+    size_t submit_batch(const std::vector<ValidatorSignature>& signatures);
+
+    /**
+     * @brief Blocks until the quorum is complete or the timeout expires.
+     *
+     * @return True if the quorum is complete.
+     */
+    bool wait_for_quorum(std::chrono::milliseconds timeout) const;
+
+    bool has_quorum() const { return complete.load(std::memory_order_acquire); }  ///< Whether the quorum is complete.
+    size_t get_signature_count() const { return valid_count.load(std::memory_order_acquire); } ///< Valid signatures counted.
+    size_t get_rejected_count() const { return rejected_count.load(std::memory_order_relaxed); } ///< Invalid signatures seen.
+    size_t get_required_signatures() const { return required_signatures; }  ///< Quorum size.
+
+    /**
+     * @brief Returns the bit per validator set for every counted signature.
+     */
+    VerificationBitmap get_signers() const;
+
+    /**
+     * @brief Returns the counted signatures in validator order, at most `required_signatures` of them.
+     */
+    std::vector<std::string> get_quorum_signatures() const;
+
+private:
+    static const uint8_t SLOT_EMPTY = 0;      ///< No signature yet.
+    static const uint8_t SLOT_VERIFYING = 1;  ///< A submitter owns the slot and is checking its signature.
+    static const uint8_t SLOT_FILLED = 2;     ///< The slot holds a valid, counted signature.
+
+    struct Slot {
+        std::atomic<uint8_t> state{ SLOT_EMPTY };  ///< Slot state; `signature` is published by the FILLED store.
+        std::string signature;                     ///< Written only by the submitter that owns the slot.
+    };
+
+    std::string message;                        ///< The signed block hash.
+    std::vector<std::string> validator_keys;    ///< Public keys by validator.
+    size_t required_signatures;                 ///< Quorum size.
+    SignatureVerifier verifier;                 ///< Batch verifier for `submit_batch`.
+    std::unique_ptr<Slot[]> slots;              ///< One slot per validator.
+    std::atomic<size_t> reserved_count;         ///< Places in the quorum taken by verified signatures.
+    std::atomic<size_t> valid_count;            ///< Counted signatures whose slots are published.
+    std::atomic<size_t> rejected_count;         ///< Invalid signatures seen.
+    std::atomic<bool> complete;                 ///< Set once `valid_count` reaches the quorum.
+    mutable std::mutex wait_mutex;              ///< Only used to sleep in `wait_for_quorum`.
+    mutable std::condition_variable quorum_reached; ///< Signalled when the quorum completes.
+
+    bool claim(size_t validator_index);                             ///< EMPTY -> VERIFYING.
+    bool publish(size_t validator_index, const std::string& signature); ///< VERIFYING -> FILLED if the quorum has room.
+    void release(size_t validator_index);                           ///< VERIFYING -> EMPTY after a bad signature.
+};
+
+#endif  // SIGNATURE_COLLECTOR_HPP
+
+/**
+ * @file signature_collector.hpp
+ *
+ * Taking one lock per signature turns parallel collection into a queue, while the expensive part, verification,
+ * needs no shared state at all. Claiming a slot with a single CAS before verifying lets any number of threads
+ * verify at once, keeps a retransmitted signature from being checked twice, and lets the round stop at the
+ * quorum instead of waiting for every validator.
+ */
@@ -12,6 +12,9 @@
 #define CRYPTO_HPP
 
 #include <string>
+#include <string_view>
+#include <initializer_list>
+#include "hash256.hpp"  // Raw digest type and streaming hasher
 
 /**
  * @class Crypto
@@ -34,6 +37,27 @@ public:
      */
     static std::string hash(const std::string& data);
 
+    /**
+     * @brief Computes the raw SHA-256 digest of the given data.
+     * 
+     * Preferred over `hash()` on hot paths: the digest stays in its 32-byte form and no hex
+     * string is allocated. Convert with `Hash256::to_hex()` only where text is required.
+     * 
+     * @param data The input data to be hashed.
+     * @return The raw 32-byte digest.
+     */
+    static Hash256 hash_raw(std::string_view data);
+
+    /**
+     * @brief Computes the raw SHA-256 digest over the concatenation of several spans.
+     * 
+     * Equivalent to hashing the concatenated input, without building the concatenation.
+     * 
+     * @param parts The input spans, hashed in order.
+     * @return The raw 32-byte digest.
+     */
+    static Hash256 hash_raw(std::initializer_list<std::string_view> parts);
+
     /**
      * @brief Signs a message using a private key.
      * 
@@ -57,9 +81,12 @@ public:
      * @param message The original message that was signed.
      * @param signature The digital signature to verify.
      * @param public_key The public key corresponding to the private key that signed the message.
-     * @return True if the signature is valid, false otherwise.
+     * Parsed public keys are kept in `PublicKeyCache::shared()`, so repeated senders are decoded only once.
+     * 
+     * @return True if the signature is valid, false otherwise (including malformed hex signatures).
+     * @throws std::runtime_error if the public key cannot be parsed.
      */
-    static bool verify_signature(const std::string& message, const std::string& signature, const std::string& public_key);
+    static bool verify_signature(std::string_view message, std::string_view signature, std::string_view public_key);
 };
 
 #endif // CRYPTO_HPP
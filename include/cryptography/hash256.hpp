@@ -0,0 +1,153 @@
+/**
+ * @file hash256.hpp
+ * @brief Raw SHA-256 digests, streaming hashing and hex formatting for SynLedger.
+ *
+ * This header defines the `Hash256` value type holding a raw 32-byte digest, the `Sha256Hasher`
+ * streaming hasher that accepts any number of input spans, and the `Hex` formatter. Digests are kept
+ * in raw form throughout the ledger and only converted to hexadecimal at the edges (logging, RPC,
+ * legacy string-based APIs).
+ */
+
+#ifndef HASH256_HPP
+#define HASH256_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+struct evp_md_ctx_st;  // OpenSSL EVP_MD_CTX, kept opaque to avoid leaking OpenSSL headers.
+
+/**
+ * @class Hex
+ * @brief Table-driven hexadecimal encoding and decoding.
+ */
+class Hex {
+public:
+    /**
+     * @brief Encodes bytes as lowercase hexadecimal.
+     *
+     * @param data The bytes to encode.
+     * @param size Number of bytes.
+     * @return A string of `2 * size` hex characters.
+     */
+    static std::string encode(const void* data, size_t size);
+
+    /**
+     * @brief Writes the lowercase hex encoding of `size` bytes into `out` (which must hold `2 * size` chars).
+     */
+    static void encode_to(const void* data, size_t size, char* out);
+
+    /**
+     * @brief Decodes a hex string (either case) into a caller-provided buffer.
+     *
+     * @param hex The hex text; its length must be exactly `2 * out_size`.
+     * @param out Destination buffer.
+     * @param out_size Size of the destination buffer in bytes.
+     * @return True on success, false if the length is wrong or a non-hex character is found; `out` is then left
+     *         unchanged.
+     */
+    static bool decode(std::string_view hex, uint8_t* out, size_t out_size);
+
+    /**
+     * @brief Decodes a hex string into a byte string.
+     *
+     * @param hex The hex text.
+     * @param out Receives the decoded bytes.
+     * @return True on success, false if the input is not valid hex; `out` is then left unchanged.
+     */
+    static bool decode(std::string_view hex, std::string& out);
+};
+
+/**
+ * @struct Hash256
+ * @brief A raw 32-byte SHA-256 digest.
+ *
+ * Value type with cheap copies and comparisons. A default-constructed digest is all zeroes.
+ */
+struct Hash256 {
+    static constexpr size_t SIZE = 32;   ///< Digest size in bytes.
+    std::array<uint8_t, SIZE> bytes{};   ///< Raw digest bytes.
+
+    const uint8_t* data() const { return bytes.data(); }
+    uint8_t* data() { return bytes.data(); }
+    bool is_zero() const;
+
+    /**
+     * @brief Formats the digest as 64 lowercase hex characters.
+     */
+    std::string to_hex() const;
+
+    /**
+     * @brief Parses a 64-character hex string.
+     *
+     * @param hex The hex text.
+     * @param out Receives the digest on success; left unchanged otherwise.
+     * @return True if `hex` is a valid 64-character hex string.
+     */
+    static bool from_hex(std::string_view hex, Hash256& out);
+
+    bool operator==(const Hash256& other) const { return bytes == other.bytes; }
+    bool operator!=(const Hash256& other) const { return bytes != other.bytes; }
+    bool operator<(const Hash256& other) const { return bytes < other.bytes; }
+};
+
+/**
+ * @struct Hash256Hasher
+ * @brief Hash functor for unordered containers keyed by digests.
+ *
+ * The input is already uniformly distributed, so the first eight bytes are used directly.
+ */
+struct Hash256Hasher {
+    size_t operator()(const Hash256& digest) const;
+};
+
+/**
+ * @class Sha256Hasher
+ * @brief Streaming SHA-256 hasher over multiple input spans.
+ *
+ * Digest contexts are taken from a thread-local pool and returned on destruction, so repeated hashing
+ * on the same thread does not allocate. Instances are not thread-safe and must stay on the thread that
+ * created them.
+ */
+class Sha256Hasher {
+public:
+    Sha256Hasher();
+    ~Sha256Hasher();
+
+    Sha256Hasher(const Sha256Hasher&) = delete;
+    Sha256Hasher& operator=(const Sha256Hasher&) = delete;
+
+    /**
+     * @brief Feeds a span of bytes into the digest.
+     */
+    Sha256Hasher& update(const void* data, size_t size);
+    Sha256Hasher& update(std::string_view data) { return update(data.data(), data.size()); }
+    Sha256Hasher& update(const Hash256& digest) { return update(digest.data(), Hash256::SIZE); }
+
+    /**
+     * @brief Feeds a fixed-width little-endian integer into the digest.
+     */
+    Sha256Hasher& update_u64(uint64_t value);
+
+    /**
+     * @brief Completes the digest and resets the hasher so it can be reused.
+     *
+     * @return The raw digest of everything fed since construction or the last finalize.
+     */
+    Hash256 finalize();
+
+private:
+    evp_md_ctx_st* ctx;  ///< Pooled digest context.
+};
+
+#endif  // HASH256_HPP
+
+/**
+ * @file hash256.hpp
+ *
+ * Hashing is on the hot path of block building, import and validation. Working with raw digests halves
+ * the bytes fed into parent hashes compared with hex strings, and pooling digest contexts per thread
+ * removes an allocation and provider lookup from every call.
+ */
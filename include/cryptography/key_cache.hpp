@@ -0,0 +1,109 @@
+/**
+ * @file key_cache.hpp
+ * @brief Bounded cache of parsed public keys for signature verification.
+ *
+ * This header defines the `PublicKeyCache` class, a thread-safe LRU cache that maps the fingerprint of a
+ * PEM-encoded public key (SHA-256 of its text) to a ready-to-use OpenSSL key object. Since sender addresses
+ * in SynLedger are the senders' PEM public keys, the fingerprint doubles as an address key. Hot senders are
+ * parsed once rather than on every verification.
+ */
+
+#ifndef KEY_CACHE_HPP
+#define KEY_CACHE_HPP
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <unordered_map>
+#include "hash256.hpp"
+
+struct evp_pkey_st;  // OpenSSL EVP_PKEY, kept opaque to avoid leaking OpenSSL headers.
+
+/**
+ * @brief Shared handle to a parsed public key. Evicted keys stay valid while a handle is held.
+ */
+using PublicKeyHandle = std::shared_ptr<evp_pkey_st>;
+
+/**
+ * @struct KeyCacheStats
+ * @brief Counters used to size the cache.
+ */
+struct KeyCacheStats {
+    uint64_t hits;       ///< Lookups served from the cache.
+    uint64_t misses;     ///< Lookups that had to parse the PEM text.
+    uint64_t evictions;  ///< Entries dropped to stay within capacity.
+    size_t size;         ///< Current number of cached keys.
+    size_t capacity;     ///< Maximum number of cached keys.
+};
+
+/**
+ * @class PublicKeyCache
+ * @brief Thread-safe LRU cache from key fingerprint to parsed `EVP_PKEY`.
+ *
+ * Parsing happens outside the cache lock, so a miss on one thread does not stall hits on others.
+ */
+class PublicKeyCache {
+public:
+    static const size_t DEFAULT_CAPACITY = 4096;  ///< Default number of cached keys.
+
+    /**
+     * @brief Constructs a cache holding at most `capacity` keys.
+     */
+    explicit PublicKeyCache(size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * @brief Process-wide cache used by `Crypto::verify_signature` and `ECDSA::verify_signature`.
+     */
+    static PublicKeyCache& shared();
+
+    /**
+     * @brief Returns the parsed key for the given PEM text, parsing and caching it on a miss.
+     *
+     * @param public_key PEM-encoded public key.
+     * @return A handle to the parsed key.
+     * @throws std::runtime_error if the PEM text cannot be parsed.
+     */
+    PublicKeyHandle acquire(std::string_view public_key);
+
+    /**
+     * @brief Changes the capacity, evicting least recently used keys if necessary.
+     */
+    void set_capacity(size_t capacity);
+
+    /**
+     * @brief Drops all cached keys. Counters are preserved.
+     */
+    void clear();
+
+    /**
+     * @brief Returns a snapshot of the cache counters.
+     */
+    KeyCacheStats get_stats() const;
+
+private:
+    using Entry = std::pair<Hash256, PublicKeyHandle>;
+
+    size_t capacity;                                                           ///< Maximum number of entries.
+    std::list<Entry> lru;                                                      ///< Entries, most recently used first.
+    std::unordered_map<Hash256, std::list<Entry>::iterator, Hash256Hasher> index; ///< Fingerprint lookup.
+    mutable std::mutex cache_mutex;                                            ///< Protects `lru` and `index`.
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    std::atomic<uint64_t> evictions;
+
+    void evict_excess();  ///< Drops entries beyond capacity; caller holds the lock.
+};
+
+#endif  // KEY_CACHE_HPP
+
+/**
+ * @file key_cache.hpp
+ *
+ * PEM decoding and key validation cost far more than the signature check itself. A small set of senders
+ * produces most of the traffic, so caching parsed keys removes most of that work while the bound keeps
+ * memory predictable under adversarial key churn.
+ */
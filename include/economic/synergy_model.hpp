@@ -11,6 +11,9 @@
 #ifndef SYNERGY_MODEL_HPP
 #define SYNERGY_MODEL_HPP
 
+#include <cstddef>
+#include <cstdint>
+
 /**
  * @class SynergyModel
  * @brief Implements synergy calculations and adjustments for participants in the PoSyg consensus.
@@ -71,6 +74,48 @@ public:
      * @return The adjusted conversion rate.
      */
     static double adjust_conversion_rate(double current_rate, double network_conditions);
+
+    /**
+     * @name Batch overloads
+     *
+     * Apply the scalar rules above element-wise over contiguous arrays of `count` participants, with results equal
+     * to calling the scalar functions one participant at a time. The kernels are compiled for AVX-512, AVX2 and
+     * baseline x86-64 (or only the baseline elsewhere), and the widest one the CPU supports is selected at load
+     * time. Outputs may alias the corresponding inputs.
+     */
+    ///@{
+
+    /**
+     * @brief Computes `out[i] = calculate_synergy(initial_synergy[i], economic_activity[i], governance_activity[i])`.
+     */
+    static void calculate_synergy(const double* initial_synergy, const double* economic_activity,
+                                  const double* governance_activity, double* out, size_t count);
+
+    /**
+     * @brief Computes `out[i] = apply_penalty(synergy[i], penalty[i])`.
+     */
+    static void apply_penalty(const double* synergy, const double* penalty, double* out, size_t count);
+
+    /**
+     * @brief Converts the synergy of every participant not flagged in `excluded` at a common rate.
+     *
+     * @param synergy Synergy scores.
+     * @param conversion_rate The rate of conversion from synergy to tokens.
+     * @param balances If not null, receives `balances[i] += convert_synergy_to_tokens(synergy[i], conversion_rate)`.
+     * @param excluded If not null, a bitset (bit `i % 64` of word `i / 64`) of participants that convert nothing.
+     * @param count Number of participants.
+     * @return The total number of tokens converted.
+     */
+    static double convert_synergy_to_tokens(const double* synergy, double conversion_rate, double* balances,
+                                            const uint64_t* excluded, size_t count);
+
+    /**
+     * @brief Computes `out[i] = adjust_conversion_rate(current_rate[i], network_conditions[i])`.
+     */
+    static void adjust_conversion_rate(const double* current_rate, const double* network_conditions, double* out,
+                                       size_t count);
+
+    ///@}
 };
 
 #endif // SYNERGY_MODEL_HPP
@@ -6,6 +6,11 @@
  * proposals within the SynLedger blockchain. It integrates closely with the PoSygEngine to ensure that
  * voting is linked to participant contributions and synergy scores. The governance system is designed
  * to enable decentralized, democratic control over the future development and rules of the network.
+ *
+ * Proposals are stored densely by id, each participant may vote once per proposal (tracked in a per-proposal
+ * bitset), and large vote batches are tallied in parallel into per-thread partial sums that are merged when
+ * the proposal is finalized. Vote weights come from the engine's synergy snapshot taken when the proposal
+ * opened, so ballots never read the live participant table that consensus cycles update.
  */
 
 #ifndef GOVERNANCE_HPP
@@ -13,6 +18,9 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
 #include "../consensus/posyg_engine.hpp"
 
 /**
@@ -28,6 +36,78 @@ struct Proposal {
     double votes_for;         ///< Number of votes in favor of the proposal.
     double votes_against;     ///< Number of votes against the proposal.
     bool is_active;           ///< Indicates whether the proposal is still active and open for voting.
+    std::vector<uint64_t> voters; ///< Bit per participant that has voted; released when the proposal is finalized.
+    std::shared_ptr<const SynergySnapshot> weights; ///< Vote weights as of the opening; released when finalized.
+};
+
+/**
+ * @struct Vote
+ * @brief One ballot of a vote batch.
+ */
+struct Vote {
+    int proposal_id;        ///< The proposal voted on.
+    size_t participant_id;  ///< The voter.
+    bool vote_for;          ///< True for a vote in favor.
+};
+
+/**
+ * @struct VoteTally
+ * @brief Synergy-weighted vote totals.
+ */
+struct VoteTally {
+    double votes_for = 0.0;      ///< Weight in favor.
+    double votes_against = 0.0;  ///< Weight against.
+};
+
+/**
+ * @class ActiveProposalView
+ * @brief Iterable view of the active proposals in id order, referring to the governance store without copying.
+ *
+ * The view is invalidated by creating or finalizing proposals.
+ */
+class ActiveProposalView {
+public:
+    /**
+     * @brief Forward iterator yielding `const Proposal&`.
+     */
+    class iterator {
+    public:
+        iterator(const std::vector<Proposal>* proposals, const size_t* position, const size_t* end)
+            : proposals(proposals), position(position), end(end) { skip_inactive(); }
+
+        const Proposal& operator*() const { return (*proposals)[*position]; }
+        const Proposal* operator->() const { return &(*proposals)[*position]; }
+        iterator& operator++() { ++position; skip_inactive(); return *this; }
+        bool operator==(const iterator& other) const { return position == other.position; }
+        bool operator!=(const iterator& other) const { return position != other.position; }
+
+    private:
+        const std::vector<Proposal>* proposals;  ///< The proposal store.
+        const size_t* position;                  ///< Current entry of the active index list.
+        const size_t* end;                       ///< End of the active index list.
+
+        void skip_inactive() {
+            while (position != end && !(*proposals)[*position].is_active) {
+                ++position;
+            }
+        }
+    };
+
+    ActiveProposalView(const std::vector<Proposal>& proposals, const std::vector<size_t>& indices, size_t count)
+        : proposals(&proposals), indices(&indices), count(count) {}
+
+    iterator begin() const { return iterator(proposals, indices->data(), indices->data() + indices->size()); }
+    iterator end() const {
+        const size_t* last = indices->data() + indices->size();
+        return iterator(proposals, last, last);
+    }
+    size_t size() const { return count; }    ///< Number of active proposals.
+    bool empty() const { return count == 0; } ///< True if no proposal is open.
+
+private:
+    const std::vector<Proposal>* proposals;  ///< The proposal store.
+    const std::vector<size_t>* indices;      ///< Store positions of proposals that were active when last compacted.
+    size_t count;                            ///< Number of active proposals.
 };
 
 /**
@@ -65,19 +145,41 @@ public:
      * 
      * This method allows a participant to vote on an active proposal. The weight of the vote can be linked 
      * to the participant's synergy or contribution to the network, ensuring that higher-contributing members 
-     * have more influence.
+     * have more influence. The weight is the participant's synergy when the proposal was created.
      * 
      * @param proposal_id The ID of the proposal being voted on.
      * @param vote_for A boolean indicating whether the vote is in favor of the proposal (true) or against it (false).
      * @param participant_id The ID of the participant casting the vote.
+     * @return True if the vote was counted; false if the proposal is unknown or closed, or the participant is
+     *         unknown, slashed or has already voted on it.
+     */
+    bool vote(int proposal_id, bool vote_for, size_t participant_id);
+
+    /**
+     * @brief Tallies a batch of votes in parallel.
+     * 
+     * Each thread accumulates its share of the batch into its own partial sums, which are merged into the
+     * proposal's totals by `finalize_proposal`. A participant's first counted vote on a proposal is final; if a
+     * batch holds several votes of one participant on one proposal, exactly one of them is counted.
+     * 
+     * @param votes The ballots.
+     * @return The number of votes counted.
      */
-    void vote(int proposal_id, bool vote_for, size_t participant_id);
+    size_t vote_batch(const std::vector<Vote>& votes);
+
+    /**
+     * @brief Returns the current totals of a proposal, including batched votes not yet merged.
+     * 
+     * @throws std::out_of_range if the proposal does not exist.
+     */
+    VoteTally get_tally(int proposal_id) const;
 
     /**
      * @brief Finalizes a proposal once voting is complete.
      * 
      * Closes the voting process for a proposal and finalizes its outcome. Depending on the vote tally, 
-     * the proposal may be approved or rejected, and the decision is implemented accordingly.
+     * the proposal may be approved or rejected, and the decision is implemented accordingly. Batched partial
+     * sums are merged into `votes_for` and `votes_against` at this point.
      * 
      * @param proposal_id The ID of the proposal to finalize.
      */
@@ -88,9 +190,9 @@ public:
      * 
      * Returns the currently active proposals that are still open for voting.
      * 
-     * @return A vector of active proposals.
+     * @return A view of the active proposals in id order.
      */
-    std::vector<Proposal> get_active_proposals() const;
+    ActiveProposalView get_active_proposals() const;
 
     /**
      * @brief Checks if a specific proposal has been approved.
@@ -125,9 +227,21 @@ public:
     const Proposal* get_proposal_by_id(int proposal_id) const;
 
 private:
-    std::vector<Proposal> proposals;   ///< List of all proposals in the governance system.
+    std::vector<Proposal> proposals;   ///< All proposals; the proposal with id `i` is at position `i - 1`.
     int next_proposal_id;              ///< Tracks the next available proposal ID.
     PoSygEngine& posyg_engine;         ///< Reference to the PoSygEngine for accessing participant synergy and votes.
+    std::vector<size_t> active_indices; ///< Ascending positions of active proposals, possibly with closed ones.
+    size_t active_count;               ///< Number of active proposals.
+    std::vector<std::vector<VoteTally>> thread_tallies; ///< Unmerged batch sums by thread, then by proposal position.
+
+    /**
+     * @brief Counts one vote if it is valid and the participant has not voted on the proposal yet.
+     * 
+     * May be called concurrently for different votes; the voter bit is claimed atomically.
+     * 
+     * @return The vote's weight, or a negative value if it was not counted.
+     */
+    double try_count(Proposal& proposal, size_t participant_id);
 };
 
 #endif // GOVERNANCE_HPP
@@ -139,4 +253,6 @@ private:
  * network changes democratically. The use of synergy-weighted voting ensures that participants who 
  * contribute more to the network have greater influence. The system also allows for the transparent 
  * creation and management of proposals, making the decision-making process fair and decentralized.
+ * Since ids are handed out consecutively, the position of a proposal in the store is its id minus one, and
+ * looking a proposal up on every ballot costs no more than an array access.
  */
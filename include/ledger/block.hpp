@@ -14,8 +14,16 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
+#include <iterator>
+#include <cstddef>
 #include <ctime>
 #include "../cryptography/crypto.hpp"  // For hashing and signature verification
+#include "../cryptography/signature_verifier.hpp"  // Batch signature verification for block import
+#include "merkle_tree.hpp"              // Incremental commitment to the block's transactions
+
+struct BlockView;        // Zero-copy decoded block, see wire_format.hpp.
+struct TransactionView;  // Zero-copy decoded transaction, see wire_format.hpp.
 
 /**
  * @enum TransactionType
@@ -29,6 +37,18 @@ enum class TransactionType {
     SMART_CONTRACT_EXECUTION       ///< Execution of smart contract code.
 };
 
+/**
+ * @enum WireFormat
+ * @brief Selects the encoding used by `serialize()` / `deserialize()`.
+ *
+ * The binary format (see wire_format.hpp) is used for storage, hashing and transmission. The legacy
+ * delimiter-based text format is kept for debugging and human inspection only.
+ */
+enum class WireFormat {
+    BINARY,                        ///< Versioned, length-prefixed binary encoding.
+    TEXT                           ///< Human-readable `|`/`#` delimited text (debugging only).
+};
+
 /**
  * @struct Transaction
  * @brief Represents a transaction in the blockchain.
@@ -69,14 +89,25 @@ struct Transaction {
      */
     bool verify_transaction() const;
 
+    /**
+     * @brief Describes the transaction's signature check for batch verification.
+     * 
+     * The returned check references this transaction's fields and is valid only while it is alive.
+     * 
+     * @return The (message, signature, public key) triple verified by `verify_transaction()`.
+     */
+    SignatureCheck signature_check() const;
+
     /**
      * @brief Serializes the transaction into a string for storage or transmission.
      * 
-     * Converts the transaction data into a compact string format for easy storage or transmission.
+     * Converts the transaction data into the binary wire format, or into the legacy text format
+     * when explicitly requested for debugging.
      * 
+     * @param format The encoding to produce.
      * @return A serialized string representation of the transaction.
      */
-    std::string serialize() const;
+    std::string serialize(WireFormat format = WireFormat::BINARY) const;
 
     /**
      * @brief Deserializes a transaction from a string.
@@ -84,9 +115,118 @@ struct Transaction {
      * Recreates a transaction object from its serialized string form.
      * 
      * @param serialized_transaction The serialized string of the transaction.
+     * @param format The encoding the string was produced with.
      * @return The deserialized Transaction object.
+     * @throws std::runtime_error if a binary encoding is malformed.
+     */
+    static Transaction deserialize(const std::string& serialized_transaction, WireFormat format = WireFormat::BINARY);
+
+    /**
+     * @brief Computes the transaction's identifier.
+     * 
+     * The identifier is the Merkle leaf hash of the binary encoding, so it matches the leaf stored in
+     * the block's transaction tree.
+     * 
+     * @return The raw transaction hash.
+     */
+    Hash256 hash() const;
+};
+
+/**
+ * @struct TransactionRef
+ * @brief Non-owning view of a transaction, e.g. one stored in a block's arena.
+ *
+ * The view is valid while the storage it points into is alive and unchanged. A `Transaction` converts to a
+ * view of its own fields implicitly, so code that only reads a transaction can accept either.
+ */
+struct TransactionRef {
+    std::string_view sender;     ///< The address of the transaction's sender.
+    std::string_view receiver;   ///< The address of the transaction's receiver.
+    double amount;               ///< Amount of tokens transferred.
+    std::string_view signature;  ///< Hex-encoded signature of the transaction.
+    TransactionType type;        ///< Type of the transaction.
+    std::string_view data;       ///< Additional data for governance or smart contract execution.
+
+    TransactionRef(const Transaction& tx);
+    TransactionRef(std::string_view sender, std::string_view receiver, double amount, std::string_view signature,
+                   TransactionType type, std::string_view data);
+
+    bool verify_transaction() const;                                      ///< See `Transaction::verify_transaction()`.
+    SignatureCheck signature_check() const;                               ///< See `Transaction::signature_check()`.
+    std::string serialize(WireFormat format = WireFormat::BINARY) const;  ///< See `Transaction::serialize()`.
+    Hash256 hash() const;                                                 ///< See `Transaction::hash()`.
+    Transaction to_transaction() const;                                   ///< Copies the fields into an owning Transaction.
+};
+
+/**
+ * @class TransactionArena
+ * @brief Contiguous storage for the transactions of one block.
+ *
+ * The string fields of all transactions are packed back to back into one buffer and described by fixed-size
+ * slots, so a block holds its transactions in two allocations whatever their number, and copying or freeing
+ * a block no longer touches every field of every transaction. Elements are read as `TransactionRef`s into the
+ * buffer, which are invalidated by the next append and by moving the arena.
+ */
+class TransactionArena {
+private:
+    struct Slot {
+        size_t offset;              ///< Start of the transaction's fields in `bytes`.
+        uint32_t sender_length;     ///< Bytes of the sender, stored first.
+        uint32_t receiver_length;   ///< Bytes of the receiver, stored second.
+        uint32_t signature_length;  ///< Bytes of the hex signature, stored third.
+        uint32_t data_length;       ///< Bytes of the data, stored last.
+        double amount;              ///< Transferred amount.
+        TransactionType type;       ///< Transaction type.
+    };
+
+    std::string bytes;         ///< String fields of all transactions, in block order.
+    std::vector<Slot> slots;   ///< One slot per transaction.
+
+    Slot& add_slot(size_t field_bytes, double amount, TransactionType type);
+
+public:
+    /**
+     * @brief Input iterator producing a `TransactionRef` per transaction.
+     *
+     * Dereferencing yields a view by value rather than a reference into the arena, which is why the iterator is
+     * an input iterator and has no `operator->`; it still supports multiple passes over the same arena.
+     */
+    class const_iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = TransactionRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = TransactionRef;
+
+        const_iterator(const TransactionArena* arena, size_t index) : arena(arena), index(index) {}
+        TransactionRef operator*() const { return (*arena)[index]; }
+        const_iterator& operator++() { ++index; return *this; }
+        const_iterator operator++(int) { const_iterator previous = *this; ++index; return previous; }
+        bool operator==(const const_iterator& other) const { return index == other.index; }
+        bool operator!=(const const_iterator& other) const { return index != other.index; }
+
+    private:
+        const TransactionArena* arena;
+        size_t index;
+    };
+
+    /**
+     * @brief Preallocates room for `count` more transactions with `field_bytes` bytes of string fields in total.
      */
-    static Transaction deserialize(const std::string& serialized_transaction);
+    void reserve(size_t count, size_t field_bytes);
+
+    void append(const TransactionRef& tx);   ///< Copies a transaction's fields into the arena.
+    void append(const TransactionView& tx);  ///< Copies a decoded transaction, unpacking its signature in place.
+
+    TransactionRef operator[](size_t index) const;  ///< View of the transaction at `index`.
+    TransactionRef front() const { return (*this)[0]; }                 ///< First transaction.
+    TransactionRef back() const { return (*this)[slots.size() - 1]; }   ///< Last transaction.
+    size_t size() const { return slots.size(); }                        ///< Number of transactions.
+    bool empty() const { return slots.empty(); }                        ///< Whether the arena holds none.
+    size_t field_bytes() const { return bytes.size(); }                 ///< Bytes of string fields stored.
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, slots.size()); }
 };
 
 /**
@@ -101,9 +241,12 @@ class Block {
 private:
     size_t block_number;                      ///< The block's position in the blockchain.
     std::string previous_block_hash;          ///< The hash of the previous block in the chain.
+    Hash256 previous_block_digest;            ///< Raw digest of the previous block (zero if the hash is not hex).
     std::time_t timestamp;                    ///< Timestamp of when the block was created.
-    std::vector<Transaction> transactions;    ///< List of transactions contained in the block.
-    mutable std::string block_hash;           ///< Cached hash of the block.
+    TransactionArena transactions;            ///< Transactions contained in the block, stored contiguously.
+    MerkleTree transaction_tree;              ///< Incremental Merkle tree over the transactions.
+    mutable std::string block_hash;           ///< Cached hash of the block (hex).
+    mutable Hash256 block_digest;             ///< Cached raw digest of the block.
     std::vector<std::string> validator_signatures; ///< Validator signatures on the block.
     size_t required_signatures;               ///< Number of required validator signatures for block finalization.
 
@@ -125,21 +268,97 @@ public:
     /**
      * @brief Adds a transaction to the block.
      * 
-     * Inserts a new transaction into the block's transaction list.
+     * Inserts a new transaction into the block's transaction list and appends its leaf to the Merkle
+     * tree. Only the O(log n) nodes on the new leaf's path and the constant-size header hash are
+     * recomputed.
      * 
-     * @param tx The transaction to add.
+     * @param tx The transaction to add; its fields are copied into the block's arena.
      */
-    void add_transaction(const Transaction& tx);
+    void add_transaction(const TransactionRef& tx);
+
+    /**
+     * @brief Adds a batch of transactions, verifying their signatures in parallel.
+     * 
+     * All signatures are checked with the given verifier before anything is appended, so the block
+     * is left unchanged if any transaction is invalid.
+     * 
+     * @param txs The transactions to add, in order.
+     * @param verifier The batch verifier to use.
+     * @throws std::invalid_argument if any transaction has an invalid signature.
+     */
+    void add_transactions(const std::vector<Transaction>& txs, const SignatureVerifier& verifier = SignatureVerifier());
+
+    /**
+     * @brief Adds a batch of transactions referenced in place, e.g. a mempool block template.
+     * 
+     * Behaves like the owning overload but lets the caller avoid building an intermediate vector.
+     * 
+     * @param txs Pointers to the transactions to add, in order.
+     * @param verifier The batch verifier to use.
+     * @throws std::invalid_argument if any transaction has an invalid signature.
+     */
+    void add_transactions(const std::vector<const Transaction*>& txs, const SignatureVerifier& verifier = SignatureVerifier());
+
+    /**
+     * @brief Verifies the signatures of all transactions in the block in parallel.
+     * 
+     * Intended for imported (deserialized) blocks, whose transactions are not checked on decode.
+     * 
+     * @param verifier The batch verifier to use.
+     * @return One result bit per transaction, in block order.
+     */
+    VerificationBitmap verify_transactions(const SignatureVerifier& verifier = SignatureVerifier()) const;
 
     /**
      * @brief Calculates the block's hash.
      * 
-     * Computes the cryptographic hash of the block's contents (transactions, previous hash, etc.).
+     * Computes the cryptographic hash of the block header: block number, previous hash, timestamp,
+     * transaction count and Merkle root.
      * 
      * @return The hash of the block.
      */
     const std::string& calculate_block_hash() const;
 
+    /**
+     * @brief Computes the block's raw header digest without touching the cached hash.
+     * 
+     * Used by validation to compare a freshly computed digest against the cached one.
+     * 
+     * @return The raw 32-byte digest of the block header.
+     */
+    Hash256 compute_block_digest() const;
+
+    /**
+     * @brief Computes a block header digest from its individual fields.
+     * 
+     * Lets callers holding only a decoded header (e.g. a `BlockView` over stored bytes) derive the block's
+     * digest without materializing its transactions.
+     * 
+     * @return The raw 32-byte digest of the header.
+     */
+    static Hash256 compute_header_digest(size_t block_number, std::string_view previous_block_hash, std::time_t timestamp,
+                                         uint64_t transaction_count, const Hash256& merkle_root);
+
+    /**
+     * @brief Rebuilds the Merkle root from the transactions and compares it with the cached tree.
+     * 
+     * This is an O(n) audit check; regular header validation relies on the cached root.
+     * 
+     * @return True if the cached root matches the transactions.
+     */
+    bool verify_merkle_root() const;
+
+    /**
+     * @brief Builds an inclusion proof for the transaction at `index`.
+     * 
+     * Together with the header fields, the proof lets a light client verify a transaction without
+     * downloading the full block.
+     * 
+     * @param index Position of the transaction in the block.
+     * @return The Merkle inclusion proof.
+     */
+    MerkleProof get_transaction_proof(size_t index) const;
+
     /**
      * @brief Adds a validator's signature to the block.
      * 
@@ -162,11 +381,13 @@ public:
     /**
      * @brief Serializes the block into a string format.
      * 
-     * Converts the block and its contents into a string for storage or transmission.
+     * Converts the block and its contents into a string for storage or transmission. The binary format
+     * also carries the validator signatures; the text format is intended for debugging only.
      * 
+     * @param format The encoding to produce.
      * @return A serialized string of the block.
      */
-    std::string serialize() const;
+    std::string serialize(WireFormat format = WireFormat::BINARY) const;
 
     /**
      * @brief Deserializes a block from a string.
@@ -174,16 +395,46 @@ public:
      * Recreates a Block object from its serialized form.
      * 
      * @param serialized_block The serialized string of the block.
+     * @param format The encoding the string was produced with.
      * @return The deserialized Block object.
+     * @throws std::runtime_error if a binary encoding is malformed.
+     */
+    static Block deserialize(const std::string& serialized_block, WireFormat format = WireFormat::BINARY);
+
+    /**
+     * @brief Materializes a block from a decoded binary view, e.g. one over a memory-mapped file.
+     * 
+     * @param view The decoded block.
+     * @return The owning Block object.
+     * @throws std::runtime_error if the Merkle root does not match the transactions.
+     */
+    static Block from_view(const BlockView& view);
+
+    /**
+     * @brief Assembles a block from a received header and its transactions, e.g. a reconstructed compact block.
+     *
+     * The Merkle root is not compared with any expected value; callers check `get_merkle_root()` themselves.
+     *
+     * @param transaction_ids Hashes of `transactions`, used as Merkle leaves without re-encoding.
+     * @throws std::invalid_argument if `transactions` and `transaction_ids` differ in length.
      */
-    static Block deserialize(const std::string& serialized_block);
+    static Block assemble(size_t block_number, const std::string& previous_block_hash, std::time_t timestamp,
+                          size_t required_signatures, std::vector<std::string> validator_signatures,
+                          std::vector<Transaction> transactions, const std::vector<Hash256>& transaction_ids);
 
     // Getters for block details
-    const std::vector<Transaction>& get_transactions() const;   ///< Retrieves the list of transactions in the block.
+    const TransactionArena& get_transactions() const;           ///< Retrieves the transactions in the block.
     const std::string& get_block_hash() const;                  ///< Retrieves the block's hash.
     const std::string& get_previous_block_hash() const;         ///< Retrieves the hash of the previous block.
+    const Hash256& get_block_digest() const;                    ///< Retrieves the block's cached raw digest.
+    const Hash256& get_previous_block_digest() const;           ///< Retrieves the previous block's raw digest.
+    Hash256 get_merkle_root() const;                            ///< Retrieves the Merkle root of the transactions.
+    const MerkleTree& get_transaction_tree() const;             ///< Retrieves the transaction Merkle tree.
     size_t get_block_number() const;                            ///< Retrieves the block number.
     size_t get_signature_count() const;                         ///< Retrieves the count of validator signatures.
+    std::time_t get_timestamp() const;                          ///< Retrieves the block creation time.
+    size_t get_required_signatures() const;                     ///< Retrieves the signatures required for finalization.
+    const std::vector<std::string>& get_validator_signatures() const; ///< Retrieves the validator signatures.
 };
 
 #endif  // BLOCK_HPP
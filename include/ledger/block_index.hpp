@@ -0,0 +1,111 @@
+/**
+ * @file block_index.hpp
+ * @brief Flat hash index from block digests to their position in the ledger.
+ *
+ * This header defines the `BlockIndex` class, an open-addressing hash table keyed by raw 32-byte block digests.
+ * Each entry records where the block lives (main chain or a side branch of the block tree), its height and its
+ * confirmation state, so that "do we have block X" and confirmation checks are a single probe sequence over
+ * contiguous memory instead of a walk over string-keyed trees.
+ */
+
+#ifndef BLOCK_INDEX_HPP
+#define BLOCK_INDEX_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "../cryptography/hash256.hpp"
+
+const uint32_t BLOCK_ON_MAIN_CHAIN = 0;          ///< Location of main-chain blocks.
+const uint32_t BLOCK_ON_SIDE_BRANCH = 1;         ///< Location of non-final blocks on a competing branch of the block tree.
+const uint32_t BLOCK_NOT_STORED = 0xFFFFFFFFu;   ///< Location of entries that only carry metadata for an unknown block.
+
+/**
+ * @struct BlockIndexEntry
+ * @brief What the ledger knows about a block digest.
+ */
+struct BlockIndexEntry {
+    uint64_t height;         ///< Block height.
+    uint32_t location;       ///< BLOCK_ON_MAIN_CHAIN, BLOCK_ON_SIDE_BRANCH or BLOCK_NOT_STORED.
+    bool confirmed;          ///< Whether the block has been marked as confirmed.
+};
+
+/**
+ * @class BlockIndex
+ * @brief Linear-probing hash table from `Hash256` to `BlockIndexEntry`.
+ *
+ * Block digests are uniformly distributed, so their leading bytes are used directly as the hash. The table keeps
+ * a power-of-two capacity, grows at 75% load, and uses backward-shift deletion so lookups never see tombstones.
+ */
+class BlockIndex {
+public:
+    /**
+     * @brief Constructs an empty index sized for at least `expected_size` entries.
+     */
+    explicit BlockIndex(size_t expected_size = 1024);
+
+    /**
+     * @brief Inserts or replaces the entry for a digest.
+     *
+     * @return True if the digest was not present before.
+     */
+    bool insert(const Hash256& digest, const BlockIndexEntry& entry);
+
+    /**
+     * @brief Looks up a digest.
+     *
+     * @return A pointer to the entry, or nullptr. Invalidated by insertions and removals.
+     */
+    const BlockIndexEntry* find(const Hash256& digest) const;
+    BlockIndexEntry* find(const Hash256& digest);
+
+    /**
+     * @brief Removes a digest.
+     *
+     * @return True if the digest was present.
+     */
+    bool erase(const Hash256& digest);
+
+    size_t size() const { return count; }            ///< Number of entries.
+    size_t capacity() const { return slots.size(); } ///< Number of slots.
+
+    /**
+     * @brief Removes all entries, keeping the allocated slots.
+     */
+    void clear();
+
+    /**
+     * @brief Calls `visit(digest, entry)` for every entry, in slot order.
+     */
+    template <typename Visitor>
+    void for_each(Visitor&& visit) const {
+        for (const Slot& slot : slots) {
+            if (slot.occupied) {
+                visit(slot.key, slot.value);
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        Hash256 key;
+        BlockIndexEntry value;
+        bool occupied;
+    };
+
+    std::vector<Slot> slots;  ///< Open-addressing slots; size is a power of two.
+    size_t count;             ///< Number of occupied slots.
+
+    size_t home_slot(const Hash256& digest) const;
+    size_t find_slot(const Hash256& digest) const;   ///< Slot holding the digest, or slots.size().
+    void grow();
+};
+
+#endif  // BLOCK_INDEX_HPP
+
+/**
+ * @file block_index.hpp
+ *
+ * Sync and fork resolution ask "is this block known" for every announcement and parent link. Keeping those
+ * answers in one flat table keyed by raw digests avoids hex comparisons and pointer chasing on that hot path.
+ */
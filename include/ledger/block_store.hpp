@@ -0,0 +1,159 @@
+/**
+ * @file block_store.hpp
+ * @brief Segmented, append-only on-disk block storage for SynLedger.
+ *
+ * This header defines the `BlockStore` class, which persists blocks in their binary wire format across a
+ * series of segment files and keeps a fixed-width height→location index next to them. Reads are served from
+ * memory-mapped segments, so historical blocks can be decoded in place without being held in RAM.
+ *
+ * Directory layout:
+ *   blocks_NNNNNN.dat  segment files, each a sequence of records `u32 length | u32 checksum | block bytes`
+ *   index.dat          one 16-byte entry per height: `u32 segment | u32 length | u64 offset`
+ *
+ * The checksum is the first four bytes of the SHA-256 digest of the block bytes.
+ */
+
+#ifndef BLOCK_STORE_HPP
+#define BLOCK_STORE_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "block.hpp"
+#include "wire_format.hpp"
+
+/**
+ * @struct BlockLocation
+ * @brief Position of a stored block inside the segment files.
+ */
+struct BlockLocation {
+    uint32_t segment;  ///< Segment file number.
+    uint32_t length;   ///< Length of the encoded block in bytes.
+    uint64_t offset;   ///< Offset of the encoded block (after the record header) within the segment.
+};
+
+/**
+ * @class BlockStore
+ * @brief Append-only block file store with an index, batched fsync and memory-mapped reads.
+ *
+ * Segment data is always synced before the index, so after a crash the index never points past durable data.
+ * On open only the tail (the segment holding the last indexed block and any later ones) is validated:
+ * indexed records are checksummed and decoded, unindexed but complete records are recovered into the index,
+ * and torn writes are truncated away. The store is not thread-safe; callers serialize access.
+ */
+class BlockStore {
+public:
+    static const size_t DEFAULT_SEGMENT_SIZE = 64 * 1024 * 1024;  ///< Segment size at which a new file is started.
+    static const size_t DEFAULT_SYNC_INTERVAL = 16;               ///< Appends between automatic fsyncs.
+
+    /**
+     * @brief Opens (or creates) a block store in the given directory.
+     *
+     * @param directory Directory holding the segment and index files; created if missing.
+     * @param segment_size Target segment file size in bytes.
+     * @param sync_interval Number of appends batched into one fsync; 1 syncs every block.
+     * @throws std::runtime_error if the files cannot be opened or mapped.
+     */
+    explicit BlockStore(const std::string& directory, size_t segment_size = DEFAULT_SEGMENT_SIZE,
+                        size_t sync_interval = DEFAULT_SYNC_INTERVAL);
+
+    /**
+     * @brief Syncs pending appends and releases all mappings.
+     */
+    ~BlockStore();
+
+    BlockStore(const BlockStore&) = delete;
+    BlockStore& operator=(const BlockStore&) = delete;
+
+    /**
+     * @brief Appends a block at the next height.
+     *
+     * @param block The block to store.
+     * @return The height the block was stored at.
+     * @throws std::runtime_error on I/O failure.
+     */
+    size_t append(const Block& block);
+
+    /**
+     * @brief Forces all pending appends to stable storage.
+     */
+    void sync();
+
+    /**
+     * @brief Discards every block at height `count` and above (used on rollback).
+     */
+    void truncate(size_t count);
+
+    size_t size() const { return index.size(); }   ///< Number of stored blocks.
+    bool empty() const { return index.empty(); }   ///< True if no block is stored.
+
+    /**
+     * @brief Returns the location of the block at the given height.
+     * @throws std::out_of_range if the height is not stored.
+     */
+    const BlockLocation& location(size_t height) const;
+
+    /**
+     * @brief Returns the encoded bytes of a stored block, straight from the memory-mapped segment.
+     *
+     * Segments are mapped once at their full size and never remapped while open, so the view stays valid
+     * across later appends and segment rollovers, until the store is truncated below `height` or destroyed.
+     *
+     * @throws std::out_of_range if the height is not stored.
+     */
+    std::string_view read_raw(size_t height) const;
+
+    /**
+     * @brief Decodes a stored block in place without copying it.
+     */
+    BlockView view(size_t height) const;
+
+    /**
+     * @brief Materializes a stored block.
+     */
+    Block read(size_t height) const;
+
+    /**
+     * @brief Number of blocks recovered into the index from the tail segment when the store was opened.
+     */
+    size_t get_recovered_count() const { return recovered; }
+
+private:
+    /**
+     * @brief An open, memory-mapped segment file.
+     */
+    struct Segment {
+        int fd;              ///< File descriptor opened for reading and writing.
+        char* map;           ///< Read-only shared mapping of the file.
+        size_t mapped_size;  ///< Length of the mapping, at least the segment size; pages past the file end are unused.
+        size_t file_size;    ///< Bytes currently written to the file.
+    };
+
+    std::string directory;          ///< Store directory.
+    size_t segment_size;            ///< Target segment size.
+    size_t sync_interval;           ///< Appends per fsync batch.
+    size_t unsynced;                ///< Appends since the last sync.
+    size_t recovered;               ///< Records recovered on open.
+    std::vector<Segment> segments;  ///< Segments in order; the last one receives appends.
+    std::vector<BlockLocation> index; ///< In-memory copy of the height index.
+    int index_fd;                   ///< Descriptor of the index file.
+
+    std::string segment_path(uint32_t segment) const;
+    void open_segment(uint32_t segment);
+    void map_segment(Segment& segment, size_t length);
+    void close_segment(Segment& segment);
+    void load_index();
+    void validate_tail();
+    void write_index_entry(size_t height, const BlockLocation& entry);
+};
+
+#endif  // BLOCK_STORE_HPP
+
+/**
+ * @file block_store.hpp
+ *
+ * Keeping history on disk bounds the ledger's memory to a window of recent blocks, and because only the last
+ * segment can contain a torn write, restart cost depends on the segment size rather than the chain length.
+ */
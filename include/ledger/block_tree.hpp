@@ -0,0 +1,113 @@
+/**
+ * @file block_tree.hpp
+ * @brief Parent-linked tree of non-final blocks used for fork choice.
+ *
+ * This header defines the `BlockTree` class, which holds every block above the last finalized block: the
+ * tail of the main chain together with all competing branches. Branches share their common ancestors instead
+ * of being stored as separate copies, every node carries the cumulative weight of its branch, and the heaviest
+ * tip is tracked as blocks arrive.
+ */
+
+#ifndef BLOCK_TREE_HPP
+#define BLOCK_TREE_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include "block.hpp"
+#include "../cryptography/hash256.hpp"
+
+/**
+ * @struct BlockTreeNode
+ * @brief A block in the tree together with its links and branch weight.
+ */
+struct BlockTreeNode {
+    Block block;                     ///< The block itself.
+    uint32_t parent;                 ///< Node id of the parent, or `BlockTree::NO_NODE` for the root.
+    uint64_t height;                 ///< Height of the block in the chain.
+    uint64_t weight;                 ///< Cumulative weight of the branch from the root up to this block.
+    std::vector<uint32_t> children;  ///< Node ids of the children.
+};
+
+/**
+ * @class BlockTree
+ * @brief Block DAG rooted at the most recent finalized block, with an incrementally maintained heaviest tip.
+ *
+ * Node ids are stable until the next `prune()`. On equal weight the tip seen first is kept, so a competing
+ * branch has to become strictly heavier to win.
+ */
+class BlockTree {
+public:
+    static const uint32_t NO_NODE = 0xFFFFFFFFu;  ///< Id returned when a block is not in the tree.
+
+    BlockTree();
+
+    /**
+     * @brief Discards all nodes and starts a new tree rooted at `root`.
+     *
+     * @param root The finalized block the tree grows from.
+     * @param height The root's height in the chain.
+     */
+    void reset(const Block& root, uint64_t height);
+
+    /**
+     * @brief Inserts a block below its parent (found through the block's previous digest).
+     *
+     * @param block The block to insert.
+     * @param weight The block's own weight, added to its parent's cumulative weight.
+     * @return The node id of the block (the existing id if it was already present).
+     * @throws std::invalid_argument if the parent is not in the tree or the block's number is not one above it.
+     */
+    uint32_t insert(const Block& block, uint64_t weight);
+
+    /**
+     * @brief Returns the node id of the block with the given digest, or `NO_NODE`.
+     */
+    uint32_t find(const Hash256& digest) const;
+
+    const BlockTreeNode& node(uint32_t id) const { return nodes[id]; }  ///< Accesses a node by id.
+    uint32_t root() const { return root_id; }                          ///< Node id of the finalized root.
+    uint32_t best_tip() const { return best_id; }                      ///< Node id of the heaviest tip.
+    size_t size() const { return nodes.size(); }                       ///< Number of nodes.
+
+    /**
+     * @brief Returns the deepest node that is an ancestor of (or equal to) both `a` and `b`.
+     */
+    uint32_t common_ancestor(uint32_t a, uint32_t b) const;
+
+    /**
+     * @brief Returns the nodes from `ancestor` (exclusive) down to `descendant` (inclusive), in chain order.
+     */
+    std::vector<uint32_t> path(uint32_t ancestor, uint32_t descendant) const;
+
+    /**
+     * @brief Returns the ids of all leaves, i.e. the tips of every branch.
+     */
+    std::vector<uint32_t> tips() const;
+
+    /**
+     * @brief Makes `new_root` the root and drops every node that does not descend from it.
+     *
+     * Invalidates node ids.
+     *
+     * @return The digests of the removed blocks.
+     */
+    std::vector<Hash256> prune(uint32_t new_root);
+
+private:
+    std::vector<BlockTreeNode> nodes;                                    ///< Nodes indexed by id.
+    std::unordered_map<Hash256, uint32_t, Hash256Hasher> ids_by_digest;  ///< Digest lookup.
+    uint32_t root_id;                                                    ///< Root node id.
+    uint32_t best_id;                                                    ///< Heaviest tip node id.
+};
+
+#endif  // BLOCK_TREE_HPP
+
+/**
+ * @file block_tree.hpp
+ *
+ * Storing forks as independent block vectors duplicates their shared prefix and turns every switch into a
+ * copy of the whole fork. With parent links, a reorganization only touches the blocks between the common
+ * ancestor and the two tips, and finality bounds the tree to the blocks that can still be reorganized.
+ */
@@ -0,0 +1,202 @@
+/**
+ * @file compact_block.hpp
+ * @brief Compact block relay: block headers with short transaction ids.
+ *
+ * This header defines `CompactBlock`, which carries a block header together with a 6-byte short id per
+ * transaction instead of the transactions themselves, and `PartialBlock`, which rebuilds the full block on the
+ * receiving side from the local `Mempool` and tracks the transactions that still have to be fetched.
+ *
+ * Short ids are SipHash-2-4 values of the transaction hashes, keyed with the first 16 bytes of
+ * SHA-256(header digest | nonce) and truncated to 48 bits. The sender picks the nonce, so a collision an attacker
+ * engineers against one key does not carry over to the next block or the next peer.
+ *
+ * Encoding (little-endian, as in wire_format.hpp):
+ *   u8 version | u64 block_number | i64 timestamp | u64 required_signatures | packed previous_hash |
+ *   32-byte merkle_root | u32 signature_count { str16 signature } | u64 nonce |
+ *   u32 short_id_count { 6-byte short id } | u32 prefilled_count { u32 index | u32 length | transaction }
+ */
+
+#ifndef COMPACT_BLOCK_HPP
+#define COMPACT_BLOCK_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+#include <ctime>
+#include "block.hpp"
+#include "mempool.hpp"
+#include "wire_format.hpp"
+#include "../cryptography/hash256.hpp"
+
+/**
+ * @struct PrefilledTransaction
+ * @brief A transaction sent in full inside a compact block.
+ */
+struct PrefilledTransaction {
+    uint32_t index;   ///< Position of the transaction in the block.
+    Transaction tx;   ///< The transaction.
+};
+
+/**
+ * @struct CompactBlock
+ * @brief Block header plus short transaction ids, in block order.
+ *
+ * Transactions whose short id collides with an earlier one of the same block are prefilled automatically, so
+ * every short id of a well-formed compact block is unique.
+ */
+struct CompactBlock {
+    static const size_t SHORT_ID_BYTES = 6;         ///< Encoded size of a short id.
+    static const uint32_t MAX_TRANSACTIONS = 1000000; ///< Largest transaction count accepted on decode.
+
+    size_t block_number = 0;                        ///< The block's position in the chain.
+    std::time_t timestamp = 0;                      ///< Block creation time.
+    size_t required_signatures = 0;                 ///< Signatures required for finalization.
+    std::string previous_block_hash;                ///< Hash of the previous block.
+    Hash256 merkle_root;                            ///< Merkle root of the transactions.
+    std::vector<std::string> validator_signatures;  ///< Validator signatures.
+    uint64_t nonce = 0;                             ///< Sender-chosen salt of the short id key.
+    std::vector<uint64_t> short_ids;                ///< Short ids of the non-prefilled transactions, in block order.
+    std::vector<PrefilledTransaction> prefilled;    ///< Transactions sent in full, by ascending index.
+
+    /**
+     * @brief Builds the compact form of a block.
+     *
+     * @param block The block to relay.
+     * @param nonce Salt of the short id key.
+     * @param prefill Positions of transactions the receiver is unlikely to have, e.g. ones created by this node.
+     * @throws std::out_of_range if a prefill position is not a transaction of the block.
+     */
+    static CompactBlock from_block(const Block& block, uint64_t nonce, const std::vector<uint32_t>& prefill = {});
+
+    /**
+     * @brief Builds the compact form of a decoded block without materializing its transactions.
+     */
+    static CompactBlock from_view(const BlockView& view, uint64_t nonce);
+
+    /**
+     * @brief Encodes the compact block.
+     */
+    std::string serialize() const;
+
+    /**
+     * @brief Decodes a compact block.
+     * @throws std::runtime_error on truncated input, trailing bytes, an unsupported version or prefilled
+     *         positions that are out of order or out of range.
+     */
+    static CompactBlock deserialize(std::string_view buffer);
+
+    /**
+     * @brief Returns the number of transactions in the block.
+     */
+    size_t transaction_count() const { return short_ids.size() + prefilled.size(); }
+
+    /**
+     * @brief Computes the header digest of the block, equal to `Block::get_block_digest()`.
+     */
+    Hash256 compute_digest() const;
+
+    /**
+     * @brief Computes the short id of a transaction hash under this block's key.
+     */
+    uint64_t short_id(const Hash256& tx_id) const;
+
+    /**
+     * @brief Derives the SipHash key from the header and the nonce. Called by the builders and the decoder;
+     *        must be called again after changing header fields by hand.
+     */
+    void derive_key();
+
+private:
+    uint64_t key0 = 0;  ///< First half of the SipHash key.
+    uint64_t key1 = 0;  ///< Second half of the SipHash key.
+
+    void set_key(const Hash256& block_digest);  ///< Derives the SipHash key for the given header digest.
+
+    /**
+     * @brief Fills `short_ids` for every position that is not prefilled.
+     *
+     * @return One flag per transaction, set for positions that must be prefilled: the requested ones and
+     *         those whose short id repeats an earlier one.
+     */
+    std::vector<bool> assign_short_ids(const std::vector<Hash256>& tx_ids, const std::vector<uint32_t>& prefill);
+};
+
+/**
+ * @class PartialBlock
+ * @brief Receiver-side reconstruction state of a compact block.
+ *
+ * Slots are filled from the prefilled transactions, then from the mempool by short id. A slot whose short id
+ * matches more than one pool transaction is left empty and fetched like any other missing transaction. A
+ * wrong match from a 48-bit collision is caught by the Merkle root check in `to_block`, after which the
+ * caller falls back to downloading the full block.
+ */
+class PartialBlock {
+public:
+    /**
+     * @brief Starts reconstructing a compact block; only its prefilled transactions are placed.
+     */
+    explicit PartialBlock(const CompactBlock& compact);
+
+    /**
+     * @brief Fills empty slots from the pending transactions of a mempool.
+     *
+     * The matched transactions are copied, so the pool may change afterwards.
+     *
+     * @return The number of slots filled.
+     */
+    size_t fill_from(const Mempool& pool);
+
+    /**
+     * @brief Returns the positions of the transactions still missing, in ascending order.
+     */
+    std::vector<uint32_t> get_missing() const;
+
+    /**
+     * @brief Fills the missing slots with fetched transactions, given in the order of `get_missing()`.
+     *
+     * @throws std::invalid_argument if the number of transactions does not match.
+     */
+    void fill_missing(const std::vector<Transaction>& txs);
+
+    /**
+     * @brief Returns true once every slot holds a transaction.
+     */
+    bool is_complete() const { return filled == slots.size(); }
+
+    /**
+     * @brief Materializes the reconstructed block.
+     *
+     * @throws std::runtime_error if slots are missing or the transactions do not match the Merkle root.
+     */
+    Block to_block() const;
+
+    const CompactBlock& get_compact() const { return compact; }   ///< Retrieves the compact block.
+    size_t get_matched_count() const { return matched; }          ///< Slots filled from the mempool.
+
+private:
+    struct Slot {
+        std::optional<Transaction> tx;  ///< The transaction, once known.
+        Hash256 id;                     ///< Its hash.
+        bool ambiguous = false;         ///< More than one pool transaction matched the short id.
+    };
+
+    CompactBlock compact;                                  ///< The block being rebuilt.
+    std::vector<Slot> slots;                               ///< One slot per transaction, in block order.
+    std::unordered_map<uint64_t, uint32_t> by_short_id;    ///< Short id to slot position.
+    size_t filled;                                         ///< Filled slots.
+    size_t matched;                                        ///< Slots filled from the mempool.
+};
+
+#endif  // COMPACT_BLOCK_HPP
+
+/**
+ * @file compact_block.hpp
+ *
+ * A node that has been following the pool already holds nearly every transaction of a new block. Sending it
+ * 6 bytes per transaction instead of the full encodings makes the block message small enough to relay in a single
+ * round trip, and only the transactions the peer actually lacks cross the network a second time.
+ */
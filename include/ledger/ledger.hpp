@@ -13,8 +13,22 @@
 
 #include <vector>
 #include <string>
-#include <map>
+#include <memory>
 #include "block.hpp"  // Includes the block structure for managing the blockchain.
+#include "mempool.hpp"  // Indexed pool of pending transactions.
+#include "block_store.hpp"  // Append-only on-disk block history.
+#include "block_index.hpp"  // Digest-keyed lookup of known blocks.
+#include "block_tree.hpp"   // Fork choice over non-final blocks.
+#include "state_db.hpp"     // Account balances and nonces.
+
+/**
+ * @enum ChainLogMode
+ * @brief Amount of detail written by `Ledger::log_chain_state`.
+ */
+enum class ChainLogMode {
+    SUMMARY,  ///< Length, tip and the most recent blocks.
+    FULL      ///< Every block held in memory (debug level).
+};
 
 /**
  * @class Ledger
@@ -27,15 +41,21 @@
  */
 class Ledger {
 private:
-    std::vector<Block> chain;                        ///< The main blockchain, a sequence of validated blocks.
+    std::vector<Block> chain;                        ///< The most recent blocks of the main chain (all of them without a store).
+    size_t chain_base;                               ///< Height of `chain.front()`.
+    size_t history_base;                             ///< Lowest height held; non-zero after a snapshot start.
+    std::unique_ptr<BlockStore> block_store;         ///< Persistent block history, if a data directory is used.
+    std::string checkpoint_path;                     ///< State checkpoint next to the block store, if one is used.
+    size_t replayed_blocks;                          ///< Stored blocks replayed on open past the checkpoint.
     size_t difficulty;                               ///< The difficulty level for mining/validation.
     size_t current_block_number;                     ///< The current height of the blockchain.
-    std::map<std::string, std::vector<Block>> forks; ///< Tracks alternate chains (forks) in case of disagreements.
+    BlockTree block_tree;                            ///< Non-final blocks of the main chain and all competing branches.
     std::string current_chain_tip_hash;              ///< The hash of the latest block in the main chain.
-    std::map<std::string, size_t> fork_lengths;      ///< The length of each fork chain.
-    std::map<std::string, size_t> fork_difficulties; ///< The difficulty levels for each fork chain.
-    std::map<std::string, bool> confirmed_blocks;    ///< Tracks which blocks have been confirmed.
-    std::vector<Transaction> transaction_pool;       ///< A pool of pending transactions awaiting inclusion in a block.
+    BlockIndex block_index;                          ///< Location and confirmation state of every known block.
+    mutable size_t validated_height;                 ///< Blocks below this height have been validated.
+    mutable Hash256 validated_tip;                   ///< Digest of the block at `validated_height - 1`.
+    Mempool mempool;                                 ///< Pending transactions awaiting inclusion in a block.
+    StateDB state;                                   ///< Account balances and nonces after the main-chain tip.
 
     /**
      * @brief Calculates the genesis block's hash.
@@ -47,49 +67,130 @@ private:
     std::string calculate_genesis_block_hash();
 
     /**
-     * @brief Calculates the Merkle root of the transactions in a block.
+     * @brief Prunes branches that can no longer become canonical.
      * 
-     * The Merkle root ensures the integrity of all transactions in a block. It provides a summary 
-     * hash derived from all the transactions.
+     * Once the main chain is `FINALITY_DEPTH` blocks past the tree root, the root is advanced to the final block
+     * and every branch that does not descend from it is dropped.
+     */
+    void prune_forks();
+
+    /**
+     * @brief Switches the main chain to the branch ending at the given tree node.
      * 
-     * @param transactions The list of transactions in the block.
-     * @return The Merkle root of the transactions.
+     * Rolls back to the common ancestor and appends the branch, so the cost is the depth of the divergence.
+     */
+    void reorganize_to(uint32_t tip_node);
+
+    /**
+     * @brief Appends a block to the resident window and the block store.
+     */
+    void append_block(Block&& block);
+
+    /**
+     * @brief Reloads the resident window so that it ends at the stored tip.
+     */
+    void load_resident_window();
+
+    /**
+     * @brief Writes the account state and the main-chain index entries after the stored tip to `checkpoint_path`.
+     *
+     * The file is written next to the previous checkpoint and renamed over it, so a crash leaves either one intact.
+     */
+    void write_checkpoint();
+
+    /**
+     * @brief Loads the checkpoint into the account state and the block index if it matches the block store.
+     *
+     * @return Number of stored blocks the checkpoint covers, or 0 if it is missing, damaged or stale.
+     */
+    size_t load_checkpoint();
+
+    /**
+     * @brief Records a block's location in the index, keeping its confirmation state.
      */
-    std::string calculate_merkle_root(const std::vector<Transaction>& transactions);
+    void index_block(const Block& block, size_t height, uint32_t location);
 
     /**
-     * @brief Prunes outdated or invalid forks.
+     * @brief Returns the main-chain block at `height`, loading it into `scratch` if it is not resident.
+     */
+    const Block& block_at(size_t height, Block& scratch) const;
+
+    /**
+     * @brief Validates the links of heights `[begin, end)` (with `begin >= 1`) sequentially.
      * 
-     * Removes forks that are no longer viable, helping to keep the ledger lean and focused on valid chains.
+     * @param reason Set to a description of the first failure.
+     * @return The first invalid height, or `end` if the whole range is valid.
      */
-    void prune_forks();
+    size_t validate_range(size_t begin, size_t end, const char*& reason) const;
 
 public:
+    static const size_t RESIDENT_BLOCKS = 512;       ///< Blocks kept in memory when a block store is used.
+    static const size_t FINALITY_DEPTH = 10;         ///< Confirmations after which a block can no longer be reorganized.
+    static const size_t CHECKPOINT_INTERVAL = 1024;  ///< Stored blocks between state checkpoints.
+
     /**
      * @brief Constructs a Ledger with an initial difficulty level.
      * 
-     * Initializes the ledger and sets the starting difficulty for block validation.
+     * Initializes the ledger and sets the starting difficulty for block validation. With a data directory the chain
+     * is persisted in a `BlockStore`; an existing store is reopened and only its tail is validated, so a restart
+     * resumes from the stored tip instead of a fresh genesis block. The account state and block index are loaded
+     * from the state checkpoint written every `CHECKPOINT_INTERVAL` blocks and on destruction, and only the blocks
+     * stored after it are replayed; without a usable checkpoint the whole store is replayed.
+     * 
+     * @param initial_difficulty The difficulty level for block validation.
+     * @param data_dir Directory for the block store, or empty to keep the chain in memory only.
+     */
+    Ledger(size_t initial_difficulty, const std::string& data_dir = "");
+
+    /**
+     * @brief Constructs a memory-only Ledger that starts at a snapshot block instead of genesis.
+     * 
+     * Used by fast sync: the block and the account state after it come from a verified state snapshot, and only
+     * later blocks are added. Heights below the snapshot block are not held, so they can neither be read nor
+     * rolled back; validation and audits start at the snapshot block.
      * 
      * @param initial_difficulty The difficulty level for block validation.
+     * @param base_block The snapshot block, which becomes the tip.
+     * @param accounts The account state after `base_block`.
+     * @throws std::invalid_argument if the block's cached digest does not match its contents.
      */
-    Ledger(size_t initial_difficulty);
+    Ledger(size_t initial_difficulty, const Block& base_block, const std::vector<AccountEntry>& accounts);
+
+    /**
+     * @brief Writes a final state checkpoint if a block store is used, so the next open replays nothing.
+     */
+    ~Ledger();
 
     /**
      * @brief Adds a block to the main chain.
      * 
-     * Validates and appends a new block to the blockchain.
+     * Validates and appends a new block to the blockchain. The signatures of its transactions are verified as a
+     * batch, since blocks received from peers were never checked on decode.
      * 
      * @param block The block to be added.
+     * @throws std::invalid_argument if the block does not extend the tip or a transaction signature is invalid.
      */
     void add_block(const Block& block);
 
+    /**
+     * @brief Adds a block to the main chain, taking over its storage instead of copying it.
+     *
+     * @param block The block to be added; left in a valid but unspecified state.
+     * @throws std::invalid_argument if the block does not extend the tip or a transaction signature is invalid.
+     */
+    void add_block(Block&& block);
+
     /**
      * @brief Adds a block to a fork.
      * 
-     * In the case of a chain split, adds a block to the appropriate fork.
+     * In the case of a chain split, adds the block to the block tree below its parent, which may be any non-final
+     * block. Branches share their ancestors, and the heaviest tip is updated incrementally; the main chain is only
+     * changed by `select_fork()` or `apply_fork_choice()`.
      * 
-     * @param fork_tip The hash of the tip of the fork where the block will be added.
+     * @param fork_tip The hash of the tip of the fork where the block will be added (the block's parent).
      * @param block The block to add to the fork.
+     * @throws std::invalid_argument if `fork_tip` is not the block's parent, the parent is not a non-final block, or
+     *         a transaction signature is invalid.
      */
     void add_fork_block(const std::string& fork_tip, const Block& block);
 
@@ -103,32 +204,104 @@ public:
     /**
      * @brief Returns the entire main chain.
      * 
-     * Provides access to the sequence of blocks that form the current main blockchain.
+     * Provides access to the sequence of blocks that form the current main blockchain. When a block store is used
+     * only the most recent blocks are resident; `get_chain_base()` gives the height of the first one and older
+     * blocks are available through `get_block()`.
      * 
      * @return A vector of blocks representing the main chain.
      */
     const std::vector<Block>& get_chain() const;
 
     /**
-     * @brief Retrieves the list of forks.
+     * @brief Returns the height of the first block in `get_chain()`.
+     */
+    size_t get_chain_base() const;
+
+    /**
+     * @brief Returns the lowest height the ledger holds: 0, or the snapshot block's height after a fast sync.
+     */
+    size_t get_history_base() const;
+
+    /**
+     * @brief Retrieves a block of the main chain by height, reading it from the block store if it is not resident.
+     * 
+     * @param height The block's height in the main chain.
+     * @return The block.
+     * @throws std::out_of_range if the height is past the tip or below the snapshot the ledger started from.
+     */
+    Block get_block(size_t height) const;
+
+    /**
+     * @brief Returns the block store, or nullptr if the ledger is memory-only.
+     */
+    const BlockStore* get_block_store() const;
+
+    /**
+     * @brief Returns how many stored blocks were replayed on open because the state checkpoint did not cover them.
+     */
+    size_t get_replayed_blocks() const;
+
+    /**
+     * @brief Retrieves the block tree holding all non-final blocks and forks.
      * 
-     * @return A map of forks, each represented by a chain of blocks.
+     * @return The block tree; `tips()` lists the fork tips and `best_tip()` the heaviest one.
      */
-    const std::map<std::string, std::vector<Block>>& get_forks() const;
+    const BlockTree& get_forks() const;
+
+    /**
+     * @brief Checks whether a block is held on the main chain or a fork.
+     * 
+     * Served by a single probe of the block index; used to answer peers' "do you have block X" queries.
+     * 
+     * @param block_digest The raw digest of the block.
+     * @return True if the block is known.
+     */
+    bool has_block(const Hash256& block_digest) const;
+
+    /**
+     * @brief Looks up a block's index entry (height, location, confirmation).
+     * 
+     * @param block_digest The raw digest of the block.
+     * @return The entry, or nullptr if nothing is recorded. Invalidated by any change to the ledger.
+     */
+    const BlockIndexEntry* find_block(const Hash256& block_digest) const;
+
+    static const size_t AUDIT_CHUNK_BLOCKS = 256;    ///< Heights validated per work item in `audit_chain()`.
 
     /**
      * @brief Validates the integrity of the main blockchain.
      * 
-     * Ensures that all blocks in the main chain are valid and that the chain has not been tampered with.
+     * Validation is incremental: the ledger keeps a "validated up to height H with tip X" watermark and only
+     * checks blocks appended since. Rollbacks lower the watermark, so a reorganization only re-checks the blocks it
+     * appended. If the block at `H - 1` still no longer matches the recorded tip, the whole chain is validated
+     * again from the first block the ledger holds: genesis, or the snapshot block after a fast sync.
      * 
      * @return True if the chain is valid, false otherwise.
      */
     bool validate_chain() const;
 
+    /**
+     * @brief Re-validates the whole main chain from genesis in parallel.
+     * 
+     * The chain is split into chunks of `AUDIT_CHUNK_BLOCKS` heights that are checked on separate threads.
+     * Historical blocks are read from the block store when they are not resident. On return the validation
+     * watermark reflects the audited result.
+     * 
+     * @param num_threads Number of worker threads; 0 uses the OpenMP default.
+     * @return True if every block is valid, false otherwise.
+     */
+    bool audit_chain(int num_threads = 0) const;
+
+    /**
+     * @brief Returns the height up to which the chain is known to be valid.
+     */
+    size_t get_validated_height() const;
+
     /**
      * @brief Validates a specific fork.
      * 
-     * Ensures that the blocks in the fork are valid and consistent.
+     * Ensures that the blocks between the fork tip and its common ancestor with the main chain are valid and
+     * consistent.
      * 
      * @param fork_tip The hash of the tip of the fork to validate.
      * @return True if the fork is valid, false otherwise.
@@ -165,20 +338,31 @@ public:
     /**
      * @brief Logs the current state of the blockchain.
      * 
-     * Outputs the state of the chain and any forks, useful for debugging or auditing.
+     * Outputs the state of the chain and any forks, useful for debugging or auditing. The summary reports the
+     * length, the tip and the last few blocks; the full dump lists every block held in memory at debug level.
+     * 
+     * @param mode How much of the chain to log.
      */
-    void log_chain_state() const;
+    void log_chain_state(ChainLogMode mode = ChainLogMode::SUMMARY) const;
 
     /**
      * @brief Switches the main chain to a selected fork.
      * 
-     * If a fork has outpaced the main chain, this method allows the ledger to switch to the fork.
+     * If a fork has outpaced the main chain, this method allows the ledger to switch to the fork. The diverged
+     * section of the main chain is rolled back before the fork's blocks are appended.
      * 
      * @param fork_tip The hash of the fork tip to switch to.
      * @return True if the switch was successful, false otherwise.
      */
     bool select_fork(const std::string& fork_tip);
 
+    /**
+     * @brief Switches the main chain to the heaviest tip of the block tree if it is not already canonical.
+     * 
+     * @return True if a reorganization took place.
+     */
+    bool apply_fork_choice();
+
     /**
      * @brief Sets a block's confirmation status.
      * 
@@ -197,14 +381,25 @@ public:
      */
     bool is_block_confirmed(const std::string& block_hash) const;
 
+    /**
+     * @brief Checks if a block is confirmed, by raw digest.
+     * 
+     * @param block_digest The raw digest of the block.
+     * @return True if the block is confirmed, false otherwise.
+     */
+    bool is_block_confirmed(const Hash256& block_digest) const;
+
     /**
      * @brief Adds a transaction to the pool of pending transactions.
      * 
-     * Stores a transaction until it is included in a block.
+     * Verifies the transaction's signature and stores it until it is included in a block. Transactions carry no
+     * explicit fee, so the transferred amount is used as the selection priority.
      * 
      * @param tx The transaction to add to the pool.
+     * @return True if the transaction was admitted, false if it was already pending or the pool is full.
+     * @throws std::invalid_argument if the transaction signature is invalid.
      */
-    void add_transaction(const Transaction& tx);
+    bool add_transaction(const Transaction& tx);
 
     /**
      * @brief Checks if there are pending transactions in the pool.
@@ -214,13 +409,22 @@ public:
     bool has_pending_transactions() const;
 
     /**
-     * @brief Retrieves the list of pending transactions.
+     * @brief Provides in-place access to the pending transactions.
+     * 
+     * Block producers select their template from the returned pool without copying it.
+     * 
+     * @return The pool of pending transactions.
+     */
+    const Mempool& get_pending_transactions() const;
+
+    /**
+     * @brief Provides the account state after the current main-chain tip.
      * 
-     * Returns all transactions currently awaiting inclusion in a block.
+     * Readers should take a `StateDB::snapshot()` so that their queries do not race with block application.
      * 
-     * @return A vector of pending transactions.
+     * @return The account state database.
      */
-    std::vector<Transaction> get_pending_transactions() const;
+    const StateDB& get_state() const;
 };
 
 #endif // LEDGER_HPP
@@ -0,0 +1,155 @@
+/**
+ * @file mempool.hpp
+ * @brief Indexed pool of pending transactions for SynLedger.
+ *
+ * This header defines the `Mempool` class, which holds transactions that have been accepted by the node but
+ * not yet included in a block. Transactions are indexed by their hash, grouped into per-sender FIFO queues
+ * and ordered by a priority index that drives block template selection and size-bounded eviction.
+ */
+
+#ifndef MEMPOOL_HPP
+#define MEMPOOL_HPP
+
+#include <set>
+#include <deque>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include "block.hpp"
+#include "../cryptography/hash256.hpp"
+
+/**
+ * @struct MempoolEntry
+ * @brief A pending transaction together with its pool bookkeeping.
+ */
+struct MempoolEntry {
+    Transaction tx;     ///< The pending transaction.
+    Hash256 id;         ///< Transaction hash (`Transaction::hash()`).
+    double priority;    ///< Selection priority; higher is included first and evicted last.
+    uint64_t sequence;  ///< Admission order, used to break priority ties.
+};
+
+/**
+ * @class Mempool
+ * @brief Size-bounded transaction pool with hash, sender and priority indexes.
+ *
+ * Transactions from the same sender are always selected in arrival order; across senders the pool picks the
+ * highest-priority queue head. When the pool is full, a new transaction replaces the lowest-priority entry only
+ * if it pays strictly more.
+ */
+class Mempool {
+public:
+    static const size_t DEFAULT_CAPACITY = 50000;  ///< Default maximum number of pending transactions.
+
+    /**
+     * @brief Constructs an empty pool holding at most `capacity` transactions.
+     */
+    explicit Mempool(size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * @brief Adds a transaction to the pool.
+     *
+     * @param tx The transaction to add. Its signature is expected to be verified by the caller.
+     * @param priority Selection priority (e.g. the fee paid).
+     * @return True if the transaction was admitted, false if it is a duplicate or the pool is full of
+     *         higher-priority transactions.
+     */
+    bool add(const Transaction& tx, double priority);
+
+    /**
+     * @brief Checks whether a transaction with the given hash is pending.
+     */
+    bool contains(const Hash256& id) const;
+
+    /**
+     * @brief Looks up a pending transaction by hash.
+     *
+     * @return A pointer to the transaction, or nullptr if it is not pending. Invalidated by any mutation.
+     */
+    const Transaction* find(const Hash256& id) const;
+
+    /**
+     * @brief Removes a transaction by hash.
+     *
+     * @return True if the transaction was pending.
+     */
+    bool remove(const Hash256& id);
+
+    /**
+     * @brief Removes every transaction included in the given block.
+     *
+     * Uses the block's Merkle leaves as transaction hashes, so nothing is re-serialized.
+     *
+     * @param block A block that has just been committed to the chain.
+     * @return The number of transactions removed from the pool.
+     */
+    size_t remove_included(const Block& block);
+
+    /**
+     * @brief Selects up to `max_count` transactions for a block template.
+     *
+     * @return Pointers into the pool in inclusion order. Invalidated by any mutation.
+     */
+    std::vector<const Transaction*> select(size_t max_count) const;
+
+    /**
+     * @brief Returns the number of pending transactions from the given sender.
+     */
+    size_t sender_count(const std::string& sender) const;
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    size_t get_capacity() const { return capacity; }
+    size_t get_evicted_count() const { return evicted; }  ///< Transactions dropped to make room.
+
+    /**
+     * @brief Calls `visit(const MempoolEntry&)` for every pending transaction, in no particular order.
+     */
+    template <typename Visitor>
+    void for_each(Visitor&& visit) const {
+        for (const auto& item : entries) {
+            visit(item.second);
+        }
+    }
+
+    /**
+     * @brief Removes all pending transactions.
+     */
+    void clear();
+
+private:
+    /**
+     * @brief Ordering key of the priority index; ascending order puts the next eviction victim first.
+     */
+    struct PriorityKey {
+        double priority;
+        uint64_t sequence;
+        Hash256 id;
+
+        bool operator<(const PriorityKey& other) const {
+            if (priority != other.priority) {
+                return priority < other.priority;
+            }
+            return sequence > other.sequence;  // On ties the newest entry is evicted first.
+        }
+    };
+
+    size_t capacity;                                                      ///< Maximum number of entries.
+    uint64_t next_sequence;                                               ///< Sequence number of the next admission.
+    size_t evicted;                                                       ///< Number of evicted entries.
+    std::unordered_map<Hash256, MempoolEntry, Hash256Hasher> entries;     ///< Hash index.
+    std::unordered_map<std::string, std::deque<Hash256>> sender_queues;   ///< Per-sender FIFO queues.
+    std::set<PriorityKey> by_priority;                                    ///< Priority index.
+};
+
+#endif  // MEMPOOL_HPP
+
+/**
+ * @file mempool.hpp
+ *
+ * A vector-backed pool has to be copied for every block template and cannot deduplicate or shed load. Keeping the
+ * pending set behind hash, sender and priority indexes lets the block producer read a template in place and lets
+ * committed blocks prune the pool in time proportional to their own size.
+ */
@@ -0,0 +1,98 @@
+/**
+ * @file merkle_tree.hpp
+ * @brief Incremental Merkle tree over block transactions.
+ *
+ * This header defines the `MerkleTree` class used by blocks to commit to their transactions, and the
+ * `MerkleProof` structure that lets light clients verify that a transaction is included in a block
+ * knowing only the block header. Interior nodes are cached level by level, so appending a leaf only
+ * recomputes the nodes on the path from that leaf to the root.
+ */
+
+#ifndef MERKLE_TREE_HPP
+#define MERKLE_TREE_HPP
+
+#include <vector>
+#include <cstddef>
+#include <string_view>
+#include "../cryptography/hash256.hpp"
+
+/**
+ * @struct MerkleProof
+ * @brief Inclusion proof for a single leaf.
+ *
+ * Siblings are ordered from the leaf level upwards. On levels with an odd number of nodes the last
+ * node is paired with itself, so its sibling is its own hash.
+ */
+struct MerkleProof {
+    size_t leaf_index;              ///< Position of the proven leaf.
+    size_t leaf_count;              ///< Number of leaves in the tree the proof was taken from.
+    std::vector<Hash256> siblings;  ///< Sibling hashes from the leaf level to just below the root.
+};
+
+/**
+ * @class MerkleTree
+ * @brief Append-only binary Merkle tree with cached interior nodes.
+ *
+ * Leaf and interior hashes are domain-separated (0x00 and 0x01 prefixes) so that an interior node can
+ * never be passed off as a leaf. Because the last node of an odd level is duplicated, the leaf count
+ * must be committed alongside the root to make the root unambiguous; `Block` does this in its header.
+ */
+class MerkleTree {
+public:
+    /**
+     * @brief Hashes raw leaf data (e.g. an encoded transaction) into a leaf hash.
+     */
+    static Hash256 hash_leaf(std::string_view leaf_data);
+
+    /**
+     * @brief Hashes two child nodes into their parent.
+     */
+    static Hash256 hash_node(const Hash256& left, const Hash256& right);
+
+    /**
+     * @brief Appends a leaf hash, updating only the O(log n) nodes on its path to the root.
+     */
+    void append(const Hash256& leaf_hash);
+
+    /**
+     * @brief Removes all leaves and cached nodes.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the root hash, or an all-zero digest for an empty tree.
+     */
+    Hash256 root() const;
+
+    size_t size() const;                        ///< Number of leaves.
+    const Hash256& leaf(size_t index) const;    ///< Leaf hash at the given position.
+
+    /**
+     * @brief Builds an inclusion proof for the leaf at `index`.
+     * @throws std::out_of_range if the index is not a valid leaf position.
+     */
+    MerkleProof prove(size_t index) const;
+
+    /**
+     * @brief Verifies an inclusion proof against a known root.
+     *
+     * @param leaf_hash Hash of the leaf being proven (see `hash_leaf`).
+     * @param proof The inclusion proof.
+     * @param root The Merkle root from a trusted block header.
+     * @return True if the proof links the leaf to the root.
+     */
+    static bool verify(const Hash256& leaf_hash, const MerkleProof& proof, const Hash256& root);
+
+private:
+    std::vector<std::vector<Hash256>> levels;  ///< levels[0] holds the leaves, the last level the root.
+};
+
+#endif  // MERKLE_TREE_HPP
+
+/**
+ * @file merkle_tree.hpp
+ *
+ * Committing to transactions through a Merkle root keeps the block header constant-size: the header
+ * hash no longer depends on re-serializing every transaction, and a single transaction can be proven
+ * with a logarithmic number of hashes.
+ */
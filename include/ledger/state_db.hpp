@@ -0,0 +1,181 @@
+/**
+ * @file state_db.hpp
+ * @brief Account state (balances and nonces) derived from the main chain.
+ *
+ * This header defines the `StateDB` class, which maintains the balance and nonce of every account touched by a
+ * committed transaction. Blocks are executed optimistically in parallel: every transaction is first executed
+ * against the pre-block state on its own thread, then results are committed in block order and transactions
+ * whose accounts were already written earlier in the same block are re-executed. The state is split into shards
+ * that are copied on write, so readers hold an immutable `StateSnapshot` and never block block application.
+ */
+
+#ifndef STATE_DB_HPP
+#define STATE_DB_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include "block.hpp"
+#include "wire_format.hpp"
+
+/**
+ * @struct AccountState
+ * @brief Balance and transaction count of an account.
+ */
+struct AccountState {
+    double balance;  ///< Current balance; accounts that never appeared have a zero balance.
+    uint64_t nonce;  ///< Number of transactions sent by the account.
+};
+
+/**
+ * @brief An account and its state, as listed by `StateSnapshot::entries()` and loaded by `StateDB::load()`.
+ */
+using AccountEntry = std::pair<std::string, AccountState>;
+
+/**
+ * @struct StateTransfer
+ * @brief The state transition of one transaction: `amount` moves from `sender` to `receiver`.
+ */
+struct StateTransfer {
+    std::string_view sender;    ///< Debited account; its nonce is incremented.
+    std::string_view receiver;  ///< Credited account.
+    double amount;              ///< Transferred amount.
+};
+
+/**
+ * @class StateSnapshot
+ * @brief Immutable view of the account state after a given number of applied blocks.
+ */
+class StateSnapshot {
+public:
+    using Shard = std::unordered_map<std::string, AccountState>;
+
+    /**
+     * @brief Returns the state of an account (zero balance and nonce if it never appeared).
+     */
+    AccountState get(const std::string& address) const;
+
+    uint64_t get_version() const { return version; }  ///< Number of blocks applied to reach this state.
+    size_t account_count() const;                     ///< Number of known accounts.
+
+    /**
+     * @brief Lists every known account, sorted by address, so that equal states list identically.
+     */
+    std::vector<AccountEntry> entries() const;
+
+private:
+    friend class StateDB;
+
+    std::vector<std::shared_ptr<const Shard>> shards;  ///< Shards, shared with other snapshots until written.
+    uint64_t version;                                  ///< Number of applied blocks.
+
+    size_t shard_of(std::string_view address) const;
+};
+
+/**
+ * @struct ExecutionStats
+ * @brief Outcome of executing one block.
+ */
+struct ExecutionStats {
+    size_t executed;    ///< Transactions executed speculatively.
+    size_t reexecuted;  ///< Transactions re-executed because an earlier transaction touched their accounts.
+};
+
+/**
+ * @class StateDB
+ * @brief Sharded, copy-on-write account state with optimistic parallel block execution.
+ *
+ * Transactions carry no fee and the chain has no issuance rule yet, so execution mirrors what the chain
+ * records: the amount is always moved, and balances may become negative. Writers (apply/revert) are
+ * serialized; `snapshot()` can be called from any thread at any time.
+ */
+class StateDB {
+public:
+    static const size_t DEFAULT_SHARD_COUNT = 64;  ///< Default number of copy-on-write shards.
+
+    /**
+     * @brief Constructs an empty state.
+     *
+     * @param shard_count Number of shards; only touched shards are copied when a block commits.
+     * @param num_threads Threads used for speculative execution; 0 uses the OpenMP default.
+     */
+    explicit StateDB(size_t shard_count = DEFAULT_SHARD_COUNT, int num_threads = 0);
+
+    /**
+     * @brief Returns the latest committed state. The snapshot stays valid and unchanged while held.
+     */
+    std::shared_ptr<const StateSnapshot> snapshot() const;
+
+    /**
+     * @brief Returns the latest committed state of an account.
+     */
+    AccountState get_account(const std::string& address) const;
+
+    /**
+     * @brief Number of blocks applied to the current state.
+     */
+    uint64_t get_version() const;
+
+    /**
+     * @brief Executes and commits the transactions of a block.
+     */
+    ExecutionStats apply_block(const Block& block);
+
+    /**
+     * @brief Executes and commits a block decoded in place (e.g. from the block store) without materializing it.
+     */
+    ExecutionStats apply_block(const BlockView& block);
+
+    /**
+     * @brief Undoes a previously applied block (used on rollback and reorganization).
+     */
+    void revert_block(const Block& block);
+
+    /**
+     * @brief Executes and commits transfers that do not come from a block, e.g. credits relayed from another shard.
+     */
+    ExecutionStats apply_transfers(const std::vector<StateTransfer>& transfers);
+
+    /**
+     * @brief Makes an earlier snapshot of this state current again, discarding everything applied since.
+     *
+     * Snapshots share their shards, so restoring costs no copying.
+     */
+    void restore(const std::shared_ptr<const StateSnapshot>& snapshot);
+
+    /**
+     * @brief Replaces the whole state with the given accounts, e.g. from a state snapshot downloaded by a new node.
+     *
+     * @param accounts Accounts and their states; addresses must be distinct.
+     * @param version Number of blocks the accounts reflect.
+     * @throws std::invalid_argument if an address appears twice.
+     */
+    void load(const std::vector<AccountEntry>& accounts, uint64_t version);
+
+private:
+    size_t shard_count;                                  ///< Number of shards.
+    int num_threads;                                     ///< Speculative execution threads.
+    std::shared_ptr<const StateSnapshot> current;        ///< Latest committed state.
+    mutable std::mutex snapshot_mutex;                   ///< Guards `current`.
+    std::mutex write_mutex;                              ///< Serializes block application.
+
+    ExecutionStats execute(const std::vector<StateTransfer>& transfers);
+    void publish(const std::shared_ptr<const StateSnapshot>& base,
+                 const std::unordered_map<std::string_view, AccountState>& writes, uint64_t version);
+};
+
+#endif  // STATE_DB_HPP
+
+/**
+ * @file state_db.hpp
+ *
+ * Without an account state every consumer has to replay the chain to answer a balance query. Keeping the state
+ * next to the ledger, updated as blocks commit and readable through snapshots, turns those queries into lookups
+ * while block execution itself scales with the number of independent transactions in a block.
+ */
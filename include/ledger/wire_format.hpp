@@ -0,0 +1,205 @@
+/**
+ * @file wire_format.hpp
+ * @brief Versioned binary wire/storage encoding for transactions and blocks.
+ *
+ * This header defines the low-level primitives used to encode `Transaction` and `Block` objects into a
+ * compact, length-prefixed binary representation, together with zero-copy decoders that expose views
+ * over a received buffer. All integers are little-endian and fixed-width, amounts are stored as raw
+ * IEEE-754 bits, and hex-encoded hashes and signatures are packed back into their raw bytes.
+ *
+ * Transaction layout:
+ *   u8 version | u8 type | u64 amount | str16 sender | str16 receiver | packed signature | str32 data
+ *
+ * Block layout:
+ *   u8 version | u64 block_number | i64 timestamp | u64 required_signatures | packed previous_hash |
+ *   32-byte merkle_root | u32 signature_count { str16 signature } |
+ *   u32 transaction_count { u32 length | transaction }
+ *
+ * Both layouts start with WIRE_FORMAT_VERSION; version 2 added the Merkle root to the block header.
+ *
+ * A packed field starts with a one-byte tag: `PACKED_DIGEST` is followed by 32 raw bytes,
+ * `PACKED_HEX` and `PACKED_OPAQUE` are followed by a u16 length and the bytes themselves. Decoders
+ * reject non-canonical packings, so every object has exactly one valid encoding and hashes computed over
+ * received bytes match hashes over re-encoded objects.
+ */
+
+#ifndef WIRE_FORMAT_HPP
+#define WIRE_FORMAT_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <ctime>
+#include "block.hpp"
+#include "../cryptography/hash256.hpp"
+
+const uint8_t WIRE_FORMAT_VERSION = 2;  ///< Version byte written at the start of every encoded object.
+
+const uint8_t PACKED_OPAQUE = 0;        ///< Packed field stored verbatim.
+const uint8_t PACKED_HEX    = 1;        ///< Packed field holding hex-decoded bytes of a lowercase hex string.
+const uint8_t PACKED_DIGEST = 2;        ///< Packed field holding a raw 32-byte digest (64 hex characters).
+
+/**
+ * @class ByteWriter
+ * @brief Appends fixed-width little-endian fields to an output buffer.
+ */
+class ByteWriter {
+public:
+    explicit ByteWriter(std::string& out) : out(out) {}
+
+    void put_u8(uint8_t value);
+    void put_u16(uint16_t value);
+    void put_u32(uint32_t value);
+    void put_u64(uint64_t value);
+    void put_f64(double value);
+    void put_bytes(const void* data, size_t size);
+
+    /**
+     * @brief Writes a u16 length prefix followed by the bytes of the string.
+     * @throws std::invalid_argument if the string does not fit into 65535 bytes.
+     */
+    void put_str16(std::string_view value);
+
+    /**
+     * @brief Writes a u32 length prefix followed by the bytes of the string.
+     */
+    void put_str32(std::string_view value);
+
+    /**
+     * @brief Writes a hex string (hash, signature) in its most compact packed form.
+     *
+     * 64-character lowercase hex strings are stored as 32 raw bytes, other lowercase hex strings as their
+     * decoded bytes, and everything else verbatim, so that decoding always restores the original text.
+     */
+    void put_packed(std::string_view value);
+
+    size_t size() const { return out.size(); }
+
+    /**
+     * @brief Overwrites a previously written u32 at the given offset (used for back-patched lengths).
+     */
+    void patch_u32(size_t offset, uint32_t value);
+
+private:
+    std::string& out;
+};
+
+/**
+ * @struct PackedField
+ * @brief View over a packed field inside an encoded buffer.
+ */
+struct PackedField {
+    uint8_t tag;             ///< One of PACKED_OPAQUE, PACKED_HEX or PACKED_DIGEST.
+    std::string_view bytes;  ///< Raw bytes as stored in the buffer.
+
+    /**
+     * @brief Restores the original (hex or verbatim) string representation.
+     */
+    std::string to_string() const;
+};
+
+/**
+ * @class ByteReader
+ * @brief Bounds-checked reader over an encoded buffer that never copies payload bytes.
+ */
+class ByteReader {
+public:
+    ByteReader(const char* data, size_t size) : data(data), size(size), pos(0) {}
+    explicit ByteReader(std::string_view buffer) : ByteReader(buffer.data(), buffer.size()) {}
+
+    uint8_t get_u8();
+    uint16_t get_u16();
+    uint32_t get_u32();
+    uint64_t get_u64();
+    double get_f64();
+    std::string_view get_bytes(size_t count);
+    std::string_view get_str16();
+    std::string_view get_str32();
+    PackedField get_packed();
+
+    /**
+     * @brief Returns a view over the bytes consumed since `start`.
+     */
+    std::string_view view_from(size_t start) const;
+
+    size_t remaining() const { return size - pos; }
+    size_t position() const { return pos; }
+
+private:
+    const char* data;
+    size_t size;
+    size_t pos;
+
+    void require(size_t count) const;
+};
+
+/**
+ * @struct TransactionView
+ * @brief Zero-copy decoded transaction whose fields point into the source buffer.
+ *
+ * The view is only valid while the buffer it was decoded from is alive.
+ */
+struct TransactionView {
+    std::string_view sender;    ///< Sender address.
+    std::string_view receiver;  ///< Receiver address.
+    double amount;              ///< Transferred amount.
+    PackedField signature;      ///< Signature in packed form.
+    TransactionType type;       ///< Transaction type.
+    std::string_view data;      ///< Additional payload.
+    std::string_view encoded;   ///< The complete encoding of this transaction.
+
+    /**
+     * @brief Decodes a transaction from the reader's current position.
+     * @throws std::runtime_error on truncated input or an unsupported version.
+     */
+    static TransactionView decode(ByteReader& reader);
+
+    /**
+     * @brief Materializes an owning Transaction from the view.
+     */
+    Transaction to_transaction() const;
+};
+
+/**
+ * @struct BlockView
+ * @brief Zero-copy decoded block over an encoded buffer.
+ *
+ * Header fields are decoded eagerly; transactions are exposed as views into the same buffer.
+ */
+struct BlockView {
+    size_t block_number;                              ///< The block's position in the chain.
+    std::time_t timestamp;                            ///< Block creation time.
+    size_t required_signatures;                       ///< Signatures required for finalization.
+    PackedField previous_block_hash;                  ///< Hash of the previous block in packed form.
+    std::string_view merkle_root;                     ///< Raw 32-byte Merkle root of the transactions.
+    std::vector<std::string_view> validator_signatures; ///< Validator signatures.
+    std::vector<TransactionView> transactions;        ///< Transactions contained in the block.
+
+    /**
+     * @brief Decodes a block from an encoded buffer.
+     * @throws std::runtime_error on truncated input, trailing bytes or an unsupported version.
+     */
+    static BlockView decode(std::string_view buffer);
+
+    /**
+     * @brief Computes the block's header digest, equal to `Block::get_block_digest()` of the materialized block.
+     */
+    Hash256 compute_digest() const;
+};
+
+/**
+ * @brief Encodes a transaction in the binary wire format, appending to the writer.
+ */
+void encode_transaction(ByteWriter& writer, const TransactionRef& tx);
+
+#endif  // WIRE_FORMAT_HPP
+
+/**
+ * @file wire_format.hpp
+ *
+ * Keeping the encoding versioned and fixed-width lets nodes parse blocks straight out of a network or
+ * storage buffer without tokenizing text or formatting floating-point numbers. The decoders hand out
+ * views rather than strings, so import paths only allocate when they actually need owning copies.
+ */
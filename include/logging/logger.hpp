@@ -0,0 +1,245 @@
+/**
+ * @file logger.hpp
+ * @brief Asynchronous, level-filtered logging for SynLedger.
+ *
+ * This header defines the logging macros used across the node and the `Logger` that backs them. A log statement
+ * formats its message into a fixed-size record on the calling thread, without allocating or locking, and pushes
+ * the record into that thread's lock-free ring buffer. A background writer drains every ring, orders the records
+ * by time and writes them to the output in one batch, so producers never wait for the console.
+ *
+ * Statements below `SYNLEDGER_LOG_LEVEL` are removed at compile time, arguments included:
+ *
+ *     LOG_INFO("ledger") << "Block " << number << " confirmed.";
+ *     LOG_WARN_LIMITED("p2p", 10) << "Peer " << remote << " sent an oversized frame";
+ *
+ * The `_LIMITED` forms pass at most the given number of messages per second from one call site and report how
+ * many were suppressed with the next message that passes.
+ */
+
+#ifndef LOGGER_HPP
+#define LOGGER_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <ostream>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_OFF 4
+
+// Statements below this level are compiled out; set through the SYNLEDGER_LOG_LEVEL CMake option.
+#ifndef SYNLEDGER_LOG_LEVEL
+#define SYNLEDGER_LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+/**
+ * @enum LogLevel
+ * @brief Severity of a log record.
+ */
+enum class LogLevel : uint8_t {
+    DEBUG = LOG_LEVEL_DEBUG,  ///< Detailed tracing, e.g. full chain dumps.
+    INFO = LOG_LEVEL_INFO,    ///< Normal progress of the node.
+    WARN = LOG_LEVEL_WARN,    ///< Recoverable problems, e.g. rejected peers or items.
+    ERROR = LOG_LEVEL_ERROR,  ///< Failures of an operation.
+};
+
+const size_t LOG_MESSAGE_CAPACITY = 232;  ///< Bytes of message text per record; longer messages are truncated.
+const size_t LOG_RING_CAPACITY = 1024;    ///< Records buffered per thread before new ones are dropped.
+
+/**
+ * @struct LogRecord
+ * @brief One formatted log message, as stored in a ring buffer.
+ */
+struct LogRecord {
+    int64_t timestamp_us;                ///< Wall-clock time in microseconds since the Unix epoch.
+    const char* component;               ///< Subsystem name; must be a string literal.
+    uint32_t suppressed;                 ///< Messages of the same call site dropped by rate limiting before this one.
+    uint16_t length;                     ///< Bytes used in `text`.
+    LogLevel level;                      ///< Severity.
+    char text[LOG_MESSAGE_CAPACITY];     ///< Message text, not null-terminated.
+};
+
+/**
+ * @class LogRing
+ * @brief Single-producer, single-consumer ring of log records owned by one thread.
+ */
+class LogRing {
+public:
+    /**
+     * @brief Reserves the next free record, or returns nullptr (and counts a drop) if the ring is full.
+     */
+    LogRecord* reserve();
+
+    /**
+     * @brief Makes the record returned by the last `reserve` visible to the writer.
+     */
+    void commit();
+
+    /**
+     * @brief Moves all committed records to `out`. Called by the writer only.
+     *
+     * @return The number of records dropped since the previous drain.
+     */
+    size_t drain(std::vector<LogRecord>& out);
+
+    bool is_empty() const;  ///< Whether the writer has nothing to drain.
+
+    std::atomic<bool> retired{ false };  ///< Set when the owning thread exits.
+
+private:
+    std::unique_ptr<LogRecord[]> records{ new LogRecord[LOG_RING_CAPACITY] };  ///< Storage.
+    std::atomic<size_t> head{ 0 };     ///< Next record to write; advanced by the producer.
+    std::atomic<size_t> tail{ 0 };     ///< Next record to read; advanced by the writer.
+    std::atomic<size_t> dropped{ 0 };  ///< Records lost because the ring was full.
+};
+
+/**
+ * @class Logger
+ * @brief Process-wide registry of per-thread rings and the background writer that drains them.
+ */
+class Logger {
+public:
+    /**
+     * @brief Returns the logger, starting its writer on first use.
+     */
+    static Logger& instance();
+
+    /**
+     * @brief Returns the calling thread's ring, registering it on first use.
+     */
+    LogRing& thread_ring();
+
+    /**
+     * @brief Writes everything logged so far before returning.
+     */
+    void flush();
+
+    /**
+     * @brief Redirects output (standard output by default). The stream must outlive the logger or the next call.
+     */
+    void set_output(std::ostream& stream);
+
+    ~Logger();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+private:
+    static const int WRITER_INTERVAL_MS = 20;  ///< How long the writer sleeps when every ring is empty.
+
+    std::mutex rings_mutex;                        ///< Guards `rings`; taken only when a thread registers.
+    std::vector<std::shared_ptr<LogRing>> rings;   ///< Rings of all threads that logged, live or retired.
+    std::mutex drain_mutex;                        ///< Serializes draining and writing.
+    std::ostream* output;                          ///< Destination of formatted records.
+    std::vector<LogRecord> batch;                  ///< Records of the current drain, reused.
+    std::mutex wake_mutex;                         ///< Only used to sleep in the writer.
+    std::condition_variable wake;                  ///< Signalled on shutdown.
+    bool stopping;                                 ///< Set by the destructor; guarded by `wake_mutex`.
+    std::thread writer;                            ///< Background writer.
+
+    Logger();
+    void run_writer();
+    bool drain_once();  ///< Drains and writes all rings; returns false if there was nothing to write.
+};
+
+/**
+ * @class RateLimiter
+ * @brief Per-call-site budget of messages per one-second window.
+ */
+class RateLimiter {
+public:
+    explicit RateLimiter(uint32_t per_second) : per_second(per_second) {}
+
+    /**
+     * @brief Consumes one message from the current window's budget; false means the message is suppressed.
+     */
+    bool allow();
+
+    /**
+     * @brief Returns and resets the number of suppressed messages.
+     */
+    uint32_t take_suppressed() { return suppressed.exchange(0, std::memory_order_relaxed); }
+
+private:
+    uint32_t per_second;                   ///< Messages allowed per window.
+    std::atomic<int64_t> window_start{ 0 };  ///< Start of the current window in milliseconds.
+    std::atomic<uint32_t> used{ 0 };       ///< Messages passed in the current window.
+    std::atomic<uint32_t> suppressed{ 0 };  ///< Messages suppressed since the last one that passed.
+};
+
+/**
+ * @class LogLine
+ * @brief Formats one message into a ring record; the record is published when the line goes out of scope.
+ */
+class LogLine {
+public:
+    LogLine(LogLevel level, const char* component, uint32_t suppressed = 0);
+    ~LogLine();
+
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+
+    LogLine& operator<<(std::string_view text);
+    LogLine& operator<<(const char* text) { return *this << std::string_view(text); }
+    LogLine& operator<<(const std::string& text) { return *this << std::string_view(text); }
+    LogLine& operator<<(char c) { return *this << std::string_view(&c, 1); }
+    LogLine& operator<<(bool value) { return *this << (value ? std::string_view("true") : std::string_view("false")); }
+    LogLine& operator<<(double value);
+
+    template <typename Integer, typename = std::enable_if_t<std::is_integral<Integer>::value>>
+    LogLine& operator<<(Integer value) {
+        if (std::is_signed<Integer>::value) {
+            return append_signed(static_cast<long long>(value));
+        }
+        return append_unsigned(static_cast<unsigned long long>(value));
+    }
+
+private:
+    LogRecord* record;  ///< Reserved record, or nullptr if the ring was full.
+
+    LogLine& append_signed(long long value);
+    LogLine& append_unsigned(unsigned long long value);
+};
+
+#define SYNLEDGER_LOG(level, component) \
+    if (static_cast<int>(LogLevel::level) < SYNLEDGER_LOG_LEVEL) {} else LogLine(LogLevel::level, component)
+
+#define SYNLEDGER_LOG_LIMITED(level, component, per_second)                                                   \
+    if (static_cast<int>(LogLevel::level) < SYNLEDGER_LOG_LEVEL) {                                            \
+    } else if (RateLimiter& synledger_limiter = []() -> RateLimiter& {                                        \
+                   static RateLimiter limiter(per_second);                                                    \
+                   return limiter;                                                                            \
+               }();                                                                                           \
+               !synledger_limiter.allow()) {                                                                  \
+    } else                                                                                                    \
+        LogLine(LogLevel::level, component, synledger_limiter.take_suppressed())
+
+#define LOG_DEBUG(component) SYNLEDGER_LOG(DEBUG, component)
+#define LOG_INFO(component) SYNLEDGER_LOG(INFO, component)
+#define LOG_WARN(component) SYNLEDGER_LOG(WARN, component)
+#define LOG_ERROR(component) SYNLEDGER_LOG(ERROR, component)
+
+#define LOG_INFO_LIMITED(component, per_second) SYNLEDGER_LOG_LIMITED(INFO, component, per_second)
+#define LOG_WARN_LIMITED(component, per_second) SYNLEDGER_LOG_LIMITED(WARN, component, per_second)
+
+#endif  // LOGGER_HPP
+
+/**
+ * @file logger.hpp
+ *
+ * Writing to `std::cout` with `std::endl` takes the stream lock and issues a write system call per line, on the
+ * thread doing consensus or I/O work. Moving formatting into a preallocated per-thread buffer and the write itself
+ * to one background thread turns each statement into a few stores, and records dropped under overload are counted
+ * rather than stalling the node.
+ */
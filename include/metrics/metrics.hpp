@@ -0,0 +1,313 @@
+/**
+ * @file metrics.hpp
+ * @brief Low-overhead counters, gauges and latency histograms, with Prometheus exposition and trace spans.
+ *
+ * This header defines the metric types used to instrument the node's hot paths and the `MetricsRegistry` that
+ * names them. Counters and histograms are sharded by thread: each thread updates its own cache line with a
+ * relaxed atomic add, and shards are only summed when the metrics are scraped. Histograms are log-linear in the
+ * manner of HdrHistogram, with eight sub-buckets per power of two, so any recorded value is reported within
+ * 12.5% over the full 64-bit range without configuring bounds. Metrics are registered once per call site:
+ *
+ *     static Histogram& add_block_time = MetricsRegistry::instance().timer("synledger_ledger_add_block_seconds",
+ *                                                                          "Duration of Ledger::add_block");
+ *     ScopedTimer timer(add_block_time);
+ *
+ * A timed scope is also recorded as a trace span while tracing is enabled, e.g. to find which pass of a round
+ * regressed under production load.
+ */
+
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+const size_t METRIC_SHARDS = 16;  ///< Per-thread shards of a counter or histogram; threads beyond share shards.
+
+/**
+ * @brief Returns the calling thread's shard index, assigned round-robin when the thread first records a metric.
+ */
+size_t metric_shard();
+
+/**
+ * @brief Monotonic time in nanoseconds, the unit of all timers.
+ */
+inline uint64_t metric_clock_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * @class Counter
+ * @brief Monotonically increasing count, sharded by thread.
+ */
+class Counter {
+public:
+    void add(uint64_t amount = 1) { shards[metric_shard()].value.fetch_add(amount, std::memory_order_relaxed); }
+    uint64_t value() const;  ///< Sum over all shards.
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{ 0 };
+    };
+    std::array<Shard, METRIC_SHARDS> shards;  ///< One cache line per shard.
+};
+
+/**
+ * @class Gauge
+ * @brief Value that goes up and down, e.g. a queue depth. Updates are rare enough to share one atomic.
+ */
+class Gauge {
+public:
+    void set(int64_t current) { value_.store(current, std::memory_order_relaxed); }
+    void add(int64_t delta) { value_.fetch_add(delta, std::memory_order_relaxed); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{ 0 };
+};
+
+/**
+ * @struct HistogramSnapshot
+ * @brief Merged bucket counts of a histogram at one point in time.
+ */
+struct HistogramSnapshot {
+    std::vector<uint64_t> buckets;  ///< Count per bucket.
+    uint64_t count = 0;             ///< Values recorded.
+    uint64_t sum = 0;               ///< Sum of the values recorded.
+
+    /**
+     * @brief Returns the value below which a fraction `q` of the recorded values fall (bucket midpoint), or 0.
+     */
+    double quantile(double q) const;
+};
+
+/**
+ * @class Histogram
+ * @brief Log-linear histogram of unsigned values, sharded by thread.
+ */
+class Histogram {
+public:
+    static const int SUB_BUCKET_BITS = 3;                                     ///< 8 sub-buckets per power of two.
+    static const size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;  ///< Buckets covering 64 bits.
+
+    /**
+     * @param name Metric name, also used for trace spans.
+     * @param scale Factor converting recorded values to the exported unit (1e-9 for nanosecond timers).
+     */
+    Histogram(std::string name, double scale);
+
+    void record(uint64_t value);         ///< Adds one value.
+    HistogramSnapshot snapshot() const;  ///< Merges the shards.
+
+    const std::string& get_name() const { return name; }  ///< Metric name.
+    double get_scale() const { return scale; }             ///< Export unit per recorded unit.
+
+    static size_t bucket_of(uint64_t value);        ///< Bucket holding a value.
+    static uint64_t bucket_lower(size_t bucket);    ///< Smallest value of a bucket.
+
+private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets{};  ///< Counts by bucket.
+        std::atomic<uint64_t> count{ 0 };                            ///< Values recorded.
+        std::atomic<uint64_t> sum{ 0 };                              ///< Sum of the values.
+    };
+
+    std::string name;                  ///< Metric name.
+    double scale;                      ///< Export unit per recorded unit.
+    std::unique_ptr<Shard[]> shards;   ///< METRIC_SHARDS shards.
+};
+
+/**
+ * @struct TraceSpan
+ * @brief One timed scope, recorded while tracing is enabled.
+ */
+struct TraceSpan {
+    const std::string* name;  ///< Name of the histogram that timed the scope.
+    uint64_t thread;          ///< Shard index of the recording thread, used as the trace thread id.
+    uint64_t start_ns;        ///< Start on the metric clock.
+    uint64_t duration_ns;     ///< Length of the scope.
+};
+
+/**
+ * @class MetricsWriter
+ * @brief Accumulates samples grouped into metric families for the Prometheus text format.
+ */
+class MetricsWriter {
+public:
+    /**
+     * @brief Adds a counter or gauge sample.
+     *
+     * @param labels Label set without braces, e.g. `peer="3"`; empty for none.
+     */
+    void sample(const std::string& name, const std::string& type, const std::string& help, const std::string& labels,
+                double value);
+
+    /**
+     * @brief Adds a histogram as a summary with quantiles, `_sum` and `_count`.
+     */
+    void summary(const std::string& name, const std::string& help, const HistogramSnapshot& snapshot, double scale);
+
+    std::string render() const;  ///< Text exposition format, families sorted by name.
+
+private:
+    struct Family {
+        std::string type;                ///< `counter`, `gauge` or `summary`.
+        std::string help;                ///< Description.
+        std::vector<std::string> lines;  ///< Sample lines.
+    };
+    std::map<std::string, Family> families;  ///< By metric name.
+};
+
+/**
+ * @brief Adds samples computed at scrape time, e.g. per-peer statistics that live in their owner's objects.
+ */
+using MetricsCollector = std::function<void(MetricsWriter& writer)>;
+
+/**
+ * @class MetricsRegistry
+ * @brief Process-wide set of named metrics, collectors and recorded trace spans.
+ *
+ * Lookups take a lock and are meant to run once per call site; the returned references stay valid for the life of
+ * the process. Asking again for a name returns the same metric.
+ */
+class MetricsRegistry {
+public:
+    static const size_t MAX_TRACE_SPANS = 65536;  ///< Spans kept between two trace reads; older ones are dropped.
+
+    static MetricsRegistry& instance();
+
+    Counter& counter(const std::string& name, const std::string& help);
+    Gauge& gauge(const std::string& name, const std::string& help);
+    Histogram& histogram(const std::string& name, const std::string& help, double scale = 1.0);
+
+    /**
+     * @brief Returns a histogram of nanosecond durations, exported in seconds.
+     */
+    Histogram& timer(const std::string& name, const std::string& help) { return histogram(name, help, 1e-9); }
+
+    /**
+     * @brief Registers a collector that runs on every scrape.
+     *
+     * @return Handle for `remove_collector`.
+     */
+    size_t add_collector(MetricsCollector collector);
+
+    /**
+     * @brief Unregisters a collector; once this returns the collector is not running and will not run again.
+     *
+     * Collectors run without the lock that guards metric lookups, so they may take their owner's locks even if code
+     * holding those locks registers metrics; the owner must not hold them while calling this.
+     */
+    void remove_collector(size_t handle);
+
+    /**
+     * @brief Renders every metric and collector in the Prometheus text exposition format.
+     */
+    std::string render_prometheus() const;
+
+    void set_tracing(bool enabled) { tracing.store(enabled, std::memory_order_relaxed); }  ///< Toggles spans.
+    bool is_tracing() const { return tracing.load(std::memory_order_relaxed); }            ///< Whether spans are kept.
+
+    /**
+     * @brief Stores a span; called by `ScopedTimer` while tracing is enabled.
+     */
+    void record_span(const TraceSpan& span);
+
+    /**
+     * @brief Returns and clears the recorded spans as Chrome trace-event JSON (viewable in Perfetto).
+     */
+    std::string take_trace();
+
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+private:
+    struct Entry {
+        std::string help;                       ///< Description.
+        std::unique_ptr<Counter> counter;       ///< Set for counters.
+        std::unique_ptr<Gauge> gauge;           ///< Set for gauges.
+        std::unique_ptr<Histogram> histogram;   ///< Set for histograms.
+    };
+
+    mutable std::mutex registry_mutex;                 ///< Guards `entries`.
+    std::map<std::string, Entry> entries;              ///< Metrics by name.
+    mutable std::mutex collector_mutex;                ///< Guards `collectors`; held while they run.
+    std::map<size_t, MetricsCollector> collectors;     ///< Collectors by handle.
+    size_t next_collector;                             ///< Next collector handle.
+    std::atomic<bool> tracing;                         ///< Whether spans are recorded.
+    std::mutex trace_mutex;                            ///< Guards `spans`.
+    std::vector<TraceSpan> spans;                      ///< Spans since the last `take_trace`.
+
+    MetricsRegistry();
+    Entry& entry(const std::string& name, const std::string& help);
+};
+
+/**
+ * @class ScopedTimer
+ * @brief Records the lifetime of a scope, in nanoseconds, into a histogram (and as a span while tracing).
+ */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& histogram) : histogram(histogram), start(metric_clock_ns()) {}
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Histogram& histogram;  ///< Destination.
+    uint64_t start;        ///< Start on the metric clock.
+};
+
+/**
+ * @class MetricsServer
+ * @brief Minimal HTTP endpoint serving `/metrics` (Prometheus text) and `/trace` (trace-event JSON).
+ */
+class MetricsServer {
+public:
+    explicit MetricsServer(MetricsRegistry& registry = MetricsRegistry::instance());
+    ~MetricsServer();
+
+    /**
+     * @brief Starts serving on a TCP port (0 picks a free one).
+     * @throws std::runtime_error if the port cannot be bound.
+     */
+    void start(int port);
+
+    void stop();                         ///< Stops serving; called by the destructor.
+    int get_port() const { return port; }  ///< Port actually bound.
+
+private:
+    static const int POLL_INTERVAL_MS = 200;  ///< How often the server thread checks for `stop`.
+
+    MetricsRegistry& registry;     ///< Metrics served.
+    int listen_socket;             ///< Listening socket, or -1.
+    int port;                      ///< Bound port.
+    std::atomic<bool> running;     ///< Cleared by `stop`.
+    std::thread server_thread;     ///< Accepts and answers scrapes.
+
+    void serve();
+    void answer(int client);
+};
+
+#endif  // METRICS_HPP
+
+/**
+ * @file metrics.hpp
+ *
+ * A printout per block shows that a node is slow but not where. Counting and timing the operations that dominate
+ * block import, signing and propagation, cheaply enough to leave enabled in production, makes a regression visible
+ * in the metric that moved; sharding by thread keeps the instrumentation from becoming a new point of contention on
+ * the paths it measures.
+ */
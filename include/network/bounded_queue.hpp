@@ -0,0 +1,102 @@
+/**
+ * @file bounded_queue.hpp
+ * @brief Fixed-capacity blocking queue used to hand work between threads.
+ *
+ * This header defines the `BoundedQueue` class template. Producers block while the queue is full, which turns a
+ * slow consumer into backpressure on the producer instead of unbounded memory growth.
+ */
+
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+/**
+ * @class BoundedQueue
+ * @brief Multi-producer, multi-consumer FIFO with a capacity limit and a close operation.
+ *
+ * @tparam T The element type; it must be movable.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    /**
+     * @brief Constructs an empty queue holding at most `capacity` elements.
+     */
+    explicit BoundedQueue(size_t capacity) : capacity(capacity > 0 ? capacity : 1), closed(false) {}
+
+    /**
+     * @brief Appends an element, waiting while the queue is full.
+     *
+     * @return False if the queue was closed (the element is discarded).
+     */
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [&] { return closed || items.size() < capacity; });
+        if (closed) {
+            return false;
+        }
+        items.push_back(std::move(item));
+        not_empty.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest element, waiting while the queue is empty.
+     *
+     * @return False once the queue is closed; elements still queued at that point are discarded.
+     */
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [&] { return closed || !items.empty(); });
+        if (closed) {
+            return false;
+        }
+        item = std::move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Wakes every waiting producer and consumer; subsequent pushes and pops fail.
+     */
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        items.clear();
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+    /**
+     * @brief Number of queued elements.
+     */
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return items.size();
+    }
+
+    size_t get_capacity() const { return capacity; }  ///< Maximum number of queued elements.
+
+private:
+    std::deque<T> items;                ///< Queued elements, oldest first.
+    size_t capacity;                    ///< Maximum number of elements.
+    bool closed;                        ///< Set by `close()`.
+    mutable std::mutex mutex;           ///< Guards `items` and `closed`.
+    std::condition_variable not_full;   ///< Signalled when an element is removed.
+    std::condition_variable not_empty;  ///< Signalled when an element is added.
+};
+
+#endif  // BOUNDED_QUEUE_HPP
+
+/**
+ * @file bounded_queue.hpp
+ *
+ * Network I/O threads must never buffer an unbounded amount of decoded data for handlers that fall behind.
+ * Blocking the producer when the queue is full stops it from reading further, and TCP flow control then slows
+ * the remote sender.
+ */
@@ -0,0 +1,149 @@
+/**
+ * @file event_loop.hpp
+ * @brief Single-threaded non-blocking I/O reactor.
+ *
+ * This header defines the `EventLoop` class, which waits for readiness on a set of file descriptors and runs the
+ * registered callbacks, together with tasks posted from other threads and one-shot timers. On Linux it is backed
+ * by epoll; elsewhere (or when built with `SYNLEDGER_FORCE_POLL`) it falls back to poll(2).
+ */
+
+#ifndef EVENT_LOOP_HPP
+#define EVENT_LOOP_HPP
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__linux__) && !defined(SYNLEDGER_FORCE_POLL)
+#define SYNLEDGER_HAVE_EPOLL 1
+#endif
+
+const uint32_t EVENT_READABLE = 1;  ///< The descriptor can be read without blocking.
+const uint32_t EVENT_WRITABLE = 2;  ///< The descriptor can be written without blocking.
+const uint32_t EVENT_ERROR = 4;     ///< The descriptor reported an error or hang-up (always delivered).
+
+/**
+ * @brief Callback receiving the ready events of a watched descriptor.
+ */
+using IoCallback = std::function<void(uint32_t events)>;
+
+/**
+ * @brief Work item executed on the loop thread.
+ */
+using LoopTask = std::function<void()>;
+
+/**
+ * @class EventLoop
+ * @brief Level-triggered reactor driving descriptors, posted tasks, and timers from one thread.
+ *
+ * `watch`, `modify`, `unwatch` and `post_after` must be called from the loop thread (for example from a callback
+ * or a posted task), or before `run()` starts; debug builds assert this. `post` and `stop` may be called from any
+ * thread.
+ */
+class EventLoop {
+public:
+    /**
+     * @brief Creates the poller and the wake-up channel.
+     * @throws std::runtime_error if the kernel objects cannot be created.
+     */
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /**
+     * @brief Processes events until `stop()` is called.
+     */
+    void run();
+
+    /**
+     * @brief Makes `run()` return after the current iteration.
+     */
+    void stop();
+
+    /**
+     * @brief Queues a task to run on the loop thread and wakes the loop.
+     */
+    void post(LoopTask task);
+
+    /**
+     * @brief Runs a task on the loop thread once `delay_ms` milliseconds have passed.
+     */
+    void post_after(int delay_ms, LoopTask task);
+
+    /**
+     * @brief Starts watching a descriptor.
+     *
+     * @param fd The descriptor, which should be non-blocking.
+     * @param events A combination of EVENT_READABLE and EVENT_WRITABLE.
+     * @param callback Invoked with the ready events.
+     */
+    void watch(int fd, uint32_t events, IoCallback callback);
+
+    /**
+     * @brief Changes the events a watched descriptor is interested in.
+     */
+    void modify(int fd, uint32_t events);
+
+    /**
+     * @brief Stops watching a descriptor. Must be called before the descriptor is closed.
+     */
+    void unwatch(int fd);
+
+    /**
+     * @brief Returns true when called from the thread running `run()`.
+     */
+    bool in_loop_thread() const;
+
+    /**
+     * @brief Name of the readiness backend: "epoll" or "poll".
+     */
+    static const char* backend();
+
+private:
+    struct Watch {
+        uint32_t events;
+        IoCallback callback;
+    };
+
+    struct Timer {
+        std::chrono::steady_clock::time_point due;
+        uint64_t sequence;
+        LoopTask task;
+    };
+
+    std::unordered_map<int, Watch> watches;  ///< Watched descriptors (loop thread only).
+    std::vector<Timer> timers;               ///< Min-heap of pending timers by due time (loop thread only).
+    uint64_t timer_sequence;                 ///< Tie-breaker keeping timers with equal due times in order.
+    std::vector<LoopTask> pending_tasks;     ///< Tasks posted from any thread.
+    mutable std::mutex task_mutex;           ///< Guards `pending_tasks`.
+    int wake_pipe[2];                        ///< Self-pipe used to interrupt the wait.
+    std::atomic<bool> stop_requested;        ///< Set by `stop()`.
+    std::atomic<std::thread::id> loop_thread; ///< Thread currently inside `run()`.
+#ifdef SYNLEDGER_HAVE_EPOLL
+    int epoll_fd;                            ///< epoll instance.
+#endif
+
+    void wait_for_events(int timeout_ms, std::vector<std::pair<int, uint32_t>>& ready);
+    void run_pending_tasks();
+    void run_due_timers();
+    int next_timeout_ms() const;
+    void wake();
+    void assert_loop_thread() const;  ///< Asserts the caller may touch loop-thread-only state.
+    static bool fires_later(const Timer& a, const Timer& b);  ///< Heap order: earliest timer first.
+};
+
+#endif  // EVENT_LOOP_HPP
+
+/**
+ * @file event_loop.hpp
+ *
+ * A fixed number of event loops can serve any number of sockets, so the networking layer's thread count stays
+ * constant as the peer set grows, and all per-connection state is owned by exactly one thread.
+ */
@@ -0,0 +1,239 @@
+/**
+ * @file gossip.hpp
+ * @brief Inventory-based block and transaction gossip over `P2PProtocol`.
+ *
+ * This header defines the `Gossip` class. New items are announced to peers by hash only (INV); a peer that has
+ * not seen an item asks for it (GETDATA) from one announcer and receives the payload (DATA) exactly once. A
+ * rolling bloom filter remembers what has been seen, and announcements fan out along the `SubnetManager`
+ * topology: to every peer of the local subnet and to a bounded number of peers in other subnets.
+ *
+ * When a mempool matcher is installed, blocks are requested in compact form instead (see compact_block.hpp):
+ * the announcer replies with the header and short transaction ids, the block is rebuilt from the local pool,
+ * and only the transactions still missing are fetched (GETBLOCKTXN/BLOCKTXN) before the full payload is handed
+ * to the item handler.
+ */
+
+#ifndef GOSSIP_HPP
+#define GOSSIP_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <mutex>
+#include <chrono>
+#include <random>
+#include <cstdint>
+#include <cstddef>
+#include "p2p_protocol.hpp"
+#include "../subnet/subnet_manager.hpp"
+#include "../ledger/compact_block.hpp"
+#include "../cryptography/hash256.hpp"
+
+/**
+ * @brief Kind of a gossiped item.
+ */
+enum class InventoryType : uint8_t {
+    BLOCK = 1,        ///< A serialized block, identified by its digest.
+    TRANSACTION = 2,  ///< A serialized transaction, identified by its hash.
+    COMPACT_BLOCK = 3 ///< A block requested in compact form; only valid in GETDATA.
+};
+
+/**
+ * @struct InventoryItem
+ * @brief Hash-only reference to an item, as carried by INV and GETDATA messages.
+ */
+struct InventoryItem {
+    InventoryType type;  ///< Item kind.
+    Hash256 id;          ///< Item identifier.
+};
+
+/**
+ * @brief Callback receiving every newly downloaded item.
+ *
+ * Only payloads that were requested and whose digest matches their id reach the handler.
+ *
+ * @return True if the item is valid; only valid items are marked as seen, cached and relayed further. A rejected
+ *         item is requested again from another announcer.
+ */
+using ItemHandler = std::function<bool(InventoryType type, const Hash256& id, const std::string& payload)>;
+
+/**
+ * @brief Callback filling a compact block's slots from the local mempool, typically under the ledger's lock.
+ */
+using MempoolMatcher = std::function<void(PartialBlock& block)>;
+
+/**
+ * @class SeenFilter
+ * @brief Rolling bloom filter over item ids.
+ *
+ * Two generations of `capacity` items each are kept; when the current one fills up it becomes the previous
+ * one and a fresh generation starts, so memory is fixed while the most recent items are always remembered.
+ * False positives (about 1% per generation) only ever cause an item to be skipped, never re-downloaded.
+ */
+class SeenFilter {
+public:
+    static const size_t HASH_COUNT = 7;       ///< Bit positions per item.
+    static const size_t BITS_PER_ITEM = 10;   ///< Filter bits per item of capacity.
+
+    /**
+     * @brief Constructs an empty filter remembering at least `capacity` recent items.
+     */
+    explicit SeenFilter(size_t capacity);
+
+    void insert(const Hash256& id);            ///< Marks an item as seen.
+    bool contains(const Hash256& id) const;    ///< Returns true if the item was (probably) seen.
+
+private:
+    std::vector<uint64_t> current;   ///< Bits of the generation being filled.
+    std::vector<uint64_t> previous;  ///< Bits of the previous generation.
+    size_t bit_count;                ///< Bits per generation.
+    size_t capacity;                 ///< Items per generation.
+    size_t inserted;                 ///< Items inserted into `current`.
+
+    static bool test(const std::vector<uint64_t>& bits, size_t bit_count, const Hash256& id);
+};
+
+/**
+ * @struct GossipStats
+ * @brief Traffic counters of a gossip instance.
+ */
+struct GossipStats {
+    size_t announcements_sent;   ///< INV messages sent.
+    size_t requests_sent;        ///< GETDATA messages sent.
+    size_t items_sent;           ///< DATA messages sent.
+    size_t items_received;       ///< New items downloaded.
+    size_t duplicates_ignored;   ///< Announced or delivered items that had already been seen.
+    size_t compact_blocks_received;  ///< Compact blocks received.
+    size_t compact_blocks_rebuilt;   ///< Compact blocks turned into full blocks.
+    size_t transactions_requested;   ///< Transactions fetched because the mempool lacked them.
+    size_t compact_fallbacks;        ///< Compact blocks abandoned for a full download.
+};
+
+/**
+ * @class Gossip
+ * @brief INV/GETDATA/DATA propagation with deduplication and topology-aware fan-out.
+ *
+ * Every message carries the sender's node id so replies can be addressed through `P2PProtocol::send_message`;
+ * messages from unknown peers are still processed but cannot be answered.
+ */
+class Gossip {
+public:
+    static const size_t DEFAULT_FANOUT = 8;           ///< Peers outside the local subnet announced to per item.
+    static const size_t DEFAULT_SEEN_CAPACITY = 100000; ///< Items per bloom filter generation.
+    static const size_t MAX_CACHED_ITEMS = 4096;      ///< Recent payloads kept to answer GETDATA.
+    static const int REQUEST_TIMEOUT_MS = 5000;       ///< After this, an item is requested again from another announcer.
+    static const size_t MAX_PARTIAL_BLOCKS = 64;      ///< Compact blocks waiting for missing transactions.
+
+    /**
+     * @brief Creates the gossip layer of a node.
+     *
+     * @param network Transport used for all messages; its message handler must forward to `handle_message`.
+     * @param node_id The id of this node, carried in every message.
+     * @param topology Subnet assignment used to pick fan-out peers.
+     * @param fanout Number of peers outside the local subnet each item is announced to.
+     */
+    Gossip(P2PProtocol& network, size_t node_id, const SubnetManager& topology, size_t fanout = DEFAULT_FANOUT);
+
+    /**
+     * @brief Sets the callback receiving downloaded items. Must be set before messages arrive.
+     */
+    void set_item_handler(ItemHandler handler);
+
+    /**
+     * @brief Enables compact block relay on the receiving side.
+     *
+     * Without a matcher, announced blocks are downloaded in full. Serving compact blocks to peers needs no setup.
+     */
+    void set_mempool_matcher(MempoolMatcher matcher);
+
+    /**
+     * @brief Publishes a locally produced item: caches it and announces it to the fan-out peers.
+     *
+     * @return False if the item had already been seen (nothing is sent).
+     */
+    bool broadcast(InventoryType type, const Hash256& id, const std::string& payload);
+
+    /**
+     * @brief Processes one gossip message received from the network.
+     *
+     * Malformed messages are ignored.
+     */
+    void handle_message(const std::string& message);
+
+    /**
+     * @brief Returns true if the item has been seen (broadcast, announced-and-downloaded or cached).
+     */
+    bool has_seen(const Hash256& id) const;
+
+    /**
+     * @brief Returns the traffic counters.
+     */
+    GossipStats get_stats() const;
+
+    /**
+     * @brief Returns the peers an item would be announced to, excluding `exclude`.
+     */
+    std::vector<size_t> select_peers(const std::vector<size_t>& exclude = {}) const;
+
+private:
+    struct CachedItem {
+        InventoryType type;
+        std::string payload;
+        std::string compact;  ///< Compact encoding of a block payload, built on first request.
+    };
+
+    struct PendingRequest {
+        std::chrono::steady_clock::time_point requested_at;
+        std::vector<size_t> announcers;  ///< Peers known to have the item; they are not announced to.
+        bool delivering = false;         ///< A payload is being checked by the item handler.
+    };
+
+    struct PendingBlock {
+        PartialBlock block;  ///< Reconstruction state.
+        size_t peer;         ///< Peer the missing transactions were requested from.
+    };
+
+    P2PProtocol& network;                                           ///< Transport.
+    size_t node_id;                                                 ///< This node's id.
+    const SubnetManager& topology;                                  ///< Fan-out topology.
+    size_t fanout;                                                  ///< Peers announced to outside the local subnet.
+    ItemHandler item_handler;                                       ///< Receives downloaded items.
+    MempoolMatcher mempool_matcher;                                 ///< Rebuilds compact blocks; empty if disabled.
+    SeenFilter seen;                                                ///< Items already processed.
+    std::unordered_map<Hash256, CachedItem, Hash256Hasher> cache;   ///< Payloads served to GETDATA.
+    std::deque<Hash256> cache_order;                                ///< Cache eviction order, oldest first.
+    std::unordered_map<Hash256, PendingRequest, Hash256Hasher> pending; ///< Requested but not yet delivered.
+    std::unordered_map<Hash256, PendingBlock, Hash256Hasher> partial_blocks; ///< Compact blocks awaiting transactions.
+    std::mt19937_64 nonce_source;                                   ///< Short id salts of served compact blocks.
+    mutable size_t rotation;                                        ///< Rotates the choice of remote-subnet peers.
+    GossipStats stats;                                              ///< Traffic counters.
+    mutable std::mutex gossip_mutex;                                ///< Guards every field above.
+
+    void handle_inventory(size_t sender, const std::vector<InventoryItem>& items);
+    void handle_request(size_t sender, const std::vector<InventoryItem>& items);
+    void handle_data(size_t sender, InventoryType type, const Hash256& id, const std::string& payload);
+    void handle_compact_block(size_t sender, const Hash256& id, std::string_view payload);
+    void handle_transactions_request(size_t sender, const Hash256& id, const std::vector<uint32_t>& indexes);
+    void handle_transactions(size_t sender, const Hash256& id, const std::vector<std::string>& encoded);
+    void finish_block(size_t sender, const Hash256& id, const PartialBlock& block);
+    void request_full_block(size_t sender, const Hash256& id);
+    void retry_request(size_t failed_peer, InventoryType type, const Hash256& id);
+    std::string compact_payload(const Hash256& id);
+    void announce(const InventoryItem& item, const std::vector<size_t>& exclude);
+    void cache_item(const Hash256& id, InventoryType type, const std::string& payload);
+    bool send(size_t peer, const std::string& message);
+};
+
+#endif  // GOSSIP_HPP
+
+/**
+ * @file gossip.hpp
+ *
+ * Pushing whole blocks to every peer multiplies the block size by the peer count. Announcing 33-byte inventory
+ * entries instead and downloading each payload once per node makes the cost of a block grow with the number of
+ * peers only through those announcements. Compact relay shrinks the one remaining download of a block to its header
+ * and short ids for peers whose pool already holds the transactions.
+ */
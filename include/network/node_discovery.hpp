@@ -5,6 +5,17 @@
  * This header defines the `NodeDiscovery` class, which is responsible for discovering and managing peer nodes 
  * within the SynLedger network. The module facilitates peer-to-peer communication by maintaining a list of known 
  * nodes and their corresponding network addresses, enabling nodes to connect and exchange data securely.
+ *
+ * Discovery follows Kademlia: known nodes live in a `RoutingTable` of k-buckets indexed by the XOR distance between
+ * node ids, and new nodes are found by iterative FIND_NODE lookups over UDP with up to `LOOKUP_PARALLELISM` queries
+ * in flight. A node's UDP discovery endpoint uses the same port number as its TCP peer port, so one `ip:port`
+ * address serves both `NodeDiscovery` and `P2PProtocol::add_peer`.
+ *
+ * Datagram layout (big-endian):
+ *   kind (1 byte) | rpc id (8 bytes) | sender node id (8 bytes) | body
+ *   PING, PONG: empty body
+ *   FIND_NODE:  target node id (8 bytes)
+ *   NODES:      count (1 byte) | count x (node id (8 bytes) | IPv4 (4 bytes) | port (2 bytes))
  */
 
 #ifndef NODE_DISCOVERY_HPP
@@ -12,7 +23,107 @@
 
 #include <string>
 #include <vector>
+#include <deque>
+#include <array>
 #include <unordered_map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+#include "event_loop.hpp"
+
+/**
+ * @struct NodeContact
+ * @brief What the routing table knows about one node.
+ */
+struct NodeContact {
+    size_t node_id = 0;                               ///< The node's id.
+    std::string address;                              ///< `ip:port` of the node (UDP discovery and TCP peer port).
+    double rtt_ms = -1.0;                             ///< Smoothed round-trip time, or negative if never measured.
+    int failed_requests = 0;                          ///< Consecutive requests that timed out.
+    std::chrono::steady_clock::time_point last_seen;  ///< Last time the node answered or contacted us.
+};
+
+/**
+ * @class RoutingTable
+ * @brief Bounded Kademlia routing table with one k-bucket per bit of XOR distance.
+ *
+ * Each bucket keeps at most `bucket_size` contacts ordered from least to most recently seen, plus a replacement
+ * cache of the same size. Long-lived nodes are preferred: a new contact only displaces the least recently seen one
+ * after that one fails to answer. The table therefore never holds more than `64 * bucket_size` live contacts.
+ */
+class RoutingTable {
+public:
+    static const size_t BUCKET_COUNT = 64;  ///< One bucket per bit of a 64-bit node id.
+
+    /**
+     * @brief Constructs an empty table for the node `self_id`.
+     */
+    RoutingTable(size_t self_id, size_t bucket_size);
+
+    /**
+     * @brief Index of the bucket a node falls into: the position of the highest bit of the XOR distance.
+     * 
+     * @return The bucket index, or -1 for `self_id` itself.
+     */
+    int bucket_index(size_t node_id) const;
+
+    /**
+     * @brief Records that a node is alive, moving it to the tail of its bucket.
+     * 
+     * @param contact The node; its address replaces the stored one.
+     * @param rtt_ms Measured round-trip time, or negative if the observation carried none.
+     * @param[out] stale If the bucket is full, set to its least recently seen contact, which the caller should
+     *             ping; the new contact waits in the replacement cache until that ping fails.
+     * @return True if the contact is now in the table (or was already), false if it was put in the replacement cache.
+     */
+    bool observe(const NodeContact& contact, double rtt_ms, NodeContact* stale = nullptr);
+
+    /**
+     * @brief Records a timed-out request; after `max_failures` in a row the contact is replaced.
+     * 
+     * @return True if the contact was removed from the table.
+     */
+    bool record_failure(size_t node_id, int max_failures);
+
+    /**
+     * @brief Returns up to `count` contacts closest to `target` by XOR distance, nearest first.
+     */
+    std::vector<NodeContact> closest(size_t target, size_t count) const;
+
+    /**
+     * @brief Returns every contact, lowest round-trip time first; unmeasured contacts come last.
+     */
+    std::vector<NodeContact> by_latency() const;
+
+    /**
+     * @brief Returns the least recently seen contact of every non-empty bucket seen before `cutoff`.
+     */
+    std::vector<NodeContact> stale_contacts(std::chrono::steady_clock::time_point cutoff) const;
+
+    /**
+     * @brief Looks up a contact.
+     * 
+     * @return A pointer to the contact, or nullptr. Invalidated by any mutation.
+     */
+    const NodeContact* find(size_t node_id) const;
+
+    size_t size() const;                                  ///< Number of contacts in the buckets.
+    size_t get_bucket_size() const { return bucket_size; } ///< Capacity of each bucket.
+
+private:
+    struct Bucket {
+        std::deque<NodeContact> contacts;      ///< Least recently seen first.
+        std::deque<NodeContact> replacements;  ///< Candidates waiting for a slot, most recent last.
+    };
+
+    size_t self_id;                               ///< Id distances are measured from.
+    size_t bucket_size;                           ///< The Kademlia k.
+    std::array<Bucket, BUCKET_COUNT> buckets;     ///< Buckets by distance bit.
+};
 
 /**
  * @class NodeDiscovery
@@ -20,10 +131,19 @@
  *
  * The `NodeDiscovery` class is responsible for identifying and storing information about peer nodes in the network. 
  * It maintains a registry of known nodes, each identified by a unique node ID and associated with a network address. 
- * This facilitates node-to-node communication and ensures that peers can discover and connect to each other efficiently.
+ * This facilitates node-to-node communication and ensures that peers can discover each other efficiently.
+ *
+ * All network activity runs on a private `EventLoop` thread; the public methods may be called from any thread.
  */
 class NodeDiscovery {
 public:
+    static const size_t BUCKET_SIZE = 16;           ///< Contacts per k-bucket (Kademlia k).
+    static const size_t LOOKUP_PARALLELISM = 3;     ///< FIND_NODE queries in flight per lookup (Kademlia alpha).
+    static const size_t REFRESH_LOOKUPS = 3;        ///< Random-target lookups run alongside the self-lookup.
+    static const int REQUEST_TIMEOUT_MS = 500;      ///< After this, a request counts as failed.
+    static const int PING_INTERVAL_MS = 15000;      ///< Period of the liveness check.
+    static const int MAX_FAILED_REQUESTS = 2;       ///< Consecutive timeouts before a contact is replaced.
+
     /**
      * @brief Constructs a NodeDiscovery object with the given node ID and network address.
      * 
@@ -34,28 +154,64 @@ public:
      */
     NodeDiscovery(size_t node_id, const std::string& network_address);
 
+    /**
+     * @brief Stops the discovery thread and writes the peer cache, if one is set.
+     */
+    ~NodeDiscovery();
+
+    /**
+     * @brief Binds the UDP discovery socket and starts answering and pinging nodes.
+     * 
+     * @param port The UDP port, normally the same number as the node's P2P port.
+     * @throws std::runtime_error if the socket cannot be bound.
+     */
+    void initialize(int port);
+
+    /**
+     * @brief Loads persisted contacts from `path` and saves the table there after every discovery round.
+     * 
+     * A missing file is not an error. Loaded contacts enter the routing table unverified and are the first nodes
+     * queried, so a restarted node does not need a bootstrap node to rejoin the network.
+     * 
+     * @param path File holding one `node_id ip:port rtt_ms` line per contact.
+     */
+    void set_peer_cache(const std::string& path);
+
     /**
      * @brief Discovers new nodes in the network.
      * 
-     * Initiates the node discovery process, finding new peers and adding them to the list of known nodes.
-     * This function typically involves broadcasting requests to known nodes and receiving addresses of new peers.
+     * Runs an iterative lookup for this node's own id, which fills the buckets near it, together with
+     * `REFRESH_LOOKUPS` lookups for random ids, which fill the distant ones; all of them run concurrently.
+     * Blocks until every lookup has converged.
+     * 
+     * @throws std::runtime_error if `initialize` has not been called.
      */
     void discover_nodes();
 
+    /**
+     * @brief Finds the nodes closest to `target` with an iterative lookup.
+     * 
+     * @return Up to `BUCKET_SIZE` nodes that answered, nearest first.
+     * @throws std::runtime_error if `initialize` has not been called.
+     */
+    std::vector<NodeContact> lookup(size_t target);
+
     /**
      * @brief Adds a new node to the known node list.
      * 
-     * Registers a new peer node in the local discovery database, associating it with its unique node ID and address.
+     * Registers a bootstrap or manually configured node in the routing table without verifying it first.
      * 
      * @param node_id The unique ID of the new node.
-     * @param address The network address of the new node.
+     * @param address The network address of the new node, as `ip` or `ip:port` (default port 8080).
+     * @throws std::invalid_argument if the address is not a valid IPv4 address.
      */
     void add_node(size_t node_id, const std::string& address);
 
     /**
      * @brief Retrieves a list of known node IDs.
      * 
-     * Provides a list of all nodes that this node is aware of, identified by their node IDs.
+     * Provides a list of all nodes that this node is aware of, lowest measured round-trip time first, so that
+     * callers connecting to a prefix of the list get the fastest peers.
      * 
      * @return A vector containing the IDs of all known nodes.
      */
@@ -71,10 +227,53 @@ public:
      */
     std::string get_node_address(size_t node_id) const;
 
+    /**
+     * @brief Writes the routing table to a peer cache file.
+     * 
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    void save_peer_cache(const std::string& path) const;
+
+    /**
+     * @brief Stops the discovery thread and closes the socket. Safe to call more than once.
+     */
+    void shutdown();
+
 private:
+    /**
+     * @brief Reply handler of an outstanding request; `reply` is null on timeout.
+     */
+    using ReplyHandler = std::function<void(const std::string* reply)>;
+
+    struct PendingRequest {
+        size_t node_id;                                   ///< Node the request was sent to.
+        std::chrono::steady_clock::time_point sent_at;    ///< Send time, for the round-trip estimate.
+        ReplyHandler on_reply;                            ///< Continuation.
+    };
+
+    struct Lookup;
+
     size_t node_id;  ///< The unique identifier for this node.
     std::string network_address;  ///< The network address of this node.
-    std::unordered_map<size_t, std::string> known_nodes;  ///< A map of known nodes and their network addresses.
+    RoutingTable table;  ///< Known nodes by XOR distance; guarded by `table_mutex`.
+    mutable std::mutex table_mutex;  ///< Guards `table`.
+    std::string peer_cache_path;  ///< Peer cache file, or empty.
+
+    int udp_socket;  ///< Discovery socket, or -1 before `initialize`.
+    EventLoop loop;  ///< Drives the socket, the request timeouts and the liveness timer.
+    std::thread loop_thread;  ///< Runs `loop`.
+    uint64_t next_rpc_id;  ///< Id of the next request (loop thread only).
+    std::unordered_map<uint64_t, PendingRequest> requests;  ///< Outstanding requests (loop thread only).
+
+    void handle_datagrams();
+    void handle_datagram(const std::string& datagram, const std::string& from);
+    void send_datagram(const std::string& address, const std::string& datagram);
+    void send_request(const NodeContact& contact, uint8_t kind, const std::string& body, ReplyHandler on_reply);
+    void observe(const NodeContact& contact, double rtt_ms);
+    void start_lookup(size_t target, std::function<void(std::vector<NodeContact>)> done);
+    void step_lookup(const std::shared_ptr<Lookup>& lookup);
+    void check_liveness();
+    void load_peer_cache(const std::string& path);
 };
 
 #endif // NODE_DISCOVERY_HPP
@@ -85,5 +284,6 @@ private:
  * This module implements the node discovery mechanism for the SynLedger network. It is responsible for identifying 
  * and storing peer nodes and their network addresses, enabling efficient peer-to-peer communication. The discovery 
  * process ensures that new nodes can join the network, and existing nodes can maintain awareness of their peers, 
- * contributing to the decentralized and distributed nature of the system.
+ * contributing to the decentralized and distributed nature of the system. Because each bucket is bounded and every
+ * lookup halves the remaining distance, a node needs O(log n) state and O(log n) round trips in a network of n nodes.
  */
@@ -5,6 +5,11 @@
  * This header defines the P2PProtocol class, which manages peer-to-peer communication between nodes in the 
  * SynLedger network. It facilitates the discovery of peers, exchange of messages, and handling of incoming 
  * connections through a decentralized, secure, and scalable network protocol.
+ *
+ * Every peer is reached over one long-lived TCP connection carrying length-prefixed frames (a 4-byte big-endian
+ * payload length followed by the payload), so any number of messages can be pipelined on it. All sockets are
+ * non-blocking and driven by a fixed pool of `EventLoop` threads; decoded messages reach the handler through a
+ * bounded queue.
  */
 
 #ifndef P2P_PROTOCOL_HPP
@@ -13,10 +18,67 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <deque>
+#include <memory>
 #include <thread>
 #include <mutex>
 #include <shared_mutex>
+#include <functional>
+#include <atomic>
+#include <cstdint>
 #include <netinet/in.h>  // For socket communication
+#include "event_loop.hpp"
+#include "bounded_queue.hpp"
+#include "../metrics/metrics.hpp"
+
+/**
+ * @brief Callback invoked for every complete message received from a peer.
+ *
+ * Called on the dispatch thread, in the order each peer sent its messages.
+ */
+using MessageHandler = std::function<void(const std::string& remote_address, const std::string& message)>;
+
+/**
+ * @struct InboundMessage
+ * @brief A decoded message waiting for the handler.
+ */
+struct InboundMessage {
+    std::string remote_address;  ///< Address of the connection the message arrived on.
+    std::string payload;         ///< The message itself.
+};
+
+/**
+ * @struct Connection
+ * @brief State of one TCP connection, owned by the event loop it is assigned to.
+ *
+ * Every field except the atomic counters is only touched on that loop's thread. Outbound (dialed) connections
+ * live as long as the peer is known and reconnect with exponential backoff; accepted ones are discarded on close.
+ */
+struct Connection {
+    EventLoop* loop = nullptr;            ///< Event loop driving this connection.
+    uint64_t id = 0;                      ///< Key of an accepted connection in `P2PProtocol::inbound`.
+    int socket = -1;                      ///< Socket, or -1 while disconnected.
+    std::string remote;                   ///< `host:port` of the remote end.
+    std::string read_buffer;              ///< Received bytes not yet forming a complete frame.
+    std::deque<std::string> outbound;     ///< Encoded frames waiting to be written, oldest first.
+    size_t write_offset = 0;              ///< Bytes of `outbound.front()` already written.
+    size_t outbound_bytes = 0;            ///< Total size of `outbound`.
+
+    bool dialer = false;                  ///< True for connections this node opens to a known peer.
+    std::string host;                     ///< Peer IPv4 address (dialers only).
+    int port = 0;                         ///< Peer port (dialers only).
+    bool connecting = false;              ///< A non-blocking connect is in progress.
+    bool reconnect_pending = false;       ///< A reconnection timer is armed.
+    int backoff_ms = 0;                   ///< Delay before the next reconnection attempt.
+    uint64_t attempt = 0;                 ///< Connect attempt counter, used to expire stale timeouts.
+
+    std::atomic<size_t> queued{ 0 };          ///< Mirror of `outbound.size()` for other threads.
+    std::atomic<size_t> buffered_bytes{ 0 };  ///< Mirror of the read plus write buffer size.
+    std::atomic<size_t> dropped{ 0 };         ///< Frames discarded because the queue limits were hit.
+    std::atomic<uint64_t> bytes_sent{ 0 };      ///< Bytes written to the socket, over all reconnections.
+    std::atomic<uint64_t> bytes_received{ 0 };  ///< Bytes read from the socket, over all reconnections.
+};
 
 /**
  * @class P2PProtocol
@@ -32,27 +94,87 @@ private:
     std::string network_address;          ///< Network address of this node.
     std::vector<size_t> peers;            ///< List of peer node IDs known to this node.
     std::map<size_t, std::string> peer_addresses; ///< Map of peer node IDs to their network addresses.
+    std::map<size_t, std::unique_ptr<Connection>> connections; ///< Outbound connection of every known peer.
     int listen_socket;                    ///< Socket used to listen for incoming peer connections.
     mutable std::shared_mutex peer_mutex; ///< Mutex to protect access to the peer list.
-    bool stop_flag;                       ///< Flag to signal when to stop incoming connections.
-    std::thread incoming_thread;          ///< Thread handling incoming connections.
+    std::atomic<bool> stop_flag;          ///< Flag to signal when to stop incoming connections.
+
+    std::vector<std::unique_ptr<EventLoop>> loops;  ///< One reactor per I/O thread.
+    std::vector<std::thread> io_threads;            ///< Threads running `loops`.
+    std::atomic<size_t> next_loop;                  ///< Round-robin cursor for assigning connections.
+    std::atomic<uint64_t> next_connection_id;       ///< Id given to the next accepted connection.
+    std::unordered_map<uint64_t, std::unique_ptr<Connection>> inbound; ///< Accepted connections by id.
+    mutable std::mutex inbound_mutex;               ///< Guards `inbound`.
+
+    BoundedQueue<InboundMessage> inbound_queue;     ///< Decoded messages awaiting the handler.
+    std::thread dispatch_thread;                    ///< Thread delivering `inbound_queue` to the handler.
+    MessageHandler message_handler;                 ///< Receives every inbound message.
+    std::mutex handler_mutex;                       ///< Guards `message_handler`.
+    size_t metrics_collector;                       ///< Handle of the per-peer metrics collector.
 
     /**
-     * @brief Handles incoming connections from peers.
+     * @brief Accepts every pending incoming connection.
      * 
-     * This method runs in a separate thread to continuously accept new peer connections 
-     * and assign each connection to a handler.
+     * Runs on the first event loop whenever the listen socket is readable and assigns each new connection to
+     * an event loop in round-robin order.
      */
     void handle_incoming_connections();
 
     /**
-     * @brief Handles communication with a connected peer.
+     * @brief Adds per-connection byte counts and queue depths to a metrics scrape.
+     *
+     * Dialed connections are labelled with the peer's node ID, accepted ones with their remote address.
+     */
+    void collect_metrics(MetricsWriter& writer) const;
+
+    /**
+     * @brief Handles readiness events of a connection.
      * 
-     * Manages the interaction and message exchange between this node and the connected peer.
+     * Completes a pending connect, reads and decodes frames, and writes queued frames as the socket allows.
      * 
-     * @param peer_socket The socket for the peer connection.
+     * @param connection The connection that became ready.
+     * @param events The ready events.
+     */
+    void handle_connection_event(Connection& connection, uint32_t events);
+
+    /**
+     * @brief Reads available bytes and queues every complete frame for the handler.
+     * 
+     * @return False if the connection was closed (an accepted connection is destroyed at that point).
+     */
+    bool read_frames(Connection& connection);
+
+    /**
+     * @brief Writes queued frames until the socket would block.
+     * 
+     * @return False if the connection was closed.
+     */
+    bool write_frames(Connection& connection);
+
+    /**
+     * @brief Queues an encoded frame on a connection, enforcing the per-peer limits.
+     */
+    void enqueue_frame(Connection& connection, std::string frame);
+
+    /**
+     * @brief Starts a non-blocking connect to a dialer's peer.
      */
-    void handle_peer_connection(int peer_socket);
+    void start_connect(Connection& connection);
+
+    /**
+     * @brief Arms the reconnection timer of a dialer and doubles its backoff.
+     */
+    void schedule_reconnect(Connection& connection);
+
+    /**
+     * @brief Closes the socket of a connection; dialers keep their queue and reconnect when it is not empty.
+     */
+    void close_connection(Connection& connection);
+
+    /**
+     * @brief Delivers queued inbound messages to the handler until shutdown.
+     */
+    void dispatch_messages();
 
     /**
      * @brief Sets up the listening socket to accept incoming peer connections.
@@ -63,16 +185,32 @@ private:
      */
     void setup_listen_socket(int port);
 
+    EventLoop& assign_loop();  ///< Picks the event loop for a new connection.
+    static void update_buffered_bytes(Connection& connection);  ///< Refreshes the cross-thread counters.
+
 public:
+    static const int DEFAULT_PEER_PORT = 8080;               ///< Port used for peer addresses without one.
+    static const uint32_t MAX_FRAME_SIZE = 16u << 20;        ///< Largest accepted message, in bytes.
+    static const size_t MAX_OUTBOUND_QUEUE = 4096;           ///< Frames buffered per peer before the oldest is dropped.
+    static const size_t MAX_OUTBOUND_BYTES = 64u << 20;      ///< Bytes buffered per peer before the oldest frame is dropped.
+    static const int INITIAL_BACKOFF_MS = 100;               ///< Delay before the first reconnection attempt.
+    static const int MAX_BACKOFF_MS = 30000;                 ///< Upper bound of the reconnection delay.
+    static const size_t DEFAULT_IO_THREADS = 2;              ///< Default number of event loop threads.
+    static const size_t DEFAULT_INBOUND_QUEUE = 8192;        ///< Default capacity of the inbound message queue.
+
     /**
      * @brief Constructs a P2PProtocol object.
      * 
-     * Initializes the peer-to-peer protocol for the node with its ID and network address.
+     * Initializes the peer-to-peer protocol for the node with its ID and network address and starts the I/O
+     * and dispatch threads.
      * 
      * @param node_id The unique ID of this node.
      * @param network_address The network address of this node.
+     * @param io_threads Number of event loop threads serving all connections.
+     * @param inbound_queue_capacity Messages buffered for the handler before reading pauses.
      */
-    P2PProtocol(size_t node_id, const std::string& network_address);
+    P2PProtocol(size_t node_id, const std::string& network_address, size_t io_threads = DEFAULT_IO_THREADS,
+                size_t inbound_queue_capacity = DEFAULT_INBOUND_QUEUE);
 
     /**
      * @brief Destructor for P2PProtocol.
@@ -93,20 +231,34 @@ public:
     /**
      * @brief Sends a message to a specified peer.
      * 
-     * Sends a message to the given peer node using its ID. The message is transmitted over the network.
+     * Queues the message on the peer's connection and returns immediately; the peer's event loop transmits it,
+     * in order, once the connection is up. If the peer's queue exceeds `MAX_OUTBOUND_QUEUE` frames or
+     * `MAX_OUTBOUND_BYTES` bytes, the oldest queued messages are dropped.
      * 
      * @param peer_node_id The ID of the peer to send the message to.
      * @param message The message to send.
+     * @throws std::runtime_error if the peer is unknown.
+     * @throws std::invalid_argument if the message exceeds `MAX_FRAME_SIZE`.
      */
     void send_message(size_t peer_node_id, const std::string& message);
 
+    /**
+     * @brief Sets the callback that receives inbound messages.
+     * 
+     * By default, messages are printed to standard output.
+     * 
+     * @param handler The callback to invoke for every received message.
+     */
+    void set_message_handler(MessageHandler handler);
+
     /**
      * @brief Adds a new peer to the list of known peers.
      * 
      * Registers a peer by adding its node ID and network address to the list of known peers.
      * 
      * @param peer_node_id The unique ID of the peer node.
-     * @param peer_address The network address of the peer node.
+     * @param peer_address The network address of the peer node, as `ip` or `ip:port` (default port 8080).
+     * @throws std::invalid_argument if the address is not a valid IPv4 address.
      */
     void add_peer(size_t peer_node_id, const std::string& peer_address);
 
@@ -129,10 +281,39 @@ public:
      */
     std::string get_peer_address(size_t peer_node_id) const;
 
+    /**
+     * @brief Returns the number of messages still waiting to be written to a peer.
+     * 
+     * @param peer_node_id The ID of the peer.
+     * @return The queue length, or 0 for unknown peers.
+     */
+    size_t get_queued_messages(size_t peer_node_id) const;
+
+    /**
+     * @brief Returns the number of messages dropped because a peer's queue was full.
+     * 
+     * @param peer_node_id The ID of the peer.
+     * @return The number of dropped messages, or 0 for unknown peers.
+     */
+    size_t get_dropped_messages(size_t peer_node_id) const;
+
+    /**
+     * @brief Returns the bytes buffered for all connections (pending writes plus partial reads).
+     * 
+     * @return The total buffer memory of the networking layer.
+     */
+    size_t get_buffered_bytes() const;
+
+    /**
+     * @brief Returns the number of event loop threads.
+     */
+    size_t get_io_thread_count() const;
+
     /**
      * @brief Shuts down the peer-to-peer protocol.
      * 
-     * Stops accepting new connections and closes any active connections, gracefully shutting down the peer-to-peer protocol.
+     * Stops accepting new connections, stops the I/O and dispatch threads and closes every connection.
+     * Messages still queued are discarded. Safe to call more than once.
      */
     void shutdown();
 };
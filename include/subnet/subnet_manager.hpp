@@ -5,6 +5,12 @@
  * This header defines the `SubnetManager` class, which is responsible for assigning nodes to subnets 
  * within the decentralized SynLedger network. It ensures load balancing by evenly distributing nodes 
  * across subnets and provides functionality to rebalance the subnets dynamically as network conditions change.
+ *
+ * Nodes are placed by consistent hashing with bounded loads: each subnet owns `VIRTUAL_NODES` points on a 64-bit
+ * hash ring, and a node goes to the first subnet clockwise from its own hash whose load is below
+ * `LOAD_BOUND` times the average. Readers use an immutable published snapshot of the assignment and never take a
+ * lock; writers copy only the parts of the snapshot they change and publish the result atomically, once per
+ * join or once per batch of joins.
  */
 
 #ifndef SUBNET_MANAGER_HPP
@@ -12,8 +18,23 @@
 
 #include <vector>
 #include <string>
-#include <map>
+#include <array>
+#include <unordered_map>
+#include <memory>
 #include <mutex>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @struct SubnetMigration
+ * @brief One move of a rebalance plan.
+ */
+struct SubnetMigration {
+    size_t node_id;      ///< The node to move.
+    size_t from_subnet;  ///< Its current subnet.
+    size_t to_subnet;    ///< Its new subnet.
+};
 
 /**
  * @class SubnetManager
@@ -25,65 +46,134 @@
  */
 class SubnetManager {
 public:
+    static const size_t VIRTUAL_NODES = 64;  ///< Ring points per subnet.
+    static const size_t NODE_SHARDS = 64;    ///< Shards of the published node map; a write copies one shard.
+
     /**
      * @brief Constructs a SubnetManager with a specified number of subnets.
      * 
      * Initializes the subnet manager, setting up the necessary subnets for node assignment.
      * 
      * @param total_subnets The total number of subnets in the network.
+     * @throws std::invalid_argument if `total_subnets` is zero.
      */
     SubnetManager(size_t total_subnets);
 
     /**
      * @brief Assigns a node to a subnet.
      * 
-     * Randomly assigns a node to one of the subnets, ensuring a balanced distribution of nodes across all subnets.
+     * Places the node on the hash ring and walks clockwise to the first subnet that is below its load bound,
+     * which takes O(log n) in the number of ring points. A node that is already assigned keeps its subnet.
+     * Publishing the join copies the node's shard and the subnet's member list, so one join costs
+     * O(n / NODE_SHARDS + n / total_subnets); use `assign_nodes_to_subnets` to add many nodes at once.
      * 
      * @param node_id The unique identifier of the node to be assigned.
      */
     void assign_node_to_subnet(size_t node_id);
 
+    /**
+     * @brief Assigns several nodes, in order, and publishes the result once.
+     * 
+     * Places every node exactly as the same sequence of `assign_node_to_subnet` calls would, but copies each
+     * touched shard and member list only once, so a batch of k joins costs O(n + k) instead of O(k * n).
+     * 
+     * @param node_ids The nodes to assign; already assigned nodes and repeats keep their subnet.
+     */
+    void assign_nodes_to_subnets(const std::vector<size_t>& node_ids);
+
     /**
      * @brief Retrieves the subnet ID for a specific node.
      * 
-     * Returns the subnet to which a given node is assigned.
+     * Returns the subnet to which a given node is assigned. Never blocks, even during a rebalance.
      * 
      * @param node_id The unique identifier of the node.
      * @return The ID of the subnet to which the node is assigned.
+     * @throws std::runtime_error if the node is not assigned.
      */
     size_t get_node_subnet(size_t node_id) const;
 
     /**
      * @brief Retrieves the list of nodes in a specific subnet.
      * 
-     * Returns all the nodes assigned to a given subnet.
+     * Returns all the nodes assigned to a given subnet, in the order they joined it. Never blocks.
      * 
      * @param subnet_id The ID of the subnet.
-     * @return A vector containing the node IDs assigned to the subnet.
+     * @return A vector containing the node IDs assigned to the subnet, empty for an unknown subnet.
      */
     std::vector<size_t> get_subnet_nodes(size_t subnet_id) const;
 
+    /**
+     * @brief Returns the number of nodes in a subnet, or 0 for an unknown subnet.
+     */
+    size_t get_subnet_load(size_t subnet_id) const;
+
+    size_t get_total_subnets() const { return total_subnets; }  ///< Number of subnets.
+
+    /**
+     * @brief Computes the moves that would even out the subnets.
+     * 
+     * Every subnet ends with either floor or ceil of the average load, the ceil going to the subnets that are
+     * loaded most already, which makes the number of moves the minimum possible. Moved nodes are the most recent
+     * members of their subnet, and each goes to the first subnet with room clockwise from its hash.
+     * 
+     * @return The migrations, grouped by source subnet.
+     */
+    std::vector<SubnetMigration> plan_rebalance() const;
+
     /**
      * @brief Rebalances the subnets to ensure even distribution of nodes.
      * 
-     * Dynamically redistributes nodes across subnets to ensure that no subnet becomes overloaded.
+     * Applies `plan_rebalance()` and publishes the new assignment in one step.
+     * 
+     * @return The migrations that were applied.
      */
-    void rebalance_subnets();
+    std::vector<SubnetMigration> rebalance_subnets();
 
-private:
-    size_t total_subnets;                                ///< Total number of subnets in the network.
-    std::map<size_t, size_t> node_to_subnet_map;         ///< Maps each node to its assigned subnet.
-    std::map<size_t, std::vector<size_t>> subnet_nodes;  ///< Stores the nodes assigned to each subnet.
-    mutable std::mutex subnet_mutex;                     ///< Mutex for thread-safe access to subnet data.
+    /**
+     * @brief Returns the members of every subnet, in join order, as of one published assignment.
+     */
+    std::vector<std::vector<size_t>> get_assignment() const;
 
     /**
-     * @brief Finds the least loaded subnet.
+     * @brief Replaces the whole assignment, e.g. with the one from a state snapshot.
      * 
-     * Determines which subnet currently has the fewest nodes, allowing new nodes to be assigned there.
+     * Member order is kept, so later joins and rebalances proceed exactly as on the node that took the snapshot.
      * 
-     * @return The ID of the least loaded subnet.
+     * @param members The members of each subnet, in join order.
+     * @throws std::invalid_argument if the number of subnets differs or a node is listed twice.
+     */
+    void restore_assignment(const std::vector<std::vector<size_t>>& members);
+
+private:
+    using NodeShard = std::unordered_map<size_t, size_t>;  ///< Node to subnet, for nodes of one shard.
+
+    struct Topology {
+        std::array<std::shared_ptr<const NodeShard>, NODE_SHARDS> node_shards;  ///< Node to subnet, sharded.
+        std::vector<std::shared_ptr<const std::vector<size_t>>> subnet_nodes;    ///< Members by subnet.
+    };
+
+    size_t total_subnets;                                ///< Total number of subnets in the network.
+    std::vector<std::pair<uint64_t, size_t>> ring;       ///< Ring points and their subnets, by point.
+    std::vector<size_t> loads;                           ///< Members by subnet; guarded by `subnet_mutex`.
+    size_t node_count;                                   ///< Assigned nodes; guarded by `subnet_mutex`.
+    std::shared_ptr<const Topology> published;           ///< Current assignment; accessed atomically.
+    mutable std::mutex subnet_mutex;                     ///< Serializes writers; readers never take it.
+
+    /**
+     * @brief Walks the ring clockwise from the node's hash to the first subnet accepted by `has_room`.
+     */
+    template <typename HasRoom>
+    size_t walk_ring(size_t node_id, HasRoom has_room) const;
+
+    /**
+     * @brief Returns the ring position of a node.
+     */
+    static uint64_t node_point(size_t node_id);
+
+    /**
+     * @brief Computes the rebalance plan; the caller holds `subnet_mutex`.
      */
-    size_t find_least_loaded_subnet() const;
+    std::vector<SubnetMigration> compute_plan(const Topology& topology) const;
 };
 
 #endif // SUBNET_MANAGER_HPP
@@ -93,5 +183,7 @@ private:
  * 
  * This module defines the logic for managing subnets in the SynLedger network, providing efficient 
  * load balancing by distributing nodes evenly across subnets. It supports node assignment, querying subnet membership, 
- * and rebalancing to ensure a scalable and efficient network.
+ * and rebalancing to ensure a scalable and efficient network. Consistent hashing keeps a node's subnet stable as
+ * subnets fill up, and the load bound keeps any subnet from taking more than its share, so joins and rebalances
+ * move only the nodes that must move.
  */
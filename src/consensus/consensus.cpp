@@ -1,136 +1,367 @@
 #include "consensus/consensus.hpp"
 #include "ledger/block.hpp"
 #include "network/p2p_protocol.hpp"
-#include <iostream>
+#include "cryptography/crypto.hpp"
+#include "cryptography/ecdsa.hpp"
+#include "logging/logger.hpp"
+#include "metrics/metrics.hpp"
 #include <omp.h>
 #include <mutex>
 #include <atomic>
 #include <chrono>
+#include <future>
+#include <optional>
+#include <algorithm>
+
+const size_t MAX_BLOCK_TRANSACTIONS = 2000;  // Upper bound on transactions per block template.
+
+const int Consensus::MULTISIG_TIMEOUT_MS;
 
 Consensus::Consensus(size_t num_validators, P2PProtocol& network, PoSygEngine& posyg_engine, Ledger& ledger)
     : num_validators(num_validators), current_block(0, std::string(""), 2), 
-      p2p_network(network), posyg_engine(posyg_engine), ledger(ledger),
-      slashing_penalty(100.0), reward_for_validators(50.0) {
+      p2p_network(network), gossip(nullptr), posyg_engine(posyg_engine), ledger(ledger),
+      slashing_penalty(100.0), reward_for_validators(50.0), reward_ledger(num_validators) {
+    bookkeeping_thread = std::thread([this] { bookkeeping_loop.run(); });
     for (size_t i = 0; i < num_validators; ++i) {
         validators.push_back(i);
+        auto key_pair = ECDSA::generate_key_pair();
+        validator_private_keys.push_back(key_pair.first);
+        validator_public_keys.push_back(key_pair.second);
     }
 }
 
-Consensus::~Consensus() {}
+Consensus::~Consensus() {
+    flush_bookkeeping();
+    bookkeeping_loop.stop();
+    bookkeeping_thread.join();
+}
+
+// Milliseconds elapsed since `start`.
+static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void StageLatency::record(double ms) {
+    ++samples;
+    total_ms += ms;
+    max_ms = std::max(max_ms, ms);
+}
 
 void Consensus::initiate_consensus() {
-    std::cout << "Initiating consensus with " << num_validators << " validators." << std::endl;
+    LOG_INFO("consensus") << "Initiating consensus with " << num_validators << " validators.";
     
-    auto start_time = std::chrono::high_resolution_clock::now();
-    
-    dynamic_network_management();
+    auto start_time = std::chrono::steady_clock::now();
 
     Block new_block = create_new_block();
+    bool proposed = validate_block(new_block);
+    record_latency(ConsensusStage::PROPOSE, elapsed_ms(start_time));
 
-    if (validate_block(new_block)) {
-        handle_multisig(new_block);
-        finalize_block(new_block);
+    if (!proposed) {
+        LOG_WARN("consensus") << "Block validation failed!";
     } else {
-        std::cout << "Block validation failed!" << std::endl;
+        auto vote_start = std::chrono::steady_clock::now();
+        bool voted = handle_multisig(new_block);
+        record_latency(ConsensusStage::VOTE, elapsed_ms(vote_start));
+
+        if (voted) {
+            auto finalize_start = std::chrono::steady_clock::now();
+            bool committed = finalize_block(new_block);
+            record_latency(ConsensusStage::FINALIZE, elapsed_ms(finalize_start));
+            if (committed) {
+                std::lock_guard<std::mutex> lock(stats_mutex);
+                block_latency.record(elapsed_ms(start_time));
+            }
+        } else {
+            LOG_WARN("consensus") << "Block " << new_block.get_block_number() << " did not reach its signature quorum.";
+        }
     }
 
-    auto end_time = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> block_time = end_time - start_time;
-    std::cout << "Block time: " << block_time.count() << " seconds" << std::endl;
+    LOG_INFO("consensus") << "Block time: " << elapsed_ms(start_time) / 1000.0 << " seconds";
 
-    validate_and_slash();
-    distribute_rewards();
+    schedule_bookkeeping();
+}
+
+size_t Consensus::run_pipeline(size_t rounds) {
+    struct InFlight {
+        Block block;                                        // The proposal.
+        std::chrono::steady_clock::time_point proposed_at;  // Start of its proposal stage.
+    };
+
+    std::optional<InFlight> voting;      // Proposed at the previous step, collecting votes at this one.
+    std::optional<InFlight> finalizing;  // Reached its quorum at the previous step.
+    size_t next_number = ledger.get_blockchain_length();
+    std::string parent_hash = ledger.get_latest_block().get_block_hash();
+    size_t proposed = 0;
+    size_t finalized = 0;
+
+    LOG_INFO("consensus") << "Starting consensus pipeline for " << rounds << " rounds.";
+
+    while (proposed < rounds || voting || finalizing) {
+        std::future<std::optional<InFlight>> proposal;
+        if (proposed < rounds) {
+            // Transactions of the blocks still in flight must not be proposed again.
+            std::unordered_set<Hash256, Hash256Hasher> excluded;
+            for (const std::optional<InFlight>* in_flight : { &voting, &finalizing }) {
+                if (*in_flight) {
+                    for (const auto& tx : (*in_flight)->block.get_transactions()) {
+                        excluded.insert(tx.hash());
+                    }
+                }
+            }
+            proposal = std::async(std::launch::async, [this, next_number, parent_hash, excluded = std::move(excluded)] {
+                auto start = std::chrono::steady_clock::now();
+                Block block = create_block(next_number, parent_hash, excluded);
+                bool valid = validate_block(block);
+                record_latency(ConsensusStage::PROPOSE, elapsed_ms(start));
+                return valid ? std::optional<InFlight>(InFlight{ std::move(block), start }) : std::nullopt;
+            });
+            ++proposed;
+        }
+
+        std::future<bool> finalization;
+        if (finalizing) {
+            finalization = std::async(std::launch::async, [this, &finalizing] {
+                auto start = std::chrono::steady_clock::now();
+                bool committed = finalize_block(finalizing->block);
+                record_latency(ConsensusStage::FINALIZE, elapsed_ms(start));
+                if (committed) {
+                    std::lock_guard<std::mutex> lock(stats_mutex);
+                    block_latency.record(elapsed_ms(finalizing->proposed_at));
+                }
+                return committed;
+            });
+        }
+
+        // Voting keeps the calling thread, whose OpenMP team signs for the validators.
+        bool voted = false;
+        if (voting) {
+            auto start = std::chrono::steady_clock::now();
+            voted = handle_multisig(voting->block);
+            record_latency(ConsensusStage::VOTE, elapsed_ms(start));
+        }
+
+        std::optional<InFlight> next = proposal.valid() ? proposal.get() : std::nullopt;
+        bool committed = true;
+        if (finalization.valid()) {
+            committed = finalization.get();
+            if (committed) {
+                ++finalized;
+                schedule_bookkeeping();
+            }
+        }
+
+        if (!committed) {
+            // Another block took the height, so every block in flight descends from a dead branch; restart the
+            // pipeline on the ledger's actual tip.
+            std::lock_guard<std::mutex> lock(ledger_mutex);
+            next_number = ledger.get_blockchain_length();
+            parent_hash = ledger.get_latest_block().get_block_hash();
+            voted = false;
+            next.reset();
+        } else if (voting && !voted) {
+            // The proposal was built on a block that will never be finalized; rebuild that height on its parent.
+            LOG_WARN("consensus") << "Block " << voting->block.get_block_number()
+                                  << " did not reach its signature quorum.";
+            next_number = voting->block.get_block_number();
+            parent_hash = voting->block.get_previous_block_hash();
+            next.reset();
+        } else if (next) {
+            next_number = next->block.get_block_number() + 1;
+            parent_hash = next->block.get_block_hash();
+        }
+
+        finalizing = voted ? std::move(voting) : std::nullopt;
+        voting = std::move(next);
+    }
+
+    LOG_INFO("consensus") << "Consensus pipeline finalized " << finalized << " of " << proposed << " blocks.";
+    return finalized;
 }
 
 Block Consensus::create_new_block() {
-    Block new_block(ledger.get_blockchain_length(), ledger.get_latest_block().get_block_hash(), 2);
-    std::cout << "Creating new block: " << new_block.get_block_number() << std::endl;
+    size_t block_number;
+    std::string previous_block_hash;
+    {
+        std::lock_guard<std::mutex> lock(ledger_mutex);
+        block_number = ledger.get_blockchain_length();
+        previous_block_hash = ledger.get_latest_block().get_block_hash();
+    }
+    return create_block(block_number, previous_block_hash, {});
+}
+
+Block Consensus::create_block(size_t block_number, const std::string& previous_block_hash,
+                              const std::unordered_set<Hash256, Hash256Hasher>& excluded) {
+    Block new_block(block_number, previous_block_hash, 2);
+    LOG_INFO("consensus") << "Creating new block: " << new_block.get_block_number();
+
+    std::lock_guard<std::mutex> lock(ledger_mutex);
+    if (ledger.has_pending_transactions()) {
+        // The template references transactions inside the mempool; they are only copied into the block itself.
+        std::vector<const Transaction*> selected =
+            ledger.get_pending_transactions().select(MAX_BLOCK_TRANSACTIONS + excluded.size());
+        if (!excluded.empty()) {
+            selected.erase(std::remove_if(selected.begin(), selected.end(),
+                                          [&](const Transaction* tx) { return excluded.count(tx->hash()) != 0; }),
+                           selected.end());
+        }
+        if (selected.size() > MAX_BLOCK_TRANSACTIONS) {
+            selected.resize(MAX_BLOCK_TRANSACTIONS);
+        }
+        new_block.add_transactions(selected);
+    }
 
     return new_block;
 }
 
 bool Consensus::validate_block(const Block& block) {
-    std::cout << "Validating block: " << block.get_block_number() << std::endl;
+    LOG_INFO("consensus") << "Validating block: " << block.get_block_number();
 
     if (block.get_previous_block_hash().empty()) {
-        std::cout << "Invalid block: empty previous block hash!" << std::endl;
+        LOG_WARN("consensus") << "Invalid block: empty previous block hash!";
         return false;
     }
 
     if (block.get_block_hash().empty()) {
-        std::cout << "Invalid block: empty block hash!" << std::endl;
+        LOG_WARN("consensus") << "Invalid block: empty block hash!";
         return false;
     }
 
     return true;
 }
 
-void Consensus::handle_multisig(const Block& block) {
-    Block block_copy = block;
-    std::mutex mtx;
-    std::atomic<bool> block_signed(false);
+bool Consensus::handle_multisig(Block& block) {
+    static Histogram& quorum_time = MetricsRegistry::instance().timer(
+        "synledger_consensus_quorum_seconds", "Time from the start of signature collection to a complete quorum");
+    static Counter& quorum_failures = MetricsRegistry::instance().counter(
+        "synledger_consensus_quorum_failures_total", "Signature collections that ended without a quorum");
+    const uint64_t collection_start = metric_clock_ns();
+    const size_t required = block.get_required_signatures();
+    if (required > num_validators) {
+        LOG_WARN("consensus") << "Block " << block.get_block_number() << " requires " << required
+                              << " signatures but only " << num_validators << " validators exist.";
+        return false;
+    }
 
-    std::cout << "Starting signature collection for block: " << block_copy.get_block_number() << std::endl;
+    SignatureCollector collector(block.get_block_hash(), validator_public_keys, required);
+    LOG_INFO("consensus") << "Starting signature collection for block: " << block.get_block_number();
 
-    #pragma omp parallel for
+    // Each validator signs and submits on its own thread; the collector needs no lock, and validators that
+    // start after the quorum is complete skip signing altogether.
+    #pragma omp parallel for schedule(dynamic)
     for (size_t i = 0; i < num_validators; ++i) {
-        if (!block_signed.load()) {
-            std::string validator_signature = "Signature_" + std::to_string(i);
-
-            {
-                std::lock_guard<std::mutex> lock(mtx);
-                bool is_signed = block_copy.sign_block(validator_signature);
-                if (!is_signed) {
-                    std::cout << "Block already has enough signatures. Breaking loop." << std::endl;
-                    block_signed.store(true);
-                }
-            }
+        if (collector.has_quorum()) {
+            continue;
         }
+        std::string signature = Crypto::sign(block.get_block_hash(), validator_private_keys[i]);
+        collector.submit(i, signature);
+    }
+
+    if (!collector.wait_for_quorum(std::chrono::milliseconds(MULTISIG_TIMEOUT_MS))) {
+        LOG_WARN("consensus") << "Block " << block.get_block_number() << " collected "
+                              << collector.get_signature_count() << " of " << required << " signatures.";
+        quorum_failures.add();
+        return false;
     }
+    quorum_time.record(metric_clock_ns() - collection_start);
 
-    std::cout << "Signature collection completed for block: " << block_copy.get_block_number() << std::endl;
+    for (const auto& signature : collector.get_quorum_signatures()) {
+        block.sign_block(signature);
+    }
+    LOG_INFO("consensus") << "Block " << block.get_block_number() << " verified with "
+                          << collector.get_signature_count() << " signatures (" << collector.get_rejected_count()
+                          << " rejected).";
+    return block.verify_signatures();
+}
 
-    if (block_copy.verify_signatures()) {
-        std::cout << "Block " << block_copy.get_block_number() << " verified with enough signatures." << std::endl;
-    } else {
-        std::cout << "Block " << block_copy.get_block_number() << " does not have enough signatures." << std::endl;
+bool Consensus::finalize_block(const Block& block) {
+    {
+        std::lock_guard<std::mutex> lock(ledger_mutex);
+        if (block.get_previous_block_hash() != ledger.get_latest_block().get_block_hash()) {
+            LOG_WARN("consensus") << "Finalized block " << block.get_block_number()
+                                  << " no longer extends the ledger tip; not committed.";
+            return false;
+        }
+        ledger.add_block(block);
+        current_block = block;
+    }
+    if (gossip) {
+        gossip->broadcast(InventoryType::BLOCK, block.get_block_digest(), block.serialize());
     }
+    LOG_INFO("consensus") << "Finalized block: " << block.get_block_number() << " with hash: " << block.get_block_hash();
+    return true;
 }
 
-void Consensus::finalize_block(const Block& block) {
-    current_block = block;
-    p2p_network.send_message(0, "Finalized block with hash: " + block.get_block_hash());
-    std::cout << "Finalized block: " << block.get_block_number() << " with hash: " << block.get_block_hash() << std::endl;
+void Consensus::set_gossip(Gossip* gossip) {
+    this->gossip = gossip;
 }
 
 void Consensus::slash_validator(size_t validator_id) {
-    Participant& participant = posyg_engine.get_participant(validator_id);
-    participant.apply_slash();
-    std::cout << "Validator " << validator_id << " slashed." << std::endl;
+    reward_ledger.slash(validator_id, SlashReason::SUSPICIOUS_BEHAVIOR);
 }
 
 void Consensus::validate_and_slash() {
-    #pragma omp parallel for
+    const ParticipantTable& participants = posyg_engine.get_participants();
+    reward_ledger.require_tracked(validators);
+
+    #pragma omp parallel for num_threads(reward_ledger.get_thread_capacity())
     for (size_t i = 0; i < num_validators; ++i) {
-        Participant& participant = posyg_engine.get_participant(validators[i]);
-        if (participant.detect_suspicious_behavior()) {
-            slash_validator(validators[i]);
+        const size_t id = validators[i];
+        if (!participants.is_slashed(id) && participants.is_suspicious(id)) {
+            slash_validator(id);
         }
     }
 }
 
 void Consensus::distribute_rewards() {
-    std::cout << "Distributing rewards to validators." << std::endl;
+    LOG_INFO("consensus") << "Distributing rewards to validators.";
+    reward_ledger.require_tracked(validators);
 
-    #pragma omp parallel for
+    #pragma omp parallel for num_threads(reward_ledger.get_thread_capacity())
     for (size_t i = 0; i < num_validators; ++i) {
-        Participant& participant = posyg_engine.get_participant(validators[i]);
-        participant.reward += reward_for_validators;
+        reward_ledger.credit(validators[i], reward_for_validators);
     }
 }
 
 void Consensus::dynamic_network_management() {
-    std::cout << "Adjusting network parameters dynamically." << std::endl;
+    LOG_INFO("consensus") << "Adjusting network parameters dynamically.";
     slashing_penalty *= 1.05;
     reward_for_validators *= 1.02;
 }
+
+void Consensus::schedule_bookkeeping() {
+    // Only the bookkeeping thread touches the penalties, the rewards and the participants' balances.
+    bookkeeping_loop.post([this] {
+        auto start = std::chrono::steady_clock::now();
+        dynamic_network_management();
+        validate_and_slash();
+        distribute_rewards();
+        reward_ledger.commit(posyg_engine);
+        record_latency(ConsensusStage::BOOKKEEPING, elapsed_ms(start));
+    });
+}
+
+void Consensus::set_slashing_sink(SlashingSink sink) {
+    bookkeeping_loop.post([this, sink = std::move(sink)]() mutable { reward_ledger.set_slashing_sink(std::move(sink)); });
+}
+
+void Consensus::flush_bookkeeping() {
+    std::promise<void> done;
+    std::future<void> drained = done.get_future();
+    bookkeeping_loop.post([&done] { done.set_value(); });
+    drained.wait();
+}
+
+void Consensus::record_latency(ConsensusStage stage, double ms) {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    stage_latency[static_cast<size_t>(stage)].record(ms);
+}
+
+StageLatency Consensus::get_stage_latency(ConsensusStage stage) const {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    return stage_latency[static_cast<size_t>(stage)];
+}
+
+StageLatency Consensus::get_block_latency() const {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    return block_latency;
+}
@@ -0,0 +1,549 @@
+#include "consensus/fast_sync.hpp"
+#include "cryptography/crypto.hpp"
+#include "ledger/wire_format.hpp"
+#include "logging/logger.hpp"
+#include "metrics/metrics.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <unordered_set>
+
+// Chunk layout:    format (1 byte) | section (1 byte) | first record (8 bytes) | record count (4 bytes) | records
+//   ACCOUNTS:      address (str16) | balance (f64) | nonce (u64)
+//   ENGINE:        synergy gain, penalty increment, conversion rate, slash penalty, economic activity (f64 each) |
+//                  seed | cycle | honest count | participant count (u64 each)
+//   PARTICIPANTS:  synergy, reward, penalty, economic contribution (f64 each) | violations, economic activity,
+//                  governance activity (u32 each) | behavior (u8) | slashed (u8)
+//   SUBNETS:       subnet id (u32) | node id (u64)
+// Manifest layout: format (1 byte) | height (u64) | block digest (32 bytes) | block (str32) | chunk count (u32) |
+//                  chunk count x (section (1 byte) | first (u64) | records (u32) | size (u32) | hash (32 bytes))
+const uint8_t SNAPSHOT_FORMAT = 1;
+const size_t CHUNK_HEADER_SIZE = 1 + 1 + 8 + 4;
+
+const uint64_t SnapshotStore::DEFAULT_INTERVAL;
+const size_t SnapshotStore::DEFAULT_CHUNK_BYTES;
+const size_t SnapshotStore::RETAINED_SNAPSHOTS;
+const size_t FastSync::MIN_QUORUM;
+
+static void put_hash(ByteWriter& writer, const Hash256& hash) {
+    writer.put_bytes(hash.data(), Hash256::SIZE);
+}
+
+static Hash256 get_hash(ByteReader& reader) {
+    Hash256 hash;
+    memcpy(hash.data(), reader.get_bytes(Hash256::SIZE).data(), Hash256::SIZE);
+    return hash;
+}
+
+static bool valid_section(uint8_t section) {
+    return section >= static_cast<uint8_t>(SnapshotSection::ACCOUNTS) &&
+           section <= static_cast<uint8_t>(SnapshotSection::SUBNETS);
+}
+
+std::string SnapshotManifest::serialize() const {
+    std::string out;
+    ByteWriter writer(out);
+    writer.put_u8(SNAPSHOT_FORMAT);
+    writer.put_u64(height);
+    put_hash(writer, block_digest);
+    writer.put_str32(block);
+    writer.put_u32(static_cast<uint32_t>(chunks.size()));
+    for (const SnapshotChunkInfo& chunk : chunks) {
+        writer.put_u8(static_cast<uint8_t>(chunk.section));
+        writer.put_u64(chunk.first);
+        writer.put_u32(chunk.records);
+        writer.put_u32(chunk.size);
+        put_hash(writer, chunk.hash);
+    }
+    return out;
+}
+
+SnapshotManifest SnapshotManifest::deserialize(std::string_view payload) {
+    ByteReader reader(payload);
+    if (reader.get_u8() != SNAPSHOT_FORMAT) {
+        throw std::runtime_error("Unknown snapshot manifest format");
+    }
+    SnapshotManifest manifest;
+    manifest.height = reader.get_u64();
+    manifest.block_digest = get_hash(reader);
+    manifest.block = std::string(reader.get_str32());
+    uint32_t count = reader.get_u32();
+    if (count > reader.remaining() / (1 + 8 + 4 + 4 + Hash256::SIZE)) {
+        throw std::runtime_error("Truncated wire buffer");
+    }
+    manifest.chunks.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        SnapshotChunkInfo chunk;
+        uint8_t section = reader.get_u8();
+        if (!valid_section(section)) {
+            throw std::runtime_error("Unknown snapshot section " + std::to_string(section));
+        }
+        chunk.section = static_cast<SnapshotSection>(section);
+        chunk.first = reader.get_u64();
+        chunk.records = reader.get_u32();
+        chunk.size = reader.get_u32();
+        chunk.hash = get_hash(reader);
+        manifest.chunks.push_back(chunk);
+    }
+    if (reader.remaining() != 0) {
+        throw std::runtime_error("Trailing bytes after snapshot manifest");
+    }
+    return manifest;
+}
+
+Hash256 SnapshotManifest::digest() const {
+    return Crypto::hash_raw(serialize());
+}
+
+// Cuts the records of one section into chunks that close once they reach the target size.
+struct SectionWriter {
+    NodeSnapshot& snapshot;
+    SnapshotSection section;
+    size_t chunk_bytes;
+    std::string payload;
+    uint64_t first = 0;
+    uint32_t records = 0;
+
+    SectionWriter(NodeSnapshot& snapshot, SnapshotSection section, size_t chunk_bytes)
+        : snapshot(snapshot), section(section), chunk_bytes(std::max<size_t>(chunk_bytes, CHUNK_HEADER_SIZE + 1)) {}
+
+    ByteWriter record() {
+        if (payload.size() >= chunk_bytes) {
+            flush();
+        }
+        ByteWriter writer(payload);
+        if (payload.empty()) {
+            writer.put_u8(SNAPSHOT_FORMAT);
+            writer.put_u8(static_cast<uint8_t>(section));
+            writer.put_u64(first);
+            writer.put_u32(0);  // Record count, patched by flush().
+        }
+        ++records;
+        return writer;
+    }
+
+    void flush() {
+        if (payload.empty()) {
+            return;
+        }
+        ByteWriter(payload).patch_u32(CHUNK_HEADER_SIZE - 4, records);
+        snapshot.manifest.chunks.push_back(SnapshotChunkInfo{ section, first, records,
+                                                              static_cast<uint32_t>(payload.size()),
+                                                              Crypto::hash_raw(payload) });
+        snapshot.chunks.push_back(std::move(payload));
+        payload.clear();
+        first += records;
+        records = 0;
+    }
+};
+
+SnapshotStore::SnapshotStore(uint64_t interval, size_t chunk_bytes)
+    : interval(interval > 0 ? interval : 1), chunk_bytes(chunk_bytes), snapshotted_interval(0) {}
+
+NodeSnapshot SnapshotStore::create_snapshot(const Ledger& ledger, const PoSygEngine& engine,
+                                            const SubnetManager& subnets, size_t chunk_bytes) {
+    static Histogram& create_time = MetricsRegistry::instance().timer("synledger_snapshot_create_seconds",
+                                                                      "Duration of SnapshotStore::create_snapshot");
+    ScopedTimer timer(create_time);
+
+    NodeSnapshot snapshot;
+    const Block& tip = ledger.get_latest_block();
+    snapshot.manifest.height = tip.get_block_number();
+    snapshot.manifest.block_digest = tip.get_block_digest();
+    snapshot.manifest.block = tip.serialize();
+
+    SectionWriter accounts(snapshot, SnapshotSection::ACCOUNTS, chunk_bytes);
+    for (const AccountEntry& account : ledger.get_state().snapshot()->entries()) {
+        ByteWriter writer = accounts.record();
+        writer.put_str16(account.first);
+        writer.put_f64(account.second.balance);
+        writer.put_u64(account.second.nonce);
+    }
+    accounts.flush();
+
+    const PoSygCheckpoint checkpoint = engine.get_checkpoint();
+    const ParticipantTable& table = checkpoint.participants;
+    SectionWriter parameters(snapshot, SnapshotSection::ENGINE, chunk_bytes);
+    ByteWriter writer = parameters.record();
+    writer.put_f64(checkpoint.dynamic_synergy_gain);
+    writer.put_f64(checkpoint.dynamic_penalty_increment);
+    writer.put_f64(checkpoint.dynamic_conversion_rate);
+    writer.put_f64(checkpoint.slash_penalty);
+    writer.put_f64(checkpoint.total_economic_activity);
+    writer.put_u64(checkpoint.seed);
+    writer.put_u64(checkpoint.cycle);
+    writer.put_u64(checkpoint.honest_count);
+    writer.put_u64(table.size());
+    parameters.flush();
+
+    SectionWriter participants(snapshot, SnapshotSection::PARTICIPANTS, chunk_bytes);
+    for (size_t i = 0; i < table.size(); ++i) {
+        ByteWriter row = participants.record();
+        row.put_f64(table.synergy[i]);
+        row.put_f64(table.reward[i]);
+        row.put_f64(table.penalty[i]);
+        row.put_f64(table.economic_contribution[i]);
+        row.put_u32(static_cast<uint32_t>(table.violations_count[i]));
+        row.put_u32(static_cast<uint32_t>(table.economic_activity[i]));
+        row.put_u32(static_cast<uint32_t>(table.governance_activity[i]));
+        row.put_u8(table.behavior[i]);
+        row.put_u8(table.is_slashed(i) ? 1 : 0);
+    }
+    participants.flush();
+
+    SectionWriter members(snapshot, SnapshotSection::SUBNETS, chunk_bytes);
+    const std::vector<std::vector<size_t>> assignment = subnets.get_assignment();
+    for (size_t subnet_id = 0; subnet_id < assignment.size(); ++subnet_id) {
+        for (size_t node_id : assignment[subnet_id]) {
+            ByteWriter member = members.record();
+            member.put_u32(static_cast<uint32_t>(subnet_id));
+            member.put_u64(node_id);
+        }
+    }
+    members.flush();
+    return snapshot;
+}
+
+bool SnapshotStore::maybe_snapshot(const Ledger& ledger, const PoSygEngine& engine, const SubnetManager& subnets) {
+    // Several blocks may arrive between calls, so a multiple of the interval that was passed over still counts.
+    const uint64_t height = ledger.get_latest_block().get_block_number();
+    const uint64_t reached = height / interval;
+    {
+        std::lock_guard<std::mutex> lock(store_mutex);
+        if (reached <= snapshotted_interval) {
+            return false;
+        }
+        snapshotted_interval = reached;
+    }
+
+    publish(create_snapshot(ledger, engine, subnets, chunk_bytes));
+    LOG_INFO("snapshot") << "State snapshot taken at height " << height;
+    return true;
+}
+
+void SnapshotStore::publish(NodeSnapshot snapshot) {
+    auto published = std::make_shared<const NodeSnapshot>(std::move(snapshot));
+    std::lock_guard<std::mutex> lock(store_mutex);
+    retained.push_back(published);
+    while (retained.size() > RETAINED_SNAPSHOTS) {
+        retained.pop_front();
+    }
+    chunk_index.clear();
+    for (const auto& held : retained) {
+        for (size_t i = 0; i < held->chunks.size(); ++i) {
+            chunk_index[held->manifest.chunks[i].hash] = &held->chunks[i];
+        }
+    }
+}
+
+bool SnapshotStore::has_snapshot() const {
+    std::lock_guard<std::mutex> lock(store_mutex);
+    return !retained.empty();
+}
+
+SnapshotManifest SnapshotStore::get_manifest() const {
+    std::lock_guard<std::mutex> lock(store_mutex);
+    if (retained.empty()) {
+        throw std::logic_error("No snapshot has been taken yet");
+    }
+    return retained.back()->manifest;
+}
+
+bool SnapshotStore::get_chunk(const Hash256& chunk_hash, std::string& payload) const {
+    std::lock_guard<std::mutex> lock(store_mutex);
+    auto it = chunk_index.find(chunk_hash);
+    if (it == chunk_index.end()) {
+        return false;
+    }
+    payload = *it->second;
+    return true;
+}
+
+SnapshotSource SnapshotStore::source() const {
+    return [this](const Hash256& chunk_hash, std::string& payload) { return get_chunk(chunk_hash, payload); };
+}
+
+// Checks a payload against its manifest entry: content hash, size and the header written by SectionWriter.
+static bool check_chunk(const SnapshotChunkInfo& chunk, const std::string& payload) {
+    if (payload.size() != chunk.size || payload.size() < CHUNK_HEADER_SIZE ||
+        Crypto::hash_raw(payload) != chunk.hash) {
+        return false;
+    }
+    ByteReader reader(payload);
+    return reader.get_u8() == SNAPSHOT_FORMAT && reader.get_u8() == static_cast<uint8_t>(chunk.section) &&
+           reader.get_u64() == chunk.first && reader.get_u32() == chunk.records;
+}
+
+FastSync::FastSync(const Hash256& finalized_block)
+    : finalized_block(finalized_block), has_trusted_manifest(false), accepted(false), stats{ 0, 0, 0, 0 } {}
+
+void FastSync::set_trusted_manifest(const Hash256& manifest_digest) {
+    trusted_manifest = manifest_digest;
+    has_trusted_manifest = true;
+}
+
+bool FastSync::accept_manifest(const std::vector<SnapshotOffer>& offers, size_t quorum) {
+    if (has_trusted_manifest) {
+        quorum = 1;
+    } else if (quorum < MIN_QUORUM) {
+        throw std::invalid_argument("An untrusted snapshot manifest needs a quorum of at least " +
+                                    std::to_string(MIN_QUORUM) + " peers");
+    }
+
+    // Digest of each peer's well-formed offer; peers that offer two different manifests are dropped.
+    std::unordered_map<size_t, Hash256> offered;
+    std::vector<size_t> equivocating;
+    std::unordered_map<Hash256, size_t, Hash256Hasher> first_offer;  // Digest to the index of its first offer.
+    for (size_t i = 0; i < offers.size(); ++i) {
+        const SnapshotManifest& offer = offers[i].manifest;
+        if (offer.block_digest != finalized_block) {
+            continue;
+        }
+        try {
+            Block block = Block::deserialize(offer.block);
+            if (block.get_block_digest() != finalized_block || block.compute_block_digest() != finalized_block ||
+                block.get_block_number() != offer.height || !block.verify_merkle_root()) {
+                continue;
+            }
+        } catch (const std::exception& e) {
+            LOG_WARN("snapshot") << "Rejected snapshot offer of peer " << offers[i].peer << ": " << e.what();
+            continue;
+        }
+
+        const Hash256 digest = offer.digest();
+        if (has_trusted_manifest && digest != trusted_manifest) {
+            continue;
+        }
+        auto known = offered.find(offers[i].peer);
+        if (known == offered.end()) {
+            offered.emplace(offers[i].peer, digest);
+            first_offer.emplace(digest, i);
+        } else if (known->second != digest) {
+            equivocating.push_back(offers[i].peer);
+        }
+    }
+    for (size_t peer : equivocating) {
+        offered.erase(peer);
+    }
+
+    std::unordered_map<Hash256, size_t, Hash256Hasher> votes;
+    for (const auto& entry : offered) {
+        votes[entry.second]++;
+    }
+    // Offers are scanned in order, so that the first manifest reaching the quorum wins deterministically.
+    for (size_t i = 0; i < offers.size(); ++i) {
+        auto known = offered.find(offers[i].peer);
+        if (known == offered.end() || first_offer[known->second] != i || votes[known->second] < quorum) {
+            continue;
+        }
+        manifest = offers[i].manifest;
+        accepted = true;
+        chunks.assign(manifest.chunks.size(), std::string());
+        verified.assign(manifest.chunks.size(), 0);
+        LOG_INFO("snapshot") << "Accepted snapshot at height " << manifest.height << " with "
+                             << manifest.chunks.size() << " chunks from " << votes[known->second] << " peers";
+        return true;
+    }
+    return false;
+}
+
+const SnapshotManifest& FastSync::get_manifest() const {
+    if (!accepted) {
+        throw std::logic_error("No snapshot manifest has been accepted");
+    }
+    return manifest;
+}
+
+bool FastSync::download(const std::vector<SnapshotSource>& sources, int num_threads) {
+    static Histogram& download_time = MetricsRegistry::instance().timer("synledger_snapshot_download_seconds",
+                                                                        "Duration of FastSync::download");
+    ScopedTimer timer(download_time);
+    if (!accepted) {
+        throw std::logic_error("No snapshot manifest has been accepted");
+    }
+    if (sources.empty()) {
+        return is_complete();
+    }
+
+    std::vector<size_t> wanted;
+    for (size_t i = 0; i < verified.size(); ++i) {
+        if (!verified[i]) {
+            wanted.push_back(i);
+        }
+    }
+    const size_t workers = std::min(wanted.size(), num_threads > 0 ? static_cast<size_t>(num_threads) : sources.size());
+
+    // Chunks are handed out one at a time; each worker writes only the slots of the chunks it took.
+    std::atomic<size_t> next{ 0 };
+    std::atomic<size_t> rejected{ 0 };
+    std::atomic<size_t> missing{ 0 };
+    std::atomic<uint64_t> received{ 0 };
+    auto work = [&](size_t worker) {
+        std::string payload;
+        for (size_t k; (k = next.fetch_add(1)) < wanted.size();) {
+            const size_t index = wanted[k];
+            const SnapshotChunkInfo& chunk = manifest.chunks[index];
+            for (size_t attempt = 0; attempt < sources.size(); ++attempt) {
+                payload.clear();
+                const SnapshotSource& source = sources[(worker + attempt) % sources.size()];
+                bool fetched = false;
+                try {
+                    fetched = source(chunk.hash, payload);
+                } catch (const std::exception&) {
+                    fetched = false;
+                }
+                if (!fetched) {
+                    continue;
+                }
+                if (!check_chunk(chunk, payload)) {
+                    rejected.fetch_add(1);
+                    continue;
+                }
+                chunks[index] = std::move(payload);
+                verified[index] = 1;
+                received.fetch_add(chunk.size);
+                break;
+            }
+            if (!verified[index]) {
+                missing.fetch_add(1);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t w = 1; w < workers; ++w) {
+        threads.emplace_back(work, w);
+    }
+    if (workers > 0) {
+        work(0);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    stats.chunks_verified += wanted.size() - missing.load();
+    stats.chunks_rejected += rejected.load();
+    stats.chunks_missing = missing.load();
+    stats.bytes_received += received.load();
+    if (missing.load() > 0) {
+        LOG_WARN("snapshot") << missing.load() << " of " << manifest.chunks.size()
+                             << " snapshot chunks could not be obtained";
+    }
+    return is_complete();
+}
+
+bool FastSync::is_complete() const {
+    return accepted && std::all_of(verified.begin(), verified.end(), [](uint8_t done) { return done != 0; });
+}
+
+FastSyncStats FastSync::get_stats() const {
+    return stats;
+}
+
+std::unique_ptr<Ledger> FastSync::restore(size_t initial_difficulty, PoSygEngine& engine,
+                                          SubnetManager& subnets) const {
+    if (!is_complete()) {
+        throw std::logic_error("Snapshot download is not complete");
+    }
+
+    // Decode everything before touching the engine or the subnets, so a bad snapshot leaves them unchanged.
+    std::vector<AccountEntry> accounts;
+    PoSygCheckpoint checkpoint{ ParticipantTable(0), 0.0, 0.0, 0.0, 0.0, 0.0, 0, 0, 0 };
+    uint64_t participant_count = 0;
+    bool has_engine = false;
+    std::vector<std::vector<size_t>> assignment(subnets.get_total_subnets());
+    std::unordered_set<size_t> assigned;
+    uint64_t expected[5] = { 0, 0, 0, 0, 0 };  // Next record index of each section.
+
+    for (size_t c = 0; c < manifest.chunks.size(); ++c) {
+        const SnapshotChunkInfo& chunk = manifest.chunks[c];
+        const uint8_t section = static_cast<uint8_t>(chunk.section);
+        if (chunk.first != expected[section]) {
+            throw std::runtime_error("Snapshot chunks of a section are not contiguous");
+        }
+        expected[section] += chunk.records;
+
+        ByteReader reader(chunks[c]);
+        reader.get_bytes(CHUNK_HEADER_SIZE);
+        for (uint32_t r = 0; r < chunk.records; ++r) {
+            switch (chunk.section) {
+            case SnapshotSection::ACCOUNTS: {
+                std::string address(reader.get_str16());
+                if (!accounts.empty() && accounts.back().first >= address) {
+                    throw std::runtime_error("Snapshot accounts are not sorted by address");
+                }
+                AccountState state;
+                state.balance = reader.get_f64();
+                state.nonce = reader.get_u64();
+                accounts.emplace_back(std::move(address), state);
+                break;
+            }
+            case SnapshotSection::ENGINE:
+                if (has_engine) {
+                    throw std::runtime_error("Snapshot holds more than one engine record");
+                }
+                checkpoint.dynamic_synergy_gain = reader.get_f64();
+                checkpoint.dynamic_penalty_increment = reader.get_f64();
+                checkpoint.dynamic_conversion_rate = reader.get_f64();
+                checkpoint.slash_penalty = reader.get_f64();
+                checkpoint.total_economic_activity = reader.get_f64();
+                checkpoint.seed = reader.get_u64();
+                checkpoint.cycle = reader.get_u64();
+                checkpoint.honest_count = reader.get_u64();
+                participant_count = reader.get_u64();
+                has_engine = true;
+                break;
+            case SnapshotSection::PARTICIPANTS: {
+                ParticipantTable& table = checkpoint.participants;
+                table.synergy.push_back(reader.get_f64());
+                table.reward.push_back(reader.get_f64());
+                table.penalty.push_back(reader.get_f64());
+                table.economic_contribution.push_back(reader.get_f64());
+                table.violations_count.push_back(static_cast<int>(reader.get_u32()));
+                table.economic_activity.push_back(static_cast<int>(reader.get_u32()));
+                table.governance_activity.push_back(static_cast<int>(reader.get_u32()));
+                table.behavior.push_back(reader.get_u8());
+                const size_t index = table.synergy.size() - 1;
+                if (index % 64 == 0) {
+                    table.slashed.push_back(0);
+                }
+                table.slashed.back() |= static_cast<uint64_t>(reader.get_u8() & 1) << (index % 64);
+                break;
+            }
+            case SnapshotSection::SUBNETS: {
+                const uint32_t subnet_id = reader.get_u32();
+                const uint64_t node_id = reader.get_u64();
+                if (subnet_id >= assignment.size()) {
+                    throw std::runtime_error("Snapshot subnet " + std::to_string(subnet_id) + " does not exist here");
+                }
+                if (!assigned.insert(static_cast<size_t>(node_id)).second) {
+                    throw std::runtime_error("Snapshot assigns node " + std::to_string(node_id) + " twice");
+                }
+                assignment[subnet_id].push_back(static_cast<size_t>(node_id));
+                break;
+            }
+            }
+        }
+        if (reader.remaining() != 0) {
+            throw std::runtime_error("Trailing bytes in snapshot chunk " + std::to_string(c));
+        }
+    }
+    if (!has_engine || checkpoint.participants.size() != participant_count) {
+        throw std::runtime_error("Snapshot engine state is incomplete");
+    }
+    if (checkpoint.honest_count > participant_count) {
+        throw std::runtime_error("Snapshot counts more honest participants than it holds");
+    }
+
+    // Every check of the two restores has been made above; the engine, whose checks are stricter, goes first.
+    std::unique_ptr<Ledger> ledger(new Ledger(initial_difficulty, Block::deserialize(manifest.block), accounts));
+    engine.restore_checkpoint(checkpoint);
+    subnets.restore_assignment(assignment);
+    LOG_INFO("snapshot") << "Restored " << accounts.size() << " accounts, " << participant_count
+                         << " participants and the subnet assignment at height " << manifest.height;
+    return ledger;
+}
@@ -1,7 +1,15 @@
 #include "consensus/posyg_engine.hpp"
+#include "economic/synergy_model.hpp"
+#include "metrics/metrics.hpp"
 #include <omp.h>
 #include <cstdlib>
 #include <random>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+const size_t CONVERSION_CHUNK = 4096;  // Participants per batch conversion; a multiple of 64, so chunks start on bitset words.
 
 void Participant::update_synergy() {
     if (behavior == PARTICIPANT_HONEST && !slashed) {
@@ -44,36 +52,53 @@ void Participant::update_economic_activity(double contribution) {
     economic_activity = std::min(static_cast<int>(contribution / 10.0), MAX_ECONOMIC_ACTIVITY);
 }
 
-PoSygEngine::PoSygEngine(size_t num_participants)
+ParticipantTable::ParticipantTable(size_t count)
+    : synergy(count, INITIAL_SYNERGY), reward(count, 0.0), penalty(count, 0.0), economic_contribution(count, 0.0),
+      violations_count(count, 0), economic_activity(count, 1), governance_activity(count, 1),
+      behavior(count, PARTICIPANT_HONEST), slashed((count + 63) / 64, 0) {}
+
+// Draws the first 32-bit word of Philox4x32-10 for a 128-bit counter under a 64-bit key.
+static inline uint32_t philox4x32(uint64_t key, uint64_t counter_lo, uint64_t counter_hi) {
+    uint32_t c0 = static_cast<uint32_t>(counter_lo), c1 = static_cast<uint32_t>(counter_lo >> 32);
+    uint32_t c2 = static_cast<uint32_t>(counter_hi), c3 = static_cast<uint32_t>(counter_hi >> 32);
+    uint32_t k0 = static_cast<uint32_t>(key), k1 = static_cast<uint32_t>(key >> 32);
+    for (int round = 0; round < 10; round++) {
+        const uint64_t p0 = uint64_t(0xD2511F53u) * c0;
+        const uint64_t p1 = uint64_t(0xCD9E8D57u) * c2;
+        const uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+        const uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+        c1 = static_cast<uint32_t>(p1);
+        c3 = static_cast<uint32_t>(p0);
+        c0 = n0;
+        c2 = n2;
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+    return c0;
+}
+
+PoSygEngine::PoSygEngine(size_t num_participants) : PoSygEngine(num_participants, std::random_device{}()) {}
+
+PoSygEngine::PoSygEngine(size_t num_participants, uint64_t seed)
     : num_participants(num_participants), 
+      participants(num_participants),
       dynamic_synergy_gain(10.0), 
       dynamic_penalty_increment(PENALTY_INCREMENT),
       dynamic_conversion_rate(0.1),
       slash_penalty(SLASH_PENALTY),
-      total_economic_activity(0.0) {
-    participants.resize(num_participants);
-    #pragma omp parallel for
-    for (size_t i = 0; i < num_participants; i++) {
-        participants[i] = Participant(i, PARTICIPANT_HONEST);
-    }
+      total_economic_activity(0.0),
+      seed(seed),
+      cycle(0),
+      honest_count(num_participants),
+      synergy_partials(participants.word_count(), 0.0) {
+    publish_snapshot(true);
 }
 
-PoSygEngine::~PoSygEngine() {
-    participants.clear();
-}
+PoSygEngine::~PoSygEngine() {}
 
 void PoSygEngine::adjust_network_parameters() {
-    int honest_count = 0, dishonest_count = 0;
-
-    #pragma omp parallel for reduction(+:honest_count, dishonest_count)
-    for (size_t i = 0; i < num_participants; i++) {
-        if (participants[i].behavior == PARTICIPANT_HONEST) {
-            honest_count++;
-        } else {
-            dishonest_count++;
-        }
-    }
-
+    // Behaviors are counted by the previous cycle's update pass.
+    size_t dishonest_count = num_participants - honest_count;
     double dishonest_ratio = static_cast<double>(dishonest_count) / num_participants;
 
     if (dishonest_ratio > 0.5) {
@@ -88,112 +113,317 @@ void PoSygEngine::adjust_network_parameters() {
 }
 
 int PoSygEngine::run_cycle() {
-    adjust_network_parameters();
-    
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, 9);
+    static MetricsRegistry& registry = MetricsRegistry::instance();
+    static Histogram& cycle_time = registry.timer("synledger_posyg_cycle_seconds", "Duration of PoSygEngine::run_cycle");
+    static Histogram& adjust_time = registry.timer("synledger_posyg_adjust_seconds",
+                                                   "Duration of the parameter adjustment pass of a cycle");
+    static Histogram& update_time = registry.timer("synledger_posyg_update_seconds",
+                                                   "Duration of the synergy update and slashing pass of a cycle");
+    static Histogram& distribute_time = registry.timer("synledger_posyg_distribute_seconds",
+                                                       "Duration of the reward distribution pass of a cycle");
+    static Histogram& publish_time = registry.timer("synledger_posyg_publish_seconds",
+                                                    "Duration of publishing the synergy snapshot of a cycle");
+    ScopedTimer cycle_timer(cycle_time);
 
-    #pragma omp parallel for
-    for (size_t i = 0; i < num_participants; i++) {
-        int rand_val = dis(gen);
-        if (rand_val < 3) {
-            participants[i].behavior = PARTICIPANT_DISHONEST;
-        } else {
-            participants[i].behavior = PARTICIPANT_HONEST;
-        }
-        participants[i].update_synergy();
+    double total_synergy;
+    {
+        ScopedTimer timer(adjust_time);
+        adjust_network_parameters();
+    }
+    {
+        ScopedTimer timer(update_time);
+        total_synergy = update_participants(acquire_snapshot());
+    }
+    {
+        ScopedTimer timer(distribute_time);
+        distribute_rewards(total_synergy);
+    }
+    ++cycle;
+    {
+        ScopedTimer timer(publish_time);
+        publish_snapshot(false);
     }
-
-    process_slashing();
-    distribute_rewards();
     return 0;
 }
 
-void PoSygEngine::process_slashing() {
-    #pragma omp parallel for
-    for (size_t i = 0; i < num_participants; i++) {
-        if (participants[i].violations_count > 3 && !participants[i].slashed) {
-            participants[i].apply_slash();
-        }
+SynergySnapshot& PoSygEngine::acquire_snapshot() {
+    // The spare was unpublished by the previous publication, so its count can only fall from here on.
+    if (!spare_snapshot || spare_snapshot.use_count() > 1) {
+        spare_snapshot = std::make_shared<SynergySnapshot>();
     }
+    spare_snapshot->synergy.resize(num_participants);
+    spare_snapshot->slashed.resize(participants.word_count());
+    return *spare_snapshot;
 }
 
-void PoSygEngine::distribute_rewards() {
-    double total_synergy = 0.0;
-    #pragma omp parallel for reduction(+:total_synergy)
-    for (size_t i = 0; i < num_participants; i++) {
-        if (!participants[i].slashed) {
-            total_synergy += participants[i].synergy;
-        }
+void PoSygEngine::publish_snapshot(bool copy) {
+    if (copy) {
+        SynergySnapshot& snapshot = acquire_snapshot();
+        snapshot.synergy = participants.synergy;
+        snapshot.slashed = participants.slashed;
     }
+    spare_snapshot->epoch = cycle;
+    std::atomic_store(&published, std::shared_ptr<const SynergySnapshot>(spare_snapshot));
+    std::swap(current_snapshot, spare_snapshot);
+}
 
-    if (total_synergy > 0.0) {
-        #pragma omp parallel for
-        for (size_t i = 0; i < num_participants; i++) {
-            if (!participants[i].slashed) {
-                participants[i].reward += (participants[i].synergy / total_synergy) * total_economic_activity;
-            }
-        }
-    }
+void PoSygEngine::refresh_synergy_snapshot() {
+    publish_snapshot(true);
 }
 
-void PoSygEngine::get_statistics(Stats &stats) {
-    Stats local_stats = {0, 0, 0.0, 0.0, 0, 0.0};  // Initialize local stats
+std::shared_ptr<const SynergySnapshot> PoSygEngine::get_synergy_snapshot() const {
+    return std::atomic_load(&published);
+}
 
-    #pragma omp parallel
-    {
-        Stats thread_stats = {0, 0, 0.0, 0.0, 0, 0.0};
+double PoSygEngine::update_participants(SynergySnapshot& snapshot) {
+    // Participant::update_synergy followed by process_slashing, over whole bitset words, so that each thread owns
+    // the slashed bits it sets. Every word's synergy is summed on its own and the sums are added in word order,
+    // which keeps the total independent of how words were spread over threads.
+    double* synergy = participants.synergy.data();
+    double* reward = participants.reward.data();
+    double* penalty = participants.penalty.data();
+    uint8_t* behavior = participants.behavior.data();
+    const int* economic_activity = participants.economic_activity.data();
+    const int* governance_activity = participants.governance_activity.data();
+    const int* violations_count = participants.violations_count.data();
+    uint64_t* slashed = participants.slashed.data();
+    double* partials = synergy_partials.data();
+    double* snapshot_synergy = snapshot.synergy.data();
+    uint64_t* snapshot_slashed = snapshot.slashed.data();
+    const long words = static_cast<long>(participants.word_count());
+    const uint64_t key = seed;
+    const uint64_t stream = cycle;
+    size_t honest = 0;
+
+    #pragma omp parallel for schedule(static) reduction(+:honest)
+    for (long w = 0; w < words; w++) {
+        const size_t begin = static_cast<size_t>(w) * 64;
+        const size_t lanes = std::min<size_t>(64, num_participants - begin);
+        const uint64_t word = slashed[w];
+        uint64_t newly_slashed = 0;
+        double partial = 0.0;
 
-        #pragma omp for nowait
-        for (size_t i = 0; i < num_participants; i++) {
-            if (participants[i].behavior == PARTICIPANT_HONEST) {
-                thread_stats.honest_count++;
+        #pragma omp simd reduction(|:newly_slashed) reduction(+:honest, partial)
+        for (size_t lane = 0; lane < lanes; lane++) {
+            const size_t i = begin + lane;
+            // Three draws in ten are dishonest.
+            const uint32_t draw = philox4x32(key, i, stream);
+            const bool is_honest = ((uint64_t(draw) * 10) >> 32) >= 3;
+            behavior[i] = is_honest ? PARTICIPANT_HONEST : PARTICIPANT_DISHONEST;
+            honest += is_honest;
+
+            if ((word >> lane) & 1) {
+                synergy[i] = std::max(synergy[i], 0.0);
+                snapshot_synergy[i] = synergy[i];
+                continue;
+            }
+            const double activity = economic_activity[i];
+            double score = synergy[i];
+            double charged = 0.0;
+            bool slash = violations_count[i] > 3;
+            if (is_honest) {
+                score += 10.0 * activity;
+                reward[i] += REWARD_INCREMENT * activity;
             } else {
-                thread_stats.dishonest_count++;
+                score -= 10.0 * activity;
+                charged = PENALTY_INCREMENT * activity;
+                if (economic_activity[i] > 4 && governance_activity[i] > 2) {
+                    charged += 10.0;
+                    slash = true;
+                }
             }
-            thread_stats.total_rewards += participants[i].reward;
-            thread_stats.total_penalties += participants[i].penalty;
-            if (participants[i].slashed) {
-                thread_stats.slashed_participants++;
+            if (slash) {
+                charged += SLASH_PENALTY;
+                score = 0.0;
+                newly_slashed |= uint64_t(1) << lane;
             }
+            penalty[i] += charged;
+            synergy[i] = std::max(score, 0.0);
+            snapshot_synergy[i] = synergy[i];
+            partial += synergy[i];
         }
+        slashed[w] = word | newly_slashed;
+        snapshot_slashed[w] = word | newly_slashed;
+        partials[w] = partial;
+    }
+
+    honest_count = honest;
+    double total_synergy = 0.0;
+    for (long w = 0; w < words; w++) {
+        total_synergy += partials[w];
+    }
+    return total_synergy;
+}
 
-        // Critical section to merge thread-specific stats into global stats
-        #pragma omp critical
-        {
-            local_stats.honest_count += thread_stats.honest_count;
-            local_stats.            dishonest_count += thread_stats.dishonest_count;
-            local_stats.total_rewards += thread_stats.total_rewards;
-            local_stats.total_penalties += thread_stats.total_penalties;
-            local_stats.slashed_participants += thread_stats.slashed_participants;
+void PoSygEngine::process_slashing() {
+    double* synergy = participants.synergy.data();
+    double* penalty = participants.penalty.data();
+    const int* violations_count = participants.violations_count.data();
+    uint64_t* slashed = participants.slashed.data();
+    const long words = static_cast<long>(participants.word_count());
+
+    #pragma omp parallel for schedule(static)
+    for (long w = 0; w < words; w++) {
+        const size_t begin = static_cast<size_t>(w) * 64;
+        const size_t lanes = std::min<size_t>(64, num_participants - begin);
+        const uint64_t word = slashed[w];
+        uint64_t newly_slashed = 0;
+
+        #pragma omp simd reduction(|:newly_slashed)
+        for (size_t lane = 0; lane < lanes; lane++) {
+            const size_t i = begin + lane;
+            if (violations_count[i] > 3 && !((word >> lane) & 1)) {
+                penalty[i] += SLASH_PENALTY;
+                synergy[i] = 0.0;
+                newly_slashed |= uint64_t(1) << lane;
+            }
         }
+        slashed[w] = word | newly_slashed;
+    }
+}
+
+void PoSygEngine::distribute_rewards(double total_synergy) {
+    if (total_synergy > 0.0) {
+        convert_in_chunks(total_economic_activity / total_synergy, participants.reward.data());
+    }
+}
+
+double PoSygEngine::convert_in_chunks(double conversion_rate, double* balances) const {
+    const double* synergy = participants.synergy.data();
+    const uint64_t* slashed = participants.slashed.data();
+    const long chunks = static_cast<long>((num_participants + CONVERSION_CHUNK - 1) / CONVERSION_CHUNK);
+    std::vector<double> totals(chunks, 0.0);
+
+    #pragma omp parallel for schedule(static)
+    for (long chunk = 0; chunk < chunks; chunk++) {
+        const size_t begin = static_cast<size_t>(chunk) * CONVERSION_CHUNK;
+        const size_t count = std::min(CONVERSION_CHUNK, num_participants - begin);
+        totals[chunk] = SynergyModel::convert_synergy_to_tokens(synergy + begin, conversion_rate,
+                                                                balances ? balances + begin : nullptr,
+                                                                slashed + begin / 64, count);
+    }
+
+    // Chunk totals are added in chunk order, so the result does not depend on the thread count.
+    double total = 0.0;
+    for (double chunk_total : totals) {
+        total += chunk_total;
+    }
+    return total;
+}
+
+void PoSygEngine::get_statistics(Stats &stats) {
+    const uint8_t* behavior = participants.behavior.data();
+    const double* reward = participants.reward.data();
+    const double* penalty = participants.penalty.data();
+    const uint64_t* slashed = participants.slashed.data();
+    const long words = static_cast<long>(participants.word_count());
+
+    size_t honest_count = 0;
+    double total_rewards = 0.0;
+    double total_penalties = 0.0;
+    #pragma omp parallel for simd reduction(+:honest_count, total_rewards, total_penalties)
+    for (size_t i = 0; i < num_participants; i++) {
+        honest_count += behavior[i] == PARTICIPANT_HONEST;
+        total_rewards += reward[i];
+        total_penalties += penalty[i];
+    }
+
+    size_t slashed_count = 0;
+    #pragma omp parallel for reduction(+:slashed_count)
+    for (long w = 0; w < words; w++) {
+        slashed_count += static_cast<size_t>(__builtin_popcountll(slashed[w]));
     }
 
-    stats.honest_count = local_stats.honest_count;
-    stats.dishonest_count = local_stats.dishonest_count;
-    stats.total_rewards = local_stats.total_rewards;
-    stats.total_penalties = local_stats.total_penalties;
-    stats.slashed_participants = local_stats.slashed_participants;
+    stats.honest_count = static_cast<int>(honest_count);
+    stats.dishonest_count = static_cast<int>(num_participants - honest_count);
+    stats.total_rewards = total_rewards;
+    stats.total_penalties = total_penalties;
+    stats.slashed_participants = static_cast<double>(slashed_count);
 }
 
 void PoSygEngine::convert_synergy_to_tokens(double conversion_rate, double &total_tokens) {
-    total_tokens = 0.0;
+    total_tokens = convert_in_chunks(conversion_rate, nullptr);
 
-    #pragma omp parallel for reduction(+:total_tokens)
+    double* synergy = participants.synergy.data();
+    const uint64_t* slashed = participants.slashed.data();
+    #pragma omp parallel for simd
     for (size_t i = 0; i < num_participants; i++) {
-        if (!participants[i].slashed) {
-            double tokens = participants[i].synergy * conversion_rate;
-            participants[i].synergy = 0.0;
-            total_tokens += tokens;
+        if (!((slashed[i / 64] >> (i % 64)) & 1)) {
+            synergy[i] = 0.0;
         }
     }
+    publish_snapshot(true);
 }
 
-Participant& PoSygEngine::get_participant(size_t participant_id) {
-    return participants.at(participant_id);
+Participant PoSygEngine::get_participant(size_t participant_id) {
+    if (participant_id >= participants.size()) {
+        throw std::out_of_range("Unknown participant " + std::to_string(participant_id));
+    }
+    return Participant(participants, participant_id);
+}
+
+void PoSygEngine::apply_deltas(const double* reward_delta, const double* penalty_delta, uint64_t* slashes,
+                               size_t count) {
+    if (count > num_participants) {
+        throw std::out_of_range("Deltas cover " + std::to_string(count) + " participants, the engine has "
+                                + std::to_string(num_participants));
+    }
+    double* synergy = participants.synergy.data();
+    double* reward = participants.reward.data();
+    double* penalty = participants.penalty.data();
+    uint64_t* slashed = participants.slashed.data();
+
+    #pragma omp simd
+    for (size_t i = 0; i < count; i++) {
+        reward[i] += reward_delta[i];
+        penalty[i] += penalty_delta[i];
+    }
+
+    const size_t words = (count + 63) / 64;
+    for (size_t w = 0; w < words; w++) {
+        const uint64_t newly_slashed = slashes[w] & ~slashed[w];
+        for (uint64_t bits = newly_slashed; bits != 0; bits &= bits - 1) {
+            const size_t i = w * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+            penalty[i] += SLASH_PENALTY;
+            synergy[i] = 0.0;
+        }
+        slashed[w] |= newly_slashed;
+        slashes[w] = newly_slashed;
+    }
+    publish_snapshot(true);
 }
 
 void PoSygEngine::apply_slashing_mechanism() {
     process_slashing();
+    publish_snapshot(true);
+}
+
+PoSygCheckpoint PoSygEngine::get_checkpoint() const {
+    return PoSygCheckpoint{ participants, dynamic_synergy_gain, dynamic_penalty_increment, dynamic_conversion_rate,
+                            slash_penalty, total_economic_activity, seed, cycle, honest_count };
+}
+
+void PoSygEngine::restore_checkpoint(const PoSygCheckpoint& checkpoint) {
+    const ParticipantTable& table = checkpoint.participants;
+    const size_t count = table.size();
+    if (table.reward.size() != count || table.penalty.size() != count ||
+        table.economic_contribution.size() != count || table.violations_count.size() != count ||
+        table.economic_activity.size() != count || table.governance_activity.size() != count ||
+        table.behavior.size() != count || table.word_count() != (count + 63) / 64 ||
+        checkpoint.honest_count > count) {
+        throw std::invalid_argument("Checkpoint participant columns are inconsistent");
+    }
+
+    num_participants = count;
+    participants = table;
+    dynamic_synergy_gain = checkpoint.dynamic_synergy_gain;
+    dynamic_penalty_increment = checkpoint.dynamic_penalty_increment;
+    dynamic_conversion_rate = checkpoint.dynamic_conversion_rate;
+    slash_penalty = checkpoint.slash_penalty;
+    total_economic_activity = checkpoint.total_economic_activity;
+    seed = checkpoint.seed;
+    cycle = checkpoint.cycle;
+    honest_count = static_cast<size_t>(checkpoint.honest_count);
+    synergy_partials.assign(participants.word_count(), 0.0);
+    publish_snapshot(true);
 }
@@ -0,0 +1,113 @@
+#include "consensus/reward_ledger.hpp"
+#include <omp.h>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <cassert>
+
+RewardLedger::RewardLedger(size_t participant_count)
+    : participant_count(participant_count), buffers(omp_get_max_threads()), round(0), slashed_count(0) {
+    for (auto& buffer : buffers) {
+        buffer.reward.assign(participant_count, 0.0);
+        buffer.penalty.assign(participant_count, 0.0);
+        buffer.slashes.assign((participant_count + 63) / 64, 0);
+        buffer.reasons.assign(participant_count, SlashReason::SUSPICIOUS_BEHAVIOR);
+    }
+}
+
+void RewardLedger::require_tracked(const std::vector<size_t>& participant_ids) const {
+    for (size_t participant_id : participant_ids) {
+        if (participant_id >= participant_count) {
+            throw std::out_of_range("Participant " + std::to_string(participant_id) + " is not tracked");
+        }
+    }
+}
+
+RewardLedger::ThreadBuffer& RewardLedger::local(size_t participant_id) {
+    // Called inside parallel regions, where an exception would terminate the process; callers check beforehand.
+    const size_t thread = static_cast<size_t>(omp_get_thread_num());
+    assert(participant_id < participant_count && "participant ids are checked by require_tracked");
+    assert(thread < buffers.size() && "parallel passes are capped at get_thread_capacity()");
+    (void)participant_id;
+    ThreadBuffer& buffer = buffers[thread];
+    buffer.dirty = true;
+    return buffer;
+}
+
+void RewardLedger::credit(size_t participant_id, double amount) {
+    local(participant_id).reward[participant_id] += amount;
+}
+
+void RewardLedger::penalize(size_t participant_id, double amount) {
+    local(participant_id).penalty[participant_id] += amount;
+}
+
+void RewardLedger::slash(size_t participant_id, SlashReason reason) {
+    ThreadBuffer& buffer = local(participant_id);
+    buffer.slashes[participant_id / 64] |= uint64_t(1) << (participant_id % 64);
+    buffer.reasons[participant_id] = reason;
+}
+
+size_t RewardLedger::commit(PoSygEngine& engine) {
+    // Merge into the first dirty buffer, in thread order, so sums do not depend on how work was scheduled.
+    ThreadBuffer* merged = nullptr;
+    for (auto& buffer : buffers) {
+        if (!buffer.dirty) {
+            continue;
+        }
+        if (!merged) {
+            merged = &buffer;
+            continue;
+        }
+        double* reward = merged->reward.data();
+        double* penalty = merged->penalty.data();
+        const double* thread_reward = buffer.reward.data();
+        const double* thread_penalty = buffer.penalty.data();
+        #pragma omp simd
+        for (size_t i = 0; i < participant_count; i++) {
+            reward[i] += thread_reward[i];
+            penalty[i] += thread_penalty[i];
+        }
+        for (size_t w = 0; w < merged->slashes.size(); w++) {
+            for (uint64_t bits = buffer.slashes[w] & ~merged->slashes[w]; bits != 0; bits &= bits - 1) {
+                const size_t i = w * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+                merged->reasons[i] = buffer.reasons[i];
+            }
+            merged->slashes[w] |= buffer.slashes[w];
+        }
+
+        buffer.reward.assign(participant_count, 0.0);
+        buffer.penalty.assign(participant_count, 0.0);
+        buffer.slashes.assign(buffer.slashes.size(), 0);
+        buffer.dirty = false;
+    }
+
+    ++round;
+    if (!merged) {
+        return 0;
+    }
+
+    engine.apply_deltas(merged->reward.data(), merged->penalty.data(), merged->slashes.data(), participant_count);
+
+    std::vector<SlashingEvent> events;
+    for (size_t w = 0; w < merged->slashes.size(); w++) {
+        for (uint64_t bits = merged->slashes[w]; bits != 0; bits &= bits - 1) {
+            const size_t i = w * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+            events.push_back({ round, i, SLASH_PENALTY, merged->reasons[i] });
+        }
+    }
+    slashed_count += events.size();
+    if (sink && !events.empty()) {
+        sink(events);
+    }
+
+    merged->reward.assign(participant_count, 0.0);
+    merged->penalty.assign(participant_count, 0.0);
+    merged->slashes.assign(merged->slashes.size(), 0);
+    merged->dirty = false;
+    return events.size();
+}
+
+void RewardLedger::set_slashing_sink(SlashingSink sink) {
+    this->sink = std::move(sink);
+}
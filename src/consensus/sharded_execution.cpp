@@ -0,0 +1,222 @@
+#include "consensus/sharded_execution.hpp"
+#include "consensus/signature_collector.hpp"
+#include "cryptography/crypto.hpp"
+#include "cryptography/ecdsa.hpp"
+#include "ledger/merkle_tree.hpp"
+#include "logging/logger.hpp"
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <omp.h>
+
+const int ShardedExecutor::BEACON_TIMEOUT_MS;
+
+// Feeds the bit pattern of a double into the digest.
+static void update_amount(Sha256Hasher& hasher, double amount) {
+    uint64_t bits;
+    std::memcpy(&bits, &amount, sizeof(bits));
+    hasher.update_u64(bits);
+}
+
+Hash256 CrossShardReceipt::hash() const {
+    Sha256Hasher hasher;
+    hasher.update_u64(source_shard).update_u64(target_shard).update_u64(source_height).update(tx_id);
+    hasher.update_u64(receiver.size()).update(receiver);
+    update_amount(hasher, amount);
+    return hasher.finalize();
+}
+
+Hash256 ShardHeader::digest() const {
+    Sha256Hasher hasher;
+    hasher.update_u64(shard_id).update_u64(height).update(previous_digest);
+    hasher.update(transactions_root).update(receipts_root);
+    hasher.update_u64(transaction_count).update_u64(rejected_count);
+    hasher.update_u64(outgoing_receipts).update_u64(incoming_receipts);
+    return hasher.finalize();
+}
+
+Hash256 BeaconBlock::digest() const {
+    Sha256Hasher hasher;
+    hasher.update_u64(height).update(previous_digest).update_u64(headers.size());
+    for (const auto& header : headers) {
+        hasher.update(header.digest());
+    }
+    return hasher.finalize();
+}
+
+ShardedExecutor::ShardedExecutor(const SubnetManager& subnets, size_t beacon_validators, size_t required_signatures,
+                                 int num_threads)
+    : required_signatures(required_signatures), num_threads(num_threads) {
+    if (required_signatures == 0 || required_signatures > beacon_validators) {
+        throw std::invalid_argument("Beacon quorum must be between 1 and the number of validators");
+    }
+
+    const size_t shard_count = subnets.get_total_subnets();
+    for (size_t shard_id = 0; shard_id < shard_count; ++shard_id) {
+        shards.push_back(std::make_unique<Shard>());
+        relay_accounts.push_back("relay:" + std::to_string(shard_id));
+    }
+    for (size_t i = 0; i < beacon_validators; ++i) {
+        auto key_pair = ECDSA::generate_key_pair();
+        validator_private_keys.push_back(key_pair.first);
+        validator_public_keys.push_back(key_pair.second);
+    }
+}
+
+size_t ShardedExecutor::shard_of(const std::string& address) const {
+    // FNV-1a: stable across platforms and builds, so every node agrees on the owner of an account.
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (unsigned char c : address) {
+        hash = (hash ^ c) * 0x100000001B3ull;
+    }
+    return static_cast<size_t>(hash % shards.size());
+}
+
+void ShardedExecutor::submit(const Transaction& tx) {
+    Shard& shard = *shards[shard_of(tx.sender)];
+    std::lock_guard<std::mutex> lock(shard.pending_mutex);
+    shard.pending.push_back(tx);
+}
+
+void ShardedExecutor::execute_shard(size_t shard_id, RoundOutput& output) {
+    Shard& shard = *shards[shard_id];
+    {
+        std::lock_guard<std::mutex> lock(shard.pending_mutex);
+        output.executed.swap(shard.pending);
+    }
+    output.credited.swap(shard.inbox);
+    output.before = shard.state.snapshot();
+
+    // Shards already run one per thread, so each verifies its own batch serially.
+    std::vector<SignatureCheck> checks;
+    checks.reserve(output.executed.size());
+    for (const auto& tx : output.executed) {
+        checks.push_back(tx.signature_check());
+    }
+    VerificationBitmap valid = SignatureVerifier(1).verify_batch(checks);
+
+    ShardHeader& header = output.header;
+    header.shard_id = shard_id;
+    header.height = shard.height + 1;
+    header.previous_digest = shard.last_digest;
+    header.transaction_count = 0;
+    header.rejected_count = 0;
+    header.incoming_receipts = output.credited.size();
+
+    // Incoming credits go first, so senders can spend what other shards sent them in the previous round.
+    std::vector<StateTransfer> transfers;
+    transfers.reserve(output.credited.size() + output.executed.size());
+    for (const auto& receipt : output.credited) {
+        transfers.push_back({ relay_accounts[receipt.source_shard], receipt.receiver, receipt.amount });
+    }
+
+    MerkleTree transaction_tree;
+    MerkleTree receipt_tree;
+    for (size_t i = 0; i < output.executed.size(); ++i) {
+        const Transaction& tx = output.executed[i];
+        if (!valid.test(i)) {
+            ++header.rejected_count;
+            continue;
+        }
+        Hash256 tx_id = tx.hash();
+        transaction_tree.append(tx_id);
+        ++header.transaction_count;
+
+        const size_t target = shard_of(tx.receiver);
+        if (target == shard_id) {
+            transfers.push_back({ tx.sender, tx.receiver, tx.amount });
+        } else {
+            transfers.push_back({ tx.sender, relay_accounts[target], tx.amount });
+            output.outbox.push_back({ shard_id, target, header.height, tx_id, tx.receiver, tx.amount });
+            receipt_tree.append(output.outbox.back().hash());
+        }
+    }
+    header.transactions_root = transaction_tree.root();
+    header.receipts_root = receipt_tree.root();
+    header.outgoing_receipts = output.outbox.size();
+
+    shard.state.apply_transfers(transfers);
+}
+
+bool ShardedExecutor::finalize_beacon(BeaconBlock& block) {
+    const std::string message = block.digest().to_hex();
+    SignatureCollector collector(message, validator_public_keys, required_signatures);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < validator_private_keys.size(); ++i) {
+        if (collector.has_quorum()) {
+            continue;
+        }
+        collector.submit(i, Crypto::sign(message, validator_private_keys[i]));
+    }
+
+    if (!collector.wait_for_quorum(std::chrono::milliseconds(BEACON_TIMEOUT_MS))) {
+        LOG_WARN("sharding") << "Beacon block " << block.height << " collected " << collector.get_signature_count()
+                             << " of " << required_signatures << " signatures.";
+        return false;
+    }
+    block.signatures = collector.get_quorum_signatures();
+    block.signers = collector.get_signers();
+    return true;
+}
+
+bool ShardedExecutor::run_round() {
+    const long shard_count = static_cast<long>(shards.size());
+    std::vector<RoundOutput> outputs(shards.size());
+
+    #pragma omp parallel for schedule(dynamic) num_threads(num_threads > 0 ? num_threads : omp_get_max_threads())
+    for (long shard_id = 0; shard_id < shard_count; ++shard_id) {
+        execute_shard(static_cast<size_t>(shard_id), outputs[shard_id]);
+    }
+
+    BeaconBlock block;
+    block.height = beacon_chain.size() + 1;
+    block.previous_digest = beacon_chain.empty() ? Hash256() : beacon_chain.back().digest();
+    for (const auto& output : outputs) {
+        block.headers.push_back(output.header);
+    }
+
+    if (!finalize_beacon(block)) {
+        // Undo the round and put its work back in front of anything submitted meanwhile.
+        for (size_t shard_id = 0; shard_id < shards.size(); ++shard_id) {
+            Shard& shard = *shards[shard_id];
+            RoundOutput& output = outputs[shard_id];
+            shard.state.restore(output.before);
+            shard.inbox.swap(output.credited);
+            std::lock_guard<std::mutex> lock(shard.pending_mutex);
+            output.executed.insert(output.executed.end(), shard.pending.begin(), shard.pending.end());
+            shard.pending.swap(output.executed);
+        }
+        return false;
+    }
+
+    for (size_t shard_id = 0; shard_id < shards.size(); ++shard_id) {
+        Shard& shard = *shards[shard_id];
+        shard.height = outputs[shard_id].header.height;
+        shard.last_digest = outputs[shard_id].header.digest();
+        for (auto& receipt : outputs[shard_id].outbox) {
+            shards[receipt.target_shard]->inbox.push_back(std::move(receipt));
+        }
+    }
+    beacon_chain.push_back(std::move(block));
+    return true;
+}
+
+AccountState ShardedExecutor::get_account(const std::string& address) const {
+    return shards[shard_of(address)]->state.get_account(address);
+}
+
+std::shared_ptr<const StateSnapshot> ShardedExecutor::get_shard_state(size_t shard_id) const {
+    if (shard_id >= shards.size()) {
+        throw std::out_of_range("Unknown shard " + std::to_string(shard_id));
+    }
+    return shards[shard_id]->state.snapshot();
+}
+
+size_t ShardedExecutor::get_pending_receipts() const {
+    size_t pending = 0;
+    for (const auto& shard : shards) {
+        pending += shard->inbox.size();
+    }
+    return pending;
+}
@@ -0,0 +1,131 @@
+#include "consensus/signature_collector.hpp"
+#include "cryptography/crypto.hpp"
+#include <stdexcept>
+#include <utility>
+
+const uint8_t SignatureCollector::SLOT_EMPTY;
+const uint8_t SignatureCollector::SLOT_VERIFYING;
+const uint8_t SignatureCollector::SLOT_FILLED;
+
+SignatureCollector::SignatureCollector(std::string message, std::vector<std::string> validator_keys,
+                                       size_t required_signatures, int num_threads)
+    : message(std::move(message)), validator_keys(std::move(validator_keys)),
+      required_signatures(required_signatures), verifier(num_threads),
+      slots(new Slot[this->validator_keys.size()]), reserved_count(0), valid_count(0), rejected_count(0),
+      complete(false) {
+    if (required_signatures == 0 || required_signatures > this->validator_keys.size()) {
+        throw std::invalid_argument("Quorum must be between 1 and the number of validators");
+    }
+}
+
+bool SignatureCollector::claim(size_t validator_index) {
+    if (validator_index >= validator_keys.size() || has_quorum()
+        || reserved_count.load(std::memory_order_relaxed) >= required_signatures) {
+        return false;
+    }
+    uint8_t expected = SLOT_EMPTY;
+    return slots[validator_index].state.compare_exchange_strong(expected, SLOT_VERIFYING, std::memory_order_acquire,
+                                                                std::memory_order_relaxed);
+}
+
+bool SignatureCollector::publish(size_t validator_index, const std::string& signature) {
+    // Reserve a place in the quorum first, so that signatures verified concurrently never overshoot it.
+    size_t reserved = reserved_count.load(std::memory_order_relaxed);
+    do {
+        if (reserved >= required_signatures) {
+            release(validator_index);
+            return false;
+        }
+    } while (!reserved_count.compare_exchange_weak(reserved, reserved + 1, std::memory_order_relaxed));
+
+    Slot& slot = slots[validator_index];
+    slot.signature = signature;
+    slot.state.store(SLOT_FILLED, std::memory_order_release);
+
+    // The acq_rel chain on `valid_count` makes every published slot visible to whoever completes the quorum.
+    if (valid_count.fetch_add(1, std::memory_order_acq_rel) + 1 == required_signatures) {
+        {
+            std::lock_guard<std::mutex> lock(wait_mutex);
+            complete.store(true, std::memory_order_release);
+        }
+        quorum_reached.notify_all();
+    }
+    return true;
+}
+
+void SignatureCollector::release(size_t validator_index) {
+    slots[validator_index].state.store(SLOT_EMPTY, std::memory_order_release);
+}
+
+bool SignatureCollector::submit(size_t validator_index, const std::string& signature) {
+    if (!claim(validator_index)) {
+        return false;
+    }
+
+    bool valid = false;
+    try {
+        valid = Crypto::verify_signature(message, signature, validator_keys[validator_index]);
+    } catch (const std::runtime_error&) {
+        // Malformed keys or signatures simply count as invalid.
+    }
+
+    if (!valid) {
+        rejected_count.fetch_add(1, std::memory_order_relaxed);
+        release(validator_index);
+        return false;
+    }
+    return publish(validator_index, signature);
+}
+
+size_t SignatureCollector::submit_batch(const std::vector<ValidatorSignature>& signatures) {
+    std::vector<const ValidatorSignature*> claimed;
+    std::vector<SignatureCheck> checks;
+    claimed.reserve(signatures.size());
+    checks.reserve(signatures.size());
+    for (const auto& submitted : signatures) {
+        if (claim(submitted.validator_index)) {
+            claimed.push_back(&submitted);
+            checks.push_back({ message, submitted.signature, validator_keys[submitted.validator_index] });
+        }
+    }
+
+    VerificationBitmap results = verifier.verify_batch(checks);
+
+    size_t counted = 0;
+    for (size_t i = 0; i < claimed.size(); ++i) {
+        if (!results.test(i)) {
+            rejected_count.fetch_add(1, std::memory_order_relaxed);
+            release(claimed[i]->validator_index);
+        } else if (publish(claimed[i]->validator_index, claimed[i]->signature)) {
+            ++counted;
+        }
+    }
+    return counted;
+}
+
+bool SignatureCollector::wait_for_quorum(std::chrono::milliseconds timeout) const {
+    std::unique_lock<std::mutex> lock(wait_mutex);
+    return quorum_reached.wait_for(lock, timeout, [this] { return has_quorum(); });
+}
+
+VerificationBitmap SignatureCollector::get_signers() const {
+    VerificationBitmap signers(validator_keys.size());
+    std::vector<uint64_t>& words = signers.raw_words();
+    for (size_t i = 0; i < validator_keys.size(); ++i) {
+        if (slots[i].state.load(std::memory_order_acquire) == SLOT_FILLED) {
+            words[i / 64] |= uint64_t(1) << (i % 64);
+        }
+    }
+    return signers;
+}
+
+std::vector<std::string> SignatureCollector::get_quorum_signatures() const {
+    std::vector<std::string> signatures;
+    signatures.reserve(required_signatures);
+    for (size_t i = 0; i < validator_keys.size() && signatures.size() < required_signatures; ++i) {
+        if (slots[i].state.load(std::memory_order_acquire) == SLOT_FILLED) {
+            signatures.push_back(slots[i].signature);
+        }
+    }
+    return signatures;
+}
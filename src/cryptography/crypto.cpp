@@ -1,48 +1,43 @@
 #include "cryptography/crypto.hpp"
+#include "cryptography/key_cache.hpp"
+#include "metrics/metrics.hpp"
 #include <openssl/pem.h>
 #include <openssl/err.h>
 #include <openssl/rsa.h>
 #include <openssl/evp.h>
 #include <openssl/bio.h>
-#include <openssl/sha.h>
 #include <stdexcept>
-#include <sstream>
-#include <iomanip>
 
 std::string Crypto::hash(const std::string& data) {
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    EVP_MD_CTX* mdctx = EVP_MD_CTX_new();
-
-    if (!mdctx) {
-        throw std::runtime_error("Failed to create EVP_MD_CTX");
-    }
-
-    if (1 != EVP_DigestInit_ex(mdctx, EVP_sha256(), NULL)) {
-        EVP_MD_CTX_free(mdctx);
-        throw std::runtime_error("Failed to initialize EVP digest");
-    }
-
-    if (1 != EVP_DigestUpdate(mdctx, data.c_str(), data.size())) {
-        EVP_MD_CTX_free(mdctx);
-        throw std::runtime_error("Failed to update digest");
-    }
+    return hash_raw(data).to_hex();
+}
 
-    if (1 != EVP_DigestFinal_ex(mdctx, hash, NULL)) {
-        EVP_MD_CTX_free(mdctx);
-        throw std::runtime_error("Failed to finalize digest");
-    }
+// Latency of one digest; shared by both hash_raw overloads.
+static Histogram& hash_timer() {
+    static Histogram& timer = MetricsRegistry::instance().timer("synledger_crypto_hash_seconds",
+                                                               "Duration of a SHA-256 digest");
+    return timer;
+}
 
-    EVP_MD_CTX_free(mdctx);
+Hash256 Crypto::hash_raw(std::string_view data) {
+    ScopedTimer timer(hash_timer());
+    Sha256Hasher hasher;
+    return hasher.update(data).finalize();
+}
 
-    std::stringstream ss;
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; ++i) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << (int)hash[i];
+Hash256 Crypto::hash_raw(std::initializer_list<std::string_view> parts) {
+    ScopedTimer timer(hash_timer());
+    Sha256Hasher hasher;
+    for (std::string_view part : parts) {
+        hasher.update(part);
     }
-
-    return ss.str();
+    return hasher.finalize();
 }
 
 std::string Crypto::sign(const std::string& message, const std::string& private_key) {
+    static Histogram& sign_time = MetricsRegistry::instance().timer("synledger_crypto_sign_seconds",
+                                                                    "Duration of Crypto::sign");
+    ScopedTimer timer(sign_time);
     EVP_PKEY* key = nullptr;
     EVP_MD_CTX* mdctx = nullptr;
     size_t sig_len = 0;
@@ -95,69 +90,48 @@ std::string Crypto::sign(const std::string& message, const std::string& private_
         throw std::runtime_error("Failed to finalize signature");
     }
 
-    std::stringstream ss;
-    for (size_t i = 0; i < sig_len; ++i) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << (int)sig[i];
-    }
+    signature = Hex::encode(sig, sig_len);
 
     EVP_MD_CTX_free(mdctx);
     EVP_PKEY_free(key);
     OPENSSL_free(sig);
 
-    return ss.str();
+    return signature;
 }
 
-bool Crypto::verify_signature(const std::string& message, const std::string& signature, const std::string& public_key) {
-    EVP_PKEY* key = nullptr;
-    EVP_MD_CTX* mdctx = nullptr;
-    unsigned char* sig = nullptr;
-    bool verified = false;
-    size_t sig_len = signature.length() / 2;
-
-    sig = (unsigned char*)OPENSSL_malloc(sig_len);
-    if (!sig) {
-        throw std::runtime_error("Failed to allocate memory for signature");
-    }
-
-    for (size_t i = 0; i < sig_len; ++i) {
-        sscanf(&signature[i * 2], "%2hhx", &sig[i]);
+// Verification contexts are reset and reused per thread instead of being allocated for every call.
+static EVP_MD_CTX* thread_verify_context() {
+    struct ContextHolder {
+        EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+        ~ContextHolder() { EVP_MD_CTX_free(ctx); }
+    };
+    thread_local ContextHolder holder;
+    if (!holder.ctx) {
+        throw std::runtime_error("Failed to create MD context");
     }
+    EVP_MD_CTX_reset(holder.ctx);
+    return holder.ctx;
+}
 
-    BIO* pub_bio = BIO_new_mem_buf(public_key.c_str(), -1);
-    key = PEM_read_bio_PUBKEY(pub_bio, nullptr, nullptr, nullptr);
-    BIO_free(pub_bio);
-
-    if (!key) {
-        OPENSSL_free(sig);
-        throw std::runtime_error("Failed to read public key");
+bool Crypto::verify_signature(std::string_view message, std::string_view signature, std::string_view public_key) {
+    static Histogram& verify_time = MetricsRegistry::instance().timer("synledger_crypto_verify_seconds",
+                                                                      "Duration of Crypto::verify_signature");
+    ScopedTimer timer(verify_time);
+    std::string sig;
+    if (!Hex::decode(signature, sig)) {
+        return false;
     }
 
-    mdctx = EVP_MD_CTX_new();
-    if (!mdctx) {
-        EVP_PKEY_free(key);
-        OPENSSL_free(sig);
-        throw std::runtime_error("Failed to create MD context");
-    }
+    PublicKeyHandle key = PublicKeyCache::shared().acquire(public_key);
+    EVP_MD_CTX* mdctx = thread_verify_context();
 
-    if (EVP_DigestVerifyInit(mdctx, nullptr, EVP_sha256(), nullptr, key) != 1) {
-        EVP_MD_CTX_free(mdctx);
-        EVP_PKEY_free(key);
-        OPENSSL_free(sig);
+    if (EVP_DigestVerifyInit(mdctx, nullptr, EVP_sha256(), nullptr, key.get()) != 1) {
         throw std::runtime_error("Failed to initialize DigestVerify");
     }
 
-    if (EVP_DigestVerifyUpdate(mdctx, message.c_str(), message.size()) != 1) {
-        EVP_MD_CTX_free(mdctx);
-        EVP_PKEY_free(key);
-        OPENSSL_free(sig);
+    if (EVP_DigestVerifyUpdate(mdctx, message.data(), message.size()) != 1) {
         throw std::runtime_error("Failed to update DigestVerify");
     }
 
-    verified = (EVP_DigestVerifyFinal(mdctx, sig, sig_len) == 1);
-
-    EVP_MD_CTX_free(mdctx);
-    EVP_PKEY_free(key);
-    OPENSSL_free(sig);
-
-    return verified;
+    return EVP_DigestVerifyFinal(mdctx, reinterpret_cast<const unsigned char*>(sig.data()), sig.size()) == 1;
 }
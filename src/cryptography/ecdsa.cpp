@@ -1,12 +1,12 @@
 #include "cryptography/ecdsa.hpp"
+#include "cryptography/hash256.hpp"
+#include "cryptography/crypto.hpp"
 #include <openssl/evp.h>
 #include <openssl/pem.h>
 #include <openssl/ec.h>
 #include <openssl/sha.h>
 #include <openssl/err.h>
 #include <stdexcept>
-#include <sstream>
-#include <iomanip>
 
 std::pair<std::string, std::string> ECDSA::generate_key_pair() {
     EVP_PKEY* pkey = nullptr;
@@ -104,69 +104,16 @@ std::string ECDSA::sign_message(const std::string& message, const std::string& p
         throw std::runtime_error("Failed to finalize signature");
     }
 
-    std::stringstream ss;
-    for (size_t i = 0; i < sig_len; ++i) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << (int)sig[i];
-    }
+    signature = Hex::encode(sig, sig_len);
 
     EVP_MD_CTX_free(mdctx);
     EVP_PKEY_free(pkey);
     OPENSSL_free(sig);
 
-    return ss.str();
+    return signature;
 }
 
 bool ECDSA::verify_signature(const std::string& message, const std::string& signature, const std::string& public_key) {
-    EVP_PKEY* pkey = nullptr;
-    EVP_MD_CTX* mdctx = nullptr;
-    unsigned char* sig = nullptr;
-    bool verified = false;
-    size_t sig_len = signature.length() / 2;
-
-    sig = (unsigned char*)OPENSSL_malloc(sig_len);
-    if (!sig) {
-        throw std::runtime_error("Failed to allocate memory for signature");
-    }
-
-    for (size_t i = 0; i < sig_len; ++i) {
-        sscanf(&signature[i * 2], "%2hhx", &sig[i]);
-    }
-
-    BIO* pub_bio = BIO_new_mem_buf(public_key.c_str(), -1);
-    pkey = PEM_read_bio_PUBKEY(pub_bio, nullptr, nullptr, nullptr);
-    BIO_free(pub_bio);
-
-    if (!pkey) {
-        OPENSSL_free(sig);
-        throw std::runtime_error("Failed to read public key");
-    }
-
-    mdctx = EVP_MD_CTX_new();
-    if (!mdctx) {
-        EVP_PKEY_free(pkey);
-        OPENSSL_free(sig);
-        throw std::runtime_error("Failed to create MD context");
-    }
-
-    if (EVP_DigestVerifyInit(mdctx, nullptr, EVP_sha256(), nullptr, pkey) != 1) {
-        EVP_MD_CTX_free(mdctx);
-        EVP_PKEY_free(pkey);
-        OPENSSL_free(sig);
-        throw std::runtime_error("Failed to initialize DigestVerify");
-    }
-
-    if (EVP_DigestVerifyUpdate(mdctx, message.c_str(), message.size()) != 1) {
-        EVP_MD_CTX_free(mdctx);
-        EVP_PKEY_free(pkey);
-        OPENSSL_free(sig);
-        throw std::runtime_error("Failed to update DigestVerify");
-    }
-
-    verified = (EVP_DigestVerifyFinal(mdctx, sig, sig_len) == 1);
-
-    EVP_MD_CTX_free(mdctx);
-    EVP_PKEY_free(pkey);
-    OPENSSL_free(sig);
-
-    return verified;
+    // The EVP verification path is key-type agnostic, so ECDSA shares the cached-key implementation.
+    return Crypto::verify_signature(message, signature, public_key);
 }
@@ -0,0 +1,152 @@
+#include "cryptography/hash256.hpp"
+#include <openssl/evp.h>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+static int hex_nibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+void Hex::encode_to(const void* data, size_t size, char* out) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        out[2 * i] = HEX_DIGITS[bytes[i] >> 4];
+        out[2 * i + 1] = HEX_DIGITS[bytes[i] & 0x0f];
+    }
+}
+
+std::string Hex::encode(const void* data, size_t size) {
+    std::string hex(size * 2, '\0');
+    encode_to(data, size, &hex[0]);
+    return hex;
+}
+
+bool Hex::decode(std::string_view hex, uint8_t* out, size_t out_size) {
+    if (hex.size() != out_size * 2) {
+        return false;
+    }
+    // Validate the whole input first so that a failed decode never leaves a partially written buffer.
+    for (char c : hex) {
+        if (hex_nibble(c) < 0) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < out_size; ++i) {
+        out[i] = static_cast<uint8_t>((hex_nibble(hex[2 * i]) << 4) | hex_nibble(hex[2 * i + 1]));
+    }
+    return true;
+}
+
+bool Hex::decode(std::string_view hex, std::string& out) {
+    if (hex.size() % 2 != 0) {
+        return false;
+    }
+    std::string decoded(hex.size() / 2, '\0');
+    if (!decode(hex, reinterpret_cast<uint8_t*>(&decoded[0]), decoded.size())) {
+        return false;
+    }
+    out.swap(decoded);
+    return true;
+}
+
+bool Hash256::is_zero() const {
+    for (uint8_t b : bytes) {
+        if (b != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string Hash256::to_hex() const {
+    return Hex::encode(bytes.data(), SIZE);
+}
+
+bool Hash256::from_hex(std::string_view hex, Hash256& out) {
+    return Hex::decode(hex, out.bytes.data(), SIZE);
+}
+
+size_t Hash256Hasher::operator()(const Hash256& digest) const {
+    size_t value;
+    std::memcpy(&value, digest.bytes.data(), sizeof(value));
+    return value;
+}
+
+/**
+ * Per-thread free list of digest contexts. Contexts are reused without being reset, which lets
+ * EVP_DigestInit_ex keep the already allocated digest state for the same algorithm.
+ */
+struct DigestContextPool {
+    std::vector<EVP_MD_CTX*> free_contexts;
+
+    ~DigestContextPool() {
+        for (EVP_MD_CTX* ctx : free_contexts) {
+            EVP_MD_CTX_free(ctx);
+        }
+    }
+};
+
+static thread_local DigestContextPool context_pool;
+
+static const EVP_MD* sha256_md() {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    // Fetch once instead of performing an implicit provider lookup on every init.
+    static EVP_MD* md = EVP_MD_fetch(nullptr, "SHA256", nullptr);
+    return md ? md : EVP_sha256();
+#else
+    return EVP_sha256();
+#endif
+}
+
+Sha256Hasher::Sha256Hasher() {
+    if (!context_pool.free_contexts.empty()) {
+        ctx = context_pool.free_contexts.back();
+        context_pool.free_contexts.pop_back();
+    } else {
+        ctx = EVP_MD_CTX_new();
+        if (!ctx) {
+            throw std::runtime_error("Failed to create EVP_MD_CTX");
+        }
+    }
+
+    if (1 != EVP_DigestInit_ex(ctx, sha256_md(), NULL)) {
+        EVP_MD_CTX_free(ctx);
+        throw std::runtime_error("Failed to initialize EVP digest");
+    }
+}
+
+Sha256Hasher::~Sha256Hasher() {
+    context_pool.free_contexts.push_back(ctx);
+}
+
+Sha256Hasher& Sha256Hasher::update(const void* data, size_t size) {
+    if (1 != EVP_DigestUpdate(ctx, data, size)) {
+        throw std::runtime_error("Failed to update digest");
+    }
+    return *this;
+}
+
+Sha256Hasher& Sha256Hasher::update_u64(uint64_t value) {
+    uint8_t bytes[8];
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+    return update(bytes, sizeof(bytes));
+}
+
+Hash256 Sha256Hasher::finalize() {
+    Hash256 digest;
+    if (1 != EVP_DigestFinal_ex(ctx, digest.data(), NULL)) {
+        throw std::runtime_error("Failed to finalize digest");
+    }
+    if (1 != EVP_DigestInit_ex(ctx, sha256_md(), NULL)) {
+        throw std::runtime_error("Failed to initialize EVP digest");
+    }
+    return digest;
+}
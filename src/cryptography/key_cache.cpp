@@ -0,0 +1,79 @@
+#include "cryptography/key_cache.hpp"
+#include <openssl/pem.h>
+#include <openssl/evp.h>
+#include <openssl/bio.h>
+#include <stdexcept>
+
+PublicKeyCache::PublicKeyCache(size_t capacity)
+    : capacity(capacity), hits(0), misses(0), evictions(0) {}
+
+PublicKeyCache& PublicKeyCache::shared() {
+    static PublicKeyCache cache;
+    return cache;
+}
+
+PublicKeyHandle PublicKeyCache::acquire(std::string_view public_key) {
+    Hash256 fingerprint = Sha256Hasher().update(public_key).finalize();
+
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = index.find(fingerprint);
+        if (it != index.end()) {
+            lru.splice(lru.begin(), lru, it->second);
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return it->second->second;
+        }
+    }
+
+    misses.fetch_add(1, std::memory_order_relaxed);
+
+    BIO* pub_bio = BIO_new_mem_buf(public_key.data(), static_cast<int>(public_key.size()));
+    EVP_PKEY* key = PEM_read_bio_PUBKEY(pub_bio, nullptr, nullptr, nullptr);
+    BIO_free(pub_bio);
+
+    if (!key) {
+        throw std::runtime_error("Failed to read public key");
+    }
+    PublicKeyHandle handle(key, EVP_PKEY_free);
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto it = index.find(fingerprint);
+    if (it != index.end()) {
+        // Another thread parsed the same key concurrently; keep the cached one.
+        lru.splice(lru.begin(), lru, it->second);
+        return it->second->second;
+    }
+    if (capacity == 0) {
+        return handle;
+    }
+
+    lru.emplace_front(fingerprint, handle);
+    index[fingerprint] = lru.begin();
+    evict_excess();
+    return handle;
+}
+
+void PublicKeyCache::set_capacity(size_t new_capacity) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    capacity = new_capacity;
+    evict_excess();
+}
+
+void PublicKeyCache::clear() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    index.clear();
+    lru.clear();
+}
+
+KeyCacheStats PublicKeyCache::get_stats() const {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    return KeyCacheStats{ hits.load(), misses.load(), evictions.load(), lru.size(), capacity };
+}
+
+void PublicKeyCache::evict_excess() {
+    while (lru.size() > capacity) {
+        index.erase(lru.back().first);
+        lru.pop_back();
+        evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,61 @@
+#include "cryptography/signature_verifier.hpp"
+#include "cryptography/crypto.hpp"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <algorithm>
+#include <stdexcept>
+
+size_t VerificationBitmap::count_valid() const {
+    size_t valid = 0;
+    for (uint64_t word : words) {
+        valid += static_cast<size_t>(__builtin_popcountll(word));
+    }
+    return valid;
+}
+
+bool VerificationBitmap::all_valid() const {
+    return count_valid() == count;
+}
+
+size_t VerificationBitmap::first_invalid() const {
+    for (size_t i = 0; i < count; ++i) {
+        if (!test(i)) {
+            return i;
+        }
+    }
+    return count;
+}
+
+SignatureVerifier::SignatureVerifier(int num_threads) : num_threads(num_threads) {}
+
+VerificationBitmap SignatureVerifier::verify_batch(const std::vector<SignatureCheck>& checks) const {
+    VerificationBitmap results(checks.size());
+    std::vector<uint64_t>& words = results.raw_words();
+    const long word_count = static_cast<long>(words.size());
+#ifdef _OPENMP
+    const int threads = num_threads > 0 ? num_threads : omp_get_max_threads();
+#else
+    const int threads = 1;
+#endif
+
+    #pragma omp parallel for schedule(dynamic) num_threads(threads)
+    for (long w = 0; w < word_count; ++w) {
+        uint64_t word = 0;
+        size_t begin = static_cast<size_t>(w) * 64;
+        size_t end = std::min(begin + 64, checks.size());
+        for (size_t i = begin; i < end; ++i) {
+            const SignatureCheck& check = checks[i];
+            try {
+                if (Crypto::verify_signature(check.message, check.signature, check.public_key)) {
+                    word |= uint64_t(1) << (i - begin);
+                }
+            } catch (const std::runtime_error&) {
+                // Malformed keys or signatures simply count as invalid.
+            }
+        }
+        words[w] = word;
+    }
+
+    return results;
+}
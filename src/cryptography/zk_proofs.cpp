@@ -1,34 +1,11 @@
 #include "cryptography/zk_proofs.hpp"
-#include <openssl/sha.h>
+#include "cryptography/hash256.hpp"
 #include <sstream>
-#include <iomanip>
 #include <stdexcept>
 
 std::string ZKProofs::generate_proof(const std::string& statement, const std::string& witness) {
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256_CTX sha256;
-
-    if (SHA256_Init(&sha256) != 1) {
-        throw std::runtime_error("Failed to initialize SHA256");
-    }
-
-    if (SHA256_Update(&sha256, statement.c_str(), statement.size()) != 1) {
-        throw std::runtime_error("Failed to update SHA256 with statement");
-    }
-
-    if (SHA256_Update(&sha256, witness.c_str(), witness.size()) != 1) {
-        throw std::runtime_error("Failed to update SHA256 with witness");
-    }
-
-    if (SHA256_Final(hash, &sha256) != 1) {
-        throw std::runtime_error("Failed to finalize SHA256");
-    }
-
-    std::stringstream ss;
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; ++i) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << (int)hash[i];
-    }
-    return ss.str();
+    Sha256Hasher hasher;
+    return hasher.update(statement).update(witness).finalize().to_hex();
 }
 
 bool ZKProofs::verify_proof(const std::string& statement, const std::string& proof, const std::string& witness) {
@@ -1,6 +1,18 @@
 #include "economic/synergy_model.hpp"
 #include <algorithm>
 
+// The batch kernels are cloned per instruction set and resolved once at load time through an ifunc.
+#if defined(__x86_64__) && defined(__linux__) && defined(__has_attribute)
+#if __has_attribute(target_clones)
+#define SYNERGY_KERNEL __attribute__((target_clones("avx512f", "avx2", "default")))
+#endif
+#endif
+#ifndef SYNERGY_KERNEL
+#define SYNERGY_KERNEL
+#endif
+
+const size_t TOKEN_LANES = 8;  // Independent partial sums for token totals, fixed so totals do not depend on the ISA.
+
 double SynergyModel::calculate_synergy(double initial_synergy, double economic_activity, double governance_activity) {
     double synergy_gain = (economic_activity * 0.6) + (governance_activity * 0.4);
     return std::max(initial_synergy + synergy_gain, 0.0);
@@ -18,3 +30,74 @@ double SynergyModel::adjust_conversion_rate(double current_rate, double network_
     // Adjust the conversion rate based on network conditions (e.g., activity level, synergy distribution)
     return current_rate * (1.0 + network_conditions * 0.05);
 }
+
+SYNERGY_KERNEL
+static void calculate_synergy_kernel(const double* initial_synergy, const double* economic_activity,
+                                     const double* governance_activity, double* out, size_t count) {
+    #pragma omp simd
+    for (size_t i = 0; i < count; i++) {
+        double synergy_gain = (economic_activity[i] * 0.6) + (governance_activity[i] * 0.4);
+        out[i] = std::max(initial_synergy[i] + synergy_gain, 0.0);
+    }
+}
+
+SYNERGY_KERNEL
+static void apply_penalty_kernel(const double* synergy, const double* penalty, double* out, size_t count) {
+    #pragma omp simd
+    for (size_t i = 0; i < count; i++) {
+        out[i] = std::max(synergy[i] - penalty[i], 0.0);
+    }
+}
+
+SYNERGY_KERNEL
+static double convert_synergy_kernel(const double* synergy, double conversion_rate, double* balances,
+                                     const uint64_t* excluded, size_t count) {
+    double lanes[TOKEN_LANES] = {};
+    for (size_t begin = 0; begin < count; begin += TOKEN_LANES) {
+        const size_t width = std::min(TOKEN_LANES, count - begin);
+        #pragma omp simd
+        for (size_t lane = 0; lane < width; lane++) {
+            const size_t i = begin + lane;
+            const bool skip = excluded && ((excluded[i / 64] >> (i % 64)) & 1);
+            const double tokens = skip ? 0.0 : synergy[i] * conversion_rate;
+            if (balances) {
+                balances[i] += tokens;
+            }
+            lanes[lane] += tokens;
+        }
+    }
+
+    double total = 0.0;
+    for (size_t lane = 0; lane < TOKEN_LANES; lane++) {
+        total += lanes[lane];
+    }
+    return total;
+}
+
+SYNERGY_KERNEL
+static void adjust_conversion_rate_kernel(const double* current_rate, const double* network_conditions, double* out,
+                                          size_t count) {
+    #pragma omp simd
+    for (size_t i = 0; i < count; i++) {
+        out[i] = current_rate[i] * (1.0 + network_conditions[i] * 0.05);
+    }
+}
+
+void SynergyModel::calculate_synergy(const double* initial_synergy, const double* economic_activity,
+                                     const double* governance_activity, double* out, size_t count) {
+    calculate_synergy_kernel(initial_synergy, economic_activity, governance_activity, out, count);
+}
+
+void SynergyModel::apply_penalty(const double* synergy, const double* penalty, double* out, size_t count) {
+    apply_penalty_kernel(synergy, penalty, out, count);
+}
+
+double SynergyModel::convert_synergy_to_tokens(const double* synergy, double conversion_rate, double* balances,
+                                               const uint64_t* excluded, size_t count) {
+    return convert_synergy_kernel(synergy, conversion_rate, balances, excluded, count);
+}
+
+void SynergyModel::adjust_conversion_rate(const double* current_rate, const double* network_conditions, double* out,
+                                          size_t count) {
+    adjust_conversion_rate_kernel(current_rate, network_conditions, out, count);
+}
@@ -1,8 +1,10 @@
 #include "governance/governance.hpp"
-#include <iostream>
+#include "logging/logger.hpp"
+#include <stdexcept>
+#include <omp.h>
 
-Governance::Governance(PoSygEngine& posyg_engine) 
-    : next_proposal_id(1), posyg_engine(posyg_engine) {}
+Governance::Governance(PoSygEngine& posyg_engine)
+    : next_proposal_id(1), posyg_engine(posyg_engine), active_count(0) {}
 
 void Governance::create_proposal(const std::string& description) {
     Proposal new_proposal;
@@ -11,55 +13,150 @@ void Governance::create_proposal(const std::string& description) {
     new_proposal.votes_for = 0.0;
     new_proposal.votes_against = 0.0;
     new_proposal.is_active = true;
-    proposals.push_back(new_proposal);
-    std::cout << "Proposal created: " << new_proposal.description << " (ID: " << new_proposal.id << ")" << std::endl;
+    new_proposal.weights = posyg_engine.get_synergy_snapshot();
+    new_proposal.voters.assign(new_proposal.weights->slashed.size(), 0);
+    active_indices.push_back(proposals.size());
+    ++active_count;
+    proposals.push_back(std::move(new_proposal));
+    LOG_INFO("governance") << "Proposal created: " << description << " (ID: " << proposals.back().id << ")";
 }
 
-void Governance::vote(int proposal_id, bool vote_for, size_t participant_id) {
+double Governance::try_count(Proposal& proposal, size_t participant_id) {
+    if (!proposal.is_active) {
+        return -1.0;
+    }
+    const SynergySnapshot& weights = *proposal.weights;
+    if (participant_id >= weights.size() || weights.is_slashed(participant_id)) {
+        return -1.0;
+    }
+
+    const uint64_t mask = uint64_t(1) << (participant_id % 64);
+    if (__atomic_fetch_or(&proposal.voters[participant_id / 64], mask, __ATOMIC_RELAXED) & mask) {
+        return -1.0;  // Already voted.
+    }
+    return weights.synergy[participant_id];
+}
+
+bool Governance::vote(int proposal_id, bool vote_for, size_t participant_id) {
     Proposal* proposal = get_proposal_by_id(proposal_id);
-    Participant& participant = posyg_engine.get_participant(participant_id);
+    if (!proposal) {
+        return false;
+    }
 
-    if (proposal && proposal->is_active && !participant.slashed) {
-        double vote_weight = participant.synergy;
+    double vote_weight = try_count(*proposal, participant_id);
+    if (vote_weight < 0.0) {
+        return false;
+    }
 
-        if (vote_for) {
-            proposal->votes_for += vote_weight;
-        } else {
-            proposal->votes_against += vote_weight;
+    if (vote_for) {
+        proposal->votes_for += vote_weight;
+    } else {
+        proposal->votes_against += vote_weight;
+    }
+    return true;
+}
+
+size_t Governance::vote_batch(const std::vector<Vote>& votes) {
+    const int threads = omp_get_max_threads();
+    if (thread_tallies.size() < static_cast<size_t>(threads)) {
+        thread_tallies.resize(threads);
+    }
+    for (auto& tallies : thread_tallies) {
+        tallies.resize(proposals.size());
+    }
+
+    size_t counted = 0;
+    const long vote_count = static_cast<long>(votes.size());
+
+    #pragma omp parallel num_threads(threads) reduction(+:counted)
+    {
+        std::vector<VoteTally>& tallies = thread_tallies[omp_get_thread_num()];
+
+        #pragma omp for schedule(static)
+        for (long i = 0; i < vote_count; ++i) {
+            const Vote& ballot = votes[i];
+            Proposal* proposal = get_proposal_by_id(ballot.proposal_id);
+            if (!proposal) {
+                continue;
+            }
+            double vote_weight = try_count(*proposal, ballot.participant_id);
+            if (vote_weight < 0.0) {
+                continue;
+            }
+
+            VoteTally& tally = tallies[ballot.proposal_id - 1];
+            if (ballot.vote_for) {
+                tally.votes_for += vote_weight;
+            } else {
+                tally.votes_against += vote_weight;
+            }
+            ++counted;
         }
+    }
 
-        std::cout << "Vote recorded for proposal ID " << proposal_id 
-                  << " with weight: " << vote_weight << " (" << (vote_for ? "For" : "Against") << ")" << std::endl;
-    } else {
-        std::cerr << "Error: Proposal not found, voting has ended, or participant is slashed." << std::endl;
+    return counted;
+}
+
+VoteTally Governance::get_tally(int proposal_id) const {
+    const Proposal* proposal = get_proposal_by_id(proposal_id);
+    if (!proposal) {
+        throw std::out_of_range("Unknown proposal " + std::to_string(proposal_id));
     }
+
+    VoteTally tally{ proposal->votes_for, proposal->votes_against };
+    const size_t index = static_cast<size_t>(proposal_id - 1);
+    for (const auto& tallies : thread_tallies) {
+        if (index < tallies.size()) {
+            tally.votes_for += tallies[index].votes_for;
+            tally.votes_against += tallies[index].votes_against;
+        }
+    }
+    return tally;
 }
 
 void Governance::finalize_proposal(int proposal_id) {
     Proposal* proposal = get_proposal_by_id(proposal_id);
 
     if (proposal && proposal->is_active) {
+        // Partial sums are merged in thread order, so the totals do not depend on when threads finished.
+        VoteTally tally = get_tally(proposal_id);
+        proposal->votes_for = tally.votes_for;
+        proposal->votes_against = tally.votes_against;
+        const size_t index = static_cast<size_t>(proposal_id - 1);
+        for (auto& tallies : thread_tallies) {
+            if (index < tallies.size()) {
+                tallies[index] = VoteTally();
+            }
+        }
+
         proposal->is_active = false;
-        std::cout << "Voting closed for proposal ID " << proposal_id << std::endl;
+        std::vector<uint64_t>().swap(proposal->voters);
+        proposal->weights.reset();
+        --active_count;
+        if (active_indices.size() > 2 * active_count + 16) {
+            std::vector<size_t> still_active;
+            still_active.reserve(active_count);
+            for (size_t position : active_indices) {
+                if (proposals[position].is_active) {
+                    still_active.push_back(position);
+                }
+            }
+            active_indices.swap(still_active);
+        }
+        LOG_INFO("governance") << "Voting closed for proposal ID " << proposal_id;
 
         if (proposal->votes_for > proposal->votes_against) {
-            std::cout << "Proposal " << proposal_id << " has been approved." << std::endl;
+            LOG_INFO("governance") << "Proposal " << proposal_id << " has been approved.";
         } else {
-            std::cout << "Proposal " << proposal_id << " has been rejected." << std::endl;
+            LOG_INFO("governance") << "Proposal " << proposal_id << " has been rejected.";
         }
     } else {
-        std::cerr << "Error: Proposal not found or already finalized." << std::endl;
+        LOG_WARN("governance") << "Error: Proposal not found or already finalized.";
     }
 }
 
-std::vector<Governance::Proposal> Governance::get_active_proposals() const {
-    std::vector<Proposal> active_proposals;
-    for (const auto& proposal : proposals) {
-        if (proposal.is_active) {
-            active_proposals.push_back(proposal);
-        }
-    }
-    return active_proposals;
+ActiveProposalView Governance::get_active_proposals() const {
+    return ActiveProposalView(proposals, active_indices, active_count);
 }
 
 bool Governance::is_proposal_approved(int proposal_id) const {
@@ -70,20 +167,16 @@ bool Governance::is_proposal_approved(int proposal_id) const {
     return false;
 }
 
-Governance::Proposal* Governance::get_proposal_by_id(int proposal_id) {
-    for (auto& proposal : proposals) {
-        if (proposal.id == proposal_id) {
-            return &proposal;
-        }
+Proposal* Governance::get_proposal_by_id(int proposal_id) {
+    if (proposal_id < 1 || static_cast<size_t>(proposal_id) > proposals.size()) {
+        return nullptr;
     }
-    return nullptr;
+    return &proposals[proposal_id - 1];
 }
 
-const Governance::Proposal* Governance::get_proposal_by_id(int proposal_id) const {
-    for (const auto& proposal : proposals) {
-        if (proposal.id == proposal_id) {
-            return &proposal;
-        }
+const Proposal* Governance::get_proposal_by_id(int proposal_id) const {
+    if (proposal_id < 1 || static_cast<size_t>(proposal_id) > proposals.size()) {
+        return nullptr;
     }
-    return nullptr;
+    return &proposals[proposal_id - 1];
 }
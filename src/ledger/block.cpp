@@ -1,4 +1,5 @@
 #include "ledger/block.hpp"
+#include "ledger/wire_format.hpp"
 #include "cryptography/crypto.hpp"
 #include <stdexcept>
 #include <sstream>
@@ -7,16 +8,27 @@ Transaction::Transaction(const std::string& sender, const std::string& receiver,
     : sender(sender), receiver(receiver), amount(amount), signature(signature), type(type), data(data) {}
 
 bool Transaction::verify_transaction() const {
-    return Crypto::verify_signature(sender, signature, sender);
+    return TransactionRef(*this).verify_transaction();
 }
 
-std::string Transaction::serialize() const {
-    std::ostringstream oss;
-    oss << sender << "|" << receiver << "|" << amount << "|" << signature << "|" << static_cast<int>(type) << "|" << data;
-    return oss.str();
+SignatureCheck Transaction::signature_check() const {
+    return TransactionRef(*this).signature_check();
 }
 
-Transaction Transaction::deserialize(const std::string& serialized_transaction) {
+std::string Transaction::serialize(WireFormat format) const {
+    return TransactionRef(*this).serialize(format);
+}
+
+Transaction Transaction::deserialize(const std::string& serialized_transaction, WireFormat format) {
+    if (format == WireFormat::BINARY) {
+        ByteReader reader(serialized_transaction);
+        TransactionView view = TransactionView::decode(reader);
+        if (reader.remaining() != 0) {
+            throw std::runtime_error("Trailing bytes in encoded transaction");
+        }
+        return view.to_transaction();
+    }
+
     std::istringstream iss(serialized_transaction);
     std::string sender, receiver, signature, data;
     double amount;
@@ -33,31 +45,224 @@ Transaction Transaction::deserialize(const std::string& serialized_transaction)
     return Transaction(sender, receiver, amount, signature, static_cast<TransactionType>(type), data);
 }
 
-Block::Block() : block_number(0), previous_block_hash(""), timestamp(std::time(nullptr)), required_signatures(0) {}
+Hash256 Transaction::hash() const {
+    return TransactionRef(*this).hash();
+}
+
+TransactionRef::TransactionRef(const Transaction& tx)
+    : sender(tx.sender), receiver(tx.receiver), amount(tx.amount), signature(tx.signature), type(tx.type), data(tx.data) {}
+
+TransactionRef::TransactionRef(std::string_view sender, std::string_view receiver, double amount,
+                               std::string_view signature, TransactionType type, std::string_view data)
+    : sender(sender), receiver(receiver), amount(amount), signature(signature), type(type), data(data) {}
+
+bool TransactionRef::verify_transaction() const {
+    return Crypto::verify_signature(sender, signature, sender);
+}
+
+SignatureCheck TransactionRef::signature_check() const {
+    return SignatureCheck{ sender, signature, sender };
+}
+
+std::string TransactionRef::serialize(WireFormat format) const {
+    if (format == WireFormat::BINARY) {
+        std::string out;
+        ByteWriter writer(out);
+        encode_transaction(writer, *this);
+        return out;
+    }
+
+    std::ostringstream oss;
+    oss << sender << "|" << receiver << "|" << amount << "|" << signature << "|" << static_cast<int>(type) << "|" << data;
+    return oss.str();
+}
+
+Hash256 TransactionRef::hash() const {
+    // Reuse one encoding buffer per thread; hashing runs once per transaction added to a block.
+    thread_local std::string encoded;
+    encoded.clear();
+    ByteWriter writer(encoded);
+    encode_transaction(writer, *this);
+    return MerkleTree::hash_leaf(encoded);
+}
+
+Transaction TransactionRef::to_transaction() const {
+    return Transaction(std::string(sender), std::string(receiver), amount, std::string(signature), type, std::string(data));
+}
+
+TransactionArena::Slot& TransactionArena::add_slot(size_t field_bytes, double amount, TransactionType type) {
+    slots.push_back(Slot{ bytes.size(), 0, 0, 0, 0, amount, type });
+    bytes.reserve(bytes.size() + field_bytes);
+    return slots.back();
+}
+
+void TransactionArena::reserve(size_t count, size_t field_bytes) {
+    slots.reserve(slots.size() + count);
+    bytes.reserve(bytes.size() + field_bytes);
+}
+
+void TransactionArena::append(const TransactionRef& tx) {
+    Slot& slot = add_slot(tx.sender.size() + tx.receiver.size() + tx.signature.size() + tx.data.size(), tx.amount, tx.type);
+    slot.sender_length = static_cast<uint32_t>(tx.sender.size());
+    slot.receiver_length = static_cast<uint32_t>(tx.receiver.size());
+    slot.signature_length = static_cast<uint32_t>(tx.signature.size());
+    slot.data_length = static_cast<uint32_t>(tx.data.size());
+    bytes.append(tx.sender).append(tx.receiver).append(tx.signature).append(tx.data);
+}
+
+void TransactionArena::append(const TransactionView& tx) {
+    const bool opaque = tx.signature.tag == PACKED_OPAQUE;
+    const size_t signature_length = opaque ? tx.signature.bytes.size() : 2 * tx.signature.bytes.size();
+    Slot& slot = add_slot(tx.sender.size() + tx.receiver.size() + signature_length + tx.data.size(), tx.amount, tx.type);
+    slot.sender_length = static_cast<uint32_t>(tx.sender.size());
+    slot.receiver_length = static_cast<uint32_t>(tx.receiver.size());
+    slot.signature_length = static_cast<uint32_t>(signature_length);
+    slot.data_length = static_cast<uint32_t>(tx.data.size());
+    bytes.append(tx.sender).append(tx.receiver);
+    if (opaque) {
+        bytes.append(tx.signature.bytes);
+    } else {
+        const size_t at = bytes.size();
+        bytes.resize(at + signature_length);
+        Hex::encode_to(tx.signature.bytes.data(), tx.signature.bytes.size(), &bytes[at]);
+    }
+    bytes.append(tx.data);
+}
+
+TransactionRef TransactionArena::operator[](size_t index) const {
+    const Slot& slot = slots[index];
+    const char* fields = bytes.data() + slot.offset;
+    std::string_view sender(fields, slot.sender_length);
+    fields += slot.sender_length;
+    std::string_view receiver(fields, slot.receiver_length);
+    fields += slot.receiver_length;
+    std::string_view signature(fields, slot.signature_length);
+    fields += slot.signature_length;
+    return TransactionRef(sender, receiver, slot.amount, signature, slot.type, std::string_view(fields, slot.data_length));
+}
+
+Block::Block() : block_number(0), previous_block_hash(""), timestamp(std::time(nullptr)), required_signatures(0) {
+    calculate_block_hash();
+}
 
 Block::Block(size_t block_number, const std::string& previous_block_hash, size_t required_signatures)
-    : block_number(block_number), previous_block_hash(previous_block_hash), timestamp(std::time(nullptr)), required_signatures(required_signatures) {}
+    : block_number(block_number), previous_block_hash(previous_block_hash), timestamp(std::time(nullptr)), required_signatures(required_signatures) {
+    Hash256::from_hex(previous_block_hash, previous_block_digest);
+    calculate_block_hash();
+}
 
-void Block::add_transaction(const Transaction& tx) {
+void Block::add_transaction(const TransactionRef& tx) {
     if (tx.verify_transaction()) {
-        transactions.push_back(tx);
+        transactions.append(tx);
+        transaction_tree.append(tx.hash());
         calculate_block_hash();
     } else {
         throw std::invalid_argument("Invalid transaction signature");
     }
 }
 
-const std::string& Block::calculate_block_hash() const {
-    std::string block_content = previous_block_hash + std::to_string(timestamp);
+void Block::add_transactions(const std::vector<Transaction>& txs, const SignatureVerifier& verifier) {
+    std::vector<SignatureCheck> checks;
+    checks.reserve(txs.size());
+    for (const auto& tx : txs) {
+        checks.push_back(tx.signature_check());
+    }
+
+    VerificationBitmap results = verifier.verify_batch(checks);
+    if (!results.all_valid()) {
+        throw std::invalid_argument("Invalid transaction signature at index " + std::to_string(results.first_invalid()));
+    }
+
+    size_t field_bytes = 0;
+    for (const auto& tx : txs) {
+        field_bytes += tx.sender.size() + tx.receiver.size() + tx.signature.size() + tx.data.size();
+    }
+    transactions.reserve(txs.size(), field_bytes);
+    for (const auto& tx : txs) {
+        transactions.append(tx);
+        transaction_tree.append(tx.hash());
+    }
+    calculate_block_hash();
+}
+
+void Block::add_transactions(const std::vector<const Transaction*>& txs, const SignatureVerifier& verifier) {
+    std::vector<SignatureCheck> checks;
+    checks.reserve(txs.size());
+    for (const Transaction* tx : txs) {
+        checks.push_back(tx->signature_check());
+    }
+
+    VerificationBitmap results = verifier.verify_batch(checks);
+    if (!results.all_valid()) {
+        throw std::invalid_argument("Invalid transaction signature at index " + std::to_string(results.first_invalid()));
+    }
+
+    size_t field_bytes = 0;
+    for (const Transaction* tx : txs) {
+        field_bytes += tx->sender.size() + tx->receiver.size() + tx->signature.size() + tx->data.size();
+    }
+    transactions.reserve(txs.size(), field_bytes);
+    for (const Transaction* tx : txs) {
+        transactions.append(*tx);
+        transaction_tree.append(tx->hash());
+    }
+    calculate_block_hash();
+}
 
-    for (const auto& tx : transactions) {
-        block_content += tx.serialize();
+VerificationBitmap Block::verify_transactions(const SignatureVerifier& verifier) const {
+    std::vector<SignatureCheck> checks;
+    checks.reserve(transactions.size());
+    for (TransactionRef tx : transactions) {
+        checks.push_back(tx.signature_check());
     }
+    return verifier.verify_batch(checks);
+}
 
-    block_hash = Crypto::hash(block_content);
+const std::string& Block::calculate_block_hash() const {
+    block_digest = compute_block_digest();
+    block_hash = block_digest.to_hex();
     return block_hash;
 }
 
+Hash256 Block::compute_block_digest() const {
+    return compute_header_digest(block_number, previous_block_hash, timestamp, transaction_tree.size(), transaction_tree.root());
+}
+
+Hash256 Block::compute_header_digest(size_t block_number, std::string_view previous_block_hash, std::time_t timestamp,
+                                     uint64_t transaction_count, const Hash256& merkle_root) {
+    Sha256Hasher hasher;
+    hasher.update_u64(block_number);
+
+    Hash256 previous;
+    if (Hash256::from_hex(previous_block_hash, previous)) {
+        hasher.update(previous);
+    } else {
+        hasher.update(previous_block_hash);
+    }
+    hasher.update_u64(static_cast<uint64_t>(static_cast<int64_t>(timestamp)));
+
+    // The leaf count disambiguates trees whose last leaf was duplicated on an odd level.
+    hasher.update_u64(transaction_count);
+    hasher.update(merkle_root);
+    return hasher.finalize();
+}
+
+bool Block::verify_merkle_root() const {
+    if (transactions.size() != transaction_tree.size()) {
+        return false;
+    }
+
+    MerkleTree rebuilt;
+    for (TransactionRef tx : transactions) {
+        rebuilt.append(tx.hash());
+    }
+    return rebuilt.root() == transaction_tree.root();
+}
+
+MerkleProof Block::get_transaction_proof(size_t index) const {
+    return transaction_tree.prove(index);
+}
+
 bool Block::sign_block(const std::string& validator_signature) {
     if (validator_signatures.size() < required_signatures) {
         validator_signatures.push_back(validator_signature);
@@ -70,16 +275,100 @@ bool Block::verify_signatures() const {
     return validator_signatures.size() >= required_signatures;
 }
 
-std::string Block::serialize() const {
+std::string Block::serialize(WireFormat format) const {
+    if (format == WireFormat::BINARY) {
+        std::string out;
+        ByteWriter writer(out);
+        writer.put_u8(WIRE_FORMAT_VERSION);
+        writer.put_u64(block_number);
+        writer.put_u64(static_cast<uint64_t>(static_cast<int64_t>(timestamp)));
+        writer.put_u64(required_signatures);
+        writer.put_packed(previous_block_hash);
+        Hash256 root = transaction_tree.root();
+        writer.put_bytes(root.data(), Hash256::SIZE);
+
+        writer.put_u32(static_cast<uint32_t>(validator_signatures.size()));
+        for (const auto& signature : validator_signatures) {
+            writer.put_str16(signature);
+        }
+
+        writer.put_u32(static_cast<uint32_t>(transactions.size()));
+        for (TransactionRef tx : transactions) {
+            size_t length_offset = writer.size();
+            writer.put_u32(0);
+            encode_transaction(writer, tx);
+            writer.patch_u32(length_offset, static_cast<uint32_t>(writer.size() - length_offset - 4));
+        }
+        return out;
+    }
+
     std::ostringstream oss;
     oss << block_number << "|" << previous_block_hash << "|" << timestamp << "|" << required_signatures << "|";
-    for (const auto& tx : transactions) {
-        oss << tx.serialize() << "#";
+    for (TransactionRef tx : transactions) {
+        oss << tx.serialize(WireFormat::TEXT) << "#";
     }
     return oss.str();
 }
 
-Block Block::deserialize(const std::string& serialized_block) {
+Block Block::from_view(const BlockView& view) {
+    Block block(view.block_number, view.previous_block_hash.to_string(), view.required_signatures);
+    block.timestamp = view.timestamp;
+    block.validator_signatures.reserve(view.validator_signatures.size());
+    for (const auto& signature : view.validator_signatures) {
+        block.validator_signatures.emplace_back(signature);
+    }
+    // Size the arena exactly, so importing a block allocates its transaction storage once.
+    size_t field_bytes = 0;
+    for (const auto& tx : view.transactions) {
+        const size_t packed = tx.signature.bytes.size();
+        field_bytes += tx.sender.size() + tx.receiver.size() + tx.data.size() +
+                       (tx.signature.tag == PACKED_OPAQUE ? packed : 2 * packed);
+    }
+    block.transactions.reserve(view.transactions.size(), field_bytes);
+    for (const auto& tx : view.transactions) {
+        block.transactions.append(tx);
+        block.transaction_tree.append(MerkleTree::hash_leaf(tx.encoded));
+    }
+
+    Hash256 root = block.transaction_tree.root();
+    if (view.merkle_root != std::string_view(reinterpret_cast<const char*>(root.data()), Hash256::SIZE)) {
+        throw std::runtime_error("Block Merkle root does not match its transactions");
+    }
+
+    block.calculate_block_hash();
+    return block;
+}
+
+Block Block::assemble(size_t block_number, const std::string& previous_block_hash, std::time_t timestamp,
+                      size_t required_signatures, std::vector<std::string> validator_signatures,
+                      std::vector<Transaction> transactions, const std::vector<Hash256>& transaction_ids) {
+    if (transactions.size() != transaction_ids.size()) {
+        throw std::invalid_argument("Transaction and transaction id counts differ");
+    }
+
+    Block block(block_number, previous_block_hash, required_signatures);
+    block.timestamp = timestamp;
+    block.validator_signatures = std::move(validator_signatures);
+    size_t field_bytes = 0;
+    for (const Transaction& tx : transactions) {
+        field_bytes += tx.sender.size() + tx.receiver.size() + tx.signature.size() + tx.data.size();
+    }
+    block.transactions.reserve(transactions.size(), field_bytes);
+    for (const Transaction& tx : transactions) {
+        block.transactions.append(tx);
+    }
+    for (const Hash256& id : transaction_ids) {
+        block.transaction_tree.append(id);
+    }
+    block.calculate_block_hash();
+    return block;
+}
+
+Block Block::deserialize(const std::string& serialized_block, WireFormat format) {
+    if (format == WireFormat::BINARY) {
+        return from_view(BlockView::decode(serialized_block));
+    }
+
     std::istringstream iss(serialized_block);
     size_t block_number, required_signatures;
     std::string previous_block_hash, tx_serialized;
@@ -95,7 +384,9 @@ Block Block::deserialize(const std::string& serialized_block) {
 
     while (std::getline(iss, tx_serialized, '#')) {
         if (!tx_serialized.empty()) {
-            block.transactions.push_back(Transaction::deserialize(tx_serialized));
+            Transaction tx = Transaction::deserialize(tx_serialized, WireFormat::TEXT);
+            block.transaction_tree.append(tx.hash());
+            block.transactions.append(tx);
         }
     }
 
@@ -103,7 +394,7 @@ Block Block::deserialize(const std::string& serialized_block) {
     return block;
 }
 
-const std::vector<Transaction>& Block::get_transactions() const {
+const TransactionArena& Block::get_transactions() const {
     return transactions;
 }
 
@@ -115,6 +406,22 @@ const std::string& Block::get_previous_block_hash() const {
     return previous_block_hash;
 }
 
+const Hash256& Block::get_block_digest() const {
+    return block_digest;
+}
+
+const Hash256& Block::get_previous_block_digest() const {
+    return previous_block_digest;
+}
+
+Hash256 Block::get_merkle_root() const {
+    return transaction_tree.root();
+}
+
+const MerkleTree& Block::get_transaction_tree() const {
+    return transaction_tree;
+}
+
 size_t Block::get_block_number() const {
     return block_number;
 }
@@ -122,3 +429,15 @@ size_t Block::get_block_number() const {
 size_t Block::get_signature_count() const {
     return validator_signatures.size();
 }
+
+std::time_t Block::get_timestamp() const {
+    return timestamp;
+}
+
+size_t Block::get_required_signatures() const {
+    return required_signatures;
+}
+
+const std::vector<std::string>& Block::get_validator_signatures() const {
+    return validator_signatures;
+}
@@ -0,0 +1,96 @@
+#include "ledger/block_index.hpp"
+
+BlockIndex::BlockIndex(size_t expected_size) : count(0) {
+    size_t capacity = 16;
+    while (capacity * 3 / 4 < expected_size) {
+        capacity *= 2;
+    }
+    slots.resize(capacity);
+}
+
+bool BlockIndex::insert(const Hash256& digest, const BlockIndexEntry& entry) {
+    if ((count + 1) * 4 > slots.size() * 3) {
+        grow();
+    }
+
+    size_t mask = slots.size() - 1;
+    for (size_t i = home_slot(digest);; i = (i + 1) & mask) {
+        Slot& slot = slots[i];
+        if (!slot.occupied) {
+            slot.key = digest;
+            slot.value = entry;
+            slot.occupied = true;
+            count++;
+            return true;
+        }
+        if (slot.key == digest) {
+            slot.value = entry;
+            return false;
+        }
+    }
+}
+
+const BlockIndexEntry* BlockIndex::find(const Hash256& digest) const {
+    size_t i = find_slot(digest);
+    return i == slots.size() ? nullptr : &slots[i].value;
+}
+
+BlockIndexEntry* BlockIndex::find(const Hash256& digest) {
+    size_t i = find_slot(digest);
+    return i == slots.size() ? nullptr : &slots[i].value;
+}
+
+bool BlockIndex::erase(const Hash256& digest) {
+    size_t hole = find_slot(digest);
+    if (hole == slots.size()) {
+        return false;
+    }
+
+    // Backward-shift deletion: pull later members of the probe run into the hole.
+    size_t mask = slots.size() - 1;
+    for (size_t i = (hole + 1) & mask; slots[i].occupied; i = (i + 1) & mask) {
+        size_t home = home_slot(slots[i].key);
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            slots[hole] = slots[i];
+            hole = i;
+        }
+    }
+    slots[hole].occupied = false;
+    count--;
+    return true;
+}
+
+void BlockIndex::clear() {
+    for (Slot& slot : slots) {
+        slot.occupied = false;
+    }
+    count = 0;
+}
+
+size_t BlockIndex::home_slot(const Hash256& digest) const {
+    return Hash256Hasher()(digest) & (slots.size() - 1);
+}
+
+size_t BlockIndex::find_slot(const Hash256& digest) const {
+    size_t mask = slots.size() - 1;
+    for (size_t i = home_slot(digest);; i = (i + 1) & mask) {
+        const Slot& slot = slots[i];
+        if (!slot.occupied) {
+            return slots.size();
+        }
+        if (slot.key == digest) {
+            return i;
+        }
+    }
+}
+
+void BlockIndex::grow() {
+    std::vector<Slot> old_slots(slots.size() * 2);
+    old_slots.swap(slots);
+    count = 0;
+    for (const Slot& slot : old_slots) {
+        if (slot.occupied) {
+            insert(slot.key, slot.value);
+        }
+    }
+}
@@ -0,0 +1,351 @@
+#include "ledger/block_store.hpp"
+#include "cryptography/hash256.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+
+const size_t RECORD_HEADER_SIZE = 8;   // u32 length | u32 checksum
+const size_t INDEX_ENTRY_SIZE = 16;    // u32 segment | u32 length | u64 offset
+
+static uint32_t record_checksum(std::string_view payload) {
+    Hash256 digest = Sha256Hasher().update(payload).finalize();
+    return static_cast<uint32_t>(digest.bytes[0]) | (static_cast<uint32_t>(digest.bytes[1]) << 8) |
+           (static_cast<uint32_t>(digest.bytes[2]) << 16) | (static_cast<uint32_t>(digest.bytes[3]) << 24);
+}
+
+static void write_fully(int fd, const char* data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t written = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Block store write failed: ") + std::strerror(errno));
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+}
+
+static void truncate_file(int fd, uint64_t size) {
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        throw std::runtime_error(std::string("Block store truncate failed: ") + std::strerror(errno));
+    }
+}
+
+// Checks the record header preceding `offset` and that the payload decodes as a block.
+static bool valid_record(const char* map, size_t file_size, uint64_t offset, uint32_t length) {
+    if (offset < RECORD_HEADER_SIZE || offset + length > file_size) {
+        return false;
+    }
+    ByteReader header(map + offset - RECORD_HEADER_SIZE, RECORD_HEADER_SIZE);
+    uint32_t stored_length = header.get_u32();
+    uint32_t stored_checksum = header.get_u32();
+    std::string_view payload(map + offset, length);
+    if (stored_length != length || stored_checksum != record_checksum(payload)) {
+        return false;
+    }
+    try {
+        BlockView::decode(payload);
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+    return true;
+}
+
+BlockStore::BlockStore(const std::string& directory, size_t segment_size, size_t sync_interval)
+    : directory(directory), segment_size(segment_size), sync_interval(sync_interval > 0 ? sync_interval : 1),
+      unsynced(0), recovered(0), index_fd(-1) {
+    std::filesystem::create_directories(directory);
+
+    for (uint32_t id = 0; std::filesystem::exists(segment_path(id)); ++id) {
+        open_segment(id);
+    }
+    if (segments.empty()) {
+        open_segment(0);
+    }
+
+    std::string index_path = directory + "/index.dat";
+    index_fd = ::open(index_path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (index_fd < 0) {
+        throw std::runtime_error("Failed to open block index: " + index_path);
+    }
+
+    load_index();
+    validate_tail();
+}
+
+BlockStore::~BlockStore() {
+    try {
+        sync();
+    } catch (const std::exception&) {
+        // Nothing sensible can be done about a failed sync during destruction.
+    }
+    for (Segment& segment : segments) {
+        close_segment(segment);
+    }
+    if (index_fd >= 0) {
+        ::close(index_fd);
+    }
+}
+
+size_t BlockStore::append(const Block& block) {
+    std::string record(RECORD_HEADER_SIZE, '\0');
+    record += block.serialize();
+    std::string_view payload(record.data() + RECORD_HEADER_SIZE, record.size() - RECORD_HEADER_SIZE);
+    {
+        std::string header;
+        ByteWriter writer(header);
+        writer.put_u32(static_cast<uint32_t>(payload.size()));
+        writer.put_u32(record_checksum(payload));
+        record.replace(0, RECORD_HEADER_SIZE, header);
+    }
+
+    if (segments.back().file_size > 0 && segments.back().file_size + record.size() > segment_size) {
+        // Seal the full segment: make its data durable. Its mapping stays put, so views into it remain valid.
+        ::fdatasync(segments.back().fd);
+        open_segment(static_cast<uint32_t>(segments.size()));
+    }
+
+    Segment& active = segments.back();
+    if (active.file_size + record.size() > active.mapped_size) {
+        // Only an oversized record in a still empty segment gets here, so no view points into the old mapping.
+        map_segment(active, active.file_size + record.size());
+    }
+    uint64_t record_offset = active.file_size;
+    write_fully(active.fd, record.data(), record.size(), record_offset);
+    active.file_size += record.size();
+
+    BlockLocation entry{ static_cast<uint32_t>(segments.size() - 1), static_cast<uint32_t>(payload.size()),
+                         record_offset + RECORD_HEADER_SIZE };
+    index.push_back(entry);
+    write_index_entry(index.size() - 1, entry);
+
+    if (++unsynced >= sync_interval) {
+        sync();
+    }
+    return index.size() - 1;
+}
+
+void BlockStore::sync() {
+    if (unsynced == 0) {
+        return;
+    }
+    // Data before index: a durable index entry always points at durable block bytes.
+    if (::fdatasync(segments.back().fd) != 0 || ::fdatasync(index_fd) != 0) {
+        throw std::runtime_error(std::string("Block store sync failed: ") + std::strerror(errno));
+    }
+    unsynced = 0;
+}
+
+void BlockStore::truncate(size_t count) {
+    if (count >= index.size()) {
+        return;
+    }
+
+    index.resize(count);
+    truncate_file(index_fd, count * INDEX_ENTRY_SIZE);
+
+    uint32_t last_segment = count == 0 ? 0 : index.back().segment;
+    uint64_t last_end = count == 0 ? 0 : index.back().offset + index.back().length;
+
+    while (segments.size() > last_segment + 1) {
+        close_segment(segments.back());
+        std::filesystem::remove(segment_path(static_cast<uint32_t>(segments.size() - 1)));
+        segments.pop_back();
+    }
+
+    Segment& active = segments.back();
+    truncate_file(active.fd, last_end);
+    active.file_size = last_end;
+
+    ::fdatasync(index_fd);
+    ::fdatasync(active.fd);
+    unsynced = 0;
+}
+
+const BlockLocation& BlockStore::location(size_t height) const {
+    if (height >= index.size()) {
+        throw std::out_of_range("Block height " + std::to_string(height) + " is not stored");
+    }
+    return index[height];
+}
+
+std::string_view BlockStore::read_raw(size_t height) const {
+    const BlockLocation& entry = location(height);
+    const Segment& segment = segments[entry.segment];
+    return std::string_view(segment.map + entry.offset, entry.length);
+}
+
+BlockView BlockStore::view(size_t height) const {
+    return BlockView::decode(read_raw(height));
+}
+
+Block BlockStore::read(size_t height) const {
+    return Block::from_view(view(height));
+}
+
+std::string BlockStore::segment_path(uint32_t segment) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "/blocks_%06u.dat", segment);
+    return directory + name;
+}
+
+void BlockStore::open_segment(uint32_t segment) {
+    std::string path = segment_path(segment);
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open block segment: " + path);
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Failed to stat block segment: " + path);
+    }
+
+    // Every segment is mapped once at its full size, so appends and truncation never move a live mapping.
+    segments.push_back(Segment{ fd, nullptr, 0, static_cast<size_t>(info.st_size) });
+    map_segment(segments.back(), std::max(segments.back().file_size, segment_size));
+}
+
+void BlockStore::map_segment(Segment& segment, size_t length) {
+    if (segment.map) {
+        ::munmap(segment.map, segment.mapped_size);
+        segment.map = nullptr;
+        segment.mapped_size = 0;
+    }
+    if (length == 0) {
+        return;
+    }
+
+    // Pages past the end of the file are never touched; appends extend the readable range in place.
+    void* map = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, segment.fd, 0);
+    if (map == MAP_FAILED) {
+        throw std::runtime_error(std::string("Failed to map block segment: ") + std::strerror(errno));
+    }
+    segment.map = static_cast<char*>(map);
+    segment.mapped_size = length;
+}
+
+void BlockStore::close_segment(Segment& segment) {
+    map_segment(segment, 0);
+    if (segment.fd >= 0) {
+        ::close(segment.fd);
+        segment.fd = -1;
+    }
+}
+
+void BlockStore::load_index() {
+    struct stat info;
+    if (::fstat(index_fd, &info) != 0) {
+        throw std::runtime_error("Failed to stat block index");
+    }
+
+    size_t entry_count = static_cast<size_t>(info.st_size) / INDEX_ENTRY_SIZE;
+    std::string buffer(entry_count * INDEX_ENTRY_SIZE, '\0');
+    size_t read_total = 0;
+    while (read_total < buffer.size()) {
+        ssize_t n = ::pread(index_fd, &buffer[read_total], buffer.size() - read_total, static_cast<off_t>(read_total));
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        read_total += static_cast<size_t>(n);
+    }
+    entry_count = read_total / INDEX_ENTRY_SIZE;
+
+    ByteReader reader(buffer.data(), entry_count * INDEX_ENTRY_SIZE);
+    index.reserve(entry_count);
+    for (size_t i = 0; i < entry_count; ++i) {
+        BlockLocation entry;
+        entry.segment = reader.get_u32();
+        entry.length = reader.get_u32();
+        entry.offset = reader.get_u64();
+        // Entries must be contiguous and lie within the written part of an existing segment.
+        if (entry.segment >= segments.size() || entry.offset + entry.length > segments[entry.segment].file_size ||
+            (!index.empty() && entry.segment < index.back().segment)) {
+            break;
+        }
+        index.push_back(entry);
+    }
+
+    if (static_cast<size_t>(info.st_size) != index.size() * INDEX_ENTRY_SIZE) {
+        truncate_file(index_fd, index.size() * INDEX_ENTRY_SIZE);
+    }
+}
+
+void BlockStore::validate_tail() {
+    // Only the segment holding the last indexed block (and anything after it) can hold torn writes.
+    uint32_t tail_segment = index.empty() ? 0 : index.back().segment;
+    size_t first = index.size();
+    while (first > 0 && index[first - 1].segment >= tail_segment) {
+        --first;
+    }
+    for (size_t i = first; i < index.size(); ++i) {
+        const BlockLocation& entry = index[i];
+        const Segment& segment = segments[entry.segment];
+        if (!valid_record(segment.map, segment.file_size, entry.offset, entry.length)) {
+            index.resize(i);
+            truncate_file(index_fd, i * INDEX_ENTRY_SIZE);
+            break;
+        }
+    }
+
+    // Recover complete records that were written but whose index entries never reached the disk.
+    uint32_t scan_segment = index.empty() ? 0 : index.back().segment;
+    uint64_t scan_offset = index.empty() ? 0 : index.back().offset + index.back().length;
+    for (uint32_t id = scan_segment; id < segments.size(); ++id) {
+        Segment& segment = segments[id];
+        uint64_t offset = id == scan_segment ? scan_offset : 0;
+
+        while (offset + RECORD_HEADER_SIZE <= segment.file_size) {
+            ByteReader header(segment.map + offset, RECORD_HEADER_SIZE);
+            uint32_t length = header.get_u32();
+            uint64_t payload_offset = offset + RECORD_HEADER_SIZE;
+            if (!valid_record(segment.map, segment.file_size, payload_offset, length)) {
+                break;
+            }
+            BlockLocation entry{ id, length, payload_offset };
+            index.push_back(entry);
+            write_index_entry(index.size() - 1, entry);
+            recovered++;
+            offset = payload_offset + length;
+        }
+
+        if (offset < segment.file_size) {
+            // A torn or corrupt record ends the log; drop it and every later segment.
+            truncate_file(segment.fd, offset);
+            segment.file_size = offset;
+            while (segments.size() > id + 1) {
+                close_segment(segments.back());
+                std::filesystem::remove(segment_path(static_cast<uint32_t>(segments.size() - 1)));
+                segments.pop_back();
+            }
+            break;
+        }
+    }
+
+    if (recovered > 0) {
+        ::fdatasync(index_fd);
+    }
+}
+
+void BlockStore::write_index_entry(size_t height, const BlockLocation& entry) {
+    std::string buffer;
+    ByteWriter writer(buffer);
+    writer.put_u32(entry.segment);
+    writer.put_u32(entry.length);
+    writer.put_u64(entry.offset);
+    write_fully(index_fd, buffer.data(), buffer.size(), height * INDEX_ENTRY_SIZE);
+}
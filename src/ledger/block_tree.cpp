@@ -0,0 +1,134 @@
+#include "ledger/block_tree.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+const uint32_t BlockTree::NO_NODE;
+
+BlockTree::BlockTree() : root_id(NO_NODE), best_id(NO_NODE) {}
+
+void BlockTree::reset(const Block& root, uint64_t height) {
+    nodes.clear();
+    ids_by_digest.clear();
+    nodes.push_back(BlockTreeNode{ root, NO_NODE, height, 0, {} });
+    ids_by_digest[root.get_block_digest()] = 0;
+    root_id = 0;
+    best_id = 0;
+}
+
+uint32_t BlockTree::insert(const Block& block, uint64_t weight) {
+    auto existing = ids_by_digest.find(block.get_block_digest());
+    if (existing != ids_by_digest.end()) {
+        return existing->second;
+    }
+
+    auto parent = ids_by_digest.find(block.get_previous_block_digest());
+    if (parent == ids_by_digest.end()) {
+        throw std::invalid_argument("Block " + std::to_string(block.get_block_number()) + " has an unknown parent");
+    }
+
+    uint32_t parent_id = parent->second;
+    uint64_t height = nodes[parent_id].height + 1;
+    if (block.get_block_number() != height) {
+        throw std::invalid_argument("Block " + std::to_string(block.get_block_number()) +
+                                    " does not follow its parent at height " + std::to_string(height - 1));
+    }
+    uint32_t id = static_cast<uint32_t>(nodes.size());
+    uint64_t cumulative = nodes[parent_id].weight + weight;
+    nodes.push_back(BlockTreeNode{ block, parent_id, height, cumulative, {} });
+    nodes[parent_id].children.push_back(id);
+    ids_by_digest[block.get_block_digest()] = id;
+
+    if (cumulative > nodes[best_id].weight) {
+        best_id = id;
+    }
+    return id;
+}
+
+uint32_t BlockTree::find(const Hash256& digest) const {
+    auto it = ids_by_digest.find(digest);
+    return it == ids_by_digest.end() ? NO_NODE : it->second;
+}
+
+uint32_t BlockTree::common_ancestor(uint32_t a, uint32_t b) const {
+    while (a != b) {
+        if (nodes[a].height >= nodes[b].height) {
+            a = nodes[a].parent;
+        } else {
+            b = nodes[b].parent;
+        }
+        if (a == NO_NODE || b == NO_NODE) {
+            return NO_NODE;
+        }
+    }
+    return a;
+}
+
+std::vector<uint32_t> BlockTree::path(uint32_t ancestor, uint32_t descendant) const {
+    std::vector<uint32_t> result;
+    for (uint32_t id = descendant; id != ancestor && id != NO_NODE; id = nodes[id].parent) {
+        result.push_back(id);
+    }
+    std::reverse(result.begin(), result.end());
+    return result;
+}
+
+std::vector<uint32_t> BlockTree::tips() const {
+    std::vector<uint32_t> result;
+    for (uint32_t id = 0; id < nodes.size(); ++id) {
+        if (nodes[id].children.empty()) {
+            result.push_back(id);
+        }
+    }
+    return result;
+}
+
+std::vector<Hash256> BlockTree::prune(uint32_t new_root) {
+    // Collect the surviving subtree in breadth-first order, which keeps parents before children.
+    std::vector<uint32_t> order{ new_root };
+    for (size_t i = 0; i < order.size(); ++i) {
+        for (uint32_t child : nodes[order[i]].children) {
+            order.push_back(child);
+        }
+    }
+
+    std::vector<uint32_t> remap(nodes.size(), NO_NODE);
+    for (size_t i = 0; i < order.size(); ++i) {
+        remap[order[i]] = static_cast<uint32_t>(i);
+    }
+
+    std::vector<Hash256> removed;
+    for (uint32_t id = 0; id < nodes.size(); ++id) {
+        if (remap[id] == NO_NODE) {
+            removed.push_back(nodes[id].block.get_block_digest());
+        }
+    }
+
+    std::vector<BlockTreeNode> survivors;
+    survivors.reserve(order.size());
+    ids_by_digest.clear();
+    for (uint32_t old_id : order) {
+        BlockTreeNode& node = nodes[old_id];
+        node.parent = old_id == new_root ? NO_NODE : remap[node.parent];
+        for (uint32_t& child : node.children) {
+            child = remap[child];
+        }
+        ids_by_digest[node.block.get_block_digest()] = static_cast<uint32_t>(survivors.size());
+        survivors.push_back(std::move(node));
+    }
+
+    uint32_t old_best = best_id;
+    nodes.swap(survivors);
+    root_id = 0;
+
+    // The best tip survives unless it sat on a pruned branch; only then is a rescan needed.
+    best_id = remap[old_best];
+    if (best_id == NO_NODE) {
+        best_id = 0;
+        for (uint32_t id = 1; id < nodes.size(); ++id) {
+            if (nodes[id].weight > nodes[best_id].weight) {
+                best_id = id;
+            }
+        }
+    }
+    return removed;
+}
@@ -0,0 +1,358 @@
+#include "ledger/compact_block.hpp"
+#include "ledger/merkle_tree.hpp"
+#include <stdexcept>
+#include <cstring>
+
+const uint64_t SHORT_ID_MASK = (uint64_t(1) << (8 * CompactBlock::SHORT_ID_BYTES)) - 1;  // Low 48 bits.
+
+const size_t CompactBlock::SHORT_ID_BYTES;
+const uint32_t CompactBlock::MAX_TRANSACTIONS;
+
+static uint64_t rotl(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static void sip_round(uint64_t& v0, uint64_t& v1, uint64_t& v2, uint64_t& v3) {
+    v0 += v1; v1 = rotl(v1, 13); v1 ^= v0; v0 = rotl(v0, 32);
+    v2 += v3; v3 = rotl(v3, 16); v3 ^= v2;
+    v0 += v3; v3 = rotl(v3, 21); v3 ^= v0;
+    v2 += v1; v1 = rotl(v1, 17); v1 ^= v2; v2 = rotl(v2, 32);
+}
+
+static uint64_t load_le64(const uint8_t* bytes) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+// SipHash-2-4 of a 32-byte digest: four message words followed by the length block.
+static uint64_t siphash24(uint64_t k0, uint64_t k1, const Hash256& digest) {
+    uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
+    uint64_t v1 = 0x646f72616e646f6dULL ^ k1;
+    uint64_t v2 = 0x6c7967656e657261ULL ^ k0;
+    uint64_t v3 = 0x7465646279746573ULL ^ k1;
+
+    for (size_t offset = 0; offset < Hash256::SIZE; offset += 8) {
+        uint64_t word = load_le64(digest.data() + offset);
+        v3 ^= word;
+        sip_round(v0, v1, v2, v3);
+        sip_round(v0, v1, v2, v3);
+        v0 ^= word;
+    }
+
+    uint64_t last = uint64_t(Hash256::SIZE) << 56;
+    v3 ^= last;
+    sip_round(v0, v1, v2, v3);
+    sip_round(v0, v1, v2, v3);
+    v0 ^= last;
+
+    v2 ^= 0xFF;
+    for (int i = 0; i < 4; ++i) {
+        sip_round(v0, v1, v2, v3);
+    }
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+void CompactBlock::derive_key() {
+    set_key(compute_digest());
+}
+
+void CompactBlock::set_key(const Hash256& block_digest) {
+    Sha256Hasher hasher;
+    hasher.update(block_digest);
+    hasher.update_u64(nonce);
+    Hash256 seed = hasher.finalize();
+    key0 = load_le64(seed.data());
+    key1 = load_le64(seed.data() + 8);
+}
+
+uint64_t CompactBlock::short_id(const Hash256& tx_id) const {
+    return siphash24(key0, key1, tx_id) & SHORT_ID_MASK;
+}
+
+Hash256 CompactBlock::compute_digest() const {
+    return Block::compute_header_digest(block_number, previous_block_hash, timestamp, transaction_count(), merkle_root);
+}
+
+std::vector<bool> CompactBlock::assign_short_ids(const std::vector<Hash256>& tx_ids, const std::vector<uint32_t>& prefill) {
+    std::vector<bool> prefilled_at(tx_ids.size(), false);
+    for (uint32_t index : prefill) {
+        if (index >= tx_ids.size()) {
+            throw std::out_of_range("Prefilled transaction index out of range");
+        }
+        prefilled_at[index] = true;
+    }
+
+    // The key does not depend on which transactions are prefilled, only on their total count.
+    short_ids.clear();
+    prefilled.clear();
+    set_key(Block::compute_header_digest(block_number, previous_block_hash, timestamp, tx_ids.size(), merkle_root));
+
+    std::unordered_map<uint64_t, uint32_t> first_use;
+    first_use.reserve(tx_ids.size());
+    for (uint32_t i = 0; i < tx_ids.size(); ++i) {
+        if (prefilled_at[i]) {
+            continue;
+        }
+        uint64_t id = short_id(tx_ids[i]);
+        if (!first_use.emplace(id, i).second) {
+            prefilled_at[i] = true;  // The receiver could not tell the two apart.
+            continue;
+        }
+        short_ids.push_back(id);
+    }
+    return prefilled_at;
+}
+
+CompactBlock CompactBlock::from_block(const Block& block, uint64_t nonce, const std::vector<uint32_t>& prefill) {
+    CompactBlock compact;
+    compact.block_number = block.get_block_number();
+    compact.timestamp = block.get_timestamp();
+    compact.required_signatures = block.get_required_signatures();
+    compact.previous_block_hash = block.get_previous_block_hash();
+    compact.merkle_root = block.get_merkle_root();
+    compact.validator_signatures = block.get_validator_signatures();
+    compact.nonce = nonce;
+
+    const MerkleTree& tree = block.get_transaction_tree();
+    std::vector<Hash256> tx_ids;
+    tx_ids.reserve(tree.size());
+    for (size_t i = 0; i < tree.size(); ++i) {
+        tx_ids.push_back(tree.leaf(i));
+    }
+
+    std::vector<bool> prefilled_at = compact.assign_short_ids(tx_ids, prefill);
+    const TransactionArena& txs = block.get_transactions();
+    for (uint32_t i = 0; i < txs.size(); ++i) {
+        if (prefilled_at[i]) {
+            compact.prefilled.push_back(PrefilledTransaction{ i, txs[i].to_transaction() });
+        }
+    }
+    return compact;
+}
+
+CompactBlock CompactBlock::from_view(const BlockView& view, uint64_t nonce) {
+    CompactBlock compact;
+    compact.block_number = view.block_number;
+    compact.timestamp = view.timestamp;
+    compact.required_signatures = view.required_signatures;
+    compact.previous_block_hash = view.previous_block_hash.to_string();
+    std::memcpy(compact.merkle_root.data(), view.merkle_root.data(), Hash256::SIZE);
+    compact.validator_signatures.assign(view.validator_signatures.begin(), view.validator_signatures.end());
+    compact.nonce = nonce;
+
+    std::vector<Hash256> tx_ids;
+    tx_ids.reserve(view.transactions.size());
+    for (const TransactionView& tx : view.transactions) {
+        tx_ids.push_back(MerkleTree::hash_leaf(tx.encoded));
+    }
+
+    std::vector<bool> prefilled_at = compact.assign_short_ids(tx_ids, {});
+    for (uint32_t i = 0; i < view.transactions.size(); ++i) {
+        if (prefilled_at[i]) {
+            compact.prefilled.push_back(PrefilledTransaction{ i, view.transactions[i].to_transaction() });
+        }
+    }
+    return compact;
+}
+
+std::string CompactBlock::serialize() const {
+    std::string out;
+    out.reserve(128 + short_ids.size() * SHORT_ID_BYTES);
+    ByteWriter writer(out);
+    writer.put_u8(WIRE_FORMAT_VERSION);
+    writer.put_u64(block_number);
+    writer.put_u64(static_cast<uint64_t>(static_cast<int64_t>(timestamp)));
+    writer.put_u64(required_signatures);
+    writer.put_packed(previous_block_hash);
+    writer.put_bytes(merkle_root.data(), Hash256::SIZE);
+
+    writer.put_u32(static_cast<uint32_t>(validator_signatures.size()));
+    for (const auto& signature : validator_signatures) {
+        writer.put_str16(signature);
+    }
+    writer.put_u64(nonce);
+
+    writer.put_u32(static_cast<uint32_t>(short_ids.size()));
+    for (uint64_t id : short_ids) {
+        char bytes[SHORT_ID_BYTES];
+        for (size_t i = 0; i < SHORT_ID_BYTES; ++i) {
+            bytes[i] = static_cast<char>(id >> (8 * i));
+        }
+        writer.put_bytes(bytes, SHORT_ID_BYTES);
+    }
+
+    writer.put_u32(static_cast<uint32_t>(prefilled.size()));
+    for (const PrefilledTransaction& entry : prefilled) {
+        writer.put_u32(entry.index);
+        size_t length_offset = writer.size();
+        writer.put_u32(0);
+        encode_transaction(writer, entry.tx);
+        writer.patch_u32(length_offset, static_cast<uint32_t>(writer.size() - length_offset - 4));
+    }
+    return out;
+}
+
+CompactBlock CompactBlock::deserialize(std::string_view buffer) {
+    ByteReader reader(buffer);
+    if (reader.get_u8() != WIRE_FORMAT_VERSION) {
+        throw std::runtime_error("Unsupported compact block wire format version");
+    }
+
+    CompactBlock compact;
+    compact.block_number = static_cast<size_t>(reader.get_u64());
+    compact.timestamp = static_cast<std::time_t>(static_cast<int64_t>(reader.get_u64()));
+    compact.required_signatures = static_cast<size_t>(reader.get_u64());
+    compact.previous_block_hash = reader.get_packed().to_string();
+    std::memcpy(compact.merkle_root.data(), reader.get_bytes(Hash256::SIZE).data(), Hash256::SIZE);
+
+    uint32_t signature_count = reader.get_u32();
+    for (uint32_t i = 0; i < signature_count; ++i) {
+        compact.validator_signatures.emplace_back(reader.get_str16());
+    }
+    compact.nonce = reader.get_u64();
+
+    uint32_t short_id_count = reader.get_u32();
+    if (short_id_count > MAX_TRANSACTIONS || reader.remaining() < uint64_t(short_id_count) * SHORT_ID_BYTES) {
+        throw std::runtime_error("Truncated compact block short ids");
+    }
+    compact.short_ids.reserve(short_id_count);
+    for (uint32_t i = 0; i < short_id_count; ++i) {
+        std::string_view bytes = reader.get_bytes(SHORT_ID_BYTES);
+        uint64_t id = 0;
+        for (size_t b = SHORT_ID_BYTES; b-- > 0;) {
+            id = (id << 8) | static_cast<uint8_t>(bytes[b]);
+        }
+        compact.short_ids.push_back(id);
+    }
+
+    uint32_t prefilled_count = reader.get_u32();
+    if (prefilled_count > MAX_TRANSACTIONS - short_id_count) {
+        throw std::runtime_error("Compact block has too many transactions");
+    }
+    uint64_t total = uint64_t(short_id_count) + prefilled_count;
+    for (uint32_t i = 0; i < prefilled_count; ++i) {
+        uint32_t index = reader.get_u32();
+        if (index >= total || (!compact.prefilled.empty() && index <= compact.prefilled.back().index)) {
+            throw std::runtime_error("Invalid prefilled transaction index");
+        }
+        std::string_view encoded = reader.get_str32();
+        ByteReader tx_reader(encoded);
+        TransactionView tx = TransactionView::decode(tx_reader);
+        if (tx_reader.remaining() != 0) {
+            throw std::runtime_error("Trailing bytes in encoded transaction");
+        }
+        compact.prefilled.push_back(PrefilledTransaction{ index, tx.to_transaction() });
+    }
+
+    if (reader.remaining() != 0) {
+        throw std::runtime_error("Trailing bytes in encoded compact block");
+    }
+    compact.derive_key();
+    return compact;
+}
+
+PartialBlock::PartialBlock(const CompactBlock& compact)
+    : compact(compact), slots(compact.transaction_count()), filled(0), matched(0) {
+    for (const PrefilledTransaction& entry : compact.prefilled) {
+        Slot& slot = slots[entry.index];
+        slot.id = entry.tx.hash();
+        slot.tx = entry.tx;
+        filled++;
+    }
+
+    // Short ids map to the slots not taken by prefilled transactions, in order.
+    by_short_id.reserve(compact.short_ids.size());
+    uint32_t position = 0;
+    for (uint64_t id : compact.short_ids) {
+        while (slots[position].tx) {
+            position++;
+        }
+        if (!by_short_id.emplace(id, position).second) {
+            // A well-formed sender never repeats a short id; fetch both transactions explicitly.
+            slots[by_short_id[id]].ambiguous = true;
+            slots[position].ambiguous = true;
+        }
+        position++;
+    }
+}
+
+size_t PartialBlock::fill_from(const Mempool& pool) {
+    size_t before = filled;
+    pool.for_each([&](const MempoolEntry& entry) {
+        auto it = by_short_id.find(compact.short_id(entry.id));
+        if (it == by_short_id.end()) {
+            return;
+        }
+        Slot& slot = slots[it->second];
+        if (slot.ambiguous) {
+            return;
+        }
+        if (slot.tx) {
+            if (slot.id != entry.id) {
+                // Two pool transactions share the short id: neither can be trusted.
+                slot.tx.reset();
+                slot.ambiguous = true;
+                filled--;
+                matched--;
+            }
+            return;
+        }
+        slot.tx = entry.tx;
+        slot.id = entry.id;
+        filled++;
+        matched++;
+    });
+    return filled > before ? filled - before : 0;
+}
+
+std::vector<uint32_t> PartialBlock::get_missing() const {
+    std::vector<uint32_t> missing;
+    missing.reserve(slots.size() - filled);
+    for (uint32_t i = 0; i < slots.size(); ++i) {
+        if (!slots[i].tx) {
+            missing.push_back(i);
+        }
+    }
+    return missing;
+}
+
+void PartialBlock::fill_missing(const std::vector<Transaction>& txs) {
+    if (txs.size() != slots.size() - filled) {
+        throw std::invalid_argument("Fetched transaction count does not match the missing slots");
+    }
+    size_t next = 0;
+    for (Slot& slot : slots) {
+        if (slot.tx) {
+            continue;
+        }
+        slot.id = txs[next].hash();
+        slot.tx = txs[next++];
+        filled++;
+    }
+}
+
+Block PartialBlock::to_block() const {
+    if (!is_complete()) {
+        throw std::runtime_error("Compact block reconstruction is incomplete");
+    }
+
+    std::vector<Transaction> transactions;
+    std::vector<Hash256> ids;
+    transactions.reserve(slots.size());
+    ids.reserve(slots.size());
+    for (const Slot& slot : slots) {
+        transactions.push_back(*slot.tx);
+        ids.push_back(slot.id);
+    }
+
+    Block block = Block::assemble(compact.block_number, compact.previous_block_hash, compact.timestamp,
+                                  compact.required_signatures, compact.validator_signatures,
+                                  std::move(transactions), ids);
+    if (block.get_merkle_root() != compact.merkle_root) {
+        throw std::runtime_error("Reconstructed block does not match its Merkle root");
+    }
+    return block;
+}
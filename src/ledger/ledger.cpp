@@ -1,37 +1,319 @@
 #include "ledger/ledger.hpp"
+#include "ledger/wire_format.hpp"
 #include "cryptography/crypto.hpp"
-#include <iostream>
+#include "logging/logger.hpp"
+#include "metrics/metrics.hpp"
 #include <stdexcept>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+const size_t CHAIN_SUMMARY_BLOCKS = 3;  // Most recent blocks listed by a chain state summary.
+const uint8_t CHECKPOINT_FORMAT = 1;    // Layout version of the state checkpoint file.
+const char* const CHECKPOINT_FILE = "/state.checkpoint";  // State checkpoint, relative to the data directory.
+
+// Reports the number of pending transactions after the pool changed.
+static void publish_mempool_size(const Mempool& mempool) {
+    static Gauge& size = MetricsRegistry::instance().gauge("synledger_mempool_transactions",
+                                                           "Transactions waiting in the mempool");
+    size.set(static_cast<int64_t>(mempool.size()));
+}
+
+// Block hashes are hex digests; anything else (e.g. the genesis parent "0") is keyed by its SHA-256.
+static Hash256 digest_of(const std::string& block_hash) {
+    Hash256 digest;
+    if (!Hash256::from_hex(block_hash, digest)) {
+        digest = Crypto::hash_raw(block_hash);
+    }
+    return digest;
+}
+
+// Imported blocks carry transactions that were never checked on decode; one bad signature rejects the block.
+static void require_valid_signatures(const Block& block) {
+    if (block.get_transactions().empty()) {
+        return;
+    }
+    VerificationBitmap results = block.verify_transactions();
+    if (!results.all_valid()) {
+        throw std::invalid_argument("Block " + std::to_string(block.get_block_number()) +
+                                    " has an invalid signature on transaction " +
+                                    std::to_string(results.first_invalid()) + "!");
+    }
+}
+
+// Reads a raw 32-byte digest written by `write_checkpoint`.
+static Hash256 read_digest(ByteReader& reader) {
+    Hash256 digest;
+    std::memcpy(digest.data(), reader.get_bytes(Hash256::SIZE).data(), Hash256::SIZE);
+    return digest;
+}
+
+Ledger::Ledger(size_t initial_difficulty, const std::string& data_dir) 
+    : chain_base(0), history_base(0), replayed_blocks(0), difficulty(initial_difficulty), current_block_number(0),
+      validated_height(0) {
+    if (!data_dir.empty()) {
+        block_store.reset(new BlockStore(data_dir));
+        checkpoint_path = data_dir + CHECKPOINT_FILE;
+        if (!block_store->empty()) {
+            load_resident_window();
+            block_index = BlockIndex(block_store->size());
+            // Only the blocks stored after the checkpoint are replayed into the account state and the index.
+            size_t restored = load_checkpoint();
+            for (size_t height = restored; height < chain_base; ++height) {
+                BlockView view = block_store->view(height);
+                Hash256 digest = view.compute_digest();
+                const BlockIndexEntry* known = block_index.find(digest);
+                block_index.insert(digest, BlockIndexEntry{ height, BLOCK_ON_MAIN_CHAIN, known && known->confirmed });
+                state.apply_block(view);
+            }
+            for (size_t i = std::max(restored, chain_base) - chain_base; i < chain.size(); ++i) {
+                index_block(chain[i], chain_base + i, BLOCK_ON_MAIN_CHAIN);
+                state.apply_block(chain[i]);
+            }
+            replayed_blocks = block_store->size() - restored;
+            current_block_number = block_store->size() - 1;
+            current_chain_tip_hash = chain.back().get_block_hash();
+            block_tree.reset(chain.back(), current_block_number);
+            // Stored blocks were validated before they were appended; the tail was re-checked on open.
+            validated_height = get_blockchain_length();
+            validated_tip = chain.back().get_block_digest();
+            LOG_INFO("ledger") << "Reopened " << block_store->size() << " stored blocks, replayed " << replayed_blocks
+                               << " past the state checkpoint";
+            return;
+        }
+    }
 
-Ledger::Ledger(size_t initial_difficulty) 
-    : difficulty(initial_difficulty), current_block_number(0) {
     Block genesis_block(0, "0", 1);
     genesis_block.sign_block("Genesis Block Signature");
     genesis_block.calculate_block_hash();
-    chain.push_back(genesis_block);
+    append_block(Block(genesis_block));
     current_chain_tip_hash = genesis_block.get_block_hash();
+    block_tree.reset(genesis_block, 0);
+    validated_height = 1;
+    validated_tip = genesis_block.get_block_digest();
+}
+
+Ledger::Ledger(size_t initial_difficulty, const Block& base_block, const std::vector<AccountEntry>& accounts)
+    : chain_base(base_block.get_block_number()), history_base(base_block.get_block_number()), replayed_blocks(0),
+      difficulty(initial_difficulty), current_block_number(base_block.get_block_number()),
+      validated_height(0) {
+    if (base_block.get_block_digest() != base_block.compute_block_digest()) {
+        throw std::invalid_argument("Snapshot block digest does not match its contents!");
+    }
+
+    index_block(base_block, chain_base, BLOCK_ON_MAIN_CHAIN);
+    state.load(accounts, chain_base + 1);
+    chain.push_back(base_block);
+    current_chain_tip_hash = base_block.get_block_hash();
+    block_tree.reset(base_block, chain_base);
+    validated_height = chain_base + 1;
+    validated_tip = base_block.get_block_digest();
+}
+
+Ledger::~Ledger() {
+    if (!block_store || block_store->empty()) {
+        return;
+    }
+    try {
+        write_checkpoint();
+    } catch (const std::exception& e) {
+        LOG_WARN("ledger") << "State checkpoint not written on shutdown: " << e.what();
+    }
+}
+
+void Ledger::append_block(Block&& block) {
+    index_block(block, get_blockchain_length(), BLOCK_ON_MAIN_CHAIN);
+    state.apply_block(block);
+    if (block_store) {
+        block_store->append(block);
+    }
+    chain.push_back(std::move(block));
+    if (!block_store) {
+        return;
+    }
+    if (block_store->size() % CHECKPOINT_INTERVAL == 0) {
+        write_checkpoint();
+    }
+
+    // Trim in batches so that dropping old blocks from the front stays amortized O(1).
+    if (chain.size() >= 2 * RESIDENT_BLOCKS) {
+        size_t drop = chain.size() - RESIDENT_BLOCKS;
+        chain.erase(chain.begin(), chain.begin() + drop);
+        chain_base += drop;
+    }
+}
+
+void Ledger::load_resident_window() {
+    size_t stored = block_store->size();
+    chain_base = stored > RESIDENT_BLOCKS ? stored - RESIDENT_BLOCKS : 0;
+    chain.clear();
+    chain.reserve(stored - chain_base);
+    for (size_t height = chain_base; height < stored; ++height) {
+        chain.push_back(block_store->read(height));
+    }
+}
+
+void Ledger::write_checkpoint() {
+    // The checkpoint must never cover blocks a crash could still lose.
+    block_store->sync();
+    uint64_t covered = block_store->size();
+    std::string payload;
+    ByteWriter writer(payload);
+    writer.put_u8(CHECKPOINT_FORMAT);
+    writer.put_u64(covered);
+    Block scratch;
+    const Hash256& tip = block_at(covered - 1, scratch).get_block_digest();
+    writer.put_bytes(tip.data(), Hash256::SIZE);
+
+    std::vector<AccountEntry> accounts = state.snapshot()->entries();
+    writer.put_u64(accounts.size());
+    for (const AccountEntry& account : accounts) {
+        writer.put_str16(account.first);
+        writer.put_f64(account.second.balance);
+        writer.put_u64(account.second.nonce);
+    }
+
+    // Side-branch entries belong to the block tree, which is rebuilt from the tip, so only these are kept.
+    std::string index_payload;
+    ByteWriter index_writer(index_payload);
+    uint64_t entries = 0;
+    block_index.for_each([&](const Hash256& digest, const BlockIndexEntry& entry) {
+        bool main_chain = entry.location == BLOCK_ON_MAIN_CHAIN && entry.height < covered;
+        if (!main_chain && !(entry.location == BLOCK_NOT_STORED && entry.confirmed)) {
+            return;
+        }
+        index_writer.put_bytes(digest.data(), Hash256::SIZE);
+        index_writer.put_u64(entry.height);
+        index_writer.put_u32(entry.location);
+        index_writer.put_u8(entry.confirmed ? 1 : 0);
+        ++entries;
+    });
+    writer.put_u64(entries);
+    writer.put_bytes(index_payload.data(), index_payload.size());
+    Hash256 checksum = Crypto::hash_raw(payload);
+    writer.put_bytes(checksum.data(), Hash256::SIZE);
+
+    std::string temporary = checkpoint_path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out.write(payload.data(), static_cast<std::streamsize>(payload.size())) || !out.flush()) {
+            throw std::runtime_error("Failed to write state checkpoint " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), checkpoint_path.c_str()) != 0) {
+        throw std::runtime_error("Failed to replace state checkpoint " + checkpoint_path);
+    }
+}
+
+size_t Ledger::load_checkpoint() {
+    std::ifstream in(checkpoint_path, std::ios::binary);
+    if (!in) {
+        return 0;
+    }
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    std::string payload = contents.str();
+
+    try {
+        if (payload.size() < Hash256::SIZE) {
+            throw std::runtime_error("file is truncated");
+        }
+        std::string_view body(payload.data(), payload.size() - Hash256::SIZE);
+        Hash256 checksum = Crypto::hash_raw(body);
+        if (std::memcmp(checksum.data(), payload.data() + body.size(), Hash256::SIZE) != 0) {
+            throw std::runtime_error("checksum mismatch");
+        }
+
+        ByteReader reader(body);
+        if (reader.get_u8() != CHECKPOINT_FORMAT) {
+            throw std::runtime_error("unknown format");
+        }
+        uint64_t covered = reader.get_u64();
+        Hash256 tip = read_digest(reader);
+        // A rollback or a lost tail may have replaced or dropped the block the checkpoint follows.
+        if (covered == 0 || covered > block_store->size() || block_store->view(covered - 1).compute_digest() != tip) {
+            throw std::runtime_error("it does not match the stored chain");
+        }
+
+        std::vector<AccountEntry> accounts(reader.get_u64());
+        for (AccountEntry& account : accounts) {
+            account.first = std::string(reader.get_str16());
+            account.second.balance = reader.get_f64();
+            account.second.nonce = reader.get_u64();
+        }
+        BlockIndex index(block_store->size());
+        for (uint64_t entries = reader.get_u64(); entries > 0; --entries) {
+            Hash256 digest = read_digest(reader);
+            BlockIndexEntry entry;
+            entry.height = reader.get_u64();
+            entry.location = reader.get_u32();
+            entry.confirmed = reader.get_u8() != 0;
+            index.insert(digest, entry);
+        }
+        if (reader.remaining() != 0) {
+            throw std::runtime_error("trailing bytes");
+        }
+
+        state.load(accounts, covered);
+        block_index = std::move(index);
+        return static_cast<size_t>(covered);
+    } catch (const std::exception& e) {
+        LOG_WARN("ledger") << "Ignoring state checkpoint " << checkpoint_path << ": " << e.what();
+        return 0;
+    }
 }
 
 void Ledger::add_block(const Block& block) {
-    if (block.get_previous_block_hash() == current_chain_tip_hash) {
-        chain.push_back(block);
-        current_block_number++;
-        current_chain_tip_hash = block.get_block_hash();
-    } else {
+    if (block.get_previous_block_hash() != current_chain_tip_hash) {
+        throw std::invalid_argument("Block does not fit the current chain tip!");
+    }
+    add_block(Block(block));
+}
+
+void Ledger::add_block(Block&& block) {
+    static Histogram& add_block_time = MetricsRegistry::instance().timer("synledger_ledger_add_block_seconds",
+                                                                         "Duration of Ledger::add_block");
+    ScopedTimer timer(add_block_time);
+    if (block.get_previous_block_hash() != current_chain_tip_hash) {
         throw std::invalid_argument("Block does not fit the current chain tip!");
     }
+    require_valid_signatures(block);
+
+    // The fork tree keeps its own copy; the chain takes over the caller's block.
+    block_tree.insert(block, difficulty);
+    append_block(std::move(block));
+    const Block& added = chain.back();
+    current_block_number++;
+    current_chain_tip_hash = added.get_block_hash();
+    mempool.remove_included(added);
+    publish_mempool_size(mempool);
+    prune_forks();
+}
+
+void Ledger::index_block(const Block& block, size_t height, uint32_t location) {
+    BlockIndexEntry* entry = block_index.find(block.get_block_digest());
+    if (!entry) {
+        block_index.insert(block.get_block_digest(), BlockIndexEntry{ height, location, false });
+    } else if (location == BLOCK_ON_MAIN_CHAIN || entry->location != BLOCK_ON_MAIN_CHAIN) {
+        // Main-chain placement wins over a side-branch copy of the same block.
+        entry->height = height;
+        entry->location = location;
+    }
 }
 
 void Ledger::add_fork_block(const std::string& fork_tip, const Block& block) {
-    if (forks.find(fork_tip) == forks.end()) {
-        forks[fork_tip] = std::vector<Block>();
-        fork_lengths[fork_tip] = 0;
-        fork_difficulties[fork_tip] = 0;
+    if (digest_of(fork_tip) != block.get_previous_block_digest()) {
+        throw std::invalid_argument("Fork block does not build on the given fork tip!");
     }
+    require_valid_signatures(block);
 
-    forks[fork_tip].push_back(block);
-    fork_lengths[fork_tip] = forks[fork_tip].size();
-    fork_difficulties[fork_tip] += difficulty;
+    uint32_t node = block_tree.insert(block, difficulty);
+    index_block(block, block_tree.node(node).height, BLOCK_ON_SIDE_BRANCH);
 }
 
 const Block& Ledger::get_latest_block() const {
@@ -42,45 +324,169 @@ const std::vector<Block>& Ledger::get_chain() const {
     return chain;
 }
 
-const std::map<std::string, std::vector<Block>>& Ledger::get_forks() const {
-    return forks;
+size_t Ledger::get_chain_base() const {
+    return chain_base;
+}
+
+size_t Ledger::get_history_base() const {
+    return history_base;
+}
+
+Block Ledger::get_block(size_t height) const {
+    if (height >= chain_base && height - chain_base < chain.size()) {
+        return chain[height - chain_base];
+    }
+    if (!block_store || height < history_base) {
+        throw std::out_of_range("Block height " + std::to_string(height) + " is not held by the ledger");
+    }
+    return block_store->read(height);
+}
+
+const BlockStore* Ledger::get_block_store() const {
+    return block_store.get();
+}
+
+size_t Ledger::get_replayed_blocks() const {
+    return replayed_blocks;
+}
+
+const BlockTree& Ledger::get_forks() const {
+    return block_tree;
+}
+
+bool Ledger::has_block(const Hash256& block_digest) const {
+    const BlockIndexEntry* entry = block_index.find(block_digest);
+    return entry && entry->location != BLOCK_NOT_STORED;
+}
+
+const BlockIndexEntry* Ledger::find_block(const Hash256& block_digest) const {
+    return block_index.find(block_digest);
+}
+
+// Checks that `current` links to `previous` and that its cached digest and Merkle root are intact.
+static const char* check_block_link(const Block& previous, const Block& current) {
+    if (current.get_previous_block_digest() != previous.get_block_digest()) {
+        return "invalid previous block hash";
+    }
+    if (current.get_block_digest() != current.compute_block_digest()) {
+        return "invalid block hash";
+    }
+    if (!current.verify_merkle_root()) {
+        return "invalid Merkle root";
+    }
+    return nullptr;
+}
+
+const Block& Ledger::block_at(size_t height, Block& scratch) const {
+    if (height >= chain_base && height - chain_base < chain.size()) {
+        return chain[height - chain_base];
+    }
+    scratch = get_block(height);
+    return scratch;
+}
+
+size_t Ledger::validate_range(size_t begin, size_t end, const char*& reason) const {
+    if (begin >= end) {
+        return end;
+    }
+
+    Block scratch[2];
+    int previous_slot = 0;
+    const Block* previous = &block_at(begin - 1, scratch[previous_slot]);
+    for (size_t height = begin; height < end; ++height) {
+        const Block* current = &block_at(height, scratch[1 - previous_slot]);
+        reason = check_block_link(*previous, *current);
+        if (reason) {
+            return height;
+        }
+        previous = current;
+        previous_slot = 1 - previous_slot;
+    }
+    return end;
 }
 
 bool Ledger::validate_chain() const {
-    for (size_t i = 1; i < chain.size(); ++i) {
-        const Block& previous_block = chain[i - 1];
-        const Block& current_block = chain[i];
+    static Histogram& validate_time = MetricsRegistry::instance().timer("synledger_ledger_validate_chain_seconds",
+                                                                        "Duration of Ledger::validate_chain");
+    ScopedTimer timer(validate_time);
+    size_t length = get_blockchain_length();
+    Block scratch;
 
-        if (current_block.get_previous_block_hash() != previous_block.get_block_hash()) {
-            std::cerr << "Block " << current_block.get_block_number() << " has invalid previous block hash!" << std::endl;
-            return false;
+    // Fall back to the first held block if the checkpointed tip is no longer part of the chain.
+    if (validated_height <= history_base || validated_height > length ||
+        block_at(validated_height - 1, scratch).get_block_digest() != validated_tip) {
+        validated_height = history_base + 1;
+        validated_tip = block_at(history_base, scratch).get_block_digest();
+    }
+
+    const char* reason = nullptr;
+    size_t invalid = validate_range(validated_height, length, reason);
+    if (invalid < length) {
+        LOG_WARN("ledger") << "Block " << invalid << " has " << reason << "!";
+        validated_height = invalid;
+        validated_tip = block_at(invalid - 1, scratch).get_block_digest();
+        return false;
+    }
+
+    validated_height = length;
+    validated_tip = get_latest_block().get_block_digest();
+    return true;
+}
+
+bool Ledger::audit_chain(int num_threads) const {
+    size_t length = get_blockchain_length();
+    long chunk_count = static_cast<long>((length + AUDIT_CHUNK_BLOCKS - 1) / AUDIT_CHUNK_BLOCKS);
+    std::vector<size_t> first_invalid(chunk_count, length);
+    std::vector<const char*> reasons(chunk_count, nullptr);
+#ifdef _OPENMP
+    const int threads = num_threads > 0 ? num_threads : omp_get_max_threads();
+#else
+    const int threads = 1;
+    (void)num_threads;
+#endif
+
+    #pragma omp parallel for schedule(dynamic) num_threads(threads)
+    for (long c = 0; c < chunk_count; ++c) {
+        size_t begin = std::max<size_t>(history_base + 1, static_cast<size_t>(c) * AUDIT_CHUNK_BLOCKS);
+        size_t end = std::min(length, static_cast<size_t>(c + 1) * AUDIT_CHUNK_BLOCKS);
+        size_t invalid = validate_range(begin, end, reasons[c]);
+        if (invalid < end) {
+            first_invalid[c] = invalid;
         }
+    }
 
-        if (current_block.get_block_hash() != current_block.calculate_block_hash()) {
-            std::cerr << "Block " << current_block.get_block_number() << " has invalid block hash!" << std::endl;
+    for (long c = 0; c < chunk_count; ++c) {
+        if (first_invalid[c] < length) {
+            Block scratch;
+            LOG_WARN("ledger") << "Audit: block " << first_invalid[c] << " has " << reasons[c] << "!";
+            validated_height = first_invalid[c];
+            validated_tip = block_at(first_invalid[c] - 1, scratch).get_block_digest();
             return false;
         }
     }
+
+    validated_height = length;
+    validated_tip = get_latest_block().get_block_digest();
     return true;
 }
 
+size_t Ledger::get_validated_height() const {
+    return validated_height;
+}
+
 bool Ledger::validate_fork(const std::string& fork_tip) const {
-    if (forks.find(fork_tip) == forks.end()) {
+    uint32_t tip = block_tree.find(digest_of(fork_tip));
+    if (tip == BlockTree::NO_NODE) {
         return false;
     }
 
-    const std::vector<Block>& fork = forks.at(fork_tip);
-    for (size_t i = 1; i < fork.size(); ++i) {
-        const Block& previous_block = fork[i - 1];
-        const Block& current_block = fork[i];
-
-        if (current_block.get_previous_block_hash() != previous_block.get_block_hash()) {
-            std::cerr << "Fork block " << current_block.get_block_number() << " has invalid previous block hash!" << std::endl;
-            return false;
-        }
-
-        if (current_block.get_block_hash() != current_block.calculate_block_hash()) {
-            std::cerr << "Fork block " << current_block.get_block_number() << " has invalid block hash!" << std::endl;
+    uint32_t main_tip = block_tree.find(get_latest_block().get_block_digest());
+    uint32_t ancestor = block_tree.common_ancestor(tip, main_tip);
+    for (uint32_t id : block_tree.path(ancestor, tip)) {
+        const BlockTreeNode& node = block_tree.node(id);
+        const char* reason = check_block_link(block_tree.node(node.parent).block, node.block);
+        if (reason) {
+            LOG_WARN("ledger") << "Fork block " << node.block.get_block_number() << " has " << reason << "!";
             return false;
         }
     }
@@ -88,89 +494,188 @@ bool Ledger::validate_fork(const std::string& fork_tip) const {
 }
 
 bool Ledger::rollback_chain(size_t blocks_to_rollback) {
-    if (blocks_to_rollback >= chain.size()) {
+    size_t length = get_blockchain_length();
+    if (blocks_to_rollback >= length - history_base) {
         return false;
     }
 
-    chain.resize(chain.size() - blocks_to_rollback);
+    // Transactions of rolled-back blocks become pending again; index entries only keep metadata.
+    for (size_t height = length; height-- > length - blocks_to_rollback;) {
+        Block block = get_block(height);
+        state.revert_block(block);
+        for (TransactionRef tx : block.get_transactions()) {
+            mempool.add(tx.to_transaction(), tx.amount);
+        }
+
+        BlockIndexEntry* entry = block_index.find(block.get_block_digest());
+        if (entry && entry->location == BLOCK_ON_MAIN_CHAIN) {
+            if (block_tree.find(block.get_block_digest()) != BlockTree::NO_NODE) {
+                entry->location = BLOCK_ON_SIDE_BRANCH;
+            } else if (entry->confirmed) {
+                entry->location = BLOCK_NOT_STORED;
+            } else {
+                block_index.erase(block.get_block_digest());
+            }
+        }
+    }
+
+    if (block_store) {
+        block_store->truncate(length - blocks_to_rollback);
+    }
+    if (blocks_to_rollback < chain.size()) {
+        chain.resize(chain.size() - blocks_to_rollback);
+    } else {
+        load_resident_window();
+    }
     current_block_number -= blocks_to_rollback;
+    validated_height = std::min(validated_height, get_blockchain_length());
+    if (validated_height > 0) {
+        Block scratch;
+        validated_tip = block_at(validated_height - 1, scratch).get_block_digest();
+    }
     current_chain_tip_hash = chain.back().get_block_hash();
+
+    // Rolling back past the finalized root discards the tree; it regrows from the new tip.
+    if (block_tree.find(chain.back().get_block_digest()) == BlockTree::NO_NODE) {
+        block_tree.reset(chain.back(), get_blockchain_length() - 1);
+    }
+    publish_mempool_size(mempool);
     return true;
 }
 
 bool Ledger::confirm_block(const Block& block) {
     if (block.get_block_number() <= current_block_number && block.verify_signatures()) {
-        std::cout << "Block " << block.get_block_number() << " confirmed." << std::endl;
+        LOG_INFO("ledger") << "Block " << block.get_block_number() << " confirmed.";
         return true;
     }
     return false;
 }
 
 size_t Ledger::get_blockchain_length() const {
-    return chain.size();
+    return chain_base + chain.size();
 }
 
-void Ledger::log_chain_state() const {
-    std::cout << "Current blockchain length: " << chain.size() << std::endl;
-    std::cout << "Current block number: " << current_block_number << std::endl;
-    std::cout << "Current chain tip hash: " << current_chain_tip_hash << std::endl;
+void Ledger::log_chain_state(ChainLogMode mode) const {
+    LOG_INFO("ledger") << "Chain length " << get_blockchain_length() << ", block number " << current_block_number
+                       << ", tip " << current_chain_tip_hash << ", " << get_pending_transactions().size()
+                       << " pending transactions";
 
-    for (const auto& block : chain) {
-        std::cout << "Block #" << block.get_block_number() << " | Hash: " << block.get_block_hash() << std::endl;
+    if (mode == ChainLogMode::FULL) {
+        for (const auto& block : chain) {
+            LOG_DEBUG("ledger") << "Block #" << block.get_block_number() << " | Hash: " << block.get_block_hash();
+        }
+        return;
+    }
+    const size_t shown = std::min(chain.size(), CHAIN_SUMMARY_BLOCKS);
+    for (size_t i = chain.size() - shown; i < chain.size(); ++i) {
+        LOG_INFO("ledger") << "Block #" << chain[i].get_block_number() << " | Hash: " << chain[i].get_block_hash();
     }
 }
 
-std::string Ledger::calculate_merkle_root(const std::vector<Transaction>& transactions) {
-    if (transactions.empty()) {
-        return "";
+bool Ledger::select_fork(const std::string& fork_tip) {
+    uint32_t tip = block_tree.find(digest_of(fork_tip));
+    if (tip == BlockTree::NO_NODE) {
+        return false;
     }
+    reorganize_to(tip);
+    return true;
+}
 
-    std::vector<std::string> hashes;
-    for (const auto& tx : transactions) {
-        hashes.push_back(Crypto::hash(tx.sender + tx.receiver + std::to_string(tx.amount) + tx.signature));
+bool Ledger::apply_fork_choice() {
+    uint32_t best = block_tree.best_tip();
+    uint32_t main_tip = block_tree.find(get_latest_block().get_block_digest());
+    if (best == main_tip || block_tree.node(best).weight <= block_tree.node(main_tip).weight) {
+        return false;
     }
+    reorganize_to(best);
+    return true;
+}
 
-    while (hashes.size() > 1) {
-        if (hashes.size() % 2 != 0) {
-            hashes.push_back(hashes.back());
-        }
+void Ledger::reorganize_to(uint32_t tip_node) {
+    uint32_t main_tip = block_tree.find(get_latest_block().get_block_digest());
+    uint32_t ancestor = block_tree.common_ancestor(tip_node, main_tip);
+    if (ancestor == tip_node) {
+        return;  // Already part of the main chain.
+    }
 
-        std::vector<std::string> new_hashes;
-        for (size_t i = 0; i < hashes.size(); i += 2) {
-            new_hashes.push_back(Crypto::hash(hashes[i] + hashes[i + 1]));
-        }
-        hashes = new_hashes;
+    // Only the diverged section is touched: roll back to the common ancestor, then replay the branch.
+    std::vector<uint32_t> branch = block_tree.path(ancestor, tip_node);
+    size_t depth = block_tree.node(main_tip).height - block_tree.node(ancestor).height;
+    if (depth > 0) {
+        rollback_chain(depth);
+    }
+    for (uint32_t id : branch) {
+        const Block& block = block_tree.node(id).block;
+        append_block(Block(block));
+        mempool.remove_included(block);
     }
+    publish_mempool_size(mempool);
 
-    return hashes.front();
+    current_block_number = get_blockchain_length() - 1;
+    current_chain_tip_hash = chain.back().get_block_hash();
+    prune_forks();
 }
 
-bool Ledger::select_fork(const std::string& fork_tip) {
-    if (forks.find(fork_tip) != forks.end()) {
-        const std::vector<Block>& fork_chain = forks[fork_tip];
-        chain.insert(chain.end(), fork_chain.begin(), fork_chain.end());
-        current_block_number = chain.size();
-        current_chain_tip_hash = chain.back().get_block_hash();
-        return true;
+void Ledger::set_block_confirmation(const std::string& block_hash, bool confirmed) {
+    Hash256 digest = digest_of(block_hash);
+    BlockIndexEntry* entry = block_index.find(digest);
+    if (entry) {
+        entry->confirmed = confirmed;
+    } else {
+        block_index.insert(digest, BlockIndexEntry{ 0, BLOCK_NOT_STORED, confirmed });
     }
-    return false;
 }
 
-void Ledger::set_block_confirmation(const std::string& block_hash, bool confirmed) {
-    confirmed_blocks[block_hash] = confirmed;
+bool Ledger::is_block_confirmed(const std::string& block_hash) const {
+    return is_block_confirmed(digest_of(block_hash));
 }
 
-bool Ledger::is_block_confirmed(const std::string& block_hash) const {
-    auto it = confirmed_blocks.find(block_hash);
-    return it != confirmed_blocks.end() && it->second;
+bool Ledger::is_block_confirmed(const Hash256& block_digest) const {
+    const BlockIndexEntry* entry = block_index.find(block_digest);
+    return entry && entry->confirmed;
 }
 
 void Ledger::prune_forks() {
-    for (auto it = forks.begin(); it != forks.end();) {
-        if (fork_lengths[it->first] < current_block_number - 10) {
-            it = forks.erase(it);
-        } else {
-            ++it;
+    // Advance the root in batches so that pruning stays amortized O(1) per block.
+    size_t tip_height = get_blockchain_length() - 1;
+    if (tip_height < block_tree.node(block_tree.root()).height + 2 * FINALITY_DEPTH) {
+        return;
+    }
+
+    uint32_t final_node = block_tree.find(get_latest_block().get_block_digest());
+    for (size_t i = 0; i < FINALITY_DEPTH; ++i) {
+        final_node = block_tree.node(final_node).parent;
+    }
+
+    for (const Hash256& digest : block_tree.prune(final_node)) {
+        BlockIndexEntry* entry = block_index.find(digest);
+        if (entry && entry->location == BLOCK_ON_SIDE_BRANCH) {
+            if (entry->confirmed) {
+                entry->location = BLOCK_NOT_STORED;
+            } else {
+                block_index.erase(digest);
+            }
         }
     }
 }
+
+bool Ledger::add_transaction(const Transaction& tx) {
+    if (!tx.verify_transaction()) {
+        throw std::invalid_argument("Invalid transaction signature");
+    }
+    bool added = mempool.add(tx, tx.amount);
+    publish_mempool_size(mempool);
+    return added;
+}
+
+bool Ledger::has_pending_transactions() const {
+    return !mempool.empty();
+}
+
+const StateDB& Ledger::get_state() const {
+    return state;
+}
+
+const Mempool& Ledger::get_pending_transactions() const {
+    return mempool;
+}
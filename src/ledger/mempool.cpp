@@ -0,0 +1,123 @@
+#include "ledger/mempool.hpp"
+#include <queue>
+#include <algorithm>
+
+Mempool::Mempool(size_t capacity) : capacity(capacity), next_sequence(0), evicted(0) {}
+
+bool Mempool::add(const Transaction& tx, double priority) {
+    Hash256 id = tx.hash();
+    if (entries.count(id) || capacity == 0) {
+        return false;
+    }
+
+    if (entries.size() >= capacity) {
+        const PriorityKey& lowest = *by_priority.begin();
+        if (priority <= lowest.priority) {
+            return false;
+        }
+        Hash256 victim = lowest.id;
+        remove(victim);
+        evicted++;
+    }
+
+    uint64_t sequence = next_sequence++;
+    entries.emplace(id, MempoolEntry{ tx, id, priority, sequence });
+    sender_queues[tx.sender].push_back(id);
+    by_priority.insert(PriorityKey{ priority, sequence, id });
+    return true;
+}
+
+bool Mempool::contains(const Hash256& id) const {
+    return entries.count(id) != 0;
+}
+
+const Transaction* Mempool::find(const Hash256& id) const {
+    auto it = entries.find(id);
+    return it == entries.end() ? nullptr : &it->second.tx;
+}
+
+bool Mempool::remove(const Hash256& id) {
+    auto it = entries.find(id);
+    if (it == entries.end()) {
+        return false;
+    }
+
+    const MempoolEntry& entry = it->second;
+    by_priority.erase(PriorityKey{ entry.priority, entry.sequence, id });
+
+    auto queue_it = sender_queues.find(entry.tx.sender);
+    if (queue_it != sender_queues.end()) {
+        std::deque<Hash256>& queue = queue_it->second;
+        // Included transactions are almost always at the head of their sender's queue.
+        auto pos = std::find(queue.begin(), queue.end(), id);
+        if (pos != queue.end()) {
+            queue.erase(pos);
+        }
+        if (queue.empty()) {
+            sender_queues.erase(queue_it);
+        }
+    }
+
+    entries.erase(it);
+    return true;
+}
+
+size_t Mempool::remove_included(const Block& block) {
+    if (entries.empty()) {
+        return 0;
+    }
+
+    const MerkleTree& tree = block.get_transaction_tree();
+    size_t removed = 0;
+    for (size_t i = 0; i < tree.size(); ++i) {
+        if (remove(tree.leaf(i))) {
+            removed++;
+        }
+    }
+    return removed;
+}
+
+std::vector<const Transaction*> Mempool::select(size_t max_count) const {
+    struct Cursor {
+        const MempoolEntry* entry;
+        const std::deque<Hash256>* queue;
+        size_t position;
+    };
+    auto lower = [](const Cursor& a, const Cursor& b) {
+        if (a.entry->priority != b.entry->priority) {
+            return a.entry->priority < b.entry->priority;
+        }
+        return a.entry->sequence > b.entry->sequence;
+    };
+
+    // Only the head of each sender queue is eligible; taking it exposes the sender's next transaction.
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(lower)> heads(lower);
+    for (const auto& [sender, queue] : sender_queues) {
+        heads.push(Cursor{ &entries.at(queue.front()), &queue, 0 });
+    }
+
+    std::vector<const Transaction*> selected;
+    selected.reserve(std::min(max_count, entries.size()));
+    while (!heads.empty() && selected.size() < max_count) {
+        Cursor cursor = heads.top();
+        heads.pop();
+        selected.push_back(&cursor.entry->tx);
+
+        size_t next = cursor.position + 1;
+        if (next < cursor.queue->size()) {
+            heads.push(Cursor{ &entries.at((*cursor.queue)[next]), cursor.queue, next });
+        }
+    }
+    return selected;
+}
+
+size_t Mempool::sender_count(const std::string& sender) const {
+    auto it = sender_queues.find(sender);
+    return it == sender_queues.end() ? 0 : it->second.size();
+}
+
+void Mempool::clear() {
+    entries.clear();
+    sender_queues.clear();
+    by_priority.clear();
+}
@@ -0,0 +1,100 @@
+#include "ledger/merkle_tree.hpp"
+#include <stdexcept>
+
+static const uint8_t LEAF_PREFIX = 0x00;
+static const uint8_t NODE_PREFIX = 0x01;
+
+Hash256 MerkleTree::hash_leaf(std::string_view leaf_data) {
+    Sha256Hasher hasher;
+    return hasher.update(&LEAF_PREFIX, 1).update(leaf_data).finalize();
+}
+
+Hash256 MerkleTree::hash_node(const Hash256& left, const Hash256& right) {
+    Sha256Hasher hasher;
+    return hasher.update(&NODE_PREFIX, 1).update(left).update(right).finalize();
+}
+
+void MerkleTree::append(const Hash256& leaf_hash) {
+    if (levels.empty()) {
+        levels.emplace_back();
+    }
+    levels[0].push_back(leaf_hash);
+
+    size_t index = levels[0].size() - 1;
+    for (size_t level = 0; levels[level].size() > 1; ++level) {
+        const std::vector<Hash256>& nodes = levels[level];
+        size_t parent = index / 2;
+        const Hash256& left = nodes[parent * 2];
+        const Hash256& right = (parent * 2 + 1 < nodes.size()) ? nodes[parent * 2 + 1] : left;
+        Hash256 parent_hash = hash_node(left, right);
+
+        if (levels.size() == level + 1) {
+            levels.emplace_back();
+        }
+        std::vector<Hash256>& parents = levels[level + 1];
+        if (parent < parents.size()) {
+            parents[parent] = parent_hash;
+        } else {
+            parents.push_back(parent_hash);
+        }
+        index = parent;
+    }
+}
+
+void MerkleTree::clear() {
+    levels.clear();
+}
+
+Hash256 MerkleTree::root() const {
+    if (levels.empty()) {
+        return Hash256();
+    }
+    return levels.back().front();
+}
+
+size_t MerkleTree::size() const {
+    return levels.empty() ? 0 : levels[0].size();
+}
+
+const Hash256& MerkleTree::leaf(size_t index) const {
+    return levels.at(0).at(index);
+}
+
+MerkleProof MerkleTree::prove(size_t index) const {
+    if (index >= size()) {
+        throw std::out_of_range("Merkle proof index out of range");
+    }
+
+    MerkleProof proof;
+    proof.leaf_index = index;
+    proof.leaf_count = size();
+    for (size_t level = 0; level + 1 < levels.size(); ++level) {
+        const std::vector<Hash256>& nodes = levels[level];
+        size_t sibling = index ^ 1;
+        proof.siblings.push_back(sibling < nodes.size() ? nodes[sibling] : nodes[index]);
+        index /= 2;
+    }
+    return proof;
+}
+
+bool MerkleTree::verify(const Hash256& leaf_hash, const MerkleProof& proof, const Hash256& root) {
+    if (proof.leaf_index >= proof.leaf_count) {
+        return false;
+    }
+
+    size_t expected_depth = 0;
+    for (size_t width = proof.leaf_count; width > 1; width = (width + 1) / 2) {
+        ++expected_depth;
+    }
+    if (proof.siblings.size() != expected_depth) {
+        return false;
+    }
+
+    Hash256 current = leaf_hash;
+    size_t index = proof.leaf_index;
+    for (const Hash256& sibling : proof.siblings) {
+        current = (index & 1) ? hash_node(sibling, current) : hash_node(current, sibling);
+        index /= 2;
+    }
+    return current == root;
+}
@@ -0,0 +1,220 @@
+#include "ledger/state_db.hpp"
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+const size_t PARALLEL_EXECUTION_THRESHOLD = 64;  // Smaller blocks are executed on the calling thread.
+
+AccountState StateSnapshot::get(const std::string& address) const {
+    const Shard& shard = *shards[shard_of(address)];
+    auto it = shard.find(address);
+    return it == shard.end() ? AccountState{ 0.0, 0 } : it->second;
+}
+
+size_t StateSnapshot::account_count() const {
+    size_t count = 0;
+    for (const auto& shard : shards) {
+        count += shard->size();
+    }
+    return count;
+}
+
+std::vector<AccountEntry> StateSnapshot::entries() const {
+    std::vector<AccountEntry> accounts;
+    accounts.reserve(account_count());
+    for (const auto& shard : shards) {
+        accounts.insert(accounts.end(), shard->begin(), shard->end());
+    }
+    std::sort(accounts.begin(), accounts.end(),
+              [](const AccountEntry& a, const AccountEntry& b) { return a.first < b.first; });
+    return accounts;
+}
+
+size_t StateSnapshot::shard_of(std::string_view address) const {
+    return std::hash<std::string_view>()(address) % shards.size();
+}
+
+StateDB::StateDB(size_t shard_count, int num_threads)
+    : shard_count(shard_count > 0 ? shard_count : 1), num_threads(num_threads) {
+    auto initial = std::make_shared<StateSnapshot>();
+    auto empty_shard = std::make_shared<const StateSnapshot::Shard>();
+    initial->shards.assign(this->shard_count, empty_shard);
+    initial->version = 0;
+    current = initial;
+}
+
+std::shared_ptr<const StateSnapshot> StateDB::snapshot() const {
+    std::lock_guard<std::mutex> lock(snapshot_mutex);
+    return current;
+}
+
+AccountState StateDB::get_account(const std::string& address) const {
+    return snapshot()->get(address);
+}
+
+uint64_t StateDB::get_version() const {
+    return snapshot()->get_version();
+}
+
+ExecutionStats StateDB::apply_block(const Block& block) {
+    std::vector<StateTransfer> transfers;
+    transfers.reserve(block.get_transactions().size());
+    for (TransactionRef tx : block.get_transactions()) {
+        transfers.push_back(StateTransfer{ tx.sender, tx.receiver, tx.amount });
+    }
+    return execute(transfers);
+}
+
+ExecutionStats StateDB::apply_block(const BlockView& block) {
+    std::vector<StateTransfer> transfers;
+    transfers.reserve(block.transactions.size());
+    for (const TransactionView& tx : block.transactions) {
+        transfers.push_back(StateTransfer{ tx.sender, tx.receiver, tx.amount });
+    }
+    return execute(transfers);
+}
+
+ExecutionStats StateDB::apply_transfers(const std::vector<StateTransfer>& transfers) {
+    return execute(transfers);
+}
+
+void StateDB::restore(const std::shared_ptr<const StateSnapshot>& snapshot) {
+    std::lock_guard<std::mutex> write_lock(write_mutex);
+    std::lock_guard<std::mutex> lock(snapshot_mutex);
+    current = snapshot;
+}
+
+void StateDB::load(const std::vector<AccountEntry>& accounts, uint64_t version) {
+    auto next = std::make_shared<StateSnapshot>();
+    next->version = version;
+    next->shards.resize(shard_count);
+    std::vector<std::shared_ptr<StateSnapshot::Shard>> shards(shard_count);
+    for (auto& shard : shards) {
+        shard = std::make_shared<StateSnapshot::Shard>();
+    }
+    for (const AccountEntry& account : accounts) {
+        if (!shards[next->shard_of(account.first)]->emplace(account).second) {
+            throw std::invalid_argument("Account " + account.first + " appears twice in the loaded state");
+        }
+    }
+    for (size_t shard = 0; shard < shard_count; ++shard) {
+        next->shards[shard] = shards[shard];
+    }
+    restore(next);
+}
+
+// Applies one transfer on top of the given sender and receiver states.
+static void apply_transfer(const StateTransfer& transfer, AccountState& sender, AccountState& receiver) {
+    if (transfer.sender == transfer.receiver) {
+        sender.nonce++;
+        receiver = sender;
+        return;
+    }
+    sender.balance -= transfer.amount;
+    sender.nonce++;
+    receiver.balance += transfer.amount;
+}
+
+ExecutionStats StateDB::execute(const std::vector<StateTransfer>& transfers) {
+    std::lock_guard<std::mutex> lock(write_mutex);
+    std::shared_ptr<const StateSnapshot> base = snapshot();
+
+    // Phase 1: execute every transaction speculatively against the pre-block state.
+    struct Speculation {
+        AccountState sender;
+        AccountState receiver;
+    };
+    std::vector<Speculation> speculative(transfers.size());
+    const long count = static_cast<long>(transfers.size());
+#ifdef _OPENMP
+    const int threads = num_threads > 0 ? num_threads : omp_get_max_threads();
+#else
+    const int threads = 1;
+#endif
+
+    #pragma omp parallel for schedule(static) num_threads(threads) if(transfers.size() >= PARALLEL_EXECUTION_THRESHOLD)
+    for (long i = 0; i < count; ++i) {
+        const StateTransfer& transfer = transfers[i];
+        Speculation& result = speculative[i];
+        result.sender = base->get(std::string(transfer.sender));
+        result.receiver = base->get(std::string(transfer.receiver));
+        apply_transfer(transfer, result.sender, result.receiver);
+    }
+
+    // Phase 2: commit in block order; a transaction whose accounts an earlier one wrote read stale state.
+    ExecutionStats stats{ transfers.size(), 0 };
+    std::unordered_map<std::string_view, AccountState> writes;
+    writes.reserve(transfers.size() * 2);
+    for (size_t i = 0; i < transfers.size(); ++i) {
+        const StateTransfer& transfer = transfers[i];
+        auto sender_it = writes.find(transfer.sender);
+        auto receiver_it = writes.find(transfer.receiver);
+        AccountState sender = speculative[i].sender;
+        AccountState receiver = speculative[i].receiver;
+
+        if (sender_it != writes.end() || receiver_it != writes.end()) {
+            sender = sender_it != writes.end() ? sender_it->second : base->get(std::string(transfer.sender));
+            receiver = receiver_it != writes.end() ? receiver_it->second : base->get(std::string(transfer.receiver));
+            apply_transfer(transfer, sender, receiver);
+            stats.reexecuted++;
+        }
+
+        writes[transfer.sender] = sender;
+        writes[transfer.receiver] = receiver;
+    }
+
+    publish(base, writes, base->get_version() + 1);
+    return stats;
+}
+
+void StateDB::revert_block(const Block& block) {
+    std::lock_guard<std::mutex> lock(write_mutex);
+    std::shared_ptr<const StateSnapshot> base = snapshot();
+
+    std::unordered_map<std::string_view, AccountState> writes;
+    const TransactionArena& txs = block.get_transactions();
+    for (size_t i = txs.size(); i-- > 0;) {
+        const TransactionRef tx = txs[i];
+        auto sender_it = writes.find(tx.sender);
+        AccountState sender = sender_it != writes.end() ? sender_it->second : base->get(std::string(tx.sender));
+        sender.nonce--;
+        if (tx.sender != tx.receiver) {
+            auto receiver_it = writes.find(tx.receiver);
+            AccountState receiver = receiver_it != writes.end() ? receiver_it->second : base->get(std::string(tx.receiver));
+            sender.balance += tx.amount;
+            receiver.balance -= tx.amount;
+            writes[tx.receiver] = receiver;
+        }
+        writes[tx.sender] = sender;
+    }
+
+    publish(base, writes, base->get_version() > 0 ? base->get_version() - 1 : 0);
+}
+
+void StateDB::publish(const std::shared_ptr<const StateSnapshot>& base,
+                      const std::unordered_map<std::string_view, AccountState>& writes, uint64_t version) {
+    auto next = std::make_shared<StateSnapshot>();
+    next->shards = base->shards;
+    next->version = version;
+
+    // Copy each touched shard once; untouched shards stay shared with older snapshots.
+    std::vector<std::shared_ptr<StateSnapshot::Shard>> copies(shard_count);
+    for (const auto& [address, state] : writes) {
+        size_t shard = next->shard_of(address);
+        if (!copies[shard]) {
+            copies[shard] = std::make_shared<StateSnapshot::Shard>(*base->shards[shard]);
+        }
+        (*copies[shard])[std::string(address)] = state;
+    }
+    for (size_t shard = 0; shard < shard_count; ++shard) {
+        if (copies[shard]) {
+            next->shards[shard] = copies[shard];
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(snapshot_mutex);
+    current = next;
+}
@@ -0,0 +1,284 @@
+#include "ledger/wire_format.hpp"
+#include "cryptography/hash256.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <limits>
+
+// Smallest encodings of a block's records, used to bound counts read from untrusted input before reserving.
+const size_t MIN_ENCODED_SIGNATURE = 2;     // u16 length prefix of an empty signature.
+const size_t MIN_ENCODED_TRANSACTION = 25;  // u32 prefix, version, type, amount, two empty str16, empty packed, str32.
+
+// Only lowercase hex is packed, so that decoding restores the exact original text.
+static bool is_lower_hex(std::string_view value) {
+    if (value.empty() || value.size() % 2 != 0) {
+        return false;
+    }
+    for (char c : value) {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ByteWriter::put_u8(uint8_t value) {
+    out.push_back(static_cast<char>(value));
+}
+
+void ByteWriter::put_u16(uint16_t value) {
+    char bytes[2] = { static_cast<char>(value), static_cast<char>(value >> 8) };
+    out.append(bytes, sizeof(bytes));
+}
+
+void ByteWriter::put_u32(uint32_t value) {
+    char bytes[4];
+    for (int i = 0; i < 4; ++i) {
+        bytes[i] = static_cast<char>(value >> (8 * i));
+    }
+    out.append(bytes, sizeof(bytes));
+}
+
+void ByteWriter::put_u64(uint64_t value) {
+    char bytes[8];
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<char>(value >> (8 * i));
+    }
+    out.append(bytes, sizeof(bytes));
+}
+
+void ByteWriter::put_f64(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    put_u64(bits);
+}
+
+void ByteWriter::put_bytes(const void* data, size_t size) {
+    out.append(static_cast<const char*>(data), size);
+}
+
+void ByteWriter::put_str16(std::string_view value) {
+    if (value.size() > std::numeric_limits<uint16_t>::max()) {
+        throw std::invalid_argument("Field too long for 16-bit length prefix");
+    }
+    put_u16(static_cast<uint16_t>(value.size()));
+    put_bytes(value.data(), value.size());
+}
+
+void ByteWriter::put_str32(std::string_view value) {
+    if (value.size() > std::numeric_limits<uint32_t>::max()) {
+        throw std::invalid_argument("Field too long for 32-bit length prefix");
+    }
+    put_u32(static_cast<uint32_t>(value.size()));
+    put_bytes(value.data(), value.size());
+}
+
+void ByteWriter::put_packed(std::string_view value) {
+    if (!is_lower_hex(value)) {
+        put_u8(PACKED_OPAQUE);
+        put_str16(value);
+        return;
+    }
+
+    size_t raw_len = value.size() / 2;
+    if (raw_len == 32) {
+        put_u8(PACKED_DIGEST);
+    } else {
+        if (raw_len > std::numeric_limits<uint16_t>::max()) {
+            throw std::invalid_argument("Packed field too long");
+        }
+        put_u8(PACKED_HEX);
+        put_u16(static_cast<uint16_t>(raw_len));
+    }
+
+    size_t offset = out.size();
+    out.resize(offset + raw_len);
+    Hex::decode(value, reinterpret_cast<uint8_t*>(&out[offset]), raw_len);
+}
+
+void ByteWriter::patch_u32(size_t offset, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[offset + i] = static_cast<char>(value >> (8 * i));
+    }
+}
+
+std::string PackedField::to_string() const {
+    if (tag == PACKED_OPAQUE) {
+        return std::string(bytes);
+    }
+
+    return Hex::encode(bytes.data(), bytes.size());
+}
+
+void ByteReader::require(size_t count) const {
+    if (count > size - pos) {
+        throw std::runtime_error("Truncated wire buffer");
+    }
+}
+
+uint8_t ByteReader::get_u8() {
+    require(1);
+    return static_cast<uint8_t>(data[pos++]);
+}
+
+uint16_t ByteReader::get_u16() {
+    require(2);
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data + pos);
+    pos += 2;
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t ByteReader::get_u32() {
+    require(4);
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data + pos);
+    pos += 4;
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+uint64_t ByteReader::get_u64() {
+    require(8);
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data + pos);
+    pos += 8;
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+double ByteReader::get_f64() {
+    uint64_t bits = get_u64();
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+std::string_view ByteReader::get_bytes(size_t count) {
+    require(count);
+    std::string_view view(data + pos, count);
+    pos += count;
+    return view;
+}
+
+std::string_view ByteReader::view_from(size_t start) const {
+    return std::string_view(data + start, pos - start);
+}
+
+std::string_view ByteReader::get_str16() {
+    return get_bytes(get_u16());
+}
+
+std::string_view ByteReader::get_str32() {
+    return get_bytes(get_u32());
+}
+
+PackedField ByteReader::get_packed() {
+    PackedField field;
+    field.tag = get_u8();
+    switch (field.tag) {
+        case PACKED_DIGEST:
+            field.bytes = get_bytes(32);
+            break;
+        case PACKED_HEX:
+            field.bytes = get_str16();
+            if (field.bytes.empty() || field.bytes.size() == 32) {
+                throw std::runtime_error("Non-canonical packed hex field");
+            }
+            break;
+        case PACKED_OPAQUE:
+            field.bytes = get_str16();
+            if (is_lower_hex(field.bytes)) {
+                throw std::runtime_error("Non-canonical packed opaque field");
+            }
+            break;
+        default:
+            throw std::runtime_error("Unknown packed field tag");
+    }
+    return field;
+}
+
+TransactionView TransactionView::decode(ByteReader& reader) {
+    size_t start = reader.position();
+    if (reader.get_u8() != WIRE_FORMAT_VERSION) {
+        throw std::runtime_error("Unsupported transaction wire format version");
+    }
+
+    TransactionView view;
+    uint8_t type = reader.get_u8();
+    if (type > static_cast<uint8_t>(TransactionType::SMART_CONTRACT_EXECUTION)) {
+        throw std::runtime_error("Unknown transaction type");
+    }
+    view.type = static_cast<TransactionType>(type);
+    view.amount = reader.get_f64();
+    view.sender = reader.get_str16();
+    view.receiver = reader.get_str16();
+    view.signature = reader.get_packed();
+    view.data = reader.get_str32();
+    view.encoded = reader.view_from(start);
+    return view;
+}
+
+Transaction TransactionView::to_transaction() const {
+    return Transaction(std::string(sender), std::string(receiver), amount, signature.to_string(), type, std::string(data));
+}
+
+BlockView BlockView::decode(std::string_view buffer) {
+    ByteReader reader(buffer);
+    if (reader.get_u8() != WIRE_FORMAT_VERSION) {
+        throw std::runtime_error("Unsupported block wire format version");
+    }
+
+    BlockView view;
+    view.block_number = static_cast<size_t>(reader.get_u64());
+    view.timestamp = static_cast<std::time_t>(static_cast<int64_t>(reader.get_u64()));
+    view.required_signatures = static_cast<size_t>(reader.get_u64());
+    view.previous_block_hash = reader.get_packed();
+    view.merkle_root = reader.get_bytes(Hash256::SIZE);
+
+    uint32_t signature_count = reader.get_u32();
+    if (signature_count > reader.remaining() / MIN_ENCODED_SIGNATURE) {
+        throw std::runtime_error("Block declares more validator signatures than it holds");
+    }
+    view.validator_signatures.reserve(signature_count);
+    for (uint32_t i = 0; i < signature_count; ++i) {
+        view.validator_signatures.push_back(reader.get_str16());
+    }
+
+    uint32_t transaction_count = reader.get_u32();
+    if (transaction_count > reader.remaining() / MIN_ENCODED_TRANSACTION) {
+        throw std::runtime_error("Block declares more transactions than it holds");
+    }
+    view.transactions.reserve(transaction_count);
+    for (uint32_t i = 0; i < transaction_count; ++i) {
+        std::string_view encoded = reader.get_str32();
+        ByteReader tx_reader(encoded);
+        view.transactions.push_back(TransactionView::decode(tx_reader));
+        if (tx_reader.remaining() != 0) {
+            throw std::runtime_error("Trailing bytes in encoded transaction");
+        }
+    }
+
+    if (reader.remaining() != 0) {
+        throw std::runtime_error("Trailing bytes in encoded block");
+    }
+    return view;
+}
+
+void encode_transaction(ByteWriter& writer, const TransactionRef& tx) {
+    writer.put_u8(WIRE_FORMAT_VERSION);
+    writer.put_u8(static_cast<uint8_t>(tx.type));
+    writer.put_f64(tx.amount);
+    writer.put_str16(tx.sender);
+    writer.put_str16(tx.receiver);
+    writer.put_packed(tx.signature);
+    writer.put_str32(tx.data);
+}
+
+Hash256 BlockView::compute_digest() const {
+    Hash256 root;
+    std::memcpy(root.bytes.data(), merkle_root.data(), Hash256::SIZE);
+    return Block::compute_header_digest(block_number, previous_block_hash.to_string(), timestamp, transactions.size(), root);
+}
@@ -0,0 +1,224 @@
+#include "logging/logger.hpp"
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+const int Logger::WRITER_INTERVAL_MS;
+
+// Marks its ring retired when the owning thread exits, so the writer can drop it once drained.
+struct RingHolder {
+    std::shared_ptr<LogRing> ring;
+
+    ~RingHolder() {
+        if (ring) {
+            ring->retired.store(true, std::memory_order_release);
+        }
+    }
+};
+
+static const char* level_name(LogLevel level) {
+    switch (level) {
+    case LogLevel::DEBUG: return "DEBUG";
+    case LogLevel::INFO: return "INFO ";
+    case LogLevel::WARN: return "WARN ";
+    case LogLevel::ERROR: return "ERROR";
+    }
+    return "?    ";
+}
+
+LogRecord* LogRing::reserve() {
+    const size_t position = head.load(std::memory_order_relaxed);
+    if (position - tail.load(std::memory_order_acquire) >= LOG_RING_CAPACITY) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return &records[position % LOG_RING_CAPACITY];
+}
+
+void LogRing::commit() {
+    head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+size_t LogRing::drain(std::vector<LogRecord>& out) {
+    const size_t end = head.load(std::memory_order_acquire);
+    size_t position = tail.load(std::memory_order_relaxed);
+    for (; position != end; ++position) {
+        out.push_back(records[position % LOG_RING_CAPACITY]);
+    }
+    tail.store(position, std::memory_order_release);
+    return dropped.exchange(0, std::memory_order_relaxed);
+}
+
+bool LogRing::is_empty() const {
+    return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+}
+
+Logger::Logger() : output(&std::cout), stopping(false) {
+    writer = std::thread([this] { run_writer(); });
+}
+
+Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    writer.join();
+    flush();
+}
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+LogRing& Logger::thread_ring() {
+    thread_local RingHolder holder;
+    if (!holder.ring) {
+        holder.ring = std::make_shared<LogRing>();
+        std::lock_guard<std::mutex> lock(rings_mutex);
+        rings.push_back(holder.ring);
+    }
+    return *holder.ring;
+}
+
+void Logger::flush() {
+    while (drain_once()) {
+    }
+}
+
+void Logger::set_output(std::ostream& stream) {
+    flush();
+    std::lock_guard<std::mutex> lock(drain_mutex);
+    output = &stream;
+}
+
+void Logger::run_writer() {
+    std::unique_lock<std::mutex> lock(wake_mutex);
+    while (!stopping) {
+        lock.unlock();
+        bool wrote = drain_once();
+        lock.lock();
+        if (!wrote) {
+            wake.wait_for(lock, std::chrono::milliseconds(WRITER_INTERVAL_MS), [this] { return stopping; });
+        }
+    }
+}
+
+bool Logger::drain_once() {
+    std::lock_guard<std::mutex> lock(drain_mutex);
+    std::vector<std::shared_ptr<LogRing>> current;
+    {
+        std::lock_guard<std::mutex> rings_lock(rings_mutex);
+        // A retired ring can receive nothing more, so it is dropped once it has been drained.
+        rings.erase(std::remove_if(rings.begin(), rings.end(),
+                                   [](const std::shared_ptr<LogRing>& ring) {
+                                       return ring->retired.load(std::memory_order_acquire) && ring->is_empty();
+                                   }),
+                    rings.end());
+        current = rings;
+    }
+
+    batch.clear();
+    size_t dropped = 0;
+    for (const auto& ring : current) {
+        dropped += ring->drain(batch);
+    }
+    if (batch.empty() && dropped == 0) {
+        return false;
+    }
+
+    // Rings are drained one after another; restore the order in which messages were logged.
+    std::stable_sort(batch.begin(), batch.end(),
+                     [](const LogRecord& a, const LogRecord& b) { return a.timestamp_us < b.timestamp_us; });
+
+    std::string text;
+    char prefix[64];
+    for (const LogRecord& record : batch) {
+        const std::time_t seconds = static_cast<std::time_t>(record.timestamp_us / 1000000);
+        std::tm utc;
+        gmtime_r(&seconds, &utc);
+        size_t length = std::strftime(prefix, sizeof(prefix), "%Y-%m-%d %H:%M:%S", &utc);
+        std::snprintf(prefix + length, sizeof(prefix) - length, ".%06lld ",
+                      static_cast<long long>(record.timestamp_us % 1000000));
+        text += prefix;
+        text += level_name(record.level);
+        text += ' ';
+        text += record.component;
+        text += ": ";
+        text.append(record.text, record.length);
+        if (record.suppressed > 0) {
+            text += " (" + std::to_string(record.suppressed) + " similar messages suppressed)";
+        }
+        text += '\n';
+    }
+    if (dropped > 0) {
+        text += "WARN  logging: " + std::to_string(dropped) + " records dropped, log rings were full\n";
+    }
+    output->write(text.data(), static_cast<std::streamsize>(text.size()));
+    output->flush();
+    return true;
+}
+
+bool RateLimiter::allow() {
+    const int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t start = window_start.load(std::memory_order_relaxed);
+    if (now - start >= 1000 && window_start.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+        used.store(0, std::memory_order_relaxed);
+    }
+    if (used.fetch_add(1, std::memory_order_relaxed) < per_second) {
+        return true;
+    }
+    suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+LogLine::LogLine(LogLevel level, const char* component, uint32_t suppressed)
+    : record(Logger::instance().thread_ring().reserve()) {
+    if (record) {
+        record->timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        record->component = component;
+        record->suppressed = suppressed;
+        record->length = 0;
+        record->level = level;
+    }
+}
+
+LogLine::~LogLine() {
+    if (record) {
+        Logger::instance().thread_ring().commit();
+    }
+}
+
+LogLine& LogLine::operator<<(std::string_view text) {
+    if (record) {
+        const size_t room = LOG_MESSAGE_CAPACITY - record->length;
+        const size_t count = std::min(room, text.size());
+        std::memcpy(record->text + record->length, text.data(), count);
+        record->length = static_cast<uint16_t>(record->length + count);
+    }
+    return *this;
+}
+
+LogLine& LogLine::operator<<(double value) {
+    char digits[32];
+    int length = std::snprintf(digits, sizeof(digits), "%g", value);
+    return *this << std::string_view(digits, static_cast<size_t>(std::max(length, 0)));
+}
+
+LogLine& LogLine::append_signed(long long value) {
+    char digits[24];
+    int length = std::snprintf(digits, sizeof(digits), "%lld", value);
+    return *this << std::string_view(digits, static_cast<size_t>(length));
+}
+
+LogLine& LogLine::append_unsigned(unsigned long long value) {
+    char digits[24];
+    int length = std::snprintf(digits, sizeof(digits), "%llu", value);
+    return *this << std::string_view(digits, static_cast<size_t>(length));
+}
@@ -1,23 +1,41 @@
 #include "network/p2p_protocol.hpp"
 #include "network/node_discovery.hpp"
 #include "consensus/posyg_engine.hpp"
+#include "consensus/fast_sync.hpp"
 #include "ledger/ledger.hpp"
 #include "governance/governance.hpp"
 #include "subnet/subnet_manager.hpp"
+#include "network/gossip.hpp"
+#include "logging/logger.hpp"
+#include "metrics/metrics.hpp"
 #include <iostream>
+#include <stdexcept>
 #include <thread>
 #include <chrono>
+#include <mutex>
+#include <filesystem>
+#include <cstdlib>
+
+const int METRICS_PORT_OFFSET = 1000;  // The metrics endpoint listens on the P2P port plus this offset.
 
 int main(int argc, char* argv[]) {
     size_t node_id = 1;
     int port = 8080;
+    std::string data_dir;
+    std::string bootstrap;
 
     // Handle command-line arguments
     if (argc > 2) {
         node_id = std::stoul(argv[1]);
         port = std::stoi(argv[2]);
+        if (argc > 3) {
+            data_dir = argv[3];
+        }
+        if (argc > 4) {
+            bootstrap = argv[4];
+        }
     } else {
-        std::cerr << "Usage: " << argv[0] << " <node_id> <port>" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " <node_id> <port> [data_dir] [bootstrap_id@ip:port]" << std::endl;
         return 1;
     }
 
@@ -30,16 +48,37 @@ int main(int argc, char* argv[]) {
         P2PProtocol p2p_protocol(node_id, network_address);
         p2p_protocol.initialize(port);
 
-        // Initialize Node Discovery
+        // Serve metrics for scraping; SYNLEDGER_TRACE=1 also records trace spans, read from /trace
+        const char* trace = std::getenv("SYNLEDGER_TRACE");
+        MetricsRegistry::instance().set_tracing(trace && std::string(trace) == "1");
+        MetricsServer metrics_server;
+        metrics_server.start(port + METRICS_PORT_OFFSET);
+        LOG_INFO("node") << "Metrics available at http://" << network_address << ":" << metrics_server.get_port()
+                         << "/metrics";
+
+        // Initialize Node Discovery on the UDP port matching the P2P port; peers found earlier are reused
         NodeDiscovery node_discovery(node_id, network_address);
+        node_discovery.initialize(port);
+        if (!data_dir.empty()) {
+            node_discovery.set_peer_cache((std::filesystem::path(data_dir) / "peers.cache").string());
+        }
+        if (!bootstrap.empty()) {
+            size_t at = bootstrap.find('@');
+            if (at == std::string::npos) {
+                throw std::invalid_argument("Bootstrap node must be given as <id>@<ip>:<port>");
+            }
+            node_discovery.add_node(std::stoul(bootstrap.substr(0, at)), bootstrap.substr(at + 1));
+        }
         node_discovery.discover_nodes();
+
+        // Connect to the fastest peers first
         for (size_t known_node_id : node_discovery.get_known_nodes()) {
             p2p_protocol.add_peer(known_node_id, node_discovery.get_node_address(known_node_id));
         }
 
-        // Initialize Ledger
+        // Initialize Ledger (persisted and resumed from data_dir when one is given)
         size_t initial_difficulty = 3;
-        Ledger ledger(initial_difficulty);
+        Ledger ledger(initial_difficulty, data_dir);
 
         // Initialize Governance
         Governance governance(posyg_engine);
@@ -48,16 +87,47 @@ int main(int argc, char* argv[]) {
         SubnetManager subnet_manager(5);
         subnet_manager.assign_node_to_subnet(node_id);
 
+        // Periodic state snapshots; their chunks are served by content hash to nodes that fast-sync
+        SnapshotStore snapshot_store;
+
+        // Initialize gossip: blocks and transactions received from peers are applied to the ledger
+        std::mutex ledger_mutex;
+        Gossip gossip(p2p_protocol, node_id, subnet_manager);
+        gossip.set_item_handler([&](InventoryType type, const Hash256&, const std::string& payload) {
+            std::lock_guard<std::mutex> lock(ledger_mutex);
+            try {
+                if (type == InventoryType::BLOCK) {
+                    ledger.add_block(Block::deserialize(payload));
+                    return true;
+                }
+                return ledger.add_transaction(Transaction::deserialize(payload));
+            } catch (const std::exception& e) {
+                LOG_WARN_LIMITED("node", 10) << "Rejected gossiped item: " << e.what();
+                return false;
+            }
+        });
+        gossip.set_mempool_matcher([&](PartialBlock& block) {
+            std::lock_guard<std::mutex> lock(ledger_mutex);
+            block.fill_from(ledger.get_pending_transactions());
+        });
+        p2p_protocol.set_message_handler([&](const std::string&, const std::string& message) {
+            gossip.handle_message(message);
+        });
+
         // Main loop for node operation
         while (true) {
             // Run consensus cycle
             posyg_engine.run_cycle();
 
             // Generate a new block
-            Block new_block = ledger.get_latest_block();
-            if (ledger.validate_chain()) {
-                ledger.add_block(new_block);
-                p2p_protocol.send_message(2, "New block added to the chain: " + new_block.get_block_hash());
+            {
+                std::lock_guard<std::mutex> lock(ledger_mutex);
+                Block new_block = ledger.get_latest_block();
+                if (ledger.validate_chain()) {
+                    ledger.add_block(new_block);
+                    gossip.broadcast(InventoryType::BLOCK, new_block.get_block_digest(), new_block.serialize());
+                }
+                snapshot_store.maybe_snapshot(ledger, posyg_engine, subnet_manager);
             }
 
             // Governance process example
@@ -66,7 +136,10 @@ int main(int argc, char* argv[]) {
             governance.finalize_proposal(1);
 
             // Log the state of the chain
-            ledger.log_chain_state();
+            {
+                std::lock_guard<std::mutex> lock(ledger_mutex);
+                ledger.log_chain_state();
+            }
 
             // Perform subnet rebalancing periodically
             subnet_manager.rebalance_subnets();
@@ -76,7 +149,8 @@ int main(int argc, char* argv[]) {
         }
 
     } catch (const std::exception& e) {
-        std::cerr << "Error: " << e.what() << std::endl;
+        LOG_ERROR("node") << "Error: " << e.what();
+        Logger::instance().flush();
         return 1;
     }
 
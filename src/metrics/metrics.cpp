@@ -0,0 +1,370 @@
+#include "metrics/metrics.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+const int Histogram::SUB_BUCKET_BITS;
+const size_t Histogram::BUCKET_COUNT;
+const size_t MetricsRegistry::MAX_TRACE_SPANS;
+const int MetricsServer::POLL_INTERVAL_MS;
+
+// Quantiles exported for every histogram.
+static const double EXPORTED_QUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+
+// Largest request accepted by the metrics server; scrapers send a few hundred bytes.
+static const size_t MAX_REQUEST_BYTES = 4096;
+
+static std::string format_value(double value) {
+    char digits[32];
+    std::snprintf(digits, sizeof(digits), "%.9g", value);
+    return digits;
+}
+
+size_t metric_shard() {
+    static std::atomic<size_t> next_shard{ 0 };
+    thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+    return shard;
+}
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+size_t Histogram::bucket_of(uint64_t value) {
+    const uint64_t sub_buckets = uint64_t(1) << SUB_BUCKET_BITS;
+    if (value < sub_buckets) {
+        return static_cast<size_t>(value);
+    }
+    const int exponent = 63 - __builtin_clzll(value);
+    const uint64_t mantissa = (value >> (exponent - SUB_BUCKET_BITS)) & (sub_buckets - 1);
+    return (static_cast<size_t>(exponent - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) + static_cast<size_t>(mantissa);
+}
+
+uint64_t Histogram::bucket_lower(size_t bucket) {
+    const size_t sub_buckets = size_t(1) << SUB_BUCKET_BITS;
+    if (bucket < sub_buckets) {
+        return bucket;
+    }
+    const int exponent = static_cast<int>(bucket >> SUB_BUCKET_BITS) + SUB_BUCKET_BITS - 1;
+    const uint64_t mantissa = bucket & (sub_buckets - 1);
+    return (sub_buckets + mantissa) << (exponent - SUB_BUCKET_BITS);
+}
+
+Histogram::Histogram(std::string name, double scale)
+    : name(std::move(name)), scale(scale), shards(new Shard[METRIC_SHARDS]) {}
+
+void Histogram::record(uint64_t value) {
+    Shard& shard = shards[metric_shard()];
+    shard.buckets[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+    shard.count.fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+HistogramSnapshot Histogram::snapshot() const {
+    HistogramSnapshot merged;
+    merged.buckets.assign(BUCKET_COUNT, 0);
+    for (size_t s = 0; s < METRIC_SHARDS; ++s) {
+        const Shard& shard = shards[s];
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            merged.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+        }
+        merged.count += shard.count.load(std::memory_order_relaxed);
+        merged.sum += shard.sum.load(std::memory_order_relaxed);
+    }
+    return merged;
+}
+
+double HistogramSnapshot::quantile(double q) const {
+    // Shards are read one after another, so recount rather than trust `count` to match the buckets.
+    uint64_t total = 0;
+    for (uint64_t n : buckets) {
+        total += n;
+    }
+    if (total == 0) {
+        return 0.0;
+    }
+    const double clamped = std::min(std::max(q, 0.0), 1.0);
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(clamped * static_cast<double>(total) + 0.5));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            const double lower = static_cast<double>(Histogram::bucket_lower(i));
+            const double upper = i + 1 < Histogram::BUCKET_COUNT
+                ? static_cast<double>(Histogram::bucket_lower(i + 1)) : 18446744073709551615.0;
+            return (lower + upper - 1.0) / 2.0;
+        }
+    }
+    return static_cast<double>(Histogram::bucket_lower(buckets.size() - 1));
+}
+
+void MetricsWriter::sample(const std::string& name, const std::string& type, const std::string& help,
+                           const std::string& labels, double value) {
+    Family& family = families[name];
+    family.type = type;
+    family.help = help;
+    family.lines.push_back(name + (labels.empty() ? "" : "{" + labels + "}") + " " + format_value(value));
+}
+
+void MetricsWriter::summary(const std::string& name, const std::string& help, const HistogramSnapshot& snapshot,
+                            double scale) {
+    Family& family = families[name];
+    family.type = "summary";
+    family.help = help;
+    for (double q : EXPORTED_QUANTILES) {
+        family.lines.push_back(name + "{quantile=\"" + format_value(q) + "\"} " +
+                               format_value(snapshot.quantile(q) * scale));
+    }
+    family.lines.push_back(name + "_sum " + format_value(static_cast<double>(snapshot.sum) * scale));
+    family.lines.push_back(name + "_count " + std::to_string(snapshot.count));
+}
+
+std::string MetricsWriter::render() const {
+    std::string text;
+    for (const auto& [name, family] : families) {
+        text += "# HELP " + name + " " + family.help + "\n";
+        text += "# TYPE " + name + " " + family.type + "\n";
+        for (const auto& line : family.lines) {
+            text += line;
+            text += '\n';
+        }
+    }
+    return text;
+}
+
+MetricsRegistry::MetricsRegistry() : next_collector(1), tracing(false) {}
+
+MetricsRegistry& MetricsRegistry::instance() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::Entry& MetricsRegistry::entry(const std::string& name, const std::string& help) {
+    Entry& found = entries[name];
+    if (found.help.empty()) {
+        found.help = help;
+    }
+    return found;
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    Entry& found = entry(name, help);
+    if (found.gauge || found.histogram) {
+        throw std::invalid_argument("Metric " + name + " is not a counter");
+    }
+    if (!found.counter) {
+        found.counter = std::make_unique<Counter>();
+    }
+    return *found.counter;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    Entry& found = entry(name, help);
+    if (found.counter || found.histogram) {
+        throw std::invalid_argument("Metric " + name + " is not a gauge");
+    }
+    if (!found.gauge) {
+        found.gauge = std::make_unique<Gauge>();
+    }
+    return *found.gauge;
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help, double scale) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    Entry& found = entry(name, help);
+    if (found.counter || found.gauge) {
+        throw std::invalid_argument("Metric " + name + " is not a histogram");
+    }
+    if (!found.histogram) {
+        found.histogram = std::make_unique<Histogram>(name, scale);
+    }
+    return *found.histogram;
+}
+
+size_t MetricsRegistry::add_collector(MetricsCollector collector) {
+    std::lock_guard<std::mutex> lock(collector_mutex);
+    const size_t handle = next_collector++;
+    collectors[handle] = std::move(collector);
+    return handle;
+}
+
+void MetricsRegistry::remove_collector(size_t handle) {
+    // Collectors run under this lock, so taking it waits for a scrape in progress.
+    std::lock_guard<std::mutex> lock(collector_mutex);
+    collectors.erase(handle);
+}
+
+std::string MetricsRegistry::render_prometheus() const {
+    MetricsWriter writer;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        for (const auto& [name, found] : entries) {
+            if (found.counter) {
+                writer.sample(name, "counter", found.help, "", static_cast<double>(found.counter->value()));
+            } else if (found.gauge) {
+                writer.sample(name, "gauge", found.help, "", static_cast<double>(found.gauge->value()));
+            } else if (found.histogram) {
+                writer.summary(name, found.help, found.histogram->snapshot(), found.histogram->get_scale());
+            }
+        }
+    }
+    std::lock_guard<std::mutex> lock(collector_mutex);
+    for (const auto& [handle, collector] : collectors) {
+        collector(writer);
+    }
+    return writer.render();
+}
+
+void MetricsRegistry::record_span(const TraceSpan& span) {
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    if (spans.size() >= MAX_TRACE_SPANS) {
+        spans.erase(spans.begin(), spans.begin() + static_cast<std::ptrdiff_t>(MAX_TRACE_SPANS / 2));
+    }
+    spans.push_back(span);
+}
+
+std::string MetricsRegistry::take_trace() {
+    std::vector<TraceSpan> taken;
+    {
+        std::lock_guard<std::mutex> lock(trace_mutex);
+        taken.swap(spans);
+    }
+
+    std::string json = "{\"traceEvents\":[";
+    char event[96];
+    for (size_t i = 0; i < taken.size(); ++i) {
+        const TraceSpan& span = taken[i];
+        json += i == 0 ? "" : ",";
+        json += "{\"name\":\"" + *span.name + "\",\"ph\":\"X\",\"pid\":1";
+        std::snprintf(event, sizeof(event), ",\"tid\":%llu,\"ts\":%.3f,\"dur\":%.3f}",
+                      static_cast<unsigned long long>(span.thread), static_cast<double>(span.start_ns) / 1000.0,
+                      static_cast<double>(span.duration_ns) / 1000.0);
+        json += event;
+    }
+    json += "]}";
+    return json;
+}
+
+ScopedTimer::~ScopedTimer() {
+    const uint64_t end = metric_clock_ns();
+    histogram.record(end - start);
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    if (registry.is_tracing()) {
+        registry.record_span({ &histogram.get_name(), metric_shard(), start, end - start });
+    }
+}
+
+MetricsServer::MetricsServer(MetricsRegistry& registry)
+    : registry(registry), listen_socket(-1), port(0), running(false) {}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+void MetricsServer::start(int requested_port) {
+    if (running) {
+        throw std::logic_error("Metrics server is already running");
+    }
+    listen_socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_socket < 0) {
+        throw std::runtime_error("Failed to create metrics socket");
+    }
+    int opt = 1;
+    setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(requested_port));
+    address.sin_addr.s_addr = INADDR_ANY;
+    if (bind(listen_socket, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(listen_socket, 16) < 0) {
+        close(listen_socket);
+        listen_socket = -1;
+        throw std::runtime_error("Failed to bind metrics port " + std::to_string(requested_port));
+    }
+    socklen_t length = sizeof(address);
+    getsockname(listen_socket, (struct sockaddr*)&address, &length);
+    port = ntohs(address.sin_port);
+
+    running = true;
+    server_thread = std::thread([this] { serve(); });
+}
+
+void MetricsServer::stop() {
+    running = false;
+    if (server_thread.joinable()) {
+        server_thread.join();
+    }
+    if (listen_socket >= 0) {
+        close(listen_socket);
+        listen_socket = -1;
+    }
+}
+
+void MetricsServer::serve() {
+    while (running) {
+        pollfd listener{ listen_socket, POLLIN, 0 };
+        if (poll(&listener, 1, POLL_INTERVAL_MS) <= 0) {
+            continue;
+        }
+        int client = accept(listen_socket, nullptr, nullptr);
+        if (client >= 0) {
+            answer(client);
+            close(client);
+        }
+    }
+}
+
+void MetricsServer::answer(int client) {
+    // Scrapes are small and infrequent; read the request line with a bounded wait and answer on this thread.
+    std::string request;
+    char buffer[512];
+    while (request.find("\r\n") == std::string::npos && request.size() < MAX_REQUEST_BYTES) {
+        pollfd readable{ client, POLLIN, 0 };
+        if (poll(&readable, 1, POLL_INTERVAL_MS) <= 0) {
+            return;
+        }
+        ssize_t received = recv(client, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+            return;
+        }
+        request.append(buffer, static_cast<size_t>(received));
+    }
+
+    const std::string line = request.substr(0, request.find("\r\n"));
+    std::string status = "200 OK";
+    std::string content_type = "text/plain; version=0.0.4";
+    std::string body;
+    if (line.rfind("GET /metrics ", 0) == 0) {
+        body = registry.render_prometheus();
+    } else if (line.rfind("GET /trace ", 0) == 0) {
+        content_type = "application/json";
+        body = registry.take_trace();
+    } else {
+        status = "404 Not Found";
+        body = "not found\n";
+    }
+
+    const std::string response = "HTTP/1.1 " + status + "\r\nContent-Type: " + content_type +
+                                 "\r\nContent-Length: " + std::to_string(body.size()) +
+                                 "\r\nConnection: close\r\n\r\n" + body;
+    size_t offset = 0;
+    while (offset < response.size()) {
+        ssize_t sent = send(client, response.data() + offset, response.size() - offset, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            return;
+        }
+        offset += static_cast<size_t>(sent);
+    }
+}
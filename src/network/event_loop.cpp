@@ -0,0 +1,248 @@
+#include "network/event_loop.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <cassert>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#ifdef SYNLEDGER_HAVE_EPOLL
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+const int MAX_EVENTS_PER_WAIT = 256;  // Descriptors reported by one epoll_wait() call.
+
+#ifdef SYNLEDGER_HAVE_EPOLL
+// Translates EVENT_* interest flags into epoll flags.
+static uint32_t epoll_interest(uint32_t events) {
+    uint32_t interest = 0;
+    interest |= events & EVENT_READABLE ? static_cast<uint32_t>(EPOLLIN) : 0;
+    interest |= events & EVENT_WRITABLE ? static_cast<uint32_t>(EPOLLOUT) : 0;
+    return interest;
+}
+#endif
+
+EventLoop::EventLoop() : timer_sequence(0), stop_requested(false), loop_thread(std::thread::id()) {
+    if (pipe(wake_pipe) < 0) {
+        throw std::runtime_error("Failed to create event loop wake-up pipe");
+    }
+    for (int fd : wake_pipe) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+
+#ifdef SYNLEDGER_HAVE_EPOLL
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        close(wake_pipe[0]);
+        close(wake_pipe[1]);
+        throw std::runtime_error("Failed to create epoll instance");
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = wake_pipe[0];
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_pipe[0], &event);
+#endif
+}
+
+EventLoop::~EventLoop() {
+#ifdef SYNLEDGER_HAVE_EPOLL
+    close(epoll_fd);
+#endif
+    close(wake_pipe[0]);
+    close(wake_pipe[1]);
+}
+
+const char* EventLoop::backend() {
+#ifdef SYNLEDGER_HAVE_EPOLL
+    return "epoll";
+#else
+    return "poll";
+#endif
+}
+
+bool EventLoop::in_loop_thread() const {
+    return loop_thread.load() == std::this_thread::get_id();
+}
+
+void EventLoop::assert_loop_thread() const {
+    // Before `run()` starts, the thread setting up the loop owns it.
+    assert((loop_thread.load() == std::thread::id() || in_loop_thread()) &&
+           "watch, modify, unwatch and post_after must be called from the loop thread");
+}
+
+void EventLoop::run() {
+    loop_thread = std::this_thread::get_id();
+    std::vector<std::pair<int, uint32_t>> ready;
+
+    while (!stop_requested) {
+        ready.clear();
+        wait_for_events(next_timeout_ms(), ready);
+        for (const auto& [fd, events] : ready) {
+            // An earlier callback in this batch may have unwatched the descriptor.
+            auto it = watches.find(fd);
+            if (it == watches.end()) {
+                continue;
+            }
+            IoCallback callback = it->second.callback;
+            callback(events);
+        }
+        run_pending_tasks();
+        run_due_timers();
+    }
+
+    loop_thread = std::thread::id();
+}
+
+void EventLoop::stop() {
+    stop_requested = true;
+    wake();
+}
+
+void EventLoop::post(LoopTask task) {
+    {
+        std::lock_guard<std::mutex> lock(task_mutex);
+        pending_tasks.push_back(std::move(task));
+    }
+    wake();
+}
+
+void EventLoop::post_after(int delay_ms, LoopTask task) {
+    assert_loop_thread();
+    timers.push_back(Timer{ std::chrono::steady_clock::now() + std::chrono::milliseconds(delay_ms),
+                            timer_sequence++, std::move(task) });
+    std::push_heap(timers.begin(), timers.end(), fires_later);
+}
+
+void EventLoop::watch(int fd, uint32_t events, IoCallback callback) {
+    assert_loop_thread();
+    watches[fd] = Watch{ events, std::move(callback) };
+#ifdef SYNLEDGER_HAVE_EPOLL
+    epoll_event event{};
+    event.events = epoll_interest(events);
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        watches.erase(fd);
+        throw std::runtime_error("Failed to watch descriptor");
+    }
+#endif
+}
+
+void EventLoop::modify(int fd, uint32_t events) {
+    assert_loop_thread();
+    auto it = watches.find(fd);
+    if (it == watches.end() || it->second.events == events) {
+        return;
+    }
+    it->second.events = events;
+#ifdef SYNLEDGER_HAVE_EPOLL
+    epoll_event event{};
+    event.events = epoll_interest(events);
+    event.data.fd = fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event);
+#endif
+}
+
+void EventLoop::unwatch(int fd) {
+    assert_loop_thread();
+    if (watches.erase(fd) == 0) {
+        return;
+    }
+#ifdef SYNLEDGER_HAVE_EPOLL
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+#endif
+}
+
+void EventLoop::wait_for_events(int timeout_ms, std::vector<std::pair<int, uint32_t>>& ready) {
+    bool woken = false;
+#ifdef SYNLEDGER_HAVE_EPOLL
+    epoll_event events[MAX_EVENTS_PER_WAIT];
+    int count = epoll_wait(epoll_fd, events, MAX_EVENTS_PER_WAIT, timeout_ms);
+    for (int i = 0; i < count; ++i) {
+        if (events[i].data.fd == wake_pipe[0]) {
+            woken = true;
+            continue;
+        }
+        uint32_t flags = 0;
+        flags |= events[i].events & EPOLLIN ? EVENT_READABLE : 0;
+        flags |= events[i].events & EPOLLOUT ? EVENT_WRITABLE : 0;
+        flags |= events[i].events & (EPOLLERR | EPOLLHUP) ? EVENT_ERROR : 0;
+        int fd = events[i].data.fd;
+        ready.emplace_back(fd, flags);
+    }
+#else
+    std::vector<pollfd> fds;
+    fds.reserve(watches.size() + 1);
+    fds.push_back(pollfd{ wake_pipe[0], POLLIN, 0 });
+    for (const auto& [fd, watch] : watches) {
+        short interest = (watch.events & EVENT_READABLE ? POLLIN : 0) | (watch.events & EVENT_WRITABLE ? POLLOUT : 0);
+        fds.push_back(pollfd{ fd, interest, 0 });
+    }
+    if (poll(fds.data(), fds.size(), timeout_ms) > 0) {
+        woken = fds[0].revents != 0;
+        for (size_t i = 1; i < fds.size(); ++i) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            uint32_t flags = 0;
+            flags |= fds[i].revents & POLLIN ? EVENT_READABLE : 0;
+            flags |= fds[i].revents & POLLOUT ? EVENT_WRITABLE : 0;
+            flags |= fds[i].revents & (POLLERR | POLLHUP | POLLNVAL) ? EVENT_ERROR : 0;
+            ready.emplace_back(fds[i].fd, flags);
+        }
+    }
+#endif
+
+    if (woken) {
+        char drain[64];
+        while (read(wake_pipe[0], drain, sizeof(drain)) > 0) {
+        }
+    }
+}
+
+void EventLoop::run_pending_tasks() {
+    std::vector<LoopTask> tasks;
+    {
+        std::lock_guard<std::mutex> lock(task_mutex);
+        tasks.swap(pending_tasks);
+    }
+    for (LoopTask& task : tasks) {
+        task();
+    }
+}
+
+void EventLoop::run_due_timers() {
+    auto now = std::chrono::steady_clock::now();
+    while (!timers.empty() && timers.front().due <= now) {
+        std::pop_heap(timers.begin(), timers.end(), fires_later);
+        LoopTask task = std::move(timers.back().task);
+        timers.pop_back();
+        task();
+    }
+}
+
+int EventLoop::next_timeout_ms() const {
+    {
+        std::lock_guard<std::mutex> lock(task_mutex);
+        if (!pending_tasks.empty()) {
+            return 0;
+        }
+    }
+    if (timers.empty()) {
+        return -1;
+    }
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        timers.front().due - std::chrono::steady_clock::now()).count();
+    return remaining <= 0 ? 0 : static_cast<int>(remaining) + 1;
+}
+
+bool EventLoop::fires_later(const Timer& a, const Timer& b) {
+    return a.due != b.due ? a.due > b.due : a.sequence > b.sequence;
+}
+
+void EventLoop::wake() {
+    char signal = 1;
+    ssize_t ignored = write(wake_pipe[1], &signal, 1);
+    (void)ignored;
+}
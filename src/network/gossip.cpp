@@ -0,0 +1,640 @@
+#include "network/gossip.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <optional>
+
+// Message layout: kind (1 byte) | sender node id (8 bytes, big-endian) | body.
+//   INV, GETDATA: count (4 bytes) | count x (type (1 byte) | id (32 bytes))
+//   DATA:         type (1 byte) | id (32 bytes) | payload
+//   CMPCTBLOCK:   id (32 bytes) | compact block encoding
+//   GETBLOCKTXN:  id (32 bytes) | count (4 bytes) | count x index (4 bytes)
+//   BLOCKTXN:     id (32 bytes) | count (4 bytes) | count x (length (4 bytes) | encoded transaction)
+const uint8_t GOSSIP_INV = 1;
+const uint8_t GOSSIP_GETDATA = 2;
+const uint8_t GOSSIP_DATA = 3;
+const uint8_t GOSSIP_COMPACT_BLOCK = 4;
+const uint8_t GOSSIP_GET_BLOCK_TRANSACTIONS = 5;
+const uint8_t GOSSIP_BLOCK_TRANSACTIONS = 6;
+const size_t GOSSIP_HEADER_SIZE = 1 + 8;
+const size_t INVENTORY_ENTRY_SIZE = 1 + Hash256::SIZE;
+const uint32_t MAX_INVENTORY_PER_MESSAGE = 50000;
+
+const size_t SeenFilter::HASH_COUNT;
+const size_t SeenFilter::BITS_PER_ITEM;
+const size_t Gossip::DEFAULT_FANOUT;
+const size_t Gossip::DEFAULT_SEEN_CAPACITY;
+const size_t Gossip::MAX_CACHED_ITEMS;
+const int Gossip::REQUEST_TIMEOUT_MS;
+const size_t Gossip::MAX_PARTIAL_BLOCKS;
+
+static void put_u32(std::string& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+static void put_u64(std::string& out, uint64_t value) {
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+static uint64_t get_be(const std::string& in, size_t offset, size_t width) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < width; ++i) {
+        value = (value << 8) | static_cast<uint8_t>(in[offset + i]);
+    }
+    return value;
+}
+
+static std::string encode_header(uint8_t kind, size_t sender) {
+    std::string out;
+    out.push_back(static_cast<char>(kind));
+    put_u64(out, sender);
+    return out;
+}
+
+static std::string encode_inventory(uint8_t kind, size_t sender, const std::vector<InventoryItem>& items) {
+    std::string out = encode_header(kind, sender);
+    out.reserve(out.size() + 4 + items.size() * INVENTORY_ENTRY_SIZE);
+    put_u32(out, static_cast<uint32_t>(items.size()));
+    for (const InventoryItem& item : items) {
+        out.push_back(static_cast<char>(item.type));
+        out.append(reinterpret_cast<const char*>(item.id.data()), Hash256::SIZE);
+    }
+    return out;
+}
+
+static bool valid_type(uint8_t type, bool allow_compact = false) {
+    return type == static_cast<uint8_t>(InventoryType::BLOCK) || type == static_cast<uint8_t>(InventoryType::TRANSACTION) ||
+           (allow_compact && type == static_cast<uint8_t>(InventoryType::COMPACT_BLOCK));
+}
+
+static std::string encode_block_message(uint8_t kind, size_t sender, const Hash256& id) {
+    std::string out = encode_header(kind, sender);
+    out.append(reinterpret_cast<const char*>(id.data()), Hash256::SIZE);
+    return out;
+}
+
+// Both 64-bit halves of the (uniformly distributed) id drive the double hashing.
+static void probe_seeds(const Hash256& id, uint64_t& h1, uint64_t& h2) {
+    memcpy(&h1, id.data(), sizeof(h1));
+    memcpy(&h2, id.data() + sizeof(h1), sizeof(h2));
+    h2 |= 1;
+}
+
+SeenFilter::SeenFilter(size_t capacity)
+    : capacity(std::max<size_t>(capacity, 1)), inserted(0) {
+    bit_count = this->capacity * BITS_PER_ITEM;
+    current.assign((bit_count + 63) / 64, 0);
+    previous.assign(current.size(), 0);
+}
+
+void SeenFilter::insert(const Hash256& id) {
+    if (inserted >= capacity) {
+        previous.swap(current);
+        std::fill(current.begin(), current.end(), 0);
+        inserted = 0;
+    }
+    uint64_t h1, h2;
+    probe_seeds(id, h1, h2);
+    for (size_t i = 0; i < HASH_COUNT; ++i) {
+        size_t bit = (h1 + i * h2) % bit_count;
+        current[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+    inserted++;
+}
+
+bool SeenFilter::contains(const Hash256& id) const {
+    return test(current, bit_count, id) || test(previous, bit_count, id);
+}
+
+bool SeenFilter::test(const std::vector<uint64_t>& bits, size_t bit_count, const Hash256& id) {
+    uint64_t h1, h2;
+    probe_seeds(id, h1, h2);
+    for (size_t i = 0; i < HASH_COUNT; ++i) {
+        size_t bit = (h1 + i * h2) % bit_count;
+        if (!(bits[bit / 64] & (uint64_t(1) << (bit % 64)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Gossip::Gossip(P2PProtocol& network, size_t node_id, const SubnetManager& topology, size_t fanout)
+    : network(network), node_id(node_id), topology(topology), fanout(fanout), seen(DEFAULT_SEEN_CAPACITY),
+      nonce_source(std::random_device{}()), rotation(0), stats{ 0, 0, 0, 0, 0, 0, 0, 0, 0 } {
+    item_handler = [](InventoryType, const Hash256&, const std::string&) { return true; };
+}
+
+void Gossip::set_item_handler(ItemHandler handler) {
+    std::lock_guard<std::mutex> lock(gossip_mutex);
+    item_handler = std::move(handler);
+}
+
+void Gossip::set_mempool_matcher(MempoolMatcher matcher) {
+    std::lock_guard<std::mutex> lock(gossip_mutex);
+    mempool_matcher = std::move(matcher);
+}
+
+bool Gossip::broadcast(InventoryType type, const Hash256& id, const std::string& payload) {
+    {
+        std::lock_guard<std::mutex> lock(gossip_mutex);
+        if (seen.contains(id)) {
+            return false;
+        }
+        seen.insert(id);
+        cache_item(id, type, payload);
+    }
+    announce(InventoryItem{ type, id }, {});
+    return true;
+}
+
+bool Gossip::has_seen(const Hash256& id) const {
+    std::lock_guard<std::mutex> lock(gossip_mutex);
+    return seen.contains(id);
+}
+
+GossipStats Gossip::get_stats() const {
+    std::lock_guard<std::mutex> lock(gossip_mutex);
+    return stats;
+}
+
+std::vector<size_t> Gossip::select_peers(const std::vector<size_t>& exclude) const {
+    std::vector<size_t> known = network.get_active_peers();
+    std::vector<size_t> local_subnet;
+    try {
+        local_subnet = topology.get_subnet_nodes(topology.get_node_subnet(node_id));
+    } catch (const std::exception&) {
+        // This node has no subnet yet; every peer counts as remote.
+    }
+
+    std::vector<size_t> selected;
+    std::vector<size_t> remote;
+    for (size_t peer : known) {
+        if (peer == node_id || std::find(exclude.begin(), exclude.end(), peer) != exclude.end()) {
+            continue;
+        }
+        if (std::find(local_subnet.begin(), local_subnet.end(), peer) != local_subnet.end()) {
+            selected.push_back(peer);
+        } else {
+            remote.push_back(peer);
+        }
+    }
+
+    // Rotate through the remote peers so that successive items leave the subnet through different links.
+    size_t take = std::min(fanout, remote.size());
+    size_t start;
+    {
+        std::lock_guard<std::mutex> lock(gossip_mutex);
+        start = remote.empty() ? 0 : rotation++ % remote.size();
+    }
+    for (size_t i = 0; i < take; ++i) {
+        selected.push_back(remote[(start + i) % remote.size()]);
+    }
+    return selected;
+}
+
+void Gossip::announce(const InventoryItem& item, const std::vector<size_t>& exclude) {
+    std::string message = encode_inventory(GOSSIP_INV, node_id, { item });
+    size_t sent = 0;
+    for (size_t peer : select_peers(exclude)) {
+        sent += send(peer, message) ? 1 : 0;
+    }
+    std::lock_guard<std::mutex> lock(gossip_mutex);
+    stats.announcements_sent += sent;
+}
+
+bool Gossip::send(size_t peer, const std::string& message) {
+    try {
+        network.send_message(peer, message);
+        return true;
+    } catch (const std::exception&) {
+        return false;  // The peer was never registered with the transport.
+    }
+}
+
+void Gossip::cache_item(const Hash256& id, InventoryType type, const std::string& payload) {
+    if (cache.emplace(id, CachedItem{ type, payload, {} }).second) {
+        cache_order.push_back(id);
+    }
+    while (cache_order.size() > MAX_CACHED_ITEMS) {
+        cache.erase(cache_order.front());
+        cache_order.pop_front();
+    }
+}
+
+void Gossip::handle_message(const std::string& message) {
+    if (message.size() < GOSSIP_HEADER_SIZE) {
+        return;
+    }
+    uint8_t kind = static_cast<uint8_t>(message[0]);
+    size_t sender = static_cast<size_t>(get_be(message, 1, 8));
+    size_t offset = GOSSIP_HEADER_SIZE;
+
+    if (kind == GOSSIP_INV || kind == GOSSIP_GETDATA) {
+        if (message.size() < offset + 4) {
+            return;
+        }
+        uint32_t count = static_cast<uint32_t>(get_be(message, offset, 4));
+        offset += 4;
+        if (count > MAX_INVENTORY_PER_MESSAGE || message.size() != offset + count * INVENTORY_ENTRY_SIZE) {
+            return;
+        }
+        std::vector<InventoryItem> items;
+        items.reserve(count);
+        for (uint32_t i = 0; i < count; ++i, offset += INVENTORY_ENTRY_SIZE) {
+            uint8_t type = static_cast<uint8_t>(message[offset]);
+            if (!valid_type(type, kind == GOSSIP_GETDATA)) {
+                return;
+            }
+            InventoryItem item{ static_cast<InventoryType>(type), Hash256() };
+            memcpy(item.id.data(), message.data() + offset + 1, Hash256::SIZE);
+            items.push_back(item);
+        }
+        if (kind == GOSSIP_INV) {
+            handle_inventory(sender, items);
+        } else {
+            handle_request(sender, items);
+        }
+    } else if (kind == GOSSIP_DATA) {
+        if (message.size() < offset + INVENTORY_ENTRY_SIZE || !valid_type(static_cast<uint8_t>(message[offset]))) {
+            return;
+        }
+        InventoryType type = static_cast<InventoryType>(message[offset]);
+        Hash256 id;
+        memcpy(id.data(), message.data() + offset + 1, Hash256::SIZE);
+        handle_data(sender, type, id, message.substr(offset + INVENTORY_ENTRY_SIZE));
+    } else if (kind == GOSSIP_COMPACT_BLOCK || kind == GOSSIP_GET_BLOCK_TRANSACTIONS || kind == GOSSIP_BLOCK_TRANSACTIONS) {
+        if (message.size() < offset + Hash256::SIZE) {
+            return;
+        }
+        Hash256 id;
+        memcpy(id.data(), message.data() + offset, Hash256::SIZE);
+        offset += Hash256::SIZE;
+        if (kind == GOSSIP_COMPACT_BLOCK) {
+            handle_compact_block(sender, id, std::string_view(message).substr(offset));
+            return;
+        }
+
+        if (message.size() < offset + 4) {
+            return;
+        }
+        uint32_t count = static_cast<uint32_t>(get_be(message, offset, 4));
+        offset += 4;
+        if (count > CompactBlock::MAX_TRANSACTIONS || message.size() - offset < uint64_t(count) * 4) {
+            return;
+        }
+        if (kind == GOSSIP_GET_BLOCK_TRANSACTIONS) {
+            if (message.size() != offset + uint64_t(count) * 4) {
+                return;
+            }
+            std::vector<uint32_t> indexes(count);
+            for (uint32_t i = 0; i < count; ++i, offset += 4) {
+                indexes[i] = static_cast<uint32_t>(get_be(message, offset, 4));
+            }
+            handle_transactions_request(sender, id, indexes);
+            return;
+        }
+
+        std::vector<std::string> encoded;
+        encoded.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            if (message.size() < offset + 4) {
+                return;
+            }
+            uint32_t length = static_cast<uint32_t>(get_be(message, offset, 4));
+            offset += 4;
+            if (message.size() - offset < length) {
+                return;
+            }
+            encoded.push_back(message.substr(offset, length));
+            offset += length;
+        }
+        if (offset == message.size()) {
+            handle_transactions(sender, id, encoded);
+        }
+    }
+}
+
+void Gossip::handle_inventory(size_t sender, const std::vector<InventoryItem>& items) {
+    std::vector<InventoryItem> wanted;
+    auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(gossip_mutex);
+        if (pending.size() > MAX_CACHED_ITEMS) {
+            // Forget requests that were never answered, so bogus announcements cannot grow the table.
+            for (auto it = pending.begin(); it != pending.end();) {
+                bool expired = now - it->second.requested_at > std::chrono::milliseconds(REQUEST_TIMEOUT_MS);
+                it = expired ? pending.erase(it) : std::next(it);
+            }
+        }
+        for (const InventoryItem& item : items) {
+            if (seen.contains(item.id)) {
+                stats.duplicates_ignored++;
+                continue;
+            }
+            auto it = pending.find(item.id);
+            if (it == pending.end()) {
+                pending[item.id] = PendingRequest{ now, { sender } };
+                wanted.push_back(item);
+                continue;
+            }
+            // Already requested from someone else: remember this announcer, and ask it if that request stalled.
+            PendingRequest& request = it->second;
+            request.announcers.push_back(sender);
+            if (now - request.requested_at > std::chrono::milliseconds(REQUEST_TIMEOUT_MS)) {
+                request.requested_at = now;
+                wanted.push_back(item);
+            }
+        }
+        if (mempool_matcher) {
+            for (InventoryItem& item : wanted) {
+                if (item.type == InventoryType::BLOCK) {
+                    item.type = InventoryType::COMPACT_BLOCK;
+                }
+            }
+        }
+        if (!wanted.empty()) {
+            stats.requests_sent++;
+        }
+    }
+    if (!wanted.empty()) {
+        send(sender, encode_inventory(GOSSIP_GETDATA, node_id, wanted));
+    }
+}
+
+std::string Gossip::compact_payload(const Hash256& id) {
+    std::string payload;
+    uint64_t nonce;
+    {
+        std::lock_guard<std::mutex> lock(gossip_mutex);
+        auto it = cache.find(id);
+        if (it == cache.end() || it->second.type != InventoryType::BLOCK) {
+            return std::string();
+        }
+        if (!it->second.compact.empty()) {
+            return it->second.compact;
+        }
+        payload = it->second.payload;
+        nonce = nonce_source();
+    }
+
+    // Encoding happens unlocked; a concurrent request for the same block at worst encodes it twice.
+    std::string compact;
+    try {
+        compact = CompactBlock::from_view(BlockView::decode(payload), nonce).serialize();
+    } catch (const std::exception&) {
+        return std::string();  // Not a decodable block; the caller serves the full payload.
+    }
+    std::lock_guard<std::mutex> lock(gossip_mutex);
+    auto it = cache.find(id);
+    if (it != cache.end()) {
+        it->second.compact = compact;
+    }
+    return compact;
+}
+
+void Gossip::handle_request(size_t sender, const std::vector<InventoryItem>& items) {
+    std::vector<std::string> replies;
+    std::vector<InventoryItem> full;
+    for (const InventoryItem& item : items) {
+        if (item.type != InventoryType::COMPACT_BLOCK) {
+            full.push_back(item);
+            continue;
+        }
+        std::string compact = compact_payload(item.id);
+        if (compact.empty()) {
+            full.push_back(item);
+            continue;
+        }
+        std::string reply = encode_block_message(GOSSIP_COMPACT_BLOCK, node_id, item.id);
+        reply.append(compact);
+        replies.push_back(std::move(reply));
+    }
+    {
+        std::lock_guard<std::mutex> lock(gossip_mutex);
+        for (const InventoryItem& item : full) {
+            auto it = cache.find(item.id);
+            if (it == cache.end()) {
+                continue;
+            }
+            std::string reply = encode_header(GOSSIP_DATA, node_id);
+            reply.reserve(reply.size() + INVENTORY_ENTRY_SIZE + it->second.payload.size());
+            reply.push_back(static_cast<char>(it->second.type));
+            reply.append(reinterpret_cast<const char*>(item.id.data()), Hash256::SIZE);
+            reply.append(it->second.payload);
+            replies.push_back(std::move(reply));
+        }
+    }
+    size_t sent = 0;
+    for (const std::string& reply : replies) {
+        sent += send(sender, reply) ? 1 : 0;
+    }
+    std::lock_guard<std::mutex> lock(gossip_mutex);
+    stats.items_sent += sent;
+}
+
+// Checks that a delivered payload is the item it claims to be, so a peer cannot poison an id with other content.
+static bool payload_matches(InventoryType type, const Hash256& id, const std::string& payload) {
+    try {
+        if (type == InventoryType::BLOCK) {
+            return BlockView::decode(payload).compute_digest() == id;
+        }
+        return Transaction::deserialize(payload).hash() == id;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+void Gossip::handle_data(size_t sender, InventoryType type, const Hash256& id, const std::string& payload) {
+    std::vector<size_t> exclude{ sender };
+    ItemHandler handler;
+    {
+        std::lock_guard<std::mutex> lock(gossip_mutex);
+        if (seen.contains(id)) {
+            stats.duplicates_ignored++;
+            return;
+        }
+        auto it = pending.find(id);
+        if (it == pending.end() || it->second.delivering) {
+            return;  // Unrequested, or another copy is being checked.
+        }
+        it->second.delivering = true;
+        handler = item_handler;
+    }
+
+    // The handler runs unlocked so that it may broadcast or query the gossip layer itself.
+    if (!payload_matches(type, id, payload) || !handler(type, id, payload)) {
+        retry_request(sender, type, id);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(gossip_mutex);
+        seen.insert(id);
+        auto it = pending.find(id);
+        if (it != pending.end()) {
+            exclude.insert(exclude.end(), it->second.announcers.begin(), it->second.announcers.end());
+            pending.erase(it);
+        }
+        stats.items_received++;
+        cache_item(id, type, payload);
+    }
+    announce(InventoryItem{ type, id }, exclude);
+}
+
+void Gossip::retry_request(size_t failed_peer, InventoryType type, const Hash256& id) {
+    size_t next_peer;
+    {
+        std::lock_guard<std::mutex> lock(gossip_mutex);
+        auto it = pending.find(id);
+        if (it == pending.end()) {
+            return;
+        }
+        // The failed peer is not asked again; with no announcer left the item waits for a new announcement.
+        std::vector<size_t>& announcers = it->second.announcers;
+        announcers.erase(std::remove(announcers.begin(), announcers.end(), failed_peer), announcers.end());
+        if (announcers.empty()) {
+            pending.erase(it);
+            return;
+        }
+        it->second.delivering = false;
+        it->second.requested_at = std::chrono::steady_clock::now();
+        next_peer = announcers.front();
+        stats.requests_sent++;
+    }
+    send(next_peer, encode_inventory(GOSSIP_GETDATA, node_id, { InventoryItem{ type, id } }));
+}
+
+void Gossip::handle_compact_block(size_t sender, const Hash256& id, std::string_view payload) {
+    MempoolMatcher matcher;
+    {
+        std::lock_guard<std::mutex> lock(gossip_mutex);
+        if (seen.contains(id)) {
+            stats.duplicates_ignored++;
+            return;
+        }
+        if (!pending.count(id) || partial_blocks.count(id)) {
+            return;  // Not requested, or already being rebuilt.
+        }
+        stats.compact_blocks_received++;
+        matcher = mempool_matcher;
+    }
+
+    std::optional<PartialBlock> block;
+    try {
+        CompactBlock compact = CompactBlock::deserialize(payload);
+        if (compact.compute_digest() == id) {
+            block.emplace(compact);
+        }
+    } catch (const std::exception&) {
+    }
+    if (!block) {
+        request_full_block(sender, id);
+        return;
+    }
+
+    // Matching runs unlocked: the matcher takes the ledger's lock to read its mempool.
+    if (matcher) {
+        matcher(*block);
+    }
+    if (block->is_complete()) {
+        finish_block(sender, id, *block);
+        return;
+    }
+
+    std::vector<uint32_t> missing = block->get_missing();
+    std::string request = encode_block_message(GOSSIP_GET_BLOCK_TRANSACTIONS, node_id, id);
+    request.reserve(request.size() + 4 + missing.size() * 4);
+    put_u32(request, static_cast<uint32_t>(missing.size()));
+    for (uint32_t index : missing) {
+        put_u32(request, index);
+    }
+    {
+        std::lock_guard<std::mutex> lock(gossip_mutex);
+        if (partial_blocks.size() >= MAX_PARTIAL_BLOCKS) {
+            partial_blocks.erase(partial_blocks.begin());  // Its pending request times out and is retried.
+        }
+        partial_blocks.emplace(id, PendingBlock{ std::move(*block), sender });
+        stats.transactions_requested += missing.size();
+    }
+    send(sender, request);
+}
+
+void Gossip::handle_transactions_request(size_t sender, const Hash256& id, const std::vector<uint32_t>& indexes) {
+    std::string payload;
+    {
+        std::lock_guard<std::mutex> lock(gossip_mutex);
+        auto it = cache.find(id);
+        if (it == cache.end() || it->second.type != InventoryType::BLOCK) {
+            return;
+        }
+        payload = it->second.payload;
+    }
+
+    std::string reply = encode_block_message(GOSSIP_BLOCK_TRANSACTIONS, node_id, id);
+    try {
+        BlockView view = BlockView::decode(payload);
+        put_u32(reply, static_cast<uint32_t>(indexes.size()));
+        for (uint32_t index : indexes) {
+            std::string_view encoded = view.transactions.at(index).encoded;
+            put_u32(reply, static_cast<uint32_t>(encoded.size()));
+            reply.append(encoded.data(), encoded.size());
+        }
+    } catch (const std::exception&) {
+        return;  // Bad index or undecodable block: the requester times out and retries elsewhere.
+    }
+    send(sender, reply);
+}
+
+void Gossip::handle_transactions(size_t sender, const Hash256& id, const std::vector<std::string>& encoded) {
+    std::optional<PendingBlock> pending_block;
+    {
+        std::lock_guard<std::mutex> lock(gossip_mutex);
+        auto it = partial_blocks.find(id);
+        if (it == partial_blocks.end() || it->second.peer != sender) {
+            return;
+        }
+        pending_block.emplace(std::move(it->second));
+        partial_blocks.erase(it);
+    }
+
+    try {
+        std::vector<Transaction> txs;
+        txs.reserve(encoded.size());
+        for (const std::string& tx : encoded) {
+            txs.push_back(Transaction::deserialize(tx));
+        }
+        pending_block->block.fill_missing(txs);
+    } catch (const std::exception&) {
+        request_full_block(sender, id);
+        return;
+    }
+    finish_block(sender, id, pending_block->block);
+}
+
+void Gossip::finish_block(size_t sender, const Hash256& id, const PartialBlock& block) {
+    std::string payload;
+    try {
+        payload = block.to_block().serialize();
+    } catch (const std::exception&) {
+        request_full_block(sender, id);  // A short id matched the wrong pool transaction.
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(gossip_mutex);
+        stats.compact_blocks_rebuilt++;
+    }
+    handle_data(sender, InventoryType::BLOCK, id, payload);
+}
+
+void Gossip::request_full_block(size_t sender, const Hash256& id) {
+    {
+        std::lock_guard<std::mutex> lock(gossip_mutex);
+        partial_blocks.erase(id);
+        stats.compact_fallbacks++;
+        stats.requests_sent++;
+    }
+    send(sender, encode_inventory(GOSSIP_GETDATA, node_id, { InventoryItem{ InventoryType::BLOCK, id } }));
+}
@@ -1,41 +1,633 @@
 #include "network/node_discovery.hpp"
-#include <iostream>
+#include "network/p2p_protocol.hpp"
+#include "logging/logger.hpp"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <unordered_set>
+#include <future>
+#include <random>
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+const uint8_t DISCOVERY_PING = 1;
+const uint8_t DISCOVERY_PONG = 2;
+const uint8_t DISCOVERY_FIND_NODE = 3;
+const uint8_t DISCOVERY_NODES = 4;
+const size_t DISCOVERY_HEADER_SIZE = 1 + 8 + 8;
+const size_t NODE_ENTRY_SIZE = 8 + 4 + 2;
+const size_t MAX_DATAGRAM_SIZE = 2048;
+const double RTT_SMOOTHING = 0.25;  // Weight of a new round-trip sample in the moving average.
+
+const size_t RoutingTable::BUCKET_COUNT;
+const size_t NodeDiscovery::BUCKET_SIZE;
+const size_t NodeDiscovery::LOOKUP_PARALLELISM;
+const size_t NodeDiscovery::REFRESH_LOOKUPS;
+const int NodeDiscovery::REQUEST_TIMEOUT_MS;
+const int NodeDiscovery::PING_INTERVAL_MS;
+const int NodeDiscovery::MAX_FAILED_REQUESTS;
+
+static void put_be(std::string& out, uint64_t value, size_t width) {
+    for (size_t i = width; i-- > 0;) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+static uint64_t get_be(const std::string& in, size_t offset, size_t width) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < width; ++i) {
+        value = (value << 8) | static_cast<uint8_t>(in[offset + i]);
+    }
+    return value;
+}
+
+static std::string encode_header(uint8_t kind, uint64_t rpc_id, size_t sender) {
+    std::string out;
+    out.push_back(static_cast<char>(kind));
+    put_be(out, rpc_id, 8);
+    put_be(out, sender, 8);
+    return out;
+}
+
+// Parses "ip" or "ip:port" into a socket address, validating the IPv4 address.
+static sockaddr_in parse_address(const std::string& address) {
+    size_t colon = address.rfind(':');
+    std::string host = address.substr(0, colon);
+    int port = P2PProtocol::DEFAULT_PEER_PORT;
+    if (colon != std::string::npos) {
+        try {
+            port = std::stoi(address.substr(colon + 1));
+        } catch (const std::exception&) {
+            throw std::invalid_argument("Invalid node port: " + address);
+        }
+    }
+
+    sockaddr_in parsed{};
+    parsed.sin_family = AF_INET;
+    if (inet_pton(AF_INET, host.c_str(), &parsed.sin_addr) <= 0 || port <= 0 || port > 65535) {
+        throw std::invalid_argument("Invalid node address: " + address);
+    }
+    parsed.sin_port = htons(static_cast<uint16_t>(port));
+    return parsed;
+}
+
+static std::string format_address(const sockaddr_in& address) {
+    char host[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &address.sin_addr, host, sizeof(host));
+    return std::string(host) + ":" + std::to_string(ntohs(address.sin_port));
+}
+
+RoutingTable::RoutingTable(size_t self_id, size_t bucket_size) : self_id(self_id), bucket_size(std::max<size_t>(bucket_size, 1)) {}
+
+int RoutingTable::bucket_index(size_t node_id) const {
+    uint64_t distance = static_cast<uint64_t>(self_id ^ node_id);
+    return distance == 0 ? -1 : 63 - __builtin_clzll(distance);
+}
+
+bool RoutingTable::observe(const NodeContact& contact, double rtt_ms, NodeContact* stale) {
+    int index = bucket_index(contact.node_id);
+    if (index < 0) {
+        return false;
+    }
+    Bucket& bucket = buckets[index];
+
+    auto same_node = [&](const NodeContact& entry) { return entry.node_id == contact.node_id; };
+    auto it = std::find_if(bucket.contacts.begin(), bucket.contacts.end(), same_node);
+    if (it != bucket.contacts.end()) {
+        NodeContact updated = *it;
+        updated.address = contact.address;
+        updated.last_seen = std::max(updated.last_seen, contact.last_seen);
+        updated.failed_requests = 0;
+        if (rtt_ms >= 0) {
+            updated.rtt_ms = updated.rtt_ms < 0 ? rtt_ms : updated.rtt_ms + RTT_SMOOTHING * (rtt_ms - updated.rtt_ms);
+        }
+        bucket.contacts.erase(it);
+        bucket.contacts.push_back(updated);
+        return true;
+    }
+
+    NodeContact added = contact;
+    added.failed_requests = 0;
+    if (rtt_ms >= 0) {
+        added.rtt_ms = rtt_ms;
+    }
+    auto cached = std::find_if(bucket.replacements.begin(), bucket.replacements.end(), same_node);
+    if (cached != bucket.replacements.end()) {
+        bucket.replacements.erase(cached);
+    }
+
+    if (bucket.contacts.size() < bucket_size) {
+        bucket.contacts.push_back(added);
+        return true;
+    }
+
+    bucket.replacements.push_back(added);
+    if (bucket.replacements.size() > bucket_size) {
+        bucket.replacements.pop_front();
+    }
+    if (stale) {
+        *stale = bucket.contacts.front();
+    }
+    return false;
+}
+
+bool RoutingTable::record_failure(size_t node_id, int max_failures) {
+    int index = bucket_index(node_id);
+    if (index < 0) {
+        return false;
+    }
+    Bucket& bucket = buckets[index];
+    auto it = std::find_if(bucket.contacts.begin(), bucket.contacts.end(),
+                           [&](const NodeContact& entry) { return entry.node_id == node_id; });
+    if (it == bucket.contacts.end() || ++it->failed_requests < max_failures) {
+        return false;
+    }
+
+    bucket.contacts.erase(it);
+    if (!bucket.replacements.empty()) {
+        bucket.contacts.push_back(bucket.replacements.back());
+        bucket.replacements.pop_back();
+    }
+    return true;
+}
+
+std::vector<NodeContact> RoutingTable::closest(size_t target, size_t count) const {
+    std::vector<NodeContact> all;
+    for (const Bucket& bucket : buckets) {
+        all.insert(all.end(), bucket.contacts.begin(), bucket.contacts.end());
+    }
+    count = std::min(count, all.size());
+    std::partial_sort(all.begin(), all.begin() + count, all.end(), [target](const NodeContact& a, const NodeContact& b) {
+        return (a.node_id ^ target) < (b.node_id ^ target);
+    });
+    all.resize(count);
+    return all;
+}
+
+std::vector<NodeContact> RoutingTable::by_latency() const {
+    std::vector<NodeContact> all;
+    for (const Bucket& bucket : buckets) {
+        all.insert(all.end(), bucket.contacts.begin(), bucket.contacts.end());
+    }
+    std::sort(all.begin(), all.end(), [](const NodeContact& a, const NodeContact& b) {
+        bool a_measured = a.rtt_ms >= 0;
+        bool b_measured = b.rtt_ms >= 0;
+        if (a_measured != b_measured) {
+            return a_measured;
+        }
+        return a.rtt_ms != b.rtt_ms ? a.rtt_ms < b.rtt_ms : a.node_id < b.node_id;
+    });
+    return all;
+}
+
+std::vector<NodeContact> RoutingTable::stale_contacts(std::chrono::steady_clock::time_point cutoff) const {
+    std::vector<NodeContact> stale;
+    for (const Bucket& bucket : buckets) {
+        if (!bucket.contacts.empty() && bucket.contacts.front().last_seen < cutoff) {
+            stale.push_back(bucket.contacts.front());
+        }
+    }
+    return stale;
+}
+
+const NodeContact* RoutingTable::find(size_t node_id) const {
+    int index = bucket_index(node_id);
+    if (index < 0) {
+        return nullptr;
+    }
+    for (const NodeContact& contact : buckets[index].contacts) {
+        if (contact.node_id == node_id) {
+            return &contact;
+        }
+    }
+    return nullptr;
+}
+
+size_t RoutingTable::size() const {
+    size_t total = 0;
+    for (const Bucket& bucket : buckets) {
+        total += bucket.contacts.size();
+    }
+    return total;
+}
+
+/**
+ * @brief State of one iterative FIND_NODE lookup, owned by the loop thread.
+ */
+struct NodeDiscovery::Lookup {
+    size_t target;                                          ///< Id being looked up.
+    std::vector<NodeContact> candidates;                    ///< Known nodes, nearest to `target` first.
+    std::unordered_set<size_t> queried;                     ///< Candidates already asked.
+    std::unordered_set<size_t> answered;                    ///< Candidates that replied.
+    size_t in_flight = 0;                                   ///< Outstanding FIND_NODE requests.
+    bool finished = false;                                  ///< Whether `done` has been called.
+    std::function<void(std::vector<NodeContact>)> done;     ///< Receives the result.
+};
 
 NodeDiscovery::NodeDiscovery(size_t node_id, const std::string& network_address)
-    : node_id(node_id), network_address(network_address) {}
+    : node_id(node_id), network_address(network_address), table(node_id, BUCKET_SIZE), udp_socket(-1), next_rpc_id(1) {}
+
+NodeDiscovery::~NodeDiscovery() {
+    shutdown();
+    if (!peer_cache_path.empty()) {
+        try {
+            save_peer_cache(peer_cache_path);
+        } catch (const std::exception& e) {
+            LOG_WARN("discovery") << "Failed to save peer cache: " << e.what();
+        }
+    }
+}
+
+void NodeDiscovery::initialize(int port) {
+    if (udp_socket >= 0) {
+        return;
+    }
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        throw std::runtime_error("Failed to create discovery socket");
+    }
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_port = htons(static_cast<uint16_t>(port));
+    local.sin_addr.s_addr = INADDR_ANY;
+    if (bind(sock, reinterpret_cast<sockaddr*>(&local), sizeof(local)) < 0) {
+        close(sock);
+        throw std::runtime_error("Failed to bind discovery socket");
+    }
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    udp_socket = sock;
+
+    loop_thread = std::thread([this] { loop.run(); });
+    loop.post([this] {
+        loop.watch(udp_socket, EVENT_READABLE, [this](uint32_t) { handle_datagrams(); });
+        loop.post_after(PING_INTERVAL_MS, [this] { check_liveness(); });
+    });
+}
+
+void NodeDiscovery::shutdown() {
+    if (!loop_thread.joinable()) {
+        return;
+    }
+    loop.stop();
+    loop_thread.join();
+    close(udp_socket);
+    udp_socket = -1;
+
+    // Fail what is still outstanding so that blocked lookups complete with what they have.
+    std::unordered_map<uint64_t, PendingRequest> outstanding;
+    outstanding.swap(requests);
+    for (auto& entry : outstanding) {
+        entry.second.on_reply(nullptr);
+    }
+}
+
+void NodeDiscovery::set_peer_cache(const std::string& path) {
+    peer_cache_path = path;
+    load_peer_cache(path);
+}
+
+void NodeDiscovery::load_peer_cache(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        return;
+    }
+    size_t loaded = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        NodeContact contact;
+        if (!(fields >> contact.node_id >> contact.address >> contact.rtt_ms) || contact.node_id == node_id) {
+            continue;
+        }
+        try {
+            contact.address = format_address(parse_address(contact.address));
+        } catch (const std::invalid_argument&) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(table_mutex);
+        loaded += table.observe(contact, -1.0) ? 1 : 0;
+    }
+    LOG_INFO("discovery") << "Node " << node_id << " loaded " << loaded << " cached peers from " << path;
+}
+
+void NodeDiscovery::save_peer_cache(const std::string& path) const {
+    std::vector<NodeContact> contacts;
+    {
+        std::lock_guard<std::mutex> lock(table_mutex);
+        contacts = table.by_latency();
+    }
+
+    // Write a sibling file and rename it over the old cache, so a crash never leaves a truncated cache behind.
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Failed to open peer cache " + temporary);
+        }
+        for (const NodeContact& contact : contacts) {
+            out << contact.node_id << " " << contact.address << " " << contact.rtt_ms << "\n";
+        }
+        if (!out.flush()) {
+            throw std::runtime_error("Failed to write peer cache " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Failed to replace peer cache " + path);
+    }
+}
 
 void NodeDiscovery::discover_nodes() {
-    std::cout << "Node " << node_id << " is discovering nodes on the network..." << std::endl;
-    
-    // Simulate node discovery (in a real scenario, this could involve network protocols like UDP for broadcasting)
-    add_node(1, "192.168.1.1");
-    add_node(2, "192.168.1.2");
-    add_node(3, "192.168.1.3");
+    if (udp_socket < 0) {
+        throw std::runtime_error("Node discovery is not initialized");
+    }
+    LOG_INFO("discovery") << "Node " << node_id << " is discovering nodes on the network...";
+
+    // The self-lookup fills the buckets near this node; random targets in the farthest buckets, which cover most of
+    // the id space, fill the rest.
+    std::mt19937_64 random(std::random_device{}());
+    std::vector<size_t> targets{ node_id };
+    for (size_t i = 0; i < REFRESH_LOOKUPS; ++i) {
+        uint64_t bit = uint64_t(1) << (RoutingTable::BUCKET_COUNT - 1 - i);
+        targets.push_back(node_id ^ static_cast<size_t>(bit | (random() & (bit - 1))));
+    }
+
+    std::vector<std::shared_ptr<std::promise<void>>> finished;
+    for (size_t target : targets) {
+        auto promise = std::make_shared<std::promise<void>>();
+        finished.push_back(promise);
+        loop.post([this, target, promise] {
+            start_lookup(target, [promise](std::vector<NodeContact>) { promise->set_value(); });
+        });
+    }
+    for (auto& promise : finished) {
+        promise->get_future().wait();
+    }
+
+    LOG_INFO("discovery") << "Discovery complete. Known nodes: " << get_known_nodes().size();
+    if (!peer_cache_path.empty()) {
+        save_peer_cache(peer_cache_path);
+    }
+}
 
-    std::cout << "Discovery complete. Known nodes: " << known_nodes.size() << std::endl;
+std::vector<NodeContact> NodeDiscovery::lookup(size_t target) {
+    if (udp_socket < 0) {
+        throw std::runtime_error("Node discovery is not initialized");
+    }
+    auto promise = std::make_shared<std::promise<std::vector<NodeContact>>>();
+    std::future<std::vector<NodeContact>> result = promise->get_future();
+    loop.post([this, target, promise] {
+        start_lookup(target, [promise](std::vector<NodeContact> nodes) { promise->set_value(std::move(nodes)); });
+    });
+    return result.get();
 }
 
 void NodeDiscovery::add_node(size_t new_node_id, const std::string& address) {
-    if (known_nodes.find(new_node_id) == known_nodes.end()) {
-        known_nodes[new_node_id] = address;
-        std::cout << "Node " << node_id << " added new node: " << new_node_id << " (" << address << ")" << std::endl;
-    } else {
-        std::cout << "Node " << new_node_id << " is already known." << std::endl;
+    NodeContact contact;
+    contact.node_id = new_node_id;
+    contact.address = format_address(parse_address(address));
+
+    std::lock_guard<std::mutex> lock(table_mutex);
+    if (table.find(new_node_id) != nullptr) {
+        LOG_DEBUG("discovery") << "Node " << new_node_id << " is already known.";
+    } else if (table.observe(contact, -1.0)) {
+        LOG_INFO("discovery") << "Node " << node_id << " added new node: " << new_node_id << " (" << contact.address << ")";
     }
 }
 
 std::vector<size_t> NodeDiscovery::get_known_nodes() const {
     std::vector<size_t> nodes;
-    for (const auto& node : known_nodes) {
-        nodes.push_back(node.first);
+    std::lock_guard<std::mutex> lock(table_mutex);
+    for (const NodeContact& contact : table.by_latency()) {
+        nodes.push_back(contact.node_id);
     }
     return nodes;
 }
 
 std::string NodeDiscovery::get_node_address(size_t search_node_id) const {
-    auto it = known_nodes.find(search_node_id);
-    if (it != known_nodes.end()) {
-        return it->second;
+    std::lock_guard<std::mutex> lock(table_mutex);
+    const NodeContact* contact = table.find(search_node_id);
+    if (contact != nullptr) {
+        return contact->address;
     }
     return "Unknown node";
 }
+
+void NodeDiscovery::handle_datagrams() {
+    char buffer[MAX_DATAGRAM_SIZE];
+    while (true) {
+        sockaddr_in from{};
+        socklen_t from_length = sizeof(from);
+        ssize_t received = recvfrom(udp_socket, buffer, sizeof(buffer), 0, reinterpret_cast<sockaddr*>(&from), &from_length);
+        if (received < 0) {
+            return;  // EAGAIN: drained; other errors (e.g. ICMP port unreachable) are left to the request timeouts.
+        }
+        handle_datagram(std::string(buffer, static_cast<size_t>(received)), format_address(from));
+    }
+}
+
+void NodeDiscovery::handle_datagram(const std::string& datagram, const std::string& from) {
+    if (datagram.size() < DISCOVERY_HEADER_SIZE) {
+        return;
+    }
+    uint8_t kind = static_cast<uint8_t>(datagram[0]);
+    uint64_t rpc_id = get_be(datagram, 1, 8);
+    size_t sender = static_cast<size_t>(get_be(datagram, 9, 8));
+    if (sender == node_id) {
+        return;
+    }
+    NodeContact contact;
+    contact.node_id = sender;
+    contact.address = from;
+    contact.last_seen = std::chrono::steady_clock::now();
+
+    if (kind == DISCOVERY_PING) {
+        send_datagram(from, encode_header(DISCOVERY_PONG, rpc_id, node_id));
+        observe(contact, -1.0);
+    } else if (kind == DISCOVERY_FIND_NODE) {
+        if (datagram.size() != DISCOVERY_HEADER_SIZE + 8) {
+            return;
+        }
+        size_t target = static_cast<size_t>(get_be(datagram, DISCOVERY_HEADER_SIZE, 8));
+        std::vector<NodeContact> nodes;
+        {
+            std::lock_guard<std::mutex> lock(table_mutex);
+            nodes = table.closest(target, BUCKET_SIZE + 1);
+        }
+        std::string reply = encode_header(DISCOVERY_NODES, rpc_id, node_id);
+        std::string entries;
+        uint8_t count = 0;
+        for (const NodeContact& node : nodes) {
+            if (node.node_id == sender || count == BUCKET_SIZE) {
+                continue;
+            }
+            sockaddr_in address = parse_address(node.address);
+            put_be(entries, node.node_id, 8);
+            entries.append(reinterpret_cast<const char*>(&address.sin_addr.s_addr), 4);
+            entries.append(reinterpret_cast<const char*>(&address.sin_port), 2);
+            count++;
+        }
+        reply.push_back(static_cast<char>(count));
+        reply.append(entries);
+        send_datagram(from, reply);
+        observe(contact, -1.0);
+    } else if (kind == DISCOVERY_PONG || kind == DISCOVERY_NODES) {
+        auto it = requests.find(rpc_id);
+        if (it == requests.end() || it->second.node_id != sender) {
+            return;  // Late, duplicated or spoofed reply.
+        }
+        PendingRequest request = std::move(it->second);
+        requests.erase(it);
+        double rtt_ms = std::chrono::duration<double, std::milli>(contact.last_seen - request.sent_at).count();
+        observe(contact, rtt_ms);
+        request.on_reply(&datagram);
+    }
+}
+
+void NodeDiscovery::send_datagram(const std::string& address, const std::string& datagram) {
+    try {
+        sockaddr_in destination = parse_address(address);
+        sendto(udp_socket, datagram.data(), datagram.size(), 0, reinterpret_cast<sockaddr*>(&destination), sizeof(destination));
+    } catch (const std::invalid_argument&) {
+        // Addresses are validated on entry; nothing sensible to send to otherwise.
+    }
+}
+
+void NodeDiscovery::send_request(const NodeContact& contact, uint8_t kind, const std::string& body, ReplyHandler on_reply) {
+    if (udp_socket < 0) {
+        on_reply(nullptr);
+        return;
+    }
+    uint64_t rpc_id = next_rpc_id++;
+    requests[rpc_id] = PendingRequest{ contact.node_id, std::chrono::steady_clock::now(), std::move(on_reply) };
+    send_datagram(contact.address, encode_header(kind, rpc_id, node_id) + body);
+
+    loop.post_after(REQUEST_TIMEOUT_MS, [this, rpc_id] {
+        auto it = requests.find(rpc_id);
+        if (it == requests.end()) {
+            return;
+        }
+        PendingRequest request = std::move(it->second);
+        requests.erase(it);
+        {
+            std::lock_guard<std::mutex> lock(table_mutex);
+            table.record_failure(request.node_id, MAX_FAILED_REQUESTS);
+        }
+        request.on_reply(nullptr);
+    });
+}
+
+void NodeDiscovery::observe(const NodeContact& contact, double rtt_ms) {
+    NodeContact stale;
+    bool inserted;
+    {
+        std::lock_guard<std::mutex> lock(table_mutex);
+        inserted = table.observe(contact, rtt_ms, &stale);
+    }
+    if (!inserted && !stale.address.empty()) {
+        // The bucket is full: the newcomer only gets in if its least recently seen member is gone.
+        send_request(stale, DISCOVERY_PING, std::string(), [](const std::string*) {});
+    }
+}
+
+void NodeDiscovery::start_lookup(size_t target, std::function<void(std::vector<NodeContact>)> done) {
+    auto lookup = std::make_shared<Lookup>();
+    lookup->target = target;
+    lookup->done = std::move(done);
+    {
+        std::lock_guard<std::mutex> lock(table_mutex);
+        lookup->candidates = table.closest(target, BUCKET_SIZE);
+    }
+    step_lookup(lookup);
+}
+
+void NodeDiscovery::step_lookup(const std::shared_ptr<Lookup>& lookup) {
+    if (lookup->finished) {
+        return;
+    }
+
+    // Query the nearest unqueried nodes among the BUCKET_SIZE nearest known ones, keeping LOOKUP_PARALLELISM in flight.
+    std::vector<NodeContact> to_query;
+    size_t considered = 0;
+    for (const NodeContact& candidate : lookup->candidates) {
+        if (considered++ == BUCKET_SIZE || lookup->in_flight + to_query.size() >= LOOKUP_PARALLELISM) {
+            break;
+        }
+        if (lookup->queried.insert(candidate.node_id).second) {
+            to_query.push_back(candidate);
+        }
+    }
+    lookup->in_flight += to_query.size();
+
+    if (lookup->in_flight == 0) {
+        // Every one of the nearest candidates has been asked and none is outstanding: the lookup has converged.
+        lookup->finished = true;
+        std::vector<NodeContact> result;
+        for (const NodeContact& candidate : lookup->candidates) {
+            if (result.size() < BUCKET_SIZE && lookup->answered.count(candidate.node_id)) {
+                result.push_back(candidate);
+            }
+        }
+        lookup->done(std::move(result));
+        return;
+    }
+
+    std::string body;
+    put_be(body, lookup->target, 8);
+    for (const NodeContact& contact : to_query) {
+        size_t queried_id = contact.node_id;
+        send_request(contact, DISCOVERY_FIND_NODE, body, [this, lookup, queried_id](const std::string* reply) {
+            lookup->in_flight--;
+            auto& candidates = lookup->candidates;
+            if (reply == nullptr) {
+                candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                                [&](const NodeContact& c) { return c.node_id == queried_id; }),
+                                 candidates.end());
+                step_lookup(lookup);
+                return;
+            }
+
+            lookup->answered.insert(queried_id);
+            size_t count = reply->size() > DISCOVERY_HEADER_SIZE ? static_cast<uint8_t>((*reply)[DISCOVERY_HEADER_SIZE]) : 0;
+            if (reply->size() == DISCOVERY_HEADER_SIZE + 1 + count * NODE_ENTRY_SIZE) {
+                for (size_t i = 0; i < count; ++i) {
+                    size_t offset = DISCOVERY_HEADER_SIZE + 1 + i * NODE_ENTRY_SIZE;
+                    NodeContact found;
+                    found.node_id = static_cast<size_t>(get_be(*reply, offset, 8));
+                    sockaddr_in address{};
+                    address.sin_family = AF_INET;
+                    memcpy(&address.sin_addr.s_addr, reply->data() + offset + 8, 4);
+                    memcpy(&address.sin_port, reply->data() + offset + 12, 2);
+                    found.address = format_address(address);
+                    bool known = std::any_of(candidates.begin(), candidates.end(),
+                                             [&](const NodeContact& c) { return c.node_id == found.node_id; });
+                    if (found.node_id != node_id && !known) {
+                        candidates.push_back(found);
+                    }
+                }
+                size_t target = lookup->target;
+                std::sort(candidates.begin(), candidates.end(), [target](const NodeContact& a, const NodeContact& b) {
+                    return (a.node_id ^ target) < (b.node_id ^ target);
+                });
+            }
+            step_lookup(lookup);
+        });
+    }
+}
+
+void NodeDiscovery::check_liveness() {
+    std::vector<NodeContact> stale;
+    {
+        std::lock_guard<std::mutex> lock(table_mutex);
+        stale = table.stale_contacts(std::chrono::steady_clock::now() - std::chrono::milliseconds(PING_INTERVAL_MS));
+    }
+    for (const NodeContact& contact : stale) {
+        send_request(contact, DISCOVERY_PING, std::string(), [](const std::string*) {});
+    }
+    loop.post_after(PING_INTERVAL_MS, [this] { check_liveness(); });
+}
@@ -1,25 +1,95 @@
 #include "network/p2p_protocol.hpp"
-#include <iostream>
+#include "logging/logger.hpp"
 #include <stdexcept>
+#include <algorithm>
 #include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/tcp.h>
 #include <unistd.h>
 #include <cstring>
+#include <cerrno>
 #include <fcntl.h>
 
-P2PProtocol::P2PProtocol(size_t node_id, const std::string& network_address)
-    : node_id(node_id), network_address(network_address), listen_socket(-1), stop_flag(false) {}
+const size_t MAX_IOVECS_PER_WRITE = 64;     // Frames gathered into one sendmsg() call.
+const size_t RECEIVE_CHUNK_SIZE = 65536;    // Bytes requested per recv() call.
+const size_t MAX_READS_PER_EVENT = 16;      // Bounds the time one busy connection holds its event loop.
+const int CONNECT_TIMEOUT_MS = 3000;        // Unreachable peers are retried instead of waited on.
+
+const int P2PProtocol::DEFAULT_PEER_PORT;
+const uint32_t P2PProtocol::MAX_FRAME_SIZE;
+const size_t P2PProtocol::MAX_OUTBOUND_QUEUE;
+const size_t P2PProtocol::MAX_OUTBOUND_BYTES;
+const int P2PProtocol::INITIAL_BACKOFF_MS;
+const int P2PProtocol::MAX_BACKOFF_MS;
+const size_t P2PProtocol::DEFAULT_IO_THREADS;
+const size_t P2PProtocol::DEFAULT_INBOUND_QUEUE;
+
+// Splits "ip" or "ip:port" into its parts, validating the IPv4 address.
+static void parse_peer_address(const std::string& address, std::string& host, int& port) {
+    size_t colon = address.rfind(':');
+    host = address.substr(0, colon);
+    port = P2PProtocol::DEFAULT_PEER_PORT;
+    if (colon != std::string::npos) {
+        try {
+            port = std::stoi(address.substr(colon + 1));
+        } catch (const std::exception&) {
+            throw std::invalid_argument("Invalid peer port: " + address);
+        }
+    }
+
+    in_addr parsed{};
+    if (inet_pton(AF_INET, host.c_str(), &parsed) <= 0 || port <= 0 || port > 65535) {
+        throw std::invalid_argument("Invalid peer address: " + address);
+    }
+}
+
+// Prefixes a message with its 4-byte big-endian length.
+static std::string encode_frame(const std::string& message) {
+    uint32_t length = htonl(static_cast<uint32_t>(message.size()));
+    std::string frame(sizeof(length) + message.size(), '\0');
+    memcpy(&frame[0], &length, sizeof(length));
+    memcpy(&frame[sizeof(length)], message.data(), message.size());
+    return frame;
+}
+
+static void make_non_blocking(int sock) {
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    int opt = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+}
+
+P2PProtocol::P2PProtocol(size_t node_id, const std::string& network_address, size_t io_threads,
+                         size_t inbound_queue_capacity)
+    : node_id(node_id), network_address(network_address), listen_socket(-1), stop_flag(false), next_loop(0), next_connection_id(0),
+      inbound_queue(inbound_queue_capacity) {
+    message_handler = [](const std::string&, const std::string& message) {
+        LOG_DEBUG("p2p") << "Received message: " << message;
+    };
+
+    size_t thread_count = std::max<size_t>(io_threads, 1);
+    for (size_t i = 0; i < thread_count; ++i) {
+        loops.emplace_back(new EventLoop());
+    }
+    for (auto& loop : loops) {
+        this->io_threads.emplace_back(&EventLoop::run, loop.get());
+    }
+    dispatch_thread = std::thread(&P2PProtocol::dispatch_messages, this);
+    metrics_collector = MetricsRegistry::instance().add_collector(
+        [this](MetricsWriter& writer) { collect_metrics(writer); });
+}
 
 P2PProtocol::~P2PProtocol() {
     shutdown();
-    if (incoming_thread.joinable()) {
-        incoming_thread.join();
-    }
 }
 
 void P2PProtocol::initialize(int port) {
     setup_listen_socket(port);
-    incoming_thread = std::thread(&P2PProtocol::handle_incoming_connections, this);
-    std::cout << "Node " << node_id << " initialized on " << network_address << ":" << port << std::endl;
+    loops.front()->post([this] {
+        loops.front()->watch(listen_socket, EVENT_READABLE, [this](uint32_t) { handle_incoming_connections(); });
+    });
+    LOG_INFO("p2p") << "Node " << node_id << " initialized on " << network_address << ":" << port << " ("
+                    << loops.size() << " " << EventLoop::backend() << " I/O threads)";
 }
 
 void P2PProtocol::setup_listen_socket(int port) {
@@ -44,82 +114,325 @@ void P2PProtocol::setup_listen_socket(int port) {
         throw std::runtime_error("Failed to bind socket");
     }
 
-    if (listen(listen_socket, 10) < 0) {
+    if (listen(listen_socket, 128) < 0) {
         close(listen_socket);
         throw std::runtime_error("Failed to listen on socket");
     }
+    fcntl(listen_socket, F_SETFL, fcntl(listen_socket, F_GETFL, 0) | O_NONBLOCK);
+}
+
+EventLoop& P2PProtocol::assign_loop() {
+    return *loops[next_loop++ % loops.size()];
 }
 
 void P2PProtocol::handle_incoming_connections() {
     while (!stop_flag) {
-        if (listen_socket < 0) break;
-        
         sockaddr_in client_addr{};
         socklen_t client_len = sizeof(client_addr);
         int client_socket = accept(listen_socket, (struct sockaddr*)&client_addr, &client_len);
 
-        if (client_socket >= 0) {
-            std::thread(&P2PProtocol::handle_peer_connection, this, client_socket).detach();
-        } else if (listen_socket != -1) {
-            perror("Failed to accept connection");
+        if (client_socket < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            const int error = errno;
+            if (error != EAGAIN && error != EWOULDBLOCK) {
+                LOG_WARN_LIMITED("p2p", 10) << "Failed to accept connection: " << strerror(error);
+            }
+            return;
+        }
+
+        make_non_blocking(client_socket);
+        char address[INET_ADDRSTRLEN] = {};
+        inet_ntop(AF_INET, &client_addr.sin_addr, address, sizeof(address));
+
+        // Keyed by id, not by socket: another loop may still be closing a connection whose descriptor was reused.
+        Connection* connection = new Connection();
+        connection->loop = &assign_loop();
+        connection->id = next_connection_id++;
+        connection->socket = client_socket;
+        connection->remote = std::string(address) + ":" + std::to_string(ntohs(client_addr.sin_port));
+        {
+            std::lock_guard<std::mutex> lock(inbound_mutex);
+            inbound[connection->id].reset(connection);
         }
+        connection->loop->post([this, connection] {
+            connection->loop->watch(connection->socket, EVENT_READABLE,
+                                    [this, connection](uint32_t events) { handle_connection_event(*connection, events); });
+        });
     }
 }
 
-void P2PProtocol::handle_peer_connection(int peer_socket) {
-    char buffer[1024];
-    memset(buffer, 0, sizeof(buffer));
+void P2PProtocol::handle_connection_event(Connection& connection, uint32_t events) {
+    if (connection.connecting) {
+        int error = 0;
+        socklen_t error_len = sizeof(error);
+        getsockopt(connection.socket, SOL_SOCKET, SO_ERROR, &error, &error_len);
+        if (error != 0) {
+            close_connection(connection);
+            return;
+        }
+        connection.connecting = false;
+        connection.backoff_ms = INITIAL_BACKOFF_MS;
+        connection.loop->modify(connection.socket, EVENT_READABLE | EVENT_WRITABLE);
+        write_frames(connection);
+        return;
+    }
 
-    int bytes_read = recv(peer_socket, buffer, sizeof(buffer) - 1, 0);
-    if (bytes_read > 0) {
-        buffer[bytes_read] = '\0';
-        std::string message(buffer);
-        std::cout << "Received message: " << message << std::endl;
-    } else if (bytes_read < 0) {
-        perror("Failed to read from peer socket");
+    if (events & (EVENT_READABLE | EVENT_ERROR)) {
+        if (!read_frames(connection)) {
+            return;
+        }
+    }
+    if (events & EVENT_WRITABLE) {
+        write_frames(connection);
     }
+}
 
-    close(peer_socket);
+bool P2PProtocol::read_frames(Connection& connection) {
+    char chunk[RECEIVE_CHUNK_SIZE];
+    for (size_t reads = 0; reads < MAX_READS_PER_EVENT; ++reads) {
+        ssize_t bytes_read = recv(connection.socket, chunk, sizeof(chunk), 0);
+        if (bytes_read < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (bytes_read <= 0) {
+            close_connection(connection);
+            return false;
+        }
+        connection.bytes_received.fetch_add(static_cast<uint64_t>(bytes_read), std::memory_order_relaxed);
+        connection.read_buffer.append(chunk, static_cast<size_t>(bytes_read));
+        if (static_cast<size_t>(bytes_read) < sizeof(chunk)) {
+            break;
+        }
+    }
+
+    std::string& buffer = connection.read_buffer;
+    size_t position = 0;
+    while (buffer.size() - position >= sizeof(uint32_t)) {
+        uint32_t length;
+        memcpy(&length, buffer.data() + position, sizeof(length));
+        length = ntohl(length);
+        if (length > MAX_FRAME_SIZE) {
+            LOG_WARN_LIMITED("p2p", 10) << "Peer " << connection.remote << " sent an oversized frame; closing connection";
+            close_connection(connection);
+            return false;
+        }
+        if (buffer.size() - position - sizeof(length) < length) {
+            break;
+        }
+        // Blocks while the handler is behind, which pauses reading on this loop until it catches up.
+        if (!inbound_queue.push(InboundMessage{ connection.remote, buffer.substr(position + sizeof(length), length) })) {
+            return false;
+        }
+        position += sizeof(length) + length;
+    }
+    buffer.erase(0, position);
+    update_buffered_bytes(connection);
+    return true;
 }
 
-void P2PProtocol::send_message(size_t peer_node_id, const std::string& message) {
-    std::shared_lock<std::shared_mutex> lock(peer_mutex);
-    auto it = peer_addresses.find(peer_node_id);
-    if (it == peer_addresses.end()) {
-        throw std::runtime_error("Peer address not found");
+bool P2PProtocol::write_frames(Connection& connection) {
+    while (!connection.outbound.empty()) {
+        iovec iov[MAX_IOVECS_PER_WRITE];
+        size_t count = 0;
+        for (auto it = connection.outbound.begin(); it != connection.outbound.end() && count < MAX_IOVECS_PER_WRITE;
+             ++it, ++count) {
+            size_t skip = count == 0 ? connection.write_offset : 0;
+            iov[count].iov_base = const_cast<char*>(it->data() + skip);
+            iov[count].iov_len = it->size() - skip;
+        }
+
+        msghdr header{};
+        header.msg_iov = iov;
+        header.msg_iovlen = count;
+        ssize_t written = sendmsg(connection.socket, &header, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            close_connection(connection);
+            return false;
+        }
+
+        connection.bytes_sent.fetch_add(static_cast<uint64_t>(written), std::memory_order_relaxed);
+        size_t remaining = static_cast<size_t>(written);
+        while (remaining > 0) {
+            size_t left = connection.outbound.front().size() - connection.write_offset;
+            if (remaining < left) {
+                connection.write_offset += remaining;
+                break;
+            }
+            remaining -= left;
+            connection.outbound_bytes -= connection.outbound.front().size();
+            connection.outbound.pop_front();
+            connection.write_offset = 0;
+        }
+    }
+
+    // Only ask for writability while there is something left to write.
+    uint32_t interest = EVENT_READABLE | (connection.outbound.empty() ? 0 : EVENT_WRITABLE);
+    connection.loop->modify(connection.socket, interest);
+    update_buffered_bytes(connection);
+    return true;
+}
+
+void P2PProtocol::enqueue_frame(Connection& connection, std::string frame) {
+    connection.outbound_bytes += frame.size();
+    connection.outbound.push_back(std::move(frame));
+
+    // Drop the oldest frames beyond the limits, but never one that is partially on the wire.
+    size_t first_droppable = connection.write_offset > 0 ? 1 : 0;
+    while (connection.outbound.size() > first_droppable + 1 &&
+           (connection.outbound.size() > MAX_OUTBOUND_QUEUE || connection.outbound_bytes > MAX_OUTBOUND_BYTES)) {
+        auto victim = connection.outbound.begin() + first_droppable;
+        connection.outbound_bytes -= victim->size();
+        connection.outbound.erase(victim);
+        connection.dropped++;
     }
-    std::string peer_address = it->second;
 
+    if (connection.socket < 0) {
+        if (!connection.reconnect_pending) {
+            start_connect(connection);
+        }
+    } else if (!connection.connecting) {
+        write_frames(connection);
+        return;
+    }
+    update_buffered_bytes(connection);
+}
+
+void P2PProtocol::start_connect(Connection& connection) {
     sockaddr_in peer_addr{};
     peer_addr.sin_family = AF_INET;
-    peer_addr.sin_port = htons(8080);
-    if (inet_pton(AF_INET, peer_address.c_str(), &peer_addr.sin_addr) <= 0) {
-        throw std::runtime_error("Invalid peer address");
-    }
+    peer_addr.sin_port = htons(connection.port);
+    inet_pton(AF_INET, connection.host.c_str(), &peer_addr.sin_addr);
 
     int sock = socket(AF_INET, SOCK_STREAM, 0);
     if (sock < 0) {
-        throw std::runtime_error("Failed to create socket");
+        schedule_reconnect(connection);
+        return;
     }
-
-    if (connect(sock, (struct sockaddr*)&peer_addr, sizeof(peer_addr)) < 0) {
+    make_non_blocking(sock);
+    if (connect(sock, (struct sockaddr*)&peer_addr, sizeof(peer_addr)) < 0 && errno != EINPROGRESS) {
         close(sock);
-        throw std::runtime_error("Failed to connect to peer");
+        schedule_reconnect(connection);
+        return;
     }
 
-    if (send(sock, message.c_str(), message.length(), 0) < 0) {
-        close(sock);
-        throw std::runtime_error("Failed to send message to peer");
+    // Completion (or failure) is reported as writability.
+    connection.socket = sock;
+    connection.connecting = true;
+    uint64_t attempt = ++connection.attempt;
+    Connection* target = &connection;
+    connection.loop->watch(sock, EVENT_WRITABLE, [this, target](uint32_t events) { handle_connection_event(*target, events); });
+    connection.loop->post_after(CONNECT_TIMEOUT_MS, [this, target, attempt] {
+        if (target->connecting && target->attempt == attempt) {
+            close_connection(*target);
+        }
+    });
+}
+
+void P2PProtocol::schedule_reconnect(Connection& connection) {
+    if (connection.reconnect_pending || stop_flag) {
+        return;
     }
+    connection.reconnect_pending = true;
+    Connection* target = &connection;
+    connection.loop->post_after(connection.backoff_ms, [this, target] {
+        target->reconnect_pending = false;
+        if (target->socket < 0 && !target->outbound.empty()) {
+            start_connect(*target);
+        }
+    });
+    connection.backoff_ms = std::min(connection.backoff_ms * 2, MAX_BACKOFF_MS);
+}
 
+void P2PProtocol::close_connection(Connection& connection) {
+    const int sock = connection.socket;
+    connection.loop->unwatch(sock);
+    connection.socket = -1;
+    connection.connecting = false;
+    connection.read_buffer.clear();
+
+    if (!connection.dialer) {
+        // Drop the entry before releasing the descriptor, so its number cannot be accepted again while it is held.
+        std::unique_ptr<Connection> closed;
+        {
+            std::lock_guard<std::mutex> lock(inbound_mutex);
+            auto it = inbound.find(connection.id);
+            if (it != inbound.end()) {
+                closed = std::move(it->second);
+                inbound.erase(it);
+            }
+        }
+        close(sock);
+        return;
+    }
     close(sock);
+
+    // A partially written frame is resent whole on the next connection.
+    connection.write_offset = 0;
+    update_buffered_bytes(connection);
+    if (!connection.outbound.empty()) {
+        schedule_reconnect(connection);
+    }
+}
+
+void P2PProtocol::update_buffered_bytes(Connection& connection) {
+    connection.queued = connection.outbound.size();
+    connection.buffered_bytes = connection.outbound_bytes + connection.read_buffer.size();
+}
+
+void P2PProtocol::dispatch_messages() {
+    InboundMessage message;
+    while (inbound_queue.pop(message)) {
+        std::lock_guard<std::mutex> lock(handler_mutex);
+        message_handler(message.remote_address, message.payload);
+    }
+}
+
+void P2PProtocol::send_message(size_t peer_node_id, const std::string& message) {
+    if (message.size() > MAX_FRAME_SIZE) {
+        throw std::invalid_argument("Message exceeds the maximum frame size");
+    }
+
+    std::shared_lock<std::shared_mutex> lock(peer_mutex);
+    auto it = connections.find(peer_node_id);
+    if (it == connections.end()) {
+        throw std::runtime_error("Peer address not found");
+    }
+
+    Connection* connection = it->second.get();
+    connection->loop->post([this, connection, frame = encode_frame(message)]() mutable {
+        enqueue_frame(*connection, std::move(frame));
+    });
+}
+
+void P2PProtocol::set_message_handler(MessageHandler handler) {
+    std::lock_guard<std::mutex> lock(handler_mutex);
+    message_handler = std::move(handler);
 }
 
 void P2PProtocol::add_peer(size_t peer_node_id, const std::string& peer_address) {
     std::lock_guard<std::shared_mutex> lock(peer_mutex);
     if (peer_addresses.find(peer_node_id) == peer_addresses.end()) {
+        std::unique_ptr<Connection> connection(new Connection());
+        parse_peer_address(peer_address, connection->host, connection->port);
+        connection->loop = &assign_loop();
+        connection->remote = connection->host + ":" + std::to_string(connection->port);
+        connection->dialer = true;
+        connection->backoff_ms = INITIAL_BACKOFF_MS;
+
         peers.push_back(peer_node_id);
         peer_addresses[peer_node_id] = peer_address;
+        connections[peer_node_id] = std::move(connection);
     }
 }
 
@@ -137,10 +450,95 @@ std::string P2PProtocol::get_peer_address(size_t peer_node_id) const {
     return "Unknown";
 }
 
+size_t P2PProtocol::get_queued_messages(size_t peer_node_id) const {
+    std::shared_lock<std::shared_mutex> lock(peer_mutex);
+    auto it = connections.find(peer_node_id);
+    return it == connections.end() ? 0 : it->second->queued.load();
+}
+
+size_t P2PProtocol::get_dropped_messages(size_t peer_node_id) const {
+    std::shared_lock<std::shared_mutex> lock(peer_mutex);
+    auto it = connections.find(peer_node_id);
+    return it == connections.end() ? 0 : it->second->dropped.load();
+}
+
+size_t P2PProtocol::get_buffered_bytes() const {
+    size_t total = 0;
+    {
+        std::shared_lock<std::shared_mutex> lock(peer_mutex);
+        for (const auto& entry : connections) {
+            total += entry.second->buffered_bytes;
+        }
+    }
+    std::lock_guard<std::mutex> lock(inbound_mutex);
+    for (const auto& entry : inbound) {
+        total += entry.second->buffered_bytes;
+    }
+    return total;
+}
+
+void P2PProtocol::collect_metrics(MetricsWriter& writer) const {
+    auto emit = [&writer](const std::string& labels, const Connection& connection) {
+        writer.sample("synledger_p2p_sent_bytes_total", "counter", "Bytes written to a peer connection", labels,
+                      static_cast<double>(connection.bytes_sent.load(std::memory_order_relaxed)));
+        writer.sample("synledger_p2p_received_bytes_total", "counter", "Bytes read from a peer connection", labels,
+                      static_cast<double>(connection.bytes_received.load(std::memory_order_relaxed)));
+        writer.sample("synledger_p2p_queued_frames", "gauge", "Frames waiting to be written to a peer", labels,
+                      static_cast<double>(connection.queued.load(std::memory_order_relaxed)));
+        writer.sample("synledger_p2p_dropped_frames_total", "counter", "Frames dropped because a peer queue was full",
+                      labels, static_cast<double>(connection.dropped.load(std::memory_order_relaxed)));
+    };
+
+    const std::string node = "node=\"" + std::to_string(node_id) + "\",";
+    {
+        std::shared_lock<std::shared_mutex> lock(peer_mutex);
+        for (const auto& entry : connections) {
+            emit(node + "direction=\"out\",peer=\"" + std::to_string(entry.first) + "\"", *entry.second);
+        }
+    }
+    std::lock_guard<std::mutex> lock(inbound_mutex);
+    for (const auto& entry : inbound) {
+        emit(node + "direction=\"in\",peer=\"" + entry.second->remote + "\"", *entry.second);
+    }
+}
+
+size_t P2PProtocol::get_io_thread_count() const {
+    return loops.size();
+}
+
 void P2PProtocol::shutdown() {
-    stop_flag = true;
+    if (stop_flag.exchange(true)) {
+        return;
+    }
+    MetricsRegistry::instance().remove_collector(metrics_collector);
+
+    // Closing the queue releases a loop blocked on a full queue and ends the dispatcher.
+    inbound_queue.close();
+    for (auto& loop : loops) {
+        loop->stop();
+    }
+    for (std::thread& thread : io_threads) {
+        thread.join();
+    }
+    dispatch_thread.join();
+
+    // The loops are stopped, so connection state can be torn down from this thread.
     if (listen_socket >= 0) {
         close(listen_socket);
         listen_socket = -1;
     }
+    std::lock_guard<std::shared_mutex> lock(peer_mutex);
+    for (auto& entry : connections) {
+        if (entry.second->socket >= 0) {
+            close(entry.second->socket);
+            entry.second->socket = -1;
+        }
+    }
+    std::lock_guard<std::mutex> inbound_lock(inbound_mutex);
+    for (auto& entry : inbound) {
+        if (entry.second->socket >= 0) {
+            close(entry.second->socket);
+        }
+    }
+    inbound.clear();
 }
@@ -1,62 +1,261 @@
 #include "subnet/subnet_manager.hpp"
 #include <algorithm>
+#include <numeric>
+#include <stdexcept>
 
-SubnetManager::SubnetManager(size_t total_subnets) 
-    : total_subnets(total_subnets) {}
+const size_t SubnetManager::VIRTUAL_NODES;
+const size_t SubnetManager::NODE_SHARDS;
+
+const double LOAD_BOUND = 1.25;  // A subnet accepts joins until it holds this multiple of the average load.
+
+// SplitMix64 finalizer: spreads consecutive ids uniformly over the ring.
+static uint64_t mix64(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+SubnetManager::SubnetManager(size_t total_subnets)
+    : total_subnets(total_subnets), loads(total_subnets, 0), node_count(0) {
+    if (total_subnets == 0) {
+        throw std::invalid_argument("A subnet manager needs at least one subnet");
+    }
+
+    ring.reserve(total_subnets * VIRTUAL_NODES);
+    for (size_t subnet_id = 0; subnet_id < total_subnets; ++subnet_id) {
+        for (size_t replica = 0; replica < VIRTUAL_NODES; ++replica) {
+            ring.emplace_back(mix64(mix64(subnet_id) ^ replica), subnet_id);
+        }
+    }
+    std::sort(ring.begin(), ring.end());
+
+    auto topology = std::make_shared<Topology>();
+    auto empty_shard = std::make_shared<const NodeShard>();
+    auto empty_subnet = std::make_shared<const std::vector<size_t>>();
+    topology->node_shards.fill(empty_shard);
+    topology->subnet_nodes.assign(total_subnets, empty_subnet);
+    published = topology;
+}
+
+uint64_t SubnetManager::node_point(size_t node_id) {
+    return mix64(static_cast<uint64_t>(node_id) ^ 0x5B8F3A1C6D2E4F70ull);
+}
+
+template <typename HasRoom>
+size_t SubnetManager::walk_ring(size_t node_id, HasRoom has_room) const {
+    auto start = std::lower_bound(ring.begin(), ring.end(), std::make_pair(node_point(node_id), size_t(0)));
+    size_t offset = static_cast<size_t>(start - ring.begin());
+    for (size_t step = 0; step < ring.size(); ++step) {
+        size_t subnet_id = ring[(offset + step) % ring.size()].second;
+        if (has_room(subnet_id)) {
+            return subnet_id;
+        }
+    }
+    throw std::logic_error("No subnet has room");
+}
 
 void SubnetManager::assign_node_to_subnet(size_t node_id) {
+    assign_nodes_to_subnets({ node_id });
+}
+
+void SubnetManager::assign_nodes_to_subnets(const std::vector<size_t>& node_ids) {
     std::lock_guard<std::mutex> lock(subnet_mutex);
-    size_t least_loaded_subnet = find_least_loaded_subnet();
-    node_to_subnet_map[node_id] = least_loaded_subnet;
-    subnet_nodes[least_loaded_subnet].push_back(node_id);
+    std::shared_ptr<const Topology> current = std::atomic_load(&published);
+
+    // Shards and member lists are copied the first time the batch touches them and published together.
+    std::array<std::shared_ptr<NodeShard>, NODE_SHARDS> shards;
+    std::vector<std::shared_ptr<std::vector<size_t>>> members(total_subnets);
+    const size_t assigned_before = node_count;
+    for (size_t node_id : node_ids) {
+        const size_t shard = node_id % NODE_SHARDS;
+        const NodeShard& known = shards[shard] ? *shards[shard] : *current->node_shards[shard];
+        if (known.count(node_id)) {
+            continue;
+        }
+
+        // Loads may reach LOAD_BOUND times the average with the node counted; the least loaded subnet always can.
+        const double average = static_cast<double>(node_count + 1) / total_subnets;
+        const size_t capacity = static_cast<size_t>(LOAD_BOUND * average) + 1;
+        size_t subnet_id = walk_ring(node_id, [&](size_t candidate) { return loads[candidate] < capacity; });
+
+        if (!shards[shard]) {
+            shards[shard] = std::make_shared<NodeShard>(*current->node_shards[shard]);
+        }
+        (*shards[shard])[node_id] = subnet_id;
+        if (!members[subnet_id]) {
+            members[subnet_id] = std::make_shared<std::vector<size_t>>(*current->subnet_nodes[subnet_id]);
+        }
+        members[subnet_id]->push_back(node_id);
+        ++loads[subnet_id];
+        ++node_count;
+    }
+
+    if (node_count == assigned_before) {
+        return;
+    }
+    auto next = std::make_shared<Topology>(*current);
+    for (size_t shard = 0; shard < NODE_SHARDS; ++shard) {
+        if (shards[shard]) {
+            next->node_shards[shard] = shards[shard];
+        }
+    }
+    for (size_t subnet_id = 0; subnet_id < total_subnets; ++subnet_id) {
+        if (members[subnet_id]) {
+            next->subnet_nodes[subnet_id] = members[subnet_id];
+        }
+    }
+    std::atomic_store(&published, std::shared_ptr<const Topology>(next));
 }
 
 size_t SubnetManager::get_node_subnet(size_t node_id) const {
-    std::lock_guard<std::mutex> lock(subnet_mutex);
-    auto it = node_to_subnet_map.find(node_id);
-    if (it != node_to_subnet_map.end()) {
+    std::shared_ptr<const Topology> current = std::atomic_load(&published);
+    const NodeShard& shard = *current->node_shards[node_id % NODE_SHARDS];
+    auto it = shard.find(node_id);
+    if (it != shard.end()) {
         return it->second;
     }
     throw std::runtime_error("Node not found in any subnet");
 }
 
 std::vector<size_t> SubnetManager::get_subnet_nodes(size_t subnet_id) const {
-    std::lock_guard<std::mutex> lock(subnet_mutex);
-    auto it = subnet_nodes.find(subnet_id);
-    if (it != subnet_nodes.end()) {
-        return it->second;
+    if (subnet_id >= total_subnets) {
+        return {};
     }
-    return {};
+    std::shared_ptr<const Topology> current = std::atomic_load(&published);
+    return *current->subnet_nodes[subnet_id];
 }
 
-void SubnetManager::rebalance_subnets() {
+size_t SubnetManager::get_subnet_load(size_t subnet_id) const {
+    if (subnet_id >= total_subnets) {
+        return 0;
+    }
+    std::shared_ptr<const Topology> current = std::atomic_load(&published);
+    return current->subnet_nodes[subnet_id]->size();
+}
+
+std::vector<SubnetMigration> SubnetManager::compute_plan(const Topology& topology) const {
+    // The remainder of node_count / total_subnets goes to the most loaded subnets, which already hold it.
+    std::vector<size_t> order(total_subnets);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return loads[a] > loads[b]; });
+
+    const size_t base = node_count / total_subnets;
+    const size_t remainder = node_count % total_subnets;
+    std::vector<size_t> targets(total_subnets);
+    for (size_t rank = 0; rank < total_subnets; ++rank) {
+        targets[order[rank]] = base + (rank < remainder ? 1 : 0);
+    }
+
+    std::vector<size_t> room(total_subnets, 0);
+    for (size_t subnet_id = 0; subnet_id < total_subnets; ++subnet_id) {
+        if (loads[subnet_id] < targets[subnet_id]) {
+            room[subnet_id] = targets[subnet_id] - loads[subnet_id];
+        }
+    }
+
+    std::vector<SubnetMigration> plan;
+    for (size_t subnet_id = 0; subnet_id < total_subnets; ++subnet_id) {
+        const std::vector<size_t>& members = *topology.subnet_nodes[subnet_id];
+        for (size_t excess = loads[subnet_id]; excess > targets[subnet_id]; --excess) {
+            size_t node_id = members[excess - 1];
+            size_t destination = walk_ring(node_id, [&](size_t candidate) { return room[candidate] > 0; });
+            --room[destination];
+            plan.push_back({ node_id, subnet_id, destination });
+        }
+    }
+    return plan;
+}
+
+std::vector<SubnetMigration> SubnetManager::plan_rebalance() const {
+    std::lock_guard<std::mutex> lock(subnet_mutex);
+    return compute_plan(*std::atomic_load(&published));
+}
+
+std::vector<SubnetMigration> SubnetManager::rebalance_subnets() {
     std::lock_guard<std::mutex> lock(subnet_mutex);
-    // Simple load balancing algorithm to rebalance nodes across subnets
-    for (auto& [subnet_id, nodes] : subnet_nodes) {
-        if (nodes.size() > total_subnets) {
-            size_t excess_nodes = nodes.size() - total_subnets;
-            for (size_t i = 0; i < excess_nodes; ++i) {
-                size_t node_to_move = nodes.back();
-                nodes.pop_back();
-                size_t new_subnet = find_least_loaded_subnet();
-                node_to_subnet_map[node_to_move] = new_subnet;
-                subnet_nodes[new_subnet].push_back(node_to_move);
+    std::shared_ptr<const Topology> current = std::atomic_load(&published);
+    std::vector<SubnetMigration> plan = compute_plan(*current);
+    if (plan.empty()) {
+        return plan;
+    }
+
+    // Copy only the shards and member lists that the plan touches.
+    auto next = std::make_shared<Topology>(*current);
+    std::array<std::shared_ptr<NodeShard>, NODE_SHARDS> shards;
+    std::vector<std::shared_ptr<std::vector<size_t>>> members(total_subnets);
+    for (const SubnetMigration& move : plan) {
+        std::shared_ptr<NodeShard>& shard = shards[move.node_id % NODE_SHARDS];
+        if (!shard) {
+            shard = std::make_shared<NodeShard>(*current->node_shards[move.node_id % NODE_SHARDS]);
+        }
+        (*shard)[move.node_id] = move.to_subnet;
+
+        for (size_t subnet_id : { move.from_subnet, move.to_subnet }) {
+            if (!members[subnet_id]) {
+                members[subnet_id] = std::make_shared<std::vector<size_t>>(*current->subnet_nodes[subnet_id]);
             }
         }
+        std::vector<size_t>& source = *members[move.from_subnet];
+        source.erase(std::find(source.begin(), source.end(), move.node_id));
+        members[move.to_subnet]->push_back(move.node_id);
+        --loads[move.from_subnet];
+        ++loads[move.to_subnet];
+    }
+
+    for (size_t shard = 0; shard < NODE_SHARDS; ++shard) {
+        if (shards[shard]) {
+            next->node_shards[shard] = shards[shard];
+        }
+    }
+    for (size_t subnet_id = 0; subnet_id < total_subnets; ++subnet_id) {
+        if (members[subnet_id]) {
+            next->subnet_nodes[subnet_id] = members[subnet_id];
+        }
     }
+    std::atomic_store(&published, std::shared_ptr<const Topology>(next));
+    return plan;
 }
 
-size_t SubnetManager::find_least_loaded_subnet() const {
-    size_t least_loaded_subnet = 0;
-    size_t min_size = std::numeric_limits<size_t>::max();
+std::vector<std::vector<size_t>> SubnetManager::get_assignment() const {
+    std::shared_ptr<const Topology> current = std::atomic_load(&published);
+    std::vector<std::vector<size_t>> members;
+    members.reserve(total_subnets);
+    for (const auto& subnet : current->subnet_nodes) {
+        members.push_back(*subnet);
+    }
+    return members;
+}
+
+void SubnetManager::restore_assignment(const std::vector<std::vector<size_t>>& members) {
+    if (members.size() != total_subnets) {
+        throw std::invalid_argument("Assignment has " + std::to_string(members.size()) + " subnets, expected " +
+                                    std::to_string(total_subnets));
+    }
 
+    std::array<std::shared_ptr<NodeShard>, NODE_SHARDS> shards;
+    for (auto& shard : shards) {
+        shard = std::make_shared<NodeShard>();
+    }
+    auto next = std::make_shared<Topology>();
+    std::vector<size_t> next_loads(total_subnets);
+    size_t next_count = 0;
     for (size_t subnet_id = 0; subnet_id < total_subnets; ++subnet_id) {
-        size_t subnet_size = subnet_nodes.at(subnet_id).size();
-        if (subnet_size < min_size) {
-            min_size = subnet_size;
-            least_loaded_subnet = subnet_id;
+        for (size_t node_id : members[subnet_id]) {
+            if (!shards[node_id % NODE_SHARDS]->emplace(node_id, subnet_id).second) {
+                throw std::invalid_argument("Node " + std::to_string(node_id) + " is assigned twice");
+            }
         }
+        next->subnet_nodes.push_back(std::make_shared<const std::vector<size_t>>(members[subnet_id]));
+        next_loads[subnet_id] = members[subnet_id].size();
+        next_count += members[subnet_id].size();
+    }
+    for (size_t shard = 0; shard < NODE_SHARDS; ++shard) {
+        next->node_shards[shard] = shards[shard];
     }
 
-    return least_loaded_subnet;
+    std::lock_guard<std::mutex> lock(subnet_mutex);
+    loads = std::move(next_loads);
+    node_count = next_count;
+    std::atomic_store(&published, std::shared_ptr<const Topology>(next));
 }
@@ -1,4 +1,7 @@
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include "../include/governance/governance.hpp"
 #include "../include/consensus/posyg_engine.hpp"
 
@@ -17,6 +20,69 @@ int main() {
             std::cout << "Governance proposal rejected." << std::endl;
         }
 
+        // Batched votes are deduplicated per participant and merged into the totals at finalization.
+        const size_t population = 5000;
+        PoSygEngine batch_engine(population, 7);
+        Governance batch_governance(batch_engine);
+        const int proposal_count = 40;
+        batch_engine.get_participant(3).apply_slash();
+        batch_engine.refresh_synergy_snapshot();
+        for (int i = 0; i < proposal_count; ++i) {
+            batch_governance.create_proposal("Parameter change " + std::to_string(i));
+        }
+
+        // Weights stay those of the opening snapshot while cycles change the live table.
+        batch_engine.run_cycle();
+        if (batch_engine.get_synergy_snapshot()->epoch != 1
+            || batch_governance.get_proposal_by_id(1)->weights->epoch != 0) {
+            throw std::runtime_error("Proposal weights follow the live table");
+        }
+
+        std::vector<Vote> ballots;
+        for (int id = 1; id <= proposal_count; ++id) {
+            for (size_t participant = 0; participant < population; participant += 3) {
+                ballots.push_back({ id, participant, participant % 2 == 0 });
+                ballots.push_back({ id, participant, participant % 2 == 0 });
+            }
+        }
+        ballots.push_back({ proposal_count + 1, 0, true });
+        ballots.push_back({ 1, population, true });
+
+        const size_t voters_per_proposal = (population + 2) / 3;
+        const size_t expected = proposal_count * (voters_per_proposal - 1);
+        if (batch_governance.vote_batch(ballots) != expected || batch_governance.vote(1, true, 0)) {
+            throw std::runtime_error("Duplicate or invalid ballots were counted");
+        }
+
+        VoteTally tally = batch_governance.get_tally(1);
+        double expected_for = 0.0;
+        double expected_against = 0.0;
+        for (size_t participant = 0; participant < population; participant += 3) {
+            if (participant != 3) {
+                (participant % 2 == 0 ? expected_for : expected_against) += INITIAL_SYNERGY;
+            }
+        }
+        if (tally.votes_for != expected_for || tally.votes_against != expected_against) {
+            throw std::runtime_error("Batched tally is wrong");
+        }
+
+        for (int id = 1; id <= proposal_count; id += 2) {
+            batch_governance.finalize_proposal(id);
+        }
+        size_t open = 0;
+        for (const Proposal& proposal : batch_governance.get_active_proposals()) {
+            if (!proposal.is_active || proposal.id % 2 != 0) {
+                throw std::runtime_error("Active view yielded a closed proposal");
+            }
+            ++open;
+        }
+        const Proposal* closed = batch_governance.get_proposal_by_id(1);
+        if (open != batch_governance.get_active_proposals().size() || open != proposal_count / 2
+            || closed->votes_for != expected_for || closed->votes_against != expected_against) {
+            throw std::runtime_error("Finalization did not merge the batched tally");
+        }
+        std::cout << "Batched governance voting succeeded." << std::endl;
+
         std::cout << "Governance tests passed!" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "Governance tests failed: " << e.what() << std::endl;
@@ -1,6 +1,16 @@
 #include <iostream>
+#include <stdexcept>
+#include <filesystem>
+#include <fstream>
 #include "../include/ledger/block.hpp"
 #include "../include/ledger/ledger.hpp"
+#include "../include/ledger/block_store.hpp"
+#include "../include/ledger/state_db.hpp"
+#include "../include/ledger/compact_block.hpp"
+#include "../include/ledger/wire_format.hpp"
+#include "../include/cryptography/crypto.hpp"
+#include "../include/cryptography/ecdsa.hpp"
+#include "../include/cryptography/key_cache.hpp"
 
 int main() {
     try {
@@ -15,6 +25,390 @@ int main() {
             std::cout << "Ledger validation failed." << std::endl;
         }
 
+        // Hex round-trips in either case, and a failed decode leaves the destination untouched.
+        const std::string abc_digest = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+        std::string bytes = "kept";
+        uint8_t raw[2] = { 0xAA, 0xBB };
+        if (Hex::encode("\x01\xab", 2) != "01ab" || !Hex::decode("01AB", bytes) || bytes != "\x01\xab"
+            || Hex::decode("0g", bytes) || Hex::decode("abc", bytes) || bytes != "\x01\xab"
+            || Hex::decode("12zz", raw, 2) || raw[0] != 0xAA || raw[1] != 0xBB) {
+            throw std::runtime_error("Hex encoding or decoding failed");
+        }
+        Hash256 parsed;
+        if (!Hash256::from_hex(abc_digest, parsed) || parsed.to_hex() != abc_digest
+            || Hash256::from_hex(abc_digest.substr(0, 62) + "xy", parsed) || parsed.to_hex() != abc_digest
+            || Hash256::from_hex("00", parsed) || !Hash256().is_zero() || parsed.is_zero()) {
+            throw std::runtime_error("Hash256 hex parsing failed");
+        }
+        // Streaming input in pieces gives the one-shot digest, and finalize leaves the hasher ready for reuse.
+        Sha256Hasher hasher;
+        const std::string parsed_bytes(reinterpret_cast<const char*>(parsed.data()), Hash256::SIZE);
+        if (hasher.update("a").update(std::string_view("bc")).finalize() != parsed
+            || Crypto::hash_raw("abc") != parsed || hasher.update("abc").finalize() != parsed
+            || hasher.update(parsed).finalize() != Crypto::hash_raw(parsed_bytes)) {
+            throw std::runtime_error("Streaming SHA-256 digest mismatch");
+        }
+        std::cout << "Hex and SHA-256 hashing succeeded." << std::endl;
+
+        auto key_pair = ECDSA::generate_key_pair();
+        const std::string& public_key = key_pair.second;
+        Transaction tx(public_key, "receiver", 12.5, Crypto::sign(public_key, key_pair.first), TransactionType::STANDARD_PAYMENT, "memo");
+
+        Block signed_block(2, ledger.get_latest_block().get_block_hash(), 2);
+        signed_block.add_transaction(tx);
+        signed_block.sign_block("validator_signature");
+
+        Block decoded = Block::deserialize(signed_block.serialize());
+        if (decoded.get_block_hash() != signed_block.get_block_hash() ||
+            decoded.get_signature_count() != 1 ||
+            decoded.get_transactions().front().signature != tx.signature) {
+            throw std::runtime_error("Binary block round-trip mismatch");
+        }
+
+        MerkleProof proof = decoded.get_transaction_proof(0);
+        if (!MerkleTree::verify(tx.hash(), proof, decoded.get_merkle_root())) {
+            throw std::runtime_error("Merkle inclusion proof rejected");
+        }
+
+        MerkleTree tree;
+        for (int i = 0; i < 7; ++i) {
+            tree.append(MerkleTree::hash_leaf(std::to_string(i)));
+        }
+        for (size_t i = 0; i < tree.size(); ++i) {
+            if (!MerkleTree::verify(tree.leaf(i), tree.prove(i), tree.root())) {
+                throw std::runtime_error("Merkle proof rejected for leaf " + std::to_string(i));
+            }
+        }
+        if (MerkleTree::verify(tree.leaf(1), tree.prove(2), tree.root())) {
+            throw std::runtime_error("Merkle proof accepted for the wrong leaf");
+        }
+
+        Transaction forged(public_key, "receiver", 99.0, std::string(tx.signature.size(), '0'), TransactionType::STANDARD_PAYMENT);
+        Block batch_block(3, decoded.get_block_hash(), 2);
+        batch_block.add_transactions({ tx, tx });
+        if (batch_block.get_transactions().size() != 2 || !batch_block.verify_transactions().all_valid()) {
+            throw std::runtime_error("Batch transaction import failed");
+        }
+        bool rejected = false;
+        try {
+            batch_block.add_transactions({ tx, forged });
+        } catch (const std::invalid_argument&) {
+            rejected = true;
+        }
+        if (!rejected || batch_block.get_transactions().size() != 2) {
+            throw std::runtime_error("Batch import accepted a forged signature");
+        }
+
+        std::string inflated = Block(4, decoded.get_block_hash(), 2).serialize();
+        inflated.replace(inflated.size() - 4, 4, std::string(4, '\xff'));
+        inflated.append(16, '\0');
+        bool oversized_rejected = false;
+        try {
+            BlockView::decode(inflated);
+        } catch (const std::runtime_error&) {
+            oversized_rejected = true;
+        }
+        if (!oversized_rejected) {
+            throw std::runtime_error("Block decode accepted a transaction count larger than its buffer");
+        }
+
+        Block text_block = Block::deserialize(signed_block.serialize(WireFormat::TEXT), WireFormat::TEXT);
+        if (text_block.get_merkle_root() != signed_block.get_merkle_root()) {
+            throw std::runtime_error("Text block round-trip mismatch");
+        }
+
+        Transaction text_tx = Transaction::deserialize(tx.serialize(WireFormat::TEXT), WireFormat::TEXT);
+        if (text_tx.receiver != tx.receiver || text_tx.data != tx.data) {
+            throw std::runtime_error("Text transaction round-trip mismatch");
+        }
+        std::cout << "Block serialization round-trip succeeded." << std::endl;
+
+        KeyCacheStats before = PublicKeyCache::shared().get_stats();
+        if (!ECDSA::verify_signature(public_key, tx.signature, public_key) || !tx.verify_transaction()) {
+            throw std::runtime_error("Cached-key verification failed");
+        }
+        KeyCacheStats after = PublicKeyCache::shared().get_stats();
+        if (after.hits < before.hits + 2 || after.misses != before.misses) {
+            throw std::runtime_error("Public key was re-parsed despite being cached");
+        }
+
+        Transaction second(public_key, "receiver", 50.0, Crypto::sign(public_key, key_pair.first), TransactionType::STANDARD_PAYMENT, "second");
+        if (!ledger.add_transaction(tx) || ledger.add_transaction(tx) || !ledger.add_transaction(second)) {
+            throw std::runtime_error("Mempool admission or deduplication failed");
+        }
+        std::vector<const Transaction*> template_txs = ledger.get_pending_transactions().select(10);
+        if (template_txs.size() != 2 || template_txs.front()->data != "memo") {
+            throw std::runtime_error("Mempool did not keep per-sender order");
+        }
+        Block mined(2, ledger.get_latest_block().get_block_hash(), 2);
+        mined.add_transactions({ template_txs.front() });
+        ledger.add_block(mined);
+        if (ledger.get_pending_transactions().size() != 1 || !ledger.get_pending_transactions().contains(second.hash())) {
+            throw std::runtime_error("Committed transaction was not removed from the mempool");
+        }
+
+        Mempool bounded(1);
+        bounded.add(tx, 1.0);
+        if (bounded.add(second, 0.5) || !bounded.add(second, 2.0) || bounded.contains(tx.hash()) || bounded.get_evicted_count() != 1) {
+            throw std::runtime_error("Mempool eviction picked the wrong transaction");
+        }
+        std::cout << "Mempool checks succeeded." << std::endl;
+
+        Transaction third(public_key, "receiver", 7.0, Crypto::sign(public_key, key_pair.first), TransactionType::STANDARD_PAYMENT, "third");
+        Block relayed(3, mined.get_block_hash(), 2);
+        relayed.add_transactions({ tx, third, second });
+        relayed.sign_block("validator_signature");
+        Mempool peer_pool;
+        peer_pool.add(tx, 1.0);
+        peer_pool.add(second, 1.0);
+
+        CompactBlock compact = CompactBlock::deserialize(CompactBlock::from_block(relayed, 42).serialize());
+        if (compact.compute_digest() != relayed.get_block_digest() || compact.short_ids.size() != 3 ||
+            compact.serialize().size() >= relayed.serialize().size()) {
+            throw std::runtime_error("Compact block encoding mismatch");
+        }
+        PartialBlock partial(compact);
+        if (partial.fill_from(peer_pool) != 2 || partial.get_missing() != std::vector<uint32_t>{ 1 }) {
+            throw std::runtime_error("Compact block was not matched against the mempool");
+        }
+        PartialBlock wrong = partial;
+        wrong.fill_missing({ tx });
+        partial.fill_missing({ third });
+        bool mismatch_detected = false;
+        try {
+            wrong.to_block();
+        } catch (const std::runtime_error&) {
+            mismatch_detected = true;
+        }
+        Block rebuilt = partial.to_block();
+        if (!mismatch_detected || rebuilt.get_block_digest() != relayed.get_block_digest() ||
+            rebuilt.serialize() != relayed.serialize()) {
+            throw std::runtime_error("Compact block reconstruction failed");
+        }
+        CompactBlock prefilled = CompactBlock::from_block(relayed, 7, { 1 });
+        if (prefilled.prefilled.size() != 1 || PartialBlock(prefilled).get_missing() != std::vector<uint32_t>{ 0, 2 }) {
+            throw std::runtime_error("Prefilled transaction was not placed");
+        }
+        std::cout << "Compact block relay succeeded." << std::endl;
+
+        if (!ledger.has_block(mined.get_block_digest()) || ledger.find_block(mined.get_block_digest())->height != 2 ||
+            ledger.has_block(batch_block.get_block_digest())) {
+            throw std::runtime_error("Block index lookup failed");
+        }
+        ledger.set_block_confirmation(mined.get_block_hash(), true);
+        if (!ledger.is_block_confirmed(mined.get_block_hash()) || ledger.is_block_confirmed(new_block.get_block_hash())) {
+            throw std::runtime_error("Block confirmation tracking failed");
+        }
+        // Imported blocks are rejected on the main chain and on forks if any transaction signature is forged.
+        auto assemble_forged = [&](size_t number, const std::string& parent) {
+            return Block::assemble(number, parent, 0, 2, {}, { forged }, { forged.hash() });
+        };
+        size_t forged_rejections = 0;
+        Block forged_tip = assemble_forged(3, ledger.get_latest_block().get_block_hash());
+        Block forged_fork = assemble_forged(2, new_block.get_block_hash());
+        try {
+            ledger.add_block(forged_tip);
+        } catch (const std::invalid_argument&) {
+            ++forged_rejections;
+        }
+        try {
+            ledger.add_fork_block(new_block.get_block_hash(), forged_fork);
+        } catch (const std::invalid_argument&) {
+            ++forged_rejections;
+        }
+        if (forged_rejections != 2 || ledger.has_block(forged_tip.get_block_digest()) ||
+            ledger.has_block(forged_fork.get_block_digest())) {
+            throw std::runtime_error("Block with a forged transaction signature was imported");
+        }
+        Block misnumbered_fork(7, new_block.get_block_hash(), 2);
+        bool misnumbered_rejected = false;
+        try {
+            ledger.add_fork_block(new_block.get_block_hash(), misnumbered_fork);
+        } catch (const std::invalid_argument&) {
+            misnumbered_rejected = true;
+        }
+        if (!misnumbered_rejected || ledger.has_block(misnumbered_fork.get_block_digest())) {
+            throw std::runtime_error("Fork block with a height that does not follow its parent was imported");
+        }
+        Block fork_a(2, new_block.get_block_hash(), 2);
+        fork_a.add_transaction(second);
+        ledger.add_fork_block(new_block.get_block_hash(), fork_a);
+        Block fork_b(3, fork_a.get_block_hash(), 2);
+        ledger.add_fork_block(fork_a.get_block_hash(), fork_b);
+        if (!ledger.validate_fork(fork_b.get_block_hash()) || ledger.get_forks().tips().size() != 2 ||
+            ledger.find_block(fork_b.get_block_digest())->location != BLOCK_ON_SIDE_BRANCH) {
+            throw std::runtime_error("Fork lookup through the block tree failed");
+        }
+        if (!ledger.apply_fork_choice() || ledger.get_latest_block().get_block_hash() != fork_b.get_block_hash() ||
+            ledger.get_blockchain_length() != 4 || !ledger.validate_chain() ||
+            ledger.find_block(mined.get_block_digest())->location != BLOCK_ON_SIDE_BRANCH ||
+            !ledger.get_pending_transactions().contains(tx.hash()) || ledger.get_pending_transactions().contains(second.hash())) {
+            throw std::runtime_error("Reorganization to the heaviest fork failed");
+        }
+        if (!ledger.select_fork(mined.get_block_hash()) || ledger.get_latest_block().get_block_hash() != mined.get_block_hash()) {
+            throw std::runtime_error("Explicit fork selection failed");
+        }
+
+        BlockIndex index(4);
+        for (int i = 0; i < 1000; ++i) {
+            index.insert(MerkleTree::hash_leaf(std::to_string(i)), BlockIndexEntry{ static_cast<uint64_t>(i), 0, false });
+        }
+        for (int i = 0; i < 1000; i += 2) {
+            index.erase(MerkleTree::hash_leaf(std::to_string(i)));
+        }
+        for (int i = 0; i < 1000; ++i) {
+            const BlockIndexEntry* entry = index.find(MerkleTree::hash_leaf(std::to_string(i)));
+            if ((i % 2 == 0) != (entry == nullptr) || (entry && entry->height != static_cast<uint64_t>(i))) {
+                throw std::runtime_error("Block index probe sequence broken after erase");
+            }
+        }
+
+        // Independent senders execute in parallel; the last transfer reuses accounts and must be re-executed.
+        StateDB state(8, 2);
+        Block transfers(1, "parent", 2);
+        std::vector<std::string> senders;
+        std::vector<Transaction> batch;
+        for (int i = 0; i < 70; ++i) {
+            auto pair = ECDSA::generate_key_pair();
+            senders.push_back(pair.second);
+            batch.emplace_back(pair.second, "acct_" + std::to_string(i), static_cast<double>(i),
+                               Crypto::sign(pair.second, pair.first), TransactionType::STANDARD_PAYMENT);
+        }
+        batch.emplace_back(senders[0], "acct_1", 5.0, batch[0].signature, TransactionType::STANDARD_PAYMENT);
+        transfers.add_transactions(batch);
+        std::shared_ptr<const StateSnapshot> before_block = state.snapshot();
+        ExecutionStats stats = state.apply_block(transfers);
+        if (stats.executed != 71 || stats.reexecuted != 1 || state.get_account("acct_1").balance != 6.0 ||
+            state.get_account(senders[0]).balance != -5.0 || state.get_account(senders[0]).nonce != 2 ||
+            state.get_account("acct_69").balance != 69.0 || before_block->get_version() != 0 ||
+            before_block->account_count() != 0) {
+            throw std::runtime_error("Optimistic block execution diverged from sequential execution");
+        }
+        state.revert_block(transfers);
+        if (state.get_version() != 0 || state.get_account("acct_1").balance != 0.0 || state.get_account(senders[0]).nonce != 0) {
+            throw std::runtime_error("Reverting a block did not restore the account state");
+        }
+        std::cout << "Account state execution succeeded." << std::endl;
+
+        std::string data_dir = (std::filesystem::temp_directory_path() / "synledger_block_store_test").string();
+        std::filesystem::remove_all(data_dir);
+        std::string stored_tip;
+        {
+            Ledger persistent(3, data_dir);
+            Block first(1, persistent.get_latest_block().get_block_hash(), 2);
+            first.add_transaction(tx);
+            persistent.add_block(first);
+            persistent.add_block(Block(2, first.get_block_hash(), 2));
+            stored_tip = persistent.get_latest_block().get_block_hash();
+        }
+        {
+            std::ofstream torn(data_dir + "/blocks_000000.dat", std::ios::binary | std::ios::app);
+            torn << "torn write";
+        }
+        {
+            std::ofstream damaged(data_dir + "/state.checkpoint", std::ios::binary | std::ios::app);
+            damaged << "x";
+        }
+        {
+            Ledger replayed(3, data_dir);
+            if (replayed.get_replayed_blocks() != 3 || replayed.get_state().get_account("receiver").balance != tx.amount) {
+                throw std::runtime_error("Damaged state checkpoint was not replaced by a full replay");
+            }
+        }
+        {
+            Ledger reopened(3, data_dir);
+            if (reopened.get_replayed_blocks() != 0 || reopened.get_state().get_version() != 3) {
+                throw std::runtime_error("Reopening replayed blocks covered by the state checkpoint");
+            }
+            if (reopened.get_blockchain_length() != 3 || reopened.get_latest_block().get_block_hash() != stored_tip ||
+                reopened.get_block(1).get_transactions().size() != 1 || !reopened.validate_chain()) {
+                throw std::runtime_error("Block store did not restore the chain");
+            }
+            for (size_t height = 3; height < 600; ++height) {
+                reopened.add_block(Block(height, reopened.get_latest_block().get_block_hash(), 2));
+            }
+            if (reopened.get_forks().size() > 2 * Ledger::FINALITY_DEPTH) {
+                throw std::runtime_error("Finalized blocks were not pruned from the block tree");
+            }
+            if (!reopened.validate_chain() || reopened.get_validated_height() != 600 || !reopened.audit_chain(2)) {
+                throw std::runtime_error("Incremental or audit validation failed");
+            }
+            reopened.rollback_chain(100);
+            if (reopened.get_validated_height() != 500 || !reopened.validate_chain()) {
+                throw std::runtime_error("Validation watermark not adjusted on rollback");
+            }
+            if (reopened.get_state().get_version() != 500 || reopened.get_state().get_account("receiver").balance != tx.amount ||
+                reopened.get_state().get_account(public_key).nonce != 1) {
+                throw std::runtime_error("Account state was not rebuilt from the block store");
+            }
+        }
+        {
+            Ledger restarted(3, data_dir);
+            if (restarted.get_replayed_blocks() != 0 || restarted.get_state().get_version() != 500 ||
+                !restarted.has_block(restarted.get_block(1).get_block_digest()) || !restarted.validate_chain()) {
+                throw std::runtime_error("State checkpoint did not survive a rollback and restart");
+            }
+        }
+
+        std::filesystem::remove_all(data_dir);
+        {
+            BlockStore segmented(data_dir, 512, 1);
+            segmented.append(signed_block);
+            std::string_view first = segmented.read_raw(0);
+            std::string first_bytes(first);
+            for (size_t i = 1; i < 8; ++i) {
+                segmented.append(signed_block);
+            }
+            if (segmented.location(7).segment == 0) {
+                throw std::runtime_error("Block store did not rotate segments");
+            }
+            if (first.data() != segmented.read_raw(0).data() || first != first_bytes) {
+                throw std::runtime_error("Block store view did not survive segment rollover");
+            }
+        }
+        std::filesystem::remove(data_dir + "/index.dat");
+        BlockStore recovered(data_dir, 512, 1);
+        if (recovered.size() != 8 || recovered.read(7).get_block_hash() != signed_block.get_block_hash()) {
+            throw std::runtime_error("Block store did not recover unindexed blocks");
+        }
+        std::filesystem::remove_all(data_dir);
+        std::cout << "Block store persistence succeeded." << std::endl;
+
+        // The block arena keeps every field intact across imports, copies and moves.
+        Block arena_block(1, "parent", 2);
+        std::vector<Transaction> arena_txs;
+        for (int i = 0; i < 40; ++i) {
+            arena_txs.emplace_back(tx.sender, "receiver-" + std::to_string(i), 1.0 + i, tx.signature,
+                                   TransactionType::GOVERNANCE, std::string(static_cast<size_t>(i) * 7, 'd'));
+        }
+        arena_block.add_transactions(arena_txs);
+        Block imported = Block::deserialize(arena_block.serialize());
+        Block copied = imported;
+        Block moved = std::move(copied);
+        for (const Block* candidate : { &arena_block, &imported, &moved }) {
+            const TransactionArena& stored = candidate->get_transactions();
+            if (stored.size() != arena_txs.size() || !candidate->verify_merkle_root()) {
+                throw std::runtime_error("Arena lost transactions");
+            }
+            size_t i = 0;
+            for (TransactionRef ref : stored) {
+                const Transaction& expected = arena_txs[i++];
+                if (ref.sender != expected.sender || ref.receiver != expected.receiver || ref.amount != expected.amount ||
+                    ref.signature != expected.signature || ref.data != expected.data || ref.type != expected.type) {
+                    throw std::runtime_error("Arena transaction " + std::to_string(i - 1) + " differs");
+                }
+            }
+        }
+        if (moved.get_block_hash() != arena_block.get_block_hash() || !moved.verify_transactions().all_valid()) {
+            throw std::runtime_error("Arena block does not verify after a move");
+        }
+        TransactionArena::const_iterator cursor = moved.get_transactions().begin();
+        if ((*cursor++).receiver != "receiver-0" || (*cursor).receiver != "receiver-1" ||
+            std::distance(moved.get_transactions().begin(), moved.get_transactions().end()) != 40) {
+            throw std::runtime_error("Arena iterator does not behave as an input iterator");
+        }
+        std::cout << "Transaction arena succeeded." << std::endl;
+
         std::cout << "Ledger tests passed!" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "Ledger tests failed: " << e.what() << std::endl;
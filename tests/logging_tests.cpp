@@ -0,0 +1,79 @@
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include "../include/logging/logger.hpp"
+
+// Number of occurrences of `needle` in `text`.
+static size_t count_of(const std::string& text, const std::string& needle) {
+    size_t count = 0;
+    for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + needle.size())) {
+        ++count;
+    }
+    return count;
+}
+
+int main() {
+    try {
+        std::ostringstream output;
+        Logger::instance().set_output(output);
+
+        // Records from several threads all arrive, each thread's in the order it logged them.
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 4; ++t) {
+            writers.emplace_back([t] {
+                for (int i = 0; i < 100; ++i) {
+                    LOG_INFO("test") << "thread " << t << " line " << i << " value " << 0.5 * i;
+                }
+            });
+        }
+        for (auto& writer : writers) {
+            writer.join();
+        }
+        Logger::instance().flush();
+        std::string text = output.str();
+        if (count_of(text, "INFO  test: thread ") != 400) {
+            throw std::runtime_error("Records were lost");
+        }
+        if (text.find("thread 2 line 98 value 49") > text.find("thread 2 line 99 value 49.5")) {
+            throw std::runtime_error("Records of one thread are out of order");
+        }
+
+        // Statements below the compiled level are not evaluated.
+        int evaluated = 0;
+        LOG_DEBUG("test") << (++evaluated);
+        if ((SYNLEDGER_LOG_LEVEL > LOG_LEVEL_DEBUG) != (evaluated == 0)) {
+            throw std::runtime_error("Compile-time level filter did not apply");
+        }
+
+        // A rate-limited call site passes its budget and reports what it suppressed.
+        output.str("");
+        for (int i = 0; i < 50; ++i) {
+            LOG_WARN_LIMITED("test", 5) << "burst " << i;
+        }
+        Logger::instance().flush();
+        text = output.str();
+        if (count_of(text, "WARN  test: burst ") != 5) {
+            throw std::runtime_error("Rate limit did not cap the burst");
+        }
+
+        // Long messages are truncated to the record size.
+        output.str("");
+        LOG_ERROR("test") << std::string(2 * LOG_MESSAGE_CAPACITY, 'x');
+        Logger::instance().flush();
+        if (count_of(output.str(), "x") != LOG_MESSAGE_CAPACITY) {
+            throw std::runtime_error("Long message was not truncated");
+        }
+
+        Logger::instance().set_output(std::cout);
+        std::cout << "Logging tests passed!" << std::endl;
+    } catch (const std::exception& e) {
+        Logger::instance().set_output(std::cout);
+        std::cerr << "Logging tests failed: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "../include/metrics/metrics.hpp"
+
+// Sends one HTTP GET to the local metrics server and returns the whole response.
+static std::string http_get(int port, const std::string& path) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+    if (connect(sock, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        close(sock);
+        throw std::runtime_error("Could not connect to the metrics server");
+    }
+    const std::string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    send(sock, request.data(), request.size(), 0);
+    std::string response;
+    char buffer[4096];
+    ssize_t received;
+    while ((received = recv(sock, buffer, sizeof(buffer), 0)) > 0) {
+        response.append(buffer, static_cast<size_t>(received));
+    }
+    close(sock);
+    return response;
+}
+
+int main() {
+    try {
+        // Buckets are contiguous and every value falls into the bucket whose range contains it.
+        for (size_t i = 1; i < Histogram::BUCKET_COUNT; ++i) {
+            if (Histogram::bucket_lower(i) <= Histogram::bucket_lower(i - 1) ||
+                Histogram::bucket_of(Histogram::bucket_lower(i)) != i ||
+                Histogram::bucket_of(Histogram::bucket_lower(i) - 1) != i - 1) {
+                throw std::runtime_error("Histogram buckets are not contiguous at " + std::to_string(i));
+            }
+        }
+        if (Histogram::bucket_of(UINT64_MAX) != Histogram::BUCKET_COUNT - 1) {
+            throw std::runtime_error("Largest value is outside the last bucket");
+        }
+
+        // Quantiles are reported within the bucket resolution of 12.5%.
+        MetricsRegistry& registry = MetricsRegistry::instance();
+        Histogram& latency = registry.histogram("test_latency", "Test latency");
+        for (uint64_t v = 1; v <= 10000; ++v) {
+            latency.record(v);
+        }
+        HistogramSnapshot snapshot = latency.snapshot();
+        if (snapshot.count != 10000 || snapshot.sum != 10000ull * 10001 / 2) {
+            throw std::runtime_error("Histogram count or sum is wrong");
+        }
+        for (double q : { 0.5, 0.9, 0.99 }) {
+            double expected = q * 10000;
+            if (std::fabs(snapshot.quantile(q) - expected) > 0.125 * expected) {
+                throw std::runtime_error("Quantile " + std::to_string(q) + " is off: " +
+                                         std::to_string(snapshot.quantile(q)));
+            }
+        }
+
+        // Increments from many threads land in different shards and are all counted.
+        Counter& events = registry.counter("test_events_total", "Test events");
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; ++t) {
+            threads.emplace_back([&events, &latency] {
+                for (int i = 0; i < 10000; ++i) {
+                    events.add();
+                    latency.record(5);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        if (events.value() != 80000 || latency.snapshot().count != 90000) {
+            throw std::runtime_error("Sharded updates were lost");
+        }
+        if (&registry.counter("test_events_total", "Test events") != &events) {
+            throw std::runtime_error("Registry returned a second counter for the same name");
+        }
+
+        // The exposition format carries each family's metadata once, and collectors add labelled samples.
+        registry.gauge("test_depth", "Test depth").set(-3);
+        size_t collector = registry.add_collector([](MetricsWriter& writer) {
+            writer.sample("test_peer_bytes_total", "counter", "Bytes per peer", "peer=\"1\"", 10);
+            writer.sample("test_peer_bytes_total", "counter", "Bytes per peer", "peer=\"2\"", 20);
+        });
+        std::string text = registry.render_prometheus();
+        for (const char* expected : { "# TYPE test_events_total counter\ntest_events_total 80000\n",
+                                      "# TYPE test_depth gauge\ntest_depth -3\n",
+                                      "# TYPE test_latency summary\n", "test_latency{quantile=\"0.99\"}",
+                                      "test_latency_count 90000\n", "test_peer_bytes_total{peer=\"2\"} 20\n" }) {
+            if (text.find(expected) == std::string::npos) {
+                throw std::runtime_error(std::string("Exposition lacks: ") + expected);
+            }
+        }
+        if (text.find("# HELP test_peer_bytes_total") != text.rfind("# HELP test_peer_bytes_total")) {
+            throw std::runtime_error("Family metadata was repeated");
+        }
+        registry.remove_collector(collector);
+        if (registry.render_prometheus().find("test_peer_bytes_total") != std::string::npos) {
+            throw std::runtime_error("Removed collector still ran");
+        }
+
+        // Timed scopes become trace spans while tracing is on.
+        Histogram& step = registry.timer("test_step_seconds", "Test step");
+        registry.set_tracing(true);
+        {
+            ScopedTimer timer(step);
+        }
+        registry.set_tracing(false);
+        {
+            ScopedTimer timer(step);
+        }
+        if (step.snapshot().count != 2) {
+            throw std::runtime_error("Scoped timers were not recorded");
+        }
+
+        // The endpoint serves both formats over HTTP.
+        MetricsServer server;
+        server.start(0);
+        std::string scrape = http_get(server.get_port(), "/metrics");
+        if (scrape.find("200 OK") == std::string::npos || scrape.find("test_events_total 80000") == std::string::npos) {
+            throw std::runtime_error("Scrape failed");
+        }
+        std::string trace = http_get(server.get_port(), "/trace");
+        if (trace.find("\"name\":\"test_step_seconds\"") == std::string::npos ||
+            trace.find("\"name\":\"test_step_seconds\"") != trace.rfind("\"name\":\"test_step_seconds\"")) {
+            throw std::runtime_error("Trace did not hold exactly the span recorded while tracing");
+        }
+        if (http_get(server.get_port(), "/other").find("404") == std::string::npos) {
+            throw std::runtime_error("Unknown path was served");
+        }
+        server.stop();
+
+        std::cout << "Metrics tests passed!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Metrics tests failed: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
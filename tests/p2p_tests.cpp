@@ -1,20 +1,326 @@
 #include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <cstdio>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <filesystem>
+#include <string>
 #include "../include/network/p2p_protocol.hpp"
 #include "../include/network/node_discovery.hpp"
+#include "../include/network/gossip.hpp"
+#include "../include/cryptography/crypto.hpp"
+#include "../include/cryptography/ecdsa.hpp"
 
 int main() {
     try {
         P2PProtocol p2p_protocol(1, "127.0.0.1");
         p2p_protocol.initialize(8080);
 
-        NodeDiscovery node_discovery(1, "127.0.0.1");
-        node_discovery.discover_nodes();
+        // Buckets are bounded: ids 512..1000 all share bucket 9 of node 0 and only four of them fit.
+        RoutingTable table(0, 4);
+        for (size_t id = 1; id <= 1000; ++id) {
+            NodeContact contact;
+            contact.node_id = id;
+            contact.address = "127.0.0.1:" + std::to_string(20000 + id);
+            table.observe(contact, -1.0);
+        }
+        std::vector<NodeContact> nearest = table.closest(5, 3);
+        if (table.size() != 1 + 2 + 4 * 8 || nearest.size() != 3 || nearest[0].node_id != 5 || nearest[1].node_id != 4 ||
+            !table.record_failure(512, 1) || table.find(512) != nullptr || table.size() != 35) {
+            throw std::runtime_error("Routing table bounds or XOR ordering are wrong");
+        }
 
-        for (size_t node_id : node_discovery.get_known_nodes()) {
-            p2p_protocol.add_peer(node_id, node_discovery.get_node_address(node_id));
+        // Every node bootstraps from the first one only and finds the others through iterative lookups.
+        const size_t discovery_nodes = 12;
+        auto discovery_id = [](size_t i) { return static_cast<size_t>((i + 1) * 0x9E3779B97F4A7C15ULL); };
+        std::vector<std::unique_ptr<NodeDiscovery>> discovery;
+        for (size_t i = 0; i < discovery_nodes; ++i) {
+            discovery.emplace_back(new NodeDiscovery(discovery_id(i), "127.0.0.1"));
+            discovery.back()->initialize(static_cast<int>(19000 + i));
+            if (i > 0) {
+                discovery.back()->add_node(discovery_id(0), "127.0.0.1:19000");
+            }
+        }
+        for (auto& node : discovery) {
+            node->discover_nodes();
+        }
+        for (auto& node : discovery) {
+            if (node->get_known_nodes().size() != discovery_nodes - 1) {
+                throw std::runtime_error("Lookups did not discover every node");
+            }
+        }
+        std::vector<NodeContact> found = discovery[5]->lookup(discovery_id(2));
+        if (found.empty() || found.front().node_id != discovery_id(2) || found.size() != discovery_nodes - 1) {
+            throw std::runtime_error("Lookup did not return the target node first");
+        }
+
+        // A restarted node rejoins from its peer cache without any bootstrap node.
+        // The cache lives in the temp directory under a per-run name and is removed however the test ends.
+        struct RemovedOnExit {
+            std::string path;
+            ~RemovedOnExit() { std::remove(path.c_str()); }
+        };
+        const std::string cache_name = "synledger_p2p_peers_" +
+            std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + ".cache";
+        const std::string cache_path = (std::filesystem::temp_directory_path() / cache_name).string();
+        RemovedOnExit cache_cleanup{ cache_path };
+        discovery[5]->save_peer_cache(cache_path);
+        NodeDiscovery restarted(999, "127.0.0.1");
+        restarted.initialize(19100);
+        restarted.set_peer_cache(cache_path);
+        restarted.discover_nodes();
+        if (restarted.get_known_nodes().size() != discovery_nodes) {
+            throw std::runtime_error("Peer cache was not reused on restart");
+        }
+
+        // P2P peers are fed from discovery, lowest round-trip time first.
+        std::vector<size_t> ranked = discovery.front()->get_known_nodes();
+        for (size_t node_id : ranked) {
+            p2p_protocol.add_peer(node_id, discovery.front()->get_node_address(node_id));
+        }
+        if (p2p_protocol.get_active_peers() != ranked || ranked.size() != discovery_nodes) {
+            throw std::runtime_error("Discovered nodes were not added as peers");
+        }
+        restarted.shutdown();
+        for (auto& node : discovery) {
+            node->shutdown();
         }
+        std::cout << "Kademlia node discovery succeeded." << std::endl;
 
         std::cout << "P2P network initialized successfully." << std::endl;
+
+        // Messages are framed and pipelined on one connection, so none is truncated or reordered.
+        std::mutex received_mutex;
+        std::vector<std::string> received;
+        P2PProtocol receiver(2, "127.0.0.1");
+        receiver.set_message_handler([&](const std::string&, const std::string& message) {
+            std::lock_guard<std::mutex> lock(received_mutex);
+            received.push_back(message);
+        });
+        receiver.initialize(18081);
+
+        P2PProtocol sender(3, "127.0.0.1");
+        sender.add_peer(2, "127.0.0.1:18081");
+        std::string large(5000, 'x');
+        for (int i = 0; i < 100; ++i) {
+            sender.send_message(2, i == 50 ? large : "message " + std::to_string(i));
+        }
+        for (int attempt = 0; attempt < 200; ++attempt) {
+            {
+                std::lock_guard<std::mutex> lock(received_mutex);
+                if (received.size() == 100) {
+                    break;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        {
+            std::lock_guard<std::mutex> lock(received_mutex);
+            if (received.size() != 100 || received[50] != large || received[99] != "message 99") {
+                throw std::runtime_error("Framed messages were lost, truncated or reordered");
+            }
+            received.clear();
+        }
+        std::cout << "Framed peer connection succeeded." << std::endl;
+
+        // Many connections are served by the same fixed set of I/O threads.
+        for (size_t peer = 10; peer < 60; ++peer) {
+            sender.add_peer(peer, "127.0.0.1:18081");
+            sender.send_message(peer, "hello from connection " + std::to_string(peer));
+        }
+        for (int attempt = 0; attempt < 200; ++attempt) {
+            {
+                std::lock_guard<std::mutex> lock(received_mutex);
+                if (received.size() == 50) {
+                    break;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        {
+            std::lock_guard<std::mutex> lock(received_mutex);
+            if (received.size() != 50 || receiver.get_io_thread_count() != P2PProtocol::DEFAULT_IO_THREADS) {
+                throw std::runtime_error("Event loops did not serve every connection");
+            }
+        }
+        std::cout << "Event loop connection fan-in succeeded." << std::endl;
+
+        // Short-lived inbound connections spread over the I/O threads reuse descriptor numbers while earlier ones
+        // are still being closed on another loop; every frame still arrives and the map stays consistent.
+        {
+            std::lock_guard<std::mutex> lock(received_mutex);
+            received.clear();
+        }
+        const size_t churned = 300;
+        sockaddr_in receiver_addr{};
+        receiver_addr.sin_family = AF_INET;
+        receiver_addr.sin_port = htons(18081);
+        inet_pton(AF_INET, "127.0.0.1", &receiver_addr.sin_addr);
+        for (size_t i = 0; i < churned; ++i) {
+            int client = socket(AF_INET, SOCK_STREAM, 0);
+            if (client < 0 || connect(client, reinterpret_cast<sockaddr*>(&receiver_addr), sizeof(receiver_addr)) != 0) {
+                throw std::runtime_error("Churn client could not connect");
+            }
+            const std::string body = "churn " + std::to_string(i);
+            uint32_t length = htonl(static_cast<uint32_t>(body.size()));
+            std::string frame(reinterpret_cast<const char*>(&length), sizeof(length));
+            frame += body;
+            if (send(client, frame.data(), frame.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(frame.size())) {
+                throw std::runtime_error("Churn client could not send");
+            }
+            close(client);
+            receiver.get_buffered_bytes();
+        }
+        for (int attempt = 0; attempt < 500; ++attempt) {
+            {
+                std::lock_guard<std::mutex> lock(received_mutex);
+                if (received.size() == churned) {
+                    break;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        {
+            std::lock_guard<std::mutex> lock(received_mutex);
+            if (received.size() != churned) {
+                throw std::runtime_error("Frames of churned inbound connections were lost");
+            }
+            received.clear();
+        }
+        std::cout << "Inbound connection churn succeeded." << std::endl;
+
+        // Line topology a - b - c: the payload crosses each link once, announcements are hash-only.
+        SubnetManager topology(2);
+        P2PProtocol net_a(101, "127.0.0.1"), net_b(102, "127.0.0.1"), net_c(103, "127.0.0.1");
+        Gossip gossip_a(net_a, 101, topology), gossip_b(net_b, 102, topology), gossip_c(net_c, 103, topology);
+        std::atomic<int> delivered_c{ 0 };
+        gossip_c.set_item_handler([&](InventoryType, const Hash256&, const std::string&) {
+            delivered_c++;
+            return true;
+        });
+        net_a.set_message_handler([&](const std::string&, const std::string& m) { gossip_a.handle_message(m); });
+        net_b.set_message_handler([&](const std::string&, const std::string& m) { gossip_b.handle_message(m); });
+        net_c.set_message_handler([&](const std::string&, const std::string& m) { gossip_c.handle_message(m); });
+        net_a.initialize(18101);
+        net_b.initialize(18102);
+        net_c.initialize(18103);
+        net_a.add_peer(102, "127.0.0.1:18102");
+        net_b.add_peer(101, "127.0.0.1:18101");
+        net_b.add_peer(103, "127.0.0.1:18103");
+        net_c.add_peer(102, "127.0.0.1:18102");
+
+        Block gossiped(1, std::string(64, '0'), 1);
+        std::string block_payload = gossiped.serialize();
+        Hash256 block_id = gossiped.get_block_digest();
+        if (!gossip_a.broadcast(InventoryType::BLOCK, block_id, block_payload) ||
+            gossip_a.broadcast(InventoryType::BLOCK, block_id, block_payload)) {
+            throw std::runtime_error("Gossip broadcast deduplication failed");
+        }
+        for (int attempt = 0; attempt < 200 && delivered_c == 0; ++attempt) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        if (delivered_c != 1 || gossip_a.get_stats().items_sent != 1 || gossip_b.get_stats().items_sent != 1 ||
+            gossip_b.get_stats().items_received != 1 || !gossip_c.has_seen(block_id)) {
+            throw std::runtime_error("Gossip did not deliver the item exactly once per node");
+        }
+
+        // DATA is only taken for requested ids whose payload matches; a forged copy does not block the real one.
+        Block genuine(2, std::string(64, '0'), 1);
+        const Hash256 genuine_id = genuine.get_block_digest();
+        auto gossip_message = [](uint8_t kind, size_t sender, uint8_t type, const Hash256& id, const std::string& body) {
+            std::string message(1, static_cast<char>(kind));
+            for (int shift = 56; shift >= 0; shift -= 8) {
+                message.push_back(static_cast<char>((sender >> shift) & 0xFF));
+            }
+            if (kind == 1) {
+                message.append("\0\0\0\1", 4);
+            }
+            message.push_back(static_cast<char>(type));
+            message.append(reinterpret_cast<const char*>(id.data()), Hash256::SIZE);
+            return message + body;
+        };
+        const int delivered_before = delivered_c;
+        gossip_c.handle_message(gossip_message(3, 901, 1, genuine_id, genuine.serialize()));
+        gossip_c.handle_message(gossip_message(1, 901, 1, genuine_id, ""));
+        gossip_c.handle_message(gossip_message(1, 902, 1, genuine_id, ""));
+        gossip_c.handle_message(gossip_message(3, 901, 1, genuine_id, block_payload));
+        if (delivered_c != delivered_before || gossip_c.has_seen(genuine_id)) {
+            throw std::runtime_error("Unrequested or forged DATA was accepted");
+        }
+        gossip_c.handle_message(gossip_message(3, 902, 1, genuine_id, genuine.serialize()));
+        if (delivered_c != delivered_before + 1 || !gossip_c.has_seen(genuine_id)) {
+            throw std::runtime_error("Genuine DATA was not accepted after a forged copy");
+        }
+
+        SeenFilter filter(1000);
+        for (int i = 0; i < 2500; ++i) {
+            filter.insert(Crypto::hash_raw(std::to_string(i)));
+        }
+        if (!filter.contains(Crypto::hash_raw("2499")) || !filter.contains(Crypto::hash_raw("1500"))) {
+            throw std::runtime_error("Seen filter forgot recent items");
+        }
+        // Stop the transports before the gossip instances their handlers point to are destroyed.
+        net_a.shutdown();
+        net_b.shutdown();
+        net_c.shutdown();
+        std::cout << "Gossip propagation succeeded." << std::endl;
+
+        // Compact relay: the receiver's pool holds two of three transactions, so only one is fetched.
+        auto key_pair = ECDSA::generate_key_pair();
+        std::vector<Transaction> txs;
+        for (int i = 0; i < 3; ++i) {
+            txs.emplace_back(key_pair.second, "receiver", 1.0 + i, Crypto::sign(key_pair.second, key_pair.first),
+                             TransactionType::STANDARD_PAYMENT, std::to_string(i));
+        }
+        Block relayed(1, std::string(64, '0'), 1);
+        relayed.add_transactions(txs);
+        Mempool pool_e;
+        pool_e.add(txs[0], 1.0);
+        pool_e.add(txs[2], 1.0);
+
+        P2PProtocol net_d(201, "127.0.0.1"), net_e(202, "127.0.0.1");
+        Gossip gossip_d(net_d, 201, topology), gossip_e(net_e, 202, topology);
+        std::mutex pool_mutex;
+        std::string delivered_block;
+        gossip_e.set_mempool_matcher([&](PartialBlock& block) {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            block.fill_from(pool_e);
+        });
+        gossip_e.set_item_handler([&](InventoryType, const Hash256&, const std::string& payload) {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            delivered_block = payload;
+            return true;
+        });
+        net_d.set_message_handler([&](const std::string&, const std::string& m) { gossip_d.handle_message(m); });
+        net_e.set_message_handler([&](const std::string&, const std::string& m) { gossip_e.handle_message(m); });
+        net_d.initialize(18201);
+        net_e.initialize(18202);
+        net_d.add_peer(202, "127.0.0.1:18202");
+        net_e.add_peer(201, "127.0.0.1:18201");
+
+        gossip_d.broadcast(InventoryType::BLOCK, relayed.get_block_digest(), relayed.serialize());
+        for (int attempt = 0; attempt < 200 && !gossip_e.has_seen(relayed.get_block_digest()); ++attempt) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        net_d.shutdown();
+        net_e.shutdown();
+        GossipStats compact_stats = gossip_e.get_stats();
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            if (delivered_block != relayed.serialize() || compact_stats.compact_blocks_rebuilt != 1 ||
+                compact_stats.transactions_requested != 1 || compact_stats.compact_fallbacks != 0) {
+                throw std::runtime_error("Compact block relay did not rebuild the block from the mempool");
+            }
+        }
+        std::cout << "Compact block relay succeeded." << std::endl;
         std::cout << "P2P tests passed!" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "P2P tests failed: " << e.what() << std::endl;
@@ -1,4 +1,7 @@
 #include <iostream>
+#include <thread>
+#include <atomic>
+#include <stdexcept>
 #include "../include/subnet/subnet_manager.hpp"
 
 int main() {
@@ -13,6 +16,71 @@ int main() {
         subnet_manager.rebalance_subnets();
         std::cout << "Subnet rebalancing completed." << std::endl;
 
+        // Bounded-load placement keeps every subnet near the average and is stable for known nodes.
+        const size_t subnets = 10;
+        const size_t nodes = 1000;
+        SubnetManager ring_manager(subnets);
+        for (size_t node_id = 0; node_id < nodes; ++node_id) {
+            ring_manager.assign_node_to_subnet(node_id);
+        }
+        size_t before = ring_manager.get_node_subnet(42);
+        ring_manager.assign_node_to_subnet(42);
+        size_t total = 0;
+        for (size_t subnet_id = 0; subnet_id < subnets; ++subnet_id) {
+            total += ring_manager.get_subnet_load(subnet_id);
+            if (ring_manager.get_subnet_load(subnet_id) > 1.25 * nodes / subnets + 1) {
+                throw std::runtime_error("Subnet exceeds its load bound");
+            }
+        }
+        if (total != nodes || ring_manager.get_node_subnet(42) != before) {
+            throw std::runtime_error("Reassignment changed the topology");
+        }
+
+        // A batch of joins places nodes exactly as the same joins one at a time would.
+        std::vector<size_t> joining;
+        for (size_t node_id = 0; node_id < nodes; ++node_id) {
+            joining.push_back(node_id);
+        }
+        joining.push_back(42);
+        SubnetManager batched(subnets);
+        batched.assign_nodes_to_subnets(joining);
+        if (batched.get_assignment() != ring_manager.get_assignment()) {
+            throw std::runtime_error("Batched joins differ from sequential joins");
+        }
+
+        // Rebalancing moves exactly the surplus, while readers keep resolving nodes without blocking.
+        size_t surplus = 0;
+        for (size_t subnet_id = 0; subnet_id < subnets; ++subnet_id) {
+            size_t load = ring_manager.get_subnet_load(subnet_id);
+            surplus += load > nodes / subnets ? load - nodes / subnets : 0;
+        }
+        std::atomic<bool> reading(true);
+        std::atomic<size_t> lookups(0);
+        std::thread reader([&] {
+            while (reading) {
+                ring_manager.get_node_subnet(lookups % nodes);
+                ++lookups;
+            }
+        });
+        std::vector<SubnetMigration> plan = ring_manager.rebalance_subnets();
+        reading = false;
+        reader.join();
+
+        if (plan.size() != surplus || !ring_manager.plan_rebalance().empty()) {
+            throw std::runtime_error("Rebalance did not move the minimum number of nodes");
+        }
+        for (const SubnetMigration& move : plan) {
+            if (ring_manager.get_node_subnet(move.node_id) != move.to_subnet) {
+                throw std::runtime_error("Migration was not applied");
+            }
+        }
+        for (size_t subnet_id = 0; subnet_id < subnets; ++subnet_id) {
+            if (ring_manager.get_subnet_load(subnet_id) != nodes / subnets) {
+                throw std::runtime_error("Subnets are not balanced after rebalancing");
+            }
+        }
+        std::cout << "Consistent-hashing subnets succeeded (" << plan.size() << " migrations)." << std::endl;
+
         std::cout << "Subnet tests passed!" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "Subnet tests failed: " << e.what() << std::endl;
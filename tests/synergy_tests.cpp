@@ -1,4 +1,9 @@
 #include <iostream>
+#include <vector>
+#include <stdexcept>
+#include <cmath>
+#include <string>
+#include "../include/consensus/posyg_engine.hpp"
 #include "../include/economic/synergy_model.hpp"
 
 int main() {
@@ -15,6 +20,50 @@ int main() {
         std::cout << "Honest participants: " << stats.honest_count << std::endl;
         std::cout << "Dishonest participants: " << stats.dishonest_count << std::endl;
         std::cout << "Total rewards: " << stats.total_rewards << std::endl;
+
+        // Batch kernels agree with the scalar rules element by element.
+        const size_t count = 1003;
+        std::vector<double> synergy(count), economic(count), governance(count), penalty(count), rates(count);
+        std::vector<uint64_t> excluded((count + 63) / 64, 0);
+        for (size_t i = 0; i < count; ++i) {
+            synergy[i] = static_cast<double>(i % 97) - 20.0;
+            economic[i] = static_cast<double>(i % 13) * 1.5;
+            governance[i] = static_cast<double>(i % 7) - 3.0;
+            penalty[i] = static_cast<double>(i % 11) * 2.25;
+            rates[i] = 0.1 + static_cast<double>(i % 5) * 0.01;
+            if (i % 9 == 0) {
+                excluded[i / 64] |= uint64_t(1) << (i % 64);
+            }
+        }
+
+        std::vector<double> gained(count), penalized(count), adjusted(count), balances(count, 1.0);
+        SynergyModel::calculate_synergy(synergy.data(), economic.data(), governance.data(), gained.data(), count);
+        SynergyModel::apply_penalty(synergy.data(), penalty.data(), penalized.data(), count);
+        SynergyModel::adjust_conversion_rate(rates.data(), governance.data(), adjusted.data(), count);
+        double converted = SynergyModel::convert_synergy_to_tokens(synergy.data(), 0.3, balances.data(),
+                                                                   excluded.data(), count);
+        double expected_total = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            const bool skip = (excluded[i / 64] >> (i % 64)) & 1;
+            const double tokens = skip ? 0.0 : SynergyModel::convert_synergy_to_tokens(synergy[i], 0.3);
+            expected_total += tokens;
+            if (gained[i] != SynergyModel::calculate_synergy(synergy[i], economic[i], governance[i])
+                || penalized[i] != SynergyModel::apply_penalty(synergy[i], penalty[i])
+                || adjusted[i] != SynergyModel::adjust_conversion_rate(rates[i], governance[i])
+                || balances[i] != 1.0 + tokens) {
+                throw std::runtime_error("Batch kernel differs from the scalar rule at " + std::to_string(i));
+            }
+        }
+        if (std::abs(converted - expected_total) > 1e-9 * std::abs(expected_total)) {
+            throw std::runtime_error("Batch conversion total differs from the scalar sum");
+        }
+
+        // Outputs may overwrite their inputs.
+        std::vector<double> in_place = synergy;
+        SynergyModel::apply_penalty(in_place.data(), penalty.data(), in_place.data(), count);
+        if (in_place != penalized) {
+            throw std::runtime_error("In-place batch penalty differs");
+        }
         std::cout << "Synergy tests passed!" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "Synergy tests failed: " << e.what() << std::endl;